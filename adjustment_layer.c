@@ -0,0 +1,1294 @@
+#include <string.h>
+#include <math.h>
+#include "configure.h"
+#include "adjustment_layer.h"
+#include "layer.h"
+#include "draw_window.h"
+#include "color.h"
+#include "memory.h"
+#include "gui/gui.h"
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+# include <emmintrin.h>
+#endif
+
+#ifndef TRUE
+# define TRUE 1
+#endif
+#ifndef FALSE
+# define FALSE 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ピクセルデータ内のチャンネルの位置
+#if defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
+# define ADJUSTMENT_RED 2
+# define ADJUSTMENT_BLUE 0
+#else
+# define ADJUSTMENT_RED 0
+# define ADJUSTMENT_BLUE 2
+#endif
+#define ADJUSTMENT_GREEN 1
+#define ADJUSTMENT_ALPHA 3
+
+// 8ビット固定小数点の輝度
+#define ADJUSTMENT_LUMA(R, G, B) (((R) * 77 + (G) * 150 + (B) * 29 + 128) >> 8)
+
+// RGBの順番からピクセルデータ内の位置への変換
+static const int g_adjustment_channels[3] = {ADJUSTMENT_RED, ADJUSTMENT_GREEN, ADJUSTMENT_BLUE};
+
+// 色相・彩度でまとめてHSVに変換するピクセル数
+#define ADJUSTMENT_HSV_CHUNK_SIZE LAYER_TILE_SIZE
+
+/*
+* ApplyPipelinePixel関数
+* 乗算済みアルファの1ピクセルにまとめた変換を適用する
+* 引数
+* pipeline	: 適用する変換
+* input		: 入力ピクセル
+* output	: 出力ピクセル
+*/
+static void ApplyPipelinePixel(const ADJUSTMENT_PIPELINE* pipeline, const uint8* input, uint8* output)
+{
+	unsigned int alpha = input[3];
+	uint8 color[3];
+	int i;
+
+	if(alpha == 0)
+	{
+		output[0] = output[1] = output[2] = output[3] = 0;
+		return;
+	}
+
+	if(alpha == 0xFF)
+	{
+		color[0] = pipeline->lut[0][input[0]];
+		color[1] = pipeline->lut[1][input[1]];
+		color[2] = pipeline->lut[2][input[2]];
+	}
+	else
+	{	// 乗算済みアルファを戻してから変換する
+		for(i=0; i<3; i++)
+		{
+			unsigned int value = (input[i] * 255 + alpha / 2) / alpha;
+			color[i] = pipeline->lut[i][(value > 0xFF) ? 0xFF : value];
+		}
+	}
+
+	if(pipeline->has_gradient != FALSE)
+	{
+		unsigned int luma = ADJUSTMENT_LUMA(color[ADJUSTMENT_RED], color[ADJUSTMENT_GREEN], color[ADJUSTMENT_BLUE]);
+		color[0] = pipeline->gradient[0][luma];
+		color[1] = pipeline->gradient[1][luma];
+		color[2] = pipeline->gradient[2][luma];
+	}
+
+	if(alpha != 0xFF)
+	{
+		for(i=0; i<3; i++)
+		{
+			unsigned int value = color[i] * alpha + 128;
+			color[i] = (uint8)((value + (value >> 8)) >> 8);
+		}
+	}
+
+	output[0] = color[0],	output[1] = color[1],	output[2] = color[2];
+	output[3] = (uint8)alpha;
+}
+
+/*
+* LUTFilter関数
+* 1行分のピクセルにまとめたチャンネル毎の変換テーブル(とグラデーションマップ)を適用する
+*  4ピクセルまとめて完全に不透明・透明かを判定し、大半を占めるその2つを速く処理する
+* 引数
+* layer		: 調整レイヤー
+* input		: 入力ピクセル
+* output	: 出力ピクセル
+* length	: ピクセル数
+* target	: 調整レイヤーを適用する相手(未使用)
+*/
+static void LUTFilter(
+	ADJUSTMENT_LAYER* layer,
+	uint8* input,
+	uint8* output,
+	unsigned int length,
+	LAYER* target
+)
+{
+	const ADJUSTMENT_PIPELINE *pipeline = &layer->cache.pipeline;
+	unsigned int i = 0;
+
+	(void)target;
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+
+	for( ; i + 4 <= length; i += 4)
+	{
+		__m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)&input[i*4]), alpha_mask);
+		uint8 *src = &input[i*4];
+		uint8 *dst = &output[i*4];
+		int j;
+
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF)
+		{
+			_mm_storeu_si128((__m128i*)dst, zero);
+		}
+		else if(pipeline->has_gradient == FALSE
+			&& _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFF)
+		{
+			for(j=0; j<16; j+=4)
+			{
+				dst[j] = pipeline->lut[0][src[j]];
+				dst[j+1] = pipeline->lut[1][src[j+1]];
+				dst[j+2] = pipeline->lut[2][src[j+2]];
+				dst[j+3] = 0xFF;
+			}
+		}
+		else
+		{
+			for(j=0; j<16; j+=4)
+			{
+				ApplyPipelinePixel(pipeline, &src[j], &dst[j]);
+			}
+		}
+	}
+#endif
+
+	for( ; i < length; i++)
+	{
+		ApplyPipelinePixel(pipeline, &input[i*4], &output[i*4]);
+	}
+}
+
+/*
+* HueSaturationFilter関数
+* 1行分のピクセルの色相をずらし、彩度・明度に変換テーブルを適用する
+*  固定長の区切り毎にまとめてHSVへ変換し、作業用のメモリは確保しない
+* 引数
+* layer		: 調整レイヤー
+* input		: 入力ピクセル
+* output	: 出力ピクセル
+* length	: ピクセル数
+* target	: 調整レイヤーを適用する相手(未使用)
+*/
+static void HueSaturationFilter(
+	ADJUSTMENT_LAYER* layer,
+	uint8* input,
+	uint8* output,
+	unsigned int length,
+	LAYER* target
+)
+{
+	const ADJUSTMENT_PIPELINE *pipeline = &layer->cache.pipeline;
+	uint8 rgba[ADJUSTMENT_HSV_CHUNK_SIZE*4];
+	HSV hsv[ADJUSTMENT_HSV_CHUNK_SIZE];
+	unsigned int start, i;
+
+	(void)target;
+
+	for(start=0; start<length; start+=ADJUSTMENT_HSV_CHUNK_SIZE)
+	{
+		const uint8 *src = &input[start*4];
+		uint8 *dst = &output[start*4];
+		int num_pixels = (int)((length - start < ADJUSTMENT_HSV_CHUNK_SIZE)
+			? length - start : ADJUSTMENT_HSV_CHUNK_SIZE);
+		int j;
+
+		// 乗算済みアルファを戻してR, G, B, Aの順に並べる
+		for(i=0; i<(unsigned int)num_pixels; i++)
+		{
+			const uint8 *p = &src[i*4];
+			uint8 *q = &rgba[i*4];
+			unsigned int alpha = p[3];
+
+			q[0] = p[ADJUSTMENT_RED],	q[1] = p[ADJUSTMENT_GREEN],	q[2] = p[ADJUSTMENT_BLUE];
+			q[3] = (uint8)alpha;
+			if(alpha != 0xFF && alpha != 0)
+			{
+				for(j=0; j<3; j++)
+				{
+					unsigned int value = (q[j] * 255 + alpha / 2) / alpha;
+					q[j] = (uint8)((value > 0xFF) ? 0xFF : value);
+				}
+			}
+		}
+
+		RGB2HSV_Line(rgba, hsv, num_pixels, 4);
+		for(i=0; i<(unsigned int)num_pixels; i++)
+		{	// 無彩色(彩度0)は色相が決まらないので明度のみ変換する
+			if(hsv[i].s != 0)
+			{
+				hsv[i].h = (int16)((hsv[i].h + pipeline->hue) % 360);
+				hsv[i].s = pipeline->saturation[hsv[i].s];
+			}
+			hsv[i].v = pipeline->value[hsv[i].v];
+		}
+		HSV2RGB_Line(hsv, rgba, num_pixels, 4);
+
+		for(i=0; i<(unsigned int)num_pixels; i++)
+		{
+			const uint8 *q = &rgba[i*4];
+			uint8 *p = &dst[i*4];
+			unsigned int alpha = q[3];
+
+			if(alpha == 0)
+			{
+				p[0] = p[1] = p[2] = p[3] = 0;
+			}
+			else if(alpha == 0xFF)
+			{
+				p[ADJUSTMENT_RED] = q[0],	p[ADJUSTMENT_GREEN] = q[1],	p[ADJUSTMENT_BLUE] = q[2];
+				p[3] = 0xFF;
+			}
+			else
+			{
+				for(j=0; j<3; j++)
+				{
+					unsigned int value = q[j] * alpha + 128;
+					p[g_adjustment_channels[j]] = (uint8)((value + (value >> 8)) >> 8);
+				}
+				p[3] = (uint8)alpha;
+			}
+		}
+	}
+}
+
+/*
+* ClampLUTValue関数
+* 変換テーブルの値を0～255に収める
+* 引数
+* value	: 計算した値
+* 返り値
+*	0～255の値
+*/
+static uint8 ClampLUTValue(int value)
+{
+	if(value < 0)
+	{
+		return 0;
+	}
+	else if(value > 0xFF)
+	{
+		return 0xFF;
+	}
+	return (uint8)value;
+}
+
+/*
+* ScaleTowardLimit関数
+* -100～100の設定値で0(負の値)か255(正の値)に向かって値を寄せる
+* 引数
+* value		: 元の値
+* amount	: 設定値
+* 返り値
+*	変換後の値
+*/
+static uint8 ScaleTowardLimit(int value, int amount)
+{
+	if(amount < 0)
+	{
+		return ClampLUTValue((value * (100 + amount) + 50) / 100);
+	}
+	return ClampLUTValue(value + ((255 - value) * amount + 50) / 100);
+}
+
+/*
+* BuildBrightContrastLUT関数
+* 明るさ・コントラストの変換テーブルを作成する
+*  コントラストは入力の平均値を中心にかける
+* 引数
+* layer	: 調整レイヤー
+* sums	: 入力全体のチャンネル合計
+* lut	: 変換テーブルを入れる配列(ピクセルデータと同じチャンネル順)
+*/
+static void BuildBrightContrastLUT(ADJUSTMENT_LAYER* layer, const uint64 sums[4], uint8 lut[3][256])
+{
+	int bright = layer->filter_data.bright_contrast.bright * 255;
+	int contrast = 100 + layer->filter_data.bright_contrast.contrast;
+	int i, j;
+
+	for(i=0; i<3; i++)
+	{	// 乗算済みの合計をアルファの合計で割って平均値にする
+		int mean = (sums[3] == 0) ? 128 : (int)((sums[i] * 255 + sums[3] / 2) / sums[3]);
+		if(mean > 0xFF)
+		{
+			mean = 0xFF;
+		}
+		for(j=0; j<256; j++)
+		{
+			lut[i][j] = ClampLUTValue(((j - mean) * contrast + mean * 100 + bright + 50) / 100);
+		}
+	}
+}
+
+/*
+* LevelValue関数
+* レベル補正の1チャンネル分の値を計算する
+* 引数
+* layer		: 調整レイヤー
+* channel	: 補正のチャンネル
+* value		: 入力値
+* 返り値
+*	出力値
+*/
+static int LevelValue(ADJUSTMENT_LAYER* layer, int channel, int value)
+{
+	int input_black = layer->filter_data.levels.input_black[channel];
+	int input_white = layer->filter_data.levels.input_white[channel];
+	int output_black = layer->filter_data.levels.output_black[channel];
+	int output_white = layer->filter_data.levels.output_white[channel];
+	FLOAT_T gamma = layer->filter_data.levels.gamma[channel] * 0.01;
+	FLOAT_T rate;
+
+	if(input_white <= input_black)
+	{
+		rate = (value >= input_black) ? 1 : 0;
+	}
+	else
+	{
+		rate = (value - input_black) / (FLOAT_T)(input_white - input_black);
+		if(rate < 0)
+		{
+			rate = 0;
+		}
+		else if(rate > 1)
+		{
+			rate = 1;
+		}
+	}
+	if(gamma > 0 && gamma != 1)
+	{
+		rate = pow(rate, 1 / gamma);
+	}
+
+	return ClampLUTValue((int)floor(output_black + rate * (output_white - output_black) + 0.5));
+}
+
+/*
+* BuildLevelsLUT関数
+* レベル補正の変換テーブルを作成する(全チャンネル共通の補正の後に各チャンネルの補正)
+* 引数
+* layer	: 調整レイヤー
+* lut	: 変換テーブルを入れる配列(ピクセルデータと同じチャンネル順)
+*/
+static void BuildLevelsLUT(ADJUSTMENT_LAYER* layer, uint8 lut[3][256])
+{
+	uint8 master[256];
+	int i, j;
+
+	for(j=0; j<256; j++)
+	{
+		master[j] = (uint8)LevelValue(layer, ADJUSTMENT_LAYER_CHANNEL_MASTER, j);
+	}
+	for(i=0; i<3; i++)
+	{
+		for(j=0; j<256; j++)
+		{
+			lut[g_adjustment_channels[i]][j] = (uint8)LevelValue(layer, ADJUSTMENT_LAYER_CHANNEL_RED + i, master[j]);
+		}
+	}
+}
+
+/*
+* BuildCurveTable関数
+* 制御点を通る単調な3次補間(Fritsch-Carlson)で1チャンネル分のテーブルを作成する
+* 引数
+* points		: 制御点(入力, 出力)の配列
+* num_points	: 制御点の数(2未満なら変換しない)
+* table			: テーブルを入れる配列
+*/
+static void BuildCurveTable(uint8 points[][2], int num_points, uint8 table[256])
+{
+	FLOAT_T x[ADJUSTMENT_CURVE_MAX_POINTS], y[ADJUSTMENT_CURVE_MAX_POINTS];
+	FLOAT_T delta[ADJUSTMENT_CURVE_MAX_POINTS], slope[ADJUSTMENT_CURVE_MAX_POINTS];
+	int n = 0;
+	int i, j, k;
+
+	if(num_points > ADJUSTMENT_CURVE_MAX_POINTS)
+	{
+		num_points = ADJUSTMENT_CURVE_MAX_POINTS;
+	}
+
+	// 入力の小さい順に並べ、同じ入力の制御点は後のものを使う
+	for(i=0; i<num_points; i++)
+	{
+		for(j=0; j<n && x[j] < points[i][0]; j++);
+		if(j < n && x[j] == points[i][0])
+		{
+			y[j] = points[i][1];
+			continue;
+		}
+		for(k=n; k>j; k--)
+		{
+			x[k] = x[k-1],	y[k] = y[k-1];
+		}
+		x[j] = points[i][0],	y[j] = points[i][1];
+		n++;
+	}
+
+	if(n < 2)
+	{
+		for(j=0; j<256; j++)
+		{
+			table[j] = (uint8)j;
+		}
+		return;
+	}
+
+	for(k=0; k<n-1; k++)
+	{
+		delta[k] = (y[k+1] - y[k]) / (x[k+1] - x[k]);
+	}
+	slope[0] = delta[0];
+	slope[n-1] = delta[n-2];
+	for(k=1; k<n-1; k++)
+	{
+		slope[k] = (delta[k-1] * delta[k] <= 0) ? 0 : (delta[k-1] + delta[k]) * 0.5;
+	}
+	// 行き過ぎが出ないように傾きを制限する
+	for(k=0; k<n-1; k++)
+	{
+		if(delta[k] == 0)
+		{
+			slope[k] = slope[k+1] = 0;
+		}
+		else
+		{
+			FLOAT_T a = slope[k] / delta[k],	b = slope[k+1] / delta[k];
+			FLOAT_T s = a * a + b * b;
+			if(s > 9)
+			{
+				FLOAT_T t = 3 / sqrt(s);
+				slope[k] = t * a * delta[k];
+				slope[k+1] = t * b * delta[k];
+			}
+		}
+	}
+
+	k = 0;
+	for(j=0; j<256; j++)
+	{
+		FLOAT_T value;
+
+		if(j <= x[0])
+		{
+			value = y[0];
+		}
+		else if(j >= x[n-1])
+		{
+			value = y[n-1];
+		}
+		else
+		{
+			FLOAT_T h, t, t2, t3;
+			while(j > x[k+1])
+			{
+				k++;
+			}
+			h = x[k+1] - x[k];
+			t = (j - x[k]) / h;
+			t2 = t * t,	t3 = t2 * t;
+			value = (2*t3 - 3*t2 + 1) * y[k] + (t3 - 2*t2 + t) * h * slope[k]
+				+ (-2*t3 + 3*t2) * y[k+1] + (t3 - t2) * h * slope[k+1];
+		}
+		table[j] = ClampLUTValue((int)floor(value + 0.5));
+	}
+}
+
+/*
+* BuildCurvesLUT関数
+* トーンカーブの変換テーブルを作成する(全チャンネル共通のカーブの後に各チャンネルのカーブ)
+* 引数
+* layer	: 調整レイヤー
+* lut	: 変換テーブルを入れる配列(ピクセルデータと同じチャンネル順)
+*/
+static void BuildCurvesLUT(ADJUSTMENT_LAYER* layer, uint8 lut[3][256])
+{
+	uint8 tables[NUM_ADJUSTMENT_LAYER_CHANNEL][256];
+	int i, j;
+
+	for(i=0; i<NUM_ADJUSTMENT_LAYER_CHANNEL; i++)
+	{
+		BuildCurveTable(layer->filter_data.curves.points[i],
+			layer->filter_data.curves.num_points[i], tables[i]);
+	}
+	for(i=0; i<3; i++)
+	{
+		for(j=0; j<256; j++)
+		{
+			lut[g_adjustment_channels[i]][j] =
+				tables[ADJUSTMENT_LAYER_CHANNEL_RED + i][tables[ADJUSTMENT_LAYER_CHANNEL_MASTER][j]];
+		}
+	}
+}
+
+/*
+* BuildColorBalanceLUT関数
+* カラーバランスの変換テーブルを作成する
+*  シャドウ・中間調・ハイライトの重みは2次のベルンシュタイン多項式
+* 引数
+* layer	: 調整レイヤー
+* lut	: 変換テーブルを入れる配列(ピクセルデータと同じチャンネル順)
+*/
+static void BuildColorBalanceLUT(ADJUSTMENT_LAYER* layer, uint8 lut[3][256])
+{
+	int i, j;
+
+	for(i=0; i<3; i++)
+	{
+		int shadows = layer->filter_data.color_balance.shadows[i];
+		int midtones = layer->filter_data.color_balance.midtones[i];
+		int highlights = layer->filter_data.color_balance.highlights[i];
+
+		for(j=0; j<256; j++)
+		{
+			FLOAT_T t = j / 255.0;
+			// 設定値100で128段階ずらす
+			FLOAT_T shift = (shadows * (1 - t) * (1 - t) + midtones * 2 * t * (1 - t)
+				+ highlights * t * t) * 1.28;
+			lut[g_adjustment_channels[i]][j] = ClampLUTValue((int)floor(j + shift + 0.5));
+		}
+	}
+}
+
+/*
+* BuildGradientMap関数
+* 輝度から色を決めるテーブルを作成する
+* 引数
+* layer		: 調整レイヤー
+* gradient	: テーブルを入れる配列(ピクセルデータと同じチャンネル順)
+*/
+static void BuildGradientMap(ADJUSTMENT_LAYER* layer, uint8 gradient[3][256])
+{
+	int num_colors = layer->filter_data.gradient_map.num_colors;
+	int order[ADJUSTMENT_GRADIENT_MAX_COLORS];
+	int i, j, k;
+
+	if(num_colors > ADJUSTMENT_GRADIENT_MAX_COLORS)
+	{
+		num_colors = ADJUSTMENT_GRADIENT_MAX_COLORS;
+	}
+
+	// 位置の小さい順に並べる
+	for(i=0; i<num_colors; i++)
+	{
+		int position = layer->filter_data.gradient_map.positions[i];
+		for(j=i; j>0 && layer->filter_data.gradient_map.positions[order[j-1]] > position; j--)
+		{
+			order[j] = order[j-1];
+		}
+		order[j] = i;
+	}
+
+	k = 0;
+	for(j=0; j<256; j++)
+	{
+		const uint8 *first = layer->filter_data.gradient_map.colors[order[0]];
+		const uint8 *last = layer->filter_data.gradient_map.colors[order[num_colors-1]];
+		int first_position = layer->filter_data.gradient_map.positions[order[0]];
+		int last_position = layer->filter_data.gradient_map.positions[order[num_colors-1]];
+
+		if(j <= first_position)
+		{
+			for(i=0; i<3; i++)
+			{
+				gradient[g_adjustment_channels[i]][j] = first[i];
+			}
+		}
+		else if(j >= last_position)
+		{
+			for(i=0; i<3; i++)
+			{
+				gradient[g_adjustment_channels[i]][j] = last[i];
+			}
+		}
+		else
+		{
+			const uint8 *left, *right;
+			int left_position, right_position;
+
+			while(j > layer->filter_data.gradient_map.positions[order[k+1]])
+			{
+				k++;
+			}
+			left = layer->filter_data.gradient_map.colors[order[k]];
+			right = layer->filter_data.gradient_map.colors[order[k+1]];
+			left_position = layer->filter_data.gradient_map.positions[order[k]];
+			right_position = layer->filter_data.gradient_map.positions[order[k+1]];
+			for(i=0; i<3; i++)
+			{
+				gradient[g_adjustment_channels[i]][j] = (uint8)((left[i] * (right_position - j)
+					+ right[i] * (j - left_position) + (right_position - left_position) / 2)
+						/ (right_position - left_position));
+			}
+		}
+	}
+}
+
+/*
+* AppendPipelineLUT関数
+* まとめた変換の後にチャンネル毎の変換テーブルを合成する
+* 引数
+* pipeline	: まとめた変換
+* lut		: 後に適用する変換テーブル
+*/
+static void AppendPipelineLUT(ADJUSTMENT_PIPELINE* pipeline, uint8 lut[3][256])
+{
+	int i, j;
+
+	for(i=0; i<3; i++)
+	{	// グラデーションマップの後ならその出力の色を変換する
+		uint8 *table = (pipeline->has_gradient == FALSE) ? pipeline->lut[i] : pipeline->gradient[i];
+		for(j=0; j<256; j++)
+		{
+			table[j] = lut[i][table[j]];
+		}
+	}
+}
+
+/*
+* AppendPipelineGradient関数
+* まとめた変換の後にグラデーションマップを合成する
+* 引数
+* pipeline	: まとめた変換
+* gradient	: 後に適用する輝度から色へのテーブル
+*/
+static void AppendPipelineGradient(ADJUSTMENT_PIPELINE* pipeline, uint8 gradient[3][256])
+{
+	uint8 merged[3][256];
+	int i, j;
+
+	if(pipeline->has_gradient == FALSE)
+	{
+		(void)memcpy(pipeline->gradient, gradient, sizeof(pipeline->gradient));
+		pipeline->has_gradient = TRUE;
+		return;
+	}
+
+	// 前のグラデーションマップの出力の輝度で引き直す
+	for(j=0; j<256; j++)
+	{
+		int luma = ADJUSTMENT_LUMA(pipeline->gradient[ADJUSTMENT_RED][j],
+			pipeline->gradient[ADJUSTMENT_GREEN][j], pipeline->gradient[ADJUSTMENT_BLUE][j]);
+		for(i=0; i<3; i++)
+		{
+			merged[i][j] = gradient[i][luma];
+		}
+	}
+	(void)memcpy(pipeline->gradient, merged, sizeof(pipeline->gradient));
+}
+
+/*
+* AppendAdjustmentStage関数
+* まとめた変換の後に調整レイヤー1つ分の変換を合成する
+* 引数
+* pipeline	: まとめた変換
+* stage		: 合成する調整レイヤー
+* sums		: まとめた変換の入力全体のチャンネル合計
+*/
+static void AppendAdjustmentStage(ADJUSTMENT_PIPELINE* pipeline, ADJUSTMENT_LAYER* stage, const uint64 sums[4])
+{
+	uint8 table[3][256];
+	int j;
+
+	switch(stage->type)
+	{
+	case ADJUSTMENT_LAYER_TYPE_BRIGHT_CONTRAST:
+		BuildBrightContrastLUT(stage, sums, table);
+		AppendPipelineLUT(pipeline, table);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_HUE_SATURATION:
+		pipeline->hue = stage->filter_data.hue_saturation.h % 360;
+		if(pipeline->hue < 0)
+		{
+			pipeline->hue += 360;
+		}
+		for(j=0; j<256; j++)
+		{
+			pipeline->saturation[j] = ScaleTowardLimit(j, stage->filter_data.hue_saturation.s);
+			pipeline->value[j] = ScaleTowardLimit(j, stage->filter_data.hue_saturation.v);
+		}
+		break;
+	case ADJUSTMENT_LAYER_TYPE_LEVELS:
+		BuildLevelsLUT(stage, table);
+		AppendPipelineLUT(pipeline, table);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_CURVES:
+		BuildCurvesLUT(stage, table);
+		AppendPipelineLUT(pipeline, table);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_GRADIENT_MAP:
+		if(stage->filter_data.gradient_map.num_colors > 0)
+		{
+			BuildGradientMap(stage, table);
+			AppendPipelineGradient(pipeline, table);
+		}
+		break;
+	case ADJUSTMENT_LAYER_TYPE_COLOR_BALANCE:
+		BuildColorBalanceLUT(stage, table);
+		AppendPipelineLUT(pipeline, table);
+		break;
+	}
+}
+
+/*
+* CalculateTileSums関数
+* タイル1枚分のチャンネル毎の合計を計算する
+* 引数
+* pixels	: タイル左上のピクセル
+* stride	: 1行分のバイト数
+* width		: タイルの幅
+* height	: タイルの高さ
+* sums		: 合計を入れる配列(4要素)
+*/
+static void CalculateTileSums(const uint8* pixels, int stride, int width, int height, uint64 sums[4])
+{
+	uint32 total[4] = {0};
+	int x, y;
+
+	for(y=0; y<height; y++)
+	{
+		const uint8 *p = &pixels[y*stride];
+		for(x=0; x<width; x++, p+=4)
+		{
+			total[0] += p[0],	total[1] += p[1],	total[2] += p[2],	total[3] += p[3];
+		}
+	}
+
+	sums[0] = total[0],	sums[1] = total[1],	sums[2] = total[2],	sums[3] = total[3];
+}
+
+/*
+* ReleaseAdjustmentLayerCache関数
+* 調整レイヤーのタイルキャッシュを開放する
+* 引数
+* layer	: 調整レイヤー
+*/
+static void ReleaseAdjustmentLayerCache(ADJUSTMENT_LAYER* layer)
+{
+	MEM_FREE_FUNC(layer->cache.input);
+	MEM_FREE_FUNC(layer->cache.valid);
+	MEM_FREE_FUNC(layer->cache.tile_sums);
+	(void)memset(&layer->cache, 0, sizeof(layer->cache));
+}
+
+/*
+* CreateAdjustmentLayerCache関数
+* 入力全体をコピーしてタイルキャッシュを作成する
+* 引数
+* layer			: 調整レイヤー
+* source		: 入力にするレイヤー
+* source_target	: 入力の種類
+*/
+static void CreateAdjustmentLayerCache(ADJUSTMENT_LAYER* layer, LAYER* source, int source_target)
+{
+	ADJUSTMENT_LAYER_CACHE *cache = &layer->cache;
+	int num_tiles;
+	int row, column;
+	int i, y;
+
+	ReleaseAdjustmentLayerCache(layer);
+
+	cache->source = source;
+	cache->source_target = (uint8)source_target;
+	cache->width = source->width;
+	cache->height = source->height;
+	cache->tile_columns = (source->width + LAYER_TILE_SIZE - 1) / LAYER_TILE_SIZE;
+	cache->tile_rows = (source->height + LAYER_TILE_SIZE - 1) / LAYER_TILE_SIZE;
+	num_tiles = cache->tile_columns * cache->tile_rows;
+
+	cache->input = (uint8*)MEM_ALLOC_FUNC((size_t)source->width * source->height * 4);
+	cache->valid = (uint8*)MEM_CALLOC_FUNC(num_tiles, 1);
+	cache->tile_sums = (uint64*)MEM_CALLOC_FUNC(num_tiles * 4, sizeof(*cache->tile_sums));
+
+	for(y=0; y<source->height; y++)
+	{
+		(void)memcpy(&cache->input[y*source->width*4], &source->pixels[y*source->stride], source->width*4);
+	}
+
+	for(row=0; row<cache->tile_rows; row++)
+	{
+		for(column=0; column<cache->tile_columns; column++)
+		{
+			int tile_x = column * LAYER_TILE_SIZE,	tile_y = row * LAYER_TILE_SIZE;
+			int tile_width = source->width - tile_x,	tile_height = source->height - tile_y;
+			uint64 *sums = &cache->tile_sums[(row*cache->tile_columns + column)*4];
+
+			CalculateTileSums(&cache->input[tile_y*source->width*4 + tile_x*4], source->width*4,
+				(tile_width > LAYER_TILE_SIZE) ? LAYER_TILE_SIZE : tile_width,
+				(tile_height > LAYER_TILE_SIZE) ? LAYER_TILE_SIZE : tile_height, sums);
+			for(i=0; i<4; i++)
+			{
+				cache->sums[i] += sums[i];
+			}
+		}
+	}
+}
+
+/*
+* InitializeAdjustmentLayerCache関数
+* 適用する相手の全体をコピーしてタイルキャッシュを作成する
+* 引数
+* layer		: 調整レイヤー
+* target	: 直下のレイヤー
+* mixed		: 下のレイヤーの合成結果
+*/
+static void InitializeAdjustmentLayerCache(ADJUSTMENT_LAYER* layer, LAYER* target, LAYER* mixed)
+{
+	CreateAdjustmentLayerCache(layer,
+		(layer->target == ADJUSTMENT_LAYER_TARGET_UNDER_LAYER) ? target : mixed, layer->target);
+}
+
+/*
+* CollectAdjustmentStages関数
+* 下に続く調整レイヤーのうち1回の処理にまとめられるものを集める
+*  まとめられない調整レイヤーに当たればその結果を先に作って入力にする
+* 引数
+* layer			: 一番上の調整レイヤー
+* target		: 直下のレイヤー
+* mixed			: 下のレイヤーの合成結果
+* start_x		: 更新範囲の左上のX座標
+* start_y		: 更新範囲の左上のY座標
+* width			: 更新範囲の幅
+* height		: 更新範囲の高さ
+* stages		: 集めた調整レイヤーを入れる配列(上から順)
+* num_stages	: 集めた数を入れるアドレス
+* 返り値
+*	まとめた処理の入力にするレイヤー
+*/
+static LAYER* CollectAdjustmentStages(
+	ADJUSTMENT_LAYER* layer,
+	LAYER* target,
+	LAYER* mixed,
+	int start_x,
+	int start_y,
+	int width,
+	int height,
+	ADJUSTMENT_LAYER** stages,
+	int* num_stages
+)
+{
+	ADJUSTMENT_LAYER *current = layer;
+	ADJUSTMENT_LAYER *next;
+	LAYER *below;
+
+	*num_stages = 0;
+	for(;;)
+	{
+		stages[(*num_stages)++] = current;
+		if(current->target == ADJUSTMENT_LAYER_TARGET_UNDER_MIXED)
+		{
+			return mixed;
+		}
+
+		below = (current == layer) ? target : current->self->prev;
+		// 非表示の調整レイヤーは素通りする
+		while(below != NULL && below->layer_type == TYPE_ADJUSTMENT_LAYER
+			&& (below->flags & LAYER_FLAG_INVISIBLE) != 0)
+		{
+			below = below->prev;
+		}
+		if(below == NULL || below->layer_type != TYPE_ADJUSTMENT_LAYER)
+		{
+			return below;
+		}
+
+		next = below->layer_data.adjustment_layer;
+		// 色相・彩度はテーブルにまとめられず、明るさ・コントラストは入力の平均値を使うので一番下にしか置けない
+		if(current->type == ADJUSTMENT_LAYER_TYPE_HUE_SATURATION
+			|| current->type == ADJUSTMENT_LAYER_TYPE_BRIGHT_CONTRAST
+			|| next->type == ADJUSTMENT_LAYER_TYPE_HUE_SATURATION
+			|| *num_stages >= ADJUSTMENT_PIPELINE_MAX_STAGES)
+		{
+			next->update(next, below->prev, mixed, start_x, start_y, width, height);
+			return below;
+		}
+
+		// まとめた調整レイヤーの結果は使われないのでキャッシュを開放する
+		if(next->cache.input != NULL)
+		{
+			next->release(next);
+		}
+		current = next;
+	}
+}
+
+/*
+* ADJUSTMENT_TILE_DATA構造体
+* 調整結果のタイルをスレッドプールで作り直すためのデータ
+*/
+typedef struct _ADJUSTMENT_TILE_DATA
+{
+	ADJUSTMENT_LAYER *layer;
+	LAYER *target;
+	int input_stride;
+} ADJUSTMENT_TILE_DATA;
+
+/*
+* UpdateAdjustmentLayerTile関数
+* スレッドプールから呼び出されて無効になったタイル1枚分の調整結果を作り直す
+* 引数
+* index			: タイルの番号
+* thread_index	: 処理しているスレッドの番号
+* data			: ADJUSTMENT_TILE_DATA構造体のアドレス
+*/
+static void UpdateAdjustmentLayerTile(int index, int thread_index, void* data)
+{
+	ADJUSTMENT_TILE_DATA *update = (ADJUSTMENT_TILE_DATA*)data;
+	ADJUSTMENT_LAYER *layer = update->layer;
+	ADJUSTMENT_LAYER_CACHE *cache = &layer->cache;
+	LAYER *self = layer->self;
+	int tile_x, tile_y, tile_width, tile_height;
+	int y;
+
+	(void)thread_index;
+
+	if(cache->valid[index] != FALSE)
+	{
+		return;
+	}
+
+	tile_x = (index % cache->tile_columns) * LAYER_TILE_SIZE;
+	tile_y = (index / cache->tile_columns) * LAYER_TILE_SIZE;
+	tile_width = cache->width - tile_x;
+	tile_height = cache->height - tile_y;
+	if(tile_width > LAYER_TILE_SIZE)
+	{
+		tile_width = LAYER_TILE_SIZE;
+	}
+	if(tile_height > LAYER_TILE_SIZE)
+	{
+		tile_height = LAYER_TILE_SIZE;
+	}
+	if(tile_x + tile_width > self->width)
+	{
+		tile_width = self->width - tile_x;
+	}
+	if(tile_y + tile_height > self->height)
+	{
+		tile_height = self->height - tile_y;
+	}
+
+	for(y=0; y<tile_height; y++)
+	{
+		layer->filter_func(layer, &cache->input[(tile_y+y)*update->input_stride + tile_x*4],
+			&self->pixels[(tile_y+y)*self->stride + tile_x*4], (unsigned int)tile_width, update->target);
+	}
+	cache->valid[index] = TRUE;
+}
+
+/*
+* UpdateAdjustmentLayerTiles関数
+* 範囲内で入力が変わったタイルを調べて、必要なタイルだけ調整結果を作り直す
+*  下に続く調整レイヤーの変換もまとめて1回で適用する
+* 引数
+* layer		: 調整レイヤー
+* target	: 直下のレイヤー
+* mixed		: 下のレイヤーの合成結果
+* start_x	: 更新範囲の左上のX座標
+* start_y	: 更新範囲の左上のY座標
+* width		: 更新範囲の幅
+* height	: 更新範囲の高さ
+*/
+static void UpdateAdjustmentLayerTiles(
+	ADJUSTMENT_LAYER* layer,
+	LAYER* target,
+	LAYER* mixed,
+	int start_x,
+	int start_y,
+	int width,
+	int height
+)
+{
+	ADJUSTMENT_LAYER_CACHE *cache = &layer->cache;
+	ADJUSTMENT_LAYER *stages[ADJUSTMENT_PIPELINE_MAX_STAGES];
+	ADJUSTMENT_PIPELINE pipeline;
+	ADJUSTMENT_TILE_DATA update;
+	LAYER *source;
+	LAYER *self = layer->self;
+	int source_target;
+	int num_stages;
+	int input_stride;
+	int num_tiles;
+	int row, column;
+	int i, j;
+
+	if(self == NULL)
+	{
+		return;
+	}
+
+	source = CollectAdjustmentStages(layer, target, mixed, start_x, start_y, width, height,
+		stages, &num_stages);
+	if(source == NULL)
+	{
+		return;
+	}
+	// 調整レイヤーを追加する前にタイル形式になっていたレイヤーは元に戻す
+	if(source->pixels == NULL && MaterializeLayerPixels(source) == NULL)
+	{
+		return;
+	}
+
+	// 下のレイヤーの合成結果は保存時などで別のレイヤーに入れ替わるので
+	//	ポインタではなく入力の種類で比べ、内容の差分はタイル毎に検出する
+	source_target = stages[num_stages-1]->target;
+	if(cache->input == NULL || cache->source_target != source_target
+		|| (source_target == ADJUSTMENT_LAYER_TARGET_UNDER_LAYER && cache->source != source)
+		|| cache->width != source->width || cache->height != source->height)
+	{
+		CreateAdjustmentLayerCache(layer, source, source_target);
+	}
+	cache->source = source;
+	input_stride = cache->width * 4;
+	num_tiles = cache->tile_columns * cache->tile_rows;
+
+	if(start_x < 0)
+	{
+		width += start_x;
+		start_x = 0;
+	}
+	if(start_y < 0)
+	{
+		height += start_y;
+		start_y = 0;
+	}
+	if(start_x + width > cache->width)
+	{
+		width = cache->width - start_x;
+	}
+	if(start_y + height > cache->height)
+	{
+		height = cache->height - start_y;
+	}
+
+	// 範囲に掛かるタイルの入力を前回と比べ、変わっていれば合計を差し替える
+	if(width > 0 && height > 0)
+	{
+		for(row = start_y / LAYER_TILE_SIZE; row <= (start_y + height - 1) / LAYER_TILE_SIZE; row++)
+		{
+			for(column = start_x / LAYER_TILE_SIZE; column <= (start_x + width - 1) / LAYER_TILE_SIZE; column++)
+			{
+				int tile_x = column * LAYER_TILE_SIZE,	tile_y = row * LAYER_TILE_SIZE;
+				int tile_width = cache->width - tile_x,	tile_height = cache->height - tile_y;
+				uint64 *sums = &cache->tile_sums[(row * cache->tile_columns + column)*4];
+				uint8 *cached = &cache->input[tile_y*input_stride + tile_x*4];
+				uint8 *src = &source->pixels[tile_y*source->stride + tile_x*4];
+				int y;
+
+				if(tile_width > LAYER_TILE_SIZE)
+				{
+					tile_width = LAYER_TILE_SIZE;
+				}
+				if(tile_height > LAYER_TILE_SIZE)
+				{
+					tile_height = LAYER_TILE_SIZE;
+				}
+
+				for(y=0; y<tile_height; y++)
+				{
+					if(memcmp(&cached[y*input_stride], &src[y*source->stride], tile_width*4) != 0)
+					{
+						break;
+					}
+				}
+				if(y == tile_height)
+				{
+					continue;
+				}
+
+				for( ; y<tile_height; y++)
+				{
+					(void)memcpy(&cached[y*input_stride], &src[y*source->stride], tile_width*4);
+				}
+				for(j=0; j<4; j++)
+				{
+					cache->sums[j] -= sums[j];
+				}
+				CalculateTileSums(cached, input_stride, tile_width, tile_height, sums);
+				for(j=0; j<4; j++)
+				{
+					cache->sums[j] += sums[j];
+				}
+				cache->valid[row * cache->tile_columns + column] = FALSE;
+			}
+		}
+	}
+
+	// 下の調整レイヤーから順に変換をまとめ、前回と変われば全てのタイルを作り直す
+	(void)memset(&pipeline, 0, sizeof(pipeline));
+	for(i=0; i<3; i++)
+	{
+		for(j=0; j<256; j++)
+		{
+			pipeline.lut[i][j] = (uint8)j;
+		}
+	}
+	for(i=num_stages-1; i>=0; i--)
+	{
+		AppendAdjustmentStage(&pipeline, stages[i], cache->sums);
+	}
+	if(cache->pipeline_valid == FALSE || memcmp(&pipeline, &cache->pipeline, sizeof(pipeline)) != 0)
+	{
+		cache->pipeline = pipeline;
+		cache->pipeline_valid = TRUE;
+		(void)memset(cache->valid, 0, num_tiles);
+	}
+
+	update.layer = layer;
+	update.target = target;
+	update.input_stride = input_stride;
+	ExecuteParallelLoop(num_tiles, UpdateAdjustmentLayerTile, &update);
+}
+
+/*
+* SetAdjustmentLayerDefaults関数
+* 調整レイヤーのパラメータを変換しない状態にする
+* 引数
+* layer	: 調整レイヤー
+*/
+static void SetAdjustmentLayerDefaults(ADJUSTMENT_LAYER* layer)
+{
+	int i;
+
+	(void)memset(&layer->filter_data, 0, sizeof(layer->filter_data));
+
+	switch(layer->type)
+	{
+	case ADJUSTMENT_LAYER_TYPE_LEVELS:
+		for(i=0; i<NUM_ADJUSTMENT_LAYER_CHANNEL; i++)
+		{
+			layer->filter_data.levels.input_white[i] = 0xFF;
+			layer->filter_data.levels.output_white[i] = 0xFF;
+			layer->filter_data.levels.gamma[i] = 100;
+		}
+		break;
+	case ADJUSTMENT_LAYER_TYPE_GRADIENT_MAP:
+		// 黒から白
+		layer->filter_data.gradient_map.num_colors = 2;
+		layer->filter_data.gradient_map.positions[1] = 0xFF;
+		layer->filter_data.gradient_map.colors[1][0] = layer->filter_data.gradient_map.colors[1][1]
+			= layer->filter_data.gradient_map.colors[1][2] = 0xFF;
+		break;
+	}
+}
+
+/*
+* CreateAdjustmentLayer関数
+* 調整レイヤーのデータを作成する
+* 引数
+* type			: 調整レイヤーのタイプ
+* target		: 調整レイヤーを適用する相手
+* target_layer	: 直下のレイヤー
+* self			: 調整結果を入れるレイヤー
+* 返り値
+*	初期化された構造体のアドレス
+*/
+ADJUSTMENT_LAYER* CreateAdjustmentLayer(
+	eADJUSTMENT_LAYER_TYPE type,
+	eADJUSTMENT_LAYER_TARGET target,
+	LAYER* target_layer,
+	LAYER* self
+)
+{
+	ADJUSTMENT_LAYER *ret = (ADJUSTMENT_LAYER*)MEM_CALLOC_FUNC(1, sizeof(*ret));
+
+	ret->target_layer = target_layer;
+	ret->self = self;
+	ret->type = (uint8)type;
+	SetAdjustmentLayerDefaults(ret);
+	SetAdjustmentLayerType(ret, type);
+	SetAdjustmentLayerTarget(ret, target);
+
+	return ret;
+}
+
+/*
+* ReleaseAdjustmentLayer関数
+* 調整レイヤーのメモリを開放する
+* 引数
+* layer	: 調整レイヤー
+*/
+void ReleaseAdjustmentLayer(ADJUSTMENT_LAYER** layer)
+{
+	if(layer == NULL || *layer == NULL)
+	{
+		return;
+	}
+
+	ReleaseAdjustmentLayerCache(*layer);
+	MEM_FREE_FUNC(*layer);
+	*layer = NULL;
+}
+
+/*
+* SetAdjustmentLayerType
+* 調整レイヤーのモードを設定
+* 引数
+* layer			: 調整レイヤー
+* type			; 調整レイヤーのタイプ
+*/
+void SetAdjustmentLayerType(
+	ADJUSTMENT_LAYER* layer,
+	eADJUSTMENT_LAYER_TYPE type
+)
+{
+	if((int)type < 0 || type >= NUM_ADJUSTMENT_LAYER_TYPE)
+	{
+		type = ADJUSTMENT_LAYER_TYPE_BRIGHT_CONTRAST;
+	}
+
+	// タイプが変わればパラメータを初期化する(結果はまとめた変換の違いで作り直される)
+	if(layer->type != type)
+	{
+		layer->type = (uint8)type;
+		SetAdjustmentLayerDefaults(layer);
+	}
+
+	layer->initialize = InitializeAdjustmentLayerCache;
+	layer->release = ReleaseAdjustmentLayerCache;
+	layer->update = UpdateAdjustmentLayerTiles;
+
+	// 調整結果が変わるので所属するレイヤーセットを合成し直す
+	InvalidateLayerSetCache(layer->self, 0, 0, 0, 0);
+
+	switch(type)
+	{
+	case ADJUSTMENT_LAYER_TYPE_HUE_SATURATION:
+		layer->filter_func = HueSaturationFilter;
+		break;
+	default:
+		layer->filter_func = LUTFilter;
+	}
+}
+
+/*
+* SetAdjustmentLayerTarget関数
+* 調整レイヤーを適用する相手を設定
+* layer		: 調整レイヤー
+* target	: 調整レイヤーが適用する相手(直下のレイヤー/下のレイヤーの統合)
+*/
+void SetAdjustmentLayerTarget(ADJUSTMENT_LAYER* layer, eADJUSTMENT_LAYER_TARGET target)
+{
+	if((int)target < 0 || target >= NUM_ADJUSTMENT_LAYER_TARGET)
+	{
+		target = ADJUSTMENT_LAYER_TARGET_UNDER_LAYER;
+	}
+
+	// 入力が別のレイヤーになるので次の更新で全体をコピーし直す
+	if(layer->target != target)
+	{
+		ReleaseAdjustmentLayerCache(layer);
+		InvalidateLayerSetCache(layer->self, 0, 0, 0, 0);
+	}
+	layer->target = (uint8)target;
+}
+
+#ifdef __cplusplus
+}
+#endif
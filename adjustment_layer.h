@@ -8,6 +8,10 @@ typedef enum _eADJUSTMENT_LAYER_TYPE
 {
 	ADJUSTMENT_LAYER_TYPE_BRIGHT_CONTRAST,
 	ADJUSTMENT_LAYER_TYPE_HUE_SATURATION,
+	ADJUSTMENT_LAYER_TYPE_LEVELS,
+	ADJUSTMENT_LAYER_TYPE_CURVES,
+	ADJUSTMENT_LAYER_TYPE_GRADIENT_MAP,
+	ADJUSTMENT_LAYER_TYPE_COLOR_BALANCE,
 	NUM_ADJUSTMENT_LAYER_TYPE
 } eADJUSTMENT_LAYER_TYPE;
 
@@ -18,6 +22,67 @@ typedef enum _eADJUSTMENT_LAYER_TARGET
 	NUM_ADJUSTMENT_LAYER_TARGET
 } eADJUSTMENT_LAYER_TARGET;
 
+// レベル補正・トーンカーブのチャンネル(0は全チャンネル共通)
+typedef enum _eADJUSTMENT_LAYER_CHANNEL
+{
+	ADJUSTMENT_LAYER_CHANNEL_MASTER,
+	ADJUSTMENT_LAYER_CHANNEL_RED,
+	ADJUSTMENT_LAYER_CHANNEL_GREEN,
+	ADJUSTMENT_LAYER_CHANNEL_BLUE,
+	NUM_ADJUSTMENT_LAYER_CHANNEL
+} eADJUSTMENT_LAYER_CHANNEL;
+
+// トーンカーブの制御点の最大数
+#define ADJUSTMENT_CURVE_MAX_POINTS 16
+// グラデーションマップの色の最大数
+#define ADJUSTMENT_GRADIENT_MAX_COLORS 8
+// 1回の処理にまとめる調整レイヤーの最大数
+#define ADJUSTMENT_PIPELINE_MAX_STAGES 16
+
+/*****************************************************************
+* ADJUSTMENT_PIPELINE構造体										 *
+* 連続する調整レイヤーの変換をまとめた1ピクセル分の処理		   *
+*  チャンネル毎のテーブル→(あれば)輝度からの色の決定の順に適用 *
+*****************************************************************/
+typedef struct _ADJUSTMENT_PIPELINE
+{
+	// チャンネル毎の変換テーブル(ピクセルデータと同じチャンネル順)
+	uint8 lut[3][256];
+	// 変換後の輝度から色を決めるテーブル(グラデーションマップがある時のみ)
+	uint8 gradient[3][256];
+	int has_gradient;
+	// 色相・彩度: 色相のずれと彩度・明度の変換テーブル
+	int hue;
+	uint8 saturation[256];
+	uint8 value[256];
+} ADJUSTMENT_PIPELINE;
+
+/*************************************************
+* ADJUSTMENT_LAYER_CACHE構造体					 *
+* 調整レイヤーの入力と結果をタイル単位で管理する *
+*************************************************/
+typedef struct _ADJUSTMENT_LAYER_CACHE
+{
+	// 入力にしているレイヤー
+	struct _LAYER *source;
+	// 入力の種類(直下のレイヤー or 下のレイヤーの合成結果)
+	uint8 source_target;
+	// 前回の入力のコピー(変化したタイルの検出用)
+	uint8 *input;
+	// タイル毎の結果が最新ならTRUE
+	uint8 *valid;
+	// タイル毎のチャンネル合計(ピクセルデータと同じ順に4つずつ)
+	uint64 *tile_sums;
+	// 入力全体のチャンネル合計(タイル毎の合計の差分で更新)
+	uint64 sums[4];
+	// 入力の幅、高さ、横方向・縦方向のタイル数
+	int width, height;
+	int tile_columns, tile_rows;
+	// 前回タイルに適用した処理
+	ADJUSTMENT_PIPELINE pipeline;
+	int pipeline_valid;
+} ADJUSTMENT_LAYER_CACHE;
+
 typedef struct _ADJUSTMENT_LAYER
 {
 	uint8 type;
@@ -31,28 +96,81 @@ typedef struct _ADJUSTMENT_LAYER
 		{
 			int bright;
 			int contrast;
-			uint8 *pixels;
-			uint64 sum_r, sum_g, sum_b, sum_a;
 		} bright_contrast;
 		
 		struct
 		{
 			int h, s, v;
 		} hue_saturation;
+
+		// 入力の黒・白の点、ガンマ(100で1.0)、出力の黒・白の点
+		struct
+		{
+			uint8 input_black[NUM_ADJUSTMENT_LAYER_CHANNEL];
+			uint8 input_white[NUM_ADJUSTMENT_LAYER_CHANNEL];
+			uint8 output_black[NUM_ADJUSTMENT_LAYER_CHANNEL];
+			uint8 output_white[NUM_ADJUSTMENT_LAYER_CHANNEL];
+			int16 gamma[NUM_ADJUSTMENT_LAYER_CHANNEL];
+		} levels;
+
+		// 制御点(入力, 出力)の組 制御点が無いチャンネルは変換しない
+		struct
+		{
+			uint8 num_points[NUM_ADJUSTMENT_LAYER_CHANNEL];
+			uint8 points[NUM_ADJUSTMENT_LAYER_CHANNEL][ADJUSTMENT_CURVE_MAX_POINTS][2];
+		} curves;
+
+		// 輝度の位置とRGBの色
+		struct
+		{
+			uint8 num_colors;
+			uint8 positions[ADJUSTMENT_GRADIENT_MAX_COLORS];
+			uint8 colors[ADJUSTMENT_GRADIENT_MAX_COLORS][3];
+		} gradient_map;
+
+		// シャドウ・中間調・ハイライト毎のシアン-レッド、マゼンタ-グリーン、イエロー-ブルー(-100～100)
+		struct
+		{
+			int8 shadows[3];
+			int8 midtones[3];
+			int8 highlights[3];
+		} color_balance;
 	} filter_data;
 
 	void (*initialize)(struct _ADJUSTMENT_LAYER* layer, struct _LAYER* target,struct _LAYER* mixed);
 	void (*release)(struct _ADJUSTMENT_LAYER* layer);
+	// 範囲内で入力が変わったタイルだけ調整結果を作り直す
 	void (*update)(struct _ADJUSTMENT_LAYER* layer, struct _LAYER* target, struct _LAYER* mixed,
 		int start_x, int start_y, int width, int height);
+	// 1行分のピクセルにまとめた変換を適用する
 	void (*filter_func)(struct _ADJUSTMENT_LAYER* layer, uint8* input, uint8* output,
 		unsigned int length, struct _LAYER* target);
+
+	ADJUSTMENT_LAYER_CACHE cache;
 } ADJUSTMENT_LAYER;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/****************************************************************
+* CreateAdjustmentLayer関数									   *
+* 調整レイヤーのデータを作成する								   *
+* 引数														   *
+* type			: 調整レイヤーのタイプ						   *
+* target		: 調整レイヤーを適用する相手					   *
+* target_layer	: 直下のレイヤー								   *
+* self			: 調整結果を入れるレイヤー					   *
+* 返り値														   *
+*	初期化された構造体のアドレス								   *
+****************************************************************/
+EXTERN ADJUSTMENT_LAYER* CreateAdjustmentLayer(
+	eADJUSTMENT_LAYER_TYPE type,
+	eADJUSTMENT_LAYER_TARGET target,
+	struct _LAYER* target_layer,
+	struct _LAYER* self
+);
+
 /*********************************
 * ReleaseAdjustmentLayer関数	 *
 * 調整レイヤーのメモリを開放する *
@@ -118,6 +118,8 @@ struct _APPLICATION
 	DISPLAY_FILTER display_filter;
 	
 	GRAPHICS graphics;
+	// ベクトルスクリプト実行用のLuaの状態
+	VECTOR_SCRIPT_STATE_POOL vector_script_pool;
 
 	// UIに表示する文字列
 	APPLICATION_LABELS *labels;
@@ -134,6 +136,9 @@ struct _APPLICATION
 	// 初期化用ファイルパス
 	char *common_tool_file_path;
 	char *brush_file_path;
+
+	// 入力イベントの再生で処理時間を計測中のデータ(通常はNULL)
+	struct _STROKE_REPLAY *stroke_replay;
 };
 
 #ifdef __cplusplus
@@ -151,6 +156,34 @@ extern "C" {
 */
 EXTERN void InitializeApplication(APPLICATION* app, char** argv, int argc, char* init_file_name);
 
+/*
+* ExecuteStrokeReplayMode関数
+* ウィンドウを表示せずに文書を開き、記録された入力イベントを再生して処理時間を表示する
+*  コマンドライン: --replay-stroke 文書ファイル イベントファイル [--brush ブラシ名]
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+* argv	: main関数の第一引数
+* argc	: main関数の第二引数
+* 返り値
+*	正常終了:0	失敗:0以外
+*/
+EXTERN int ExecuteStrokeReplayMode(APPLICATION* app, char** argv, int argc);
+
+/*
+* ExecuteBatchExportMode関数
+* ウィンドウを表示せずに複数の文書をPNGファイルに書き出し、処理時間を表示する
+*  メモリ使用量の上限内で複数の文書を同時に処理する
+*  コマンドライン: --batch-export [--output 出力先フォルダ] [--jobs 同時処理数]
+*		[--memory-mb 上限(MB)] [--compression 圧縮レベル] [--png-filter fast|all] 文書ファイル...
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+* argv	: main関数の第一引数
+* argc	: main関数の第二引数
+* 返り値
+*	全て成功:0	失敗有り:0以外
+*/
+EXTERN int ExecuteBatchExportMode(APPLICATION* app, char** argv, int argc);
+
 /*
 * ReadInitializeFile関数
 * 初期化ファイルを読み込む
@@ -0,0 +1,282 @@
+// Visual Studio 2005以降では古いとされる関数を使用するので
+	// 警告が出ないようにする
+#if defined _MSC_VER && _MSC_VER >= 1400
+# define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include "batch_export.h"
+#include "application.h"
+#include "display.h"
+#include "stroke_replay.h"
+#include "utils.h"
+#include "memory.h"
+#include "image_file/image_file.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* EstimateBatchExportMemory関数
+* ファイルのヘッダから書き出しに必要なメモリ量を見積もる
+* 引数
+* file_path	: 読み込むファイルのパス(.kab/.png)
+* 返り値
+*	見積もったバイト数 読み込めないファイルは0
+*/
+size_t EstimateBatchExportMemory(const char* file_path)
+{
+	const char format_string[] = "Paint Soft KABURAGI";
+	const uint8 png_signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+	uint8 header[24];
+	size_t file_size;
+	size_t ret = 0;
+	FILE *fp;
+
+	if((fp = fopen(file_path, "rb")) == NULL)
+	{
+		return 0;
+	}
+	(void)fseek(fp, 0, SEEK_END);
+	file_size = ftell(fp);
+	rewind(fp);
+
+	if(fread(header, 1, sizeof(header), fp) == sizeof(header))
+	{
+		if(memcmp(header, png_signature, sizeof(png_signature)) == 0)
+		{	// IHDRの幅と高さ(ビッグエンディアン)
+			size_t width = ((size_t)header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+			size_t height = ((size_t)header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+			width += (4 - (width % 4)) % 4;
+			height += (4 - (height % 4)) % 4;
+			// 展開したピクセルデータとレイヤー1枚分
+			ret = file_size + width * height * 4 * (BATCH_EXPORT_CANVAS_BUFFERS + 2);
+		}
+		else if(memcmp(header, format_string, sizeof(format_string)) == 0)
+		{	// ReadOriginalFormatと同じ順番でヘッダを読む
+			uint32 skip_bytes;
+			uint8 has_thumbnail;
+			uint8 channel, color_mode;
+			int32 original_width, original_height;
+			int32 width, height;
+			uint16 num_layer;
+
+			(void)fseek(fp, sizeof(format_string) + sizeof(uint32), SEEK_SET);
+			(void)fread(&has_thumbnail, sizeof(has_thumbnail), 1, fp);
+			if(has_thumbnail)
+			{
+				(void)fread(&skip_bytes, sizeof(skip_bytes), 1, fp);
+				(void)fseek(fp, skip_bytes, SEEK_CUR);
+			}
+			(void)fread(&channel, sizeof(channel), 1, fp);
+			(void)fread(&color_mode, sizeof(color_mode), 1, fp);
+			(void)fread(&original_width, sizeof(original_width), 1, fp);
+			(void)fread(&original_height, sizeof(original_height), 1, fp);
+			(void)fread(&width, sizeof(width), 1, fp);
+			(void)fread(&height, sizeof(height), 1, fp);
+			if(fread(&num_layer, sizeof(num_layer), 1, fp) == 1 && width > 0 && height > 0)
+			{	// ファイル全体をメモリに読み込んでから展開する
+				ret = file_size + (size_t)width * height * 4 * (BATCH_EXPORT_CANVAS_BUFFERS + num_layer);
+			}
+		}
+	}
+
+	(void)fclose(fp);
+
+	return ret;
+}
+
+/*
+* DeleteBatchExportCanvas関数
+* ウィジェットを作らずに読み込んだキャンバスを開放する
+* 引数
+* canvas	: 開放するキャンバス
+*/
+static void DeleteBatchExportCanvas(DRAW_WINDOW* canvas)
+{
+	LAYER **buffers[] = {&canvas->disp_temp, &canvas->under_active, &canvas->temp_layer,
+		&canvas->mixed_layer, &canvas->disp_layer, &canvas->scaled_mixed, &canvas->anti_alias,
+		&canvas->selection, &canvas->effect, &canvas->texture, &canvas->mask, &canvas->mask_temp};
+	LAYER *layer, *next;
+	int i;
+
+	// レイヤーセットの合成結果を参照するので下のレイヤーから削除する
+	for(layer = canvas->layer; layer != NULL; layer = next)
+	{
+		next = layer->next;
+		DeleteLayer(&layer);
+	}
+	canvas->layer = canvas->active_layer = NULL;
+
+	for(i=0; i<(int)(sizeof(buffers)/sizeof(*buffers)); i++)
+	{
+		DeleteLayer(buffers[i]);
+	}
+	// DeleteLayerで作業用レイヤーを初期化するので最後に削除する
+	DeleteLayer(&canvas->work_layer);
+
+	ReleaseDisplayIccTransform(canvas);
+	ReleaseCanvasContext(canvas);
+	MEM_FREE_FUNC(canvas->back_ground);
+	MEM_FREE_FUNC(canvas->brush_buffer);
+	MEM_FREE_FUNC(canvas->alpha_lock);
+	MEM_FREE_FUNC(canvas->file_name);
+	MEM_FREE_FUNC(canvas->file_path);
+	MEM_FREE_FUNC(canvas);
+}
+
+/*
+* UnpremultiplyForPNG関数
+* 合成結果(乗算済みアルファのBGRA)をPNG用のRGBAに変換する
+* 引数
+* pixels	: 変換するピクセルデータ
+* width		: 画像の幅
+* height	: 画像の高さ
+* stride	: 1行分のバイト数
+*/
+static void UnpremultiplyForPNG(uint8* pixels, int width, int height, int stride)
+{
+	int x, y;
+
+	for(y=0; y<height; y++)
+	{
+		uint8 *p = &pixels[y*stride];
+		for(x=0; x<width; x++, p += 4)
+		{
+			unsigned int blue = p[0], green = p[1], red = p[2], alpha = p[3];
+
+			if(alpha == 0)
+			{
+				p[0] = p[1] = p[2] = 0;
+			}
+			else if(alpha == 0xFF)
+			{
+				p[0] = (uint8)red,	p[2] = (uint8)blue;
+			}
+			else
+			{
+				red = (red * 255 + alpha / 2) / alpha;
+				green = (green * 255 + alpha / 2) / alpha;
+				blue = (blue * 255 + alpha / 2) / alpha;
+				p[0] = (uint8)((red > 0xFF) ? 0xFF : red);
+				p[1] = (uint8)((green > 0xFF) ? 0xFF : green);
+				p[2] = (uint8)((blue > 0xFF) ? 0xFF : blue);
+			}
+		}
+	}
+}
+
+/*
+* Flush関数
+* PNGの書き出し関数に渡すためのfflushのラッパー
+* 引数
+* fp	: 書き出し先のファイル
+*/
+static void Flush(void* fp)
+{
+	(void)fflush((FILE*)fp);
+}
+
+/*
+* ExportDocumentToPNG関数
+* 文書を読み込み、レイヤーを合成してPNGファイルに書き出す
+*  キャンバスのウィジェットを作らないので複数のスレッドから同時に呼び出せる
+* 引数
+* app			: アプリケーション全体を管理する構造体のアドレス
+* item			: 書き出す文書(計測結果もここに入る)
+* compression	: 圧縮レベル
+* filter		: 行毎に試すPNGのフィルタの範囲
+* 返り値
+*	成功:TRUE	失敗:FALSE
+*/
+int ExportDocumentToPNG(
+	APPLICATION* app,
+	BATCH_EXPORT_ITEM* item,
+	int compression,
+	ePNG_STREAM_FILTER filter
+)
+{
+	DRAW_WINDOW *canvas;
+	LAYER *mixed;
+	FILE *fp;
+	double start_time, flatten_start_time, write_start_time;
+
+	item->load_time = item->flatten_time = item->write_time = 0;
+	item->result = FALSE;
+
+	start_time = GetStrokeReplayTime();
+	canvas = ReadImageFile(app, item->input_path);
+	flatten_start_time = GetStrokeReplayTime();
+	item->load_time = flatten_start_time - start_time;
+	if(canvas == NULL)
+	{
+		return FALSE;
+	}
+
+	mixed = MixLayerForSave(canvas);
+	UnpremultiplyForPNG(mixed->pixels, canvas->original_width, canvas->original_height, mixed->stride);
+	write_start_time = GetStrokeReplayTime();
+	item->flatten_time = write_start_time - flatten_start_time;
+
+	if((fp = fopen(item->output_path, "wb")) != NULL)
+	{	// 4の倍数に広げる前の大きさで書き出す
+		if(WritePNGStreamParallel((void*)fp, (stream_func_t)fwrite, Flush,
+			mixed->pixels, canvas->original_width, canvas->original_height, mixed->stride, 4,
+				compression, filter) == FALSE)
+		{
+			WritePNGStream((void*)fp, (stream_func_t)fwrite, Flush,
+				mixed->pixels, canvas->original_width, canvas->original_height, mixed->stride, 4,
+					FALSE, compression);
+		}
+		item->result = (ferror(fp) == 0);
+		item->result = (fclose(fp) == 0) && item->result;
+	}
+	item->write_time = GetStrokeReplayTime() - write_start_time;
+
+	DeleteLayer(&mixed);
+	DeleteBatchExportCanvas(canvas);
+
+	return item->result;
+}
+
+/*
+* PrintBatchExportResult関数
+* 文書毎の処理時間と合計を出力する
+* 引数
+* items			: 書き出した文書の配列
+* num_items		: 配列の要素数
+* total_time	: 全体の経過時間(秒)
+* fp			: 出力先
+*/
+void PrintBatchExportResult(BATCH_EXPORT_ITEM* items, int num_items, double total_time, FILE* fp)
+{
+	double load_time = 0, flatten_time = 0, write_time = 0;
+	int num_failed = 0;
+	int i;
+
+	for(i=0; i<num_items; i++)
+	{
+		(void)fprintf(fp, "%-6s load %8.1f ms  flatten %8.1f ms  write %8.1f ms  %s\n",
+			(items[i].result != FALSE) ? "ok" : "FAILED", items[i].load_time * 1000,
+				items[i].flatten_time * 1000, items[i].write_time * 1000, items[i].input_path);
+		load_time += items[i].load_time;
+		flatten_time += items[i].flatten_time;
+		write_time += items[i].write_time;
+		if(items[i].result == FALSE)
+		{
+			num_failed++;
+		}
+	}
+
+	(void)fprintf(fp, "files    %10d (%d failed)\n", num_items, num_failed);
+	(void)fprintf(fp, "load     %10.3f ms\n", load_time * 1000);
+	(void)fprintf(fp, "flatten  %10.3f ms\n", flatten_time * 1000);
+	(void)fprintf(fp, "write    %10.3f ms\n", write_time * 1000);
+	(void)fprintf(fp, "total    %10.3f ms\n", total_time * 1000);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef _INCLUDED_BATCH_EXPORT_H_
+#define _INCLUDED_BATCH_EXPORT_H_
+
+#include <stdio.h>
+#include "types.h"
+#include "image_file/png_file.h"
+
+// 同時に処理する文書のメモリ使用量の上限の既定値(MB)
+#define BATCH_EXPORT_DEFAULT_MEMORY_MB 2048
+// PNGの圧縮レベルの既定値(メニューからの保存と同じ)
+#define BATCH_EXPORT_DEFAULT_COMPRESSION 5
+// キャンバス作成時に確保される作業用バッファと合成結果の概算(4チャンネルのレイヤー換算)
+#define BATCH_EXPORT_CANVAS_BUFFERS 18
+
+/*
+* BATCH_EXPORT_ITEM構造体
+* 一括書き出しする文書1つ分の設定と計測結果
+*/
+typedef struct _BATCH_EXPORT_ITEM
+{
+	// 読み込むファイルと書き出すPNGファイルのパス
+	char *input_path;
+	char *output_path;
+	// 処理に必要なメモリの見積もり(バイト)
+	size_t estimated_bytes;
+	// 段階毎の処理時間(秒)
+	double load_time;
+	double flatten_time;
+	double write_time;
+	// 成功:TRUE	失敗:FALSE
+	int result;
+} BATCH_EXPORT_ITEM;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* EstimateBatchExportMemory関数
+* ファイルのヘッダから書き出しに必要なメモリ量を見積もる
+* 引数
+* file_path	: 読み込むファイルのパス(.kab/.png)
+* 返り値
+*	見積もったバイト数 読み込めないファイルは0
+*/
+EXTERN size_t EstimateBatchExportMemory(const char* file_path);
+
+/*
+* ExportDocumentToPNG関数
+* 文書を読み込み、レイヤーを合成してPNGファイルに書き出す
+*  キャンバスのウィジェットを作らないので複数のスレッドから同時に呼び出せる
+* 引数
+* app			: アプリケーション全体を管理する構造体のアドレス
+* item			: 書き出す文書(計測結果もここに入る)
+* compression	: 圧縮レベル
+* filter		: 行毎に試すPNGのフィルタの範囲
+* 返り値
+*	成功:TRUE	失敗:FALSE
+*/
+EXTERN int ExportDocumentToPNG(
+	struct _APPLICATION* app,
+	BATCH_EXPORT_ITEM* item,
+	int compression,
+	ePNG_STREAM_FILTER filter
+);
+
+/*
+* PrintBatchExportResult関数
+* 文書毎の処理時間と合計を出力する
+* 引数
+* items			: 書き出した文書の配列
+* num_items		: 配列の要素数
+* total_time	: 全体の経過時間(秒)
+* fp			: 出力先
+*/
+EXTERN void PrintBatchExportResult(BATCH_EXPORT_ITEM* items, int num_items, double total_time, FILE* fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _INCLUDED_BATCH_EXPORT_H_
@@ -0,0 +1,92 @@
+/*
+* benchmark_common.h
+* 計測用コンソールプログラムで共通に使う時刻の取得と処理時間の集計
+*/
+
+#ifndef _INCLUDED_BENCHMARK_COMMON_H_
+#define _INCLUDED_BENCHMARK_COMMON_H_
+
+#include "../types.h"
+
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* BENCHMARK_TIME構造体
+* 1項目分の処理時間の集計
+*/
+typedef struct _BENCHMARK_TIME
+{
+	double best_seconds;	// 最速の処理時間
+	double total_seconds;	// 合計処理時間
+	int iterations;			// 計測回数
+} BENCHMARK_TIME;
+
+/*
+* GetBenchmarkTime関数
+* 単調増加する現在時刻を秒単位で取得する
+* 返り値
+*	現在時刻(秒)
+*/
+static INLINE double GetBenchmarkTime(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+	(void)QueryPerformanceFrequency(&frequency);
+	(void)QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1.0e-9;
+#endif
+}
+
+/*
+* AddBenchmarkTime関数
+* 1回分の処理時間を集計に加える
+* 引数
+* time		: 処理時間の集計
+* start		: GetBenchmarkTimeで取得した計測開始時刻
+* 返り値
+*	今回の処理時間(秒)
+*/
+static INLINE double AddBenchmarkTime(BENCHMARK_TIME* time, double start)
+{
+	double elapsed = GetBenchmarkTime() - start;
+
+	if(time->iterations == 0 || elapsed < time->best_seconds)
+	{
+		time->best_seconds = elapsed;
+	}
+	time->total_seconds += elapsed;
+	time->iterations++;
+
+	return elapsed;
+}
+
+/*
+* GetBenchmarkAverageTime関数
+* 平均の処理時間を取得する
+* 引数
+* time	: 処理時間の集計
+* 返り値
+*	平均の処理時間(秒)
+*/
+static INLINE double GetBenchmarkAverageTime(const BENCHMARK_TIME* time)
+{
+	return (time->iterations > 0) ? time->total_seconds / time->iterations : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _INCLUDED_BENCHMARK_COMMON_H_
@@ -0,0 +1,488 @@
+/*
+* graphics_benchmark.c
+* 描画エンジン(graphics/)の処理速度を計測するコンソールプログラム
+*  ブラシの円形ダブ・吹き出しの輪郭・矩形の塗りつぶし・レイヤー合成を
+*  4K/8Kのサーフェースに対して実行し、1秒あたりの処理回数と処理したピクセル数、
+*  塗りつぶしが矩形の高速処理で済んだ回数を表示する
+* 使い方
+*	graphics_benchmark [繰り返し回数] [4k|8k|all]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../graphics/graphics.h"
+#include "../graphics/graphics_context.h"
+#include "../graphics/graphics_pattern.h"
+#include "../graphics/graphics_surface.h"
+#include "../memory.h"
+#include "benchmark_common.h"
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 繰り返し回数を指定しなかった時の値
+#define BENCHMARK_DEFAULT_ITERATIONS 5
+// 1回の計測で描画するブラシのダブの数
+#define BENCHMARK_BRUSH_DABS 20000
+// 1回の計測で描画する吹き出しの数
+#define BENCHMARK_BALLOONS 500
+// 1回の計測で塗りつぶす矩形の数
+#define BENCHMARK_RECTANGLES 5000
+// 吹き出しの輪郭の線幅
+#define BENCHMARK_BALLOON_LINE_WIDTH 4.0
+
+/*
+* BENCHMARK_SURFACE構造体
+* 計測用の描画先(レイヤーと同じ構成)
+*/
+typedef struct _BENCHMARK_SURFACE
+{
+	uint8 *pixels;
+	int width, height, stride;
+	GRAPHICS_IMAGE_SURFACE surface;
+	GRAPHICS_DEFAULT_CONTEXT context;
+} BENCHMARK_SURFACE;
+
+/*
+* BENCHMARK_RESULT構造体
+* 1項目分の計測結果
+*/
+typedef struct _BENCHMARK_RESULT
+{
+	const char *name;		// 計測項目名
+	BENCHMARK_TIME time;	// 処理時間
+	double operations;		// 1回あたりの描画命令数
+	double pixels;			// 1回あたりの処理ピクセル数
+	unsigned int fast_fills;	// 矩形の高速処理で済んだ塗りつぶしの回数
+	unsigned int general_fills;	// 通常の合成処理を行った塗りつぶしの回数
+} BENCHMARK_RESULT;
+
+/*
+* BenchmarkRandom関数
+* 計測毎に同じ結果になる疑似乱数を取得する
+* 引数
+* seed	: 乱数の状態
+* 返り値
+*	0～1の乱数
+*/
+static FLOAT_T BenchmarkRandom(uint32* seed)
+{
+	*seed = *seed * 1664525 + 1013904223;
+	return (FLOAT_T)(*seed >> 8) / (FLOAT_T)(1 << 24);
+}
+
+/*
+* InitializeBenchmarkSurface関数
+* 計測用の描画先を作成する
+* 引数
+* target	: 初期化する描画先
+* graphics	: 描画エンジンの設定
+* format	: ピクセルフォーマット
+* width		: 幅
+* height	: 高さ
+* 返り値
+*	成功:TRUE	失敗:FALSE
+*/
+static int InitializeBenchmarkSurface(
+	BENCHMARK_SURFACE* target,
+	GRAPHICS* graphics,
+	eGRAPHICS_FORMAT format,
+	int width,
+	int height
+)
+{
+	(void)memset(target, 0, sizeof(*target));
+	target->width = width,	target->height = height;
+	target->stride = GraphicsFormatStrideForWidth(format, width);
+	target->pixels = (uint8*)MEM_CALLOC_FUNC((size_t)target->stride * height, 1);
+	if(target->pixels == NULL)
+	{
+		return FALSE;
+	}
+	InitializeGraphicsImageSurfaceForData(&target->surface, target->pixels, format,
+		width, height, target->stride, graphics);
+	InitializeGraphicsDefaultContext(&target->context, &target->surface, graphics);
+
+	return TRUE;
+}
+
+/*
+* ReleaseBenchmarkSurface関数
+* 計測用の描画先を開放する
+* 引数
+* target	: 開放する描画先
+*/
+static void ReleaseBenchmarkSurface(BENCHMARK_SURFACE* target)
+{
+	if(target->pixels == NULL)
+	{
+		return;
+	}
+	GraphicsDefaultContextFinish(&target->context);
+	GraphicsSurfaceFinish(&target->surface.base);
+	MEM_FREE_FUNC(target->pixels);
+	target->pixels = NULL;
+}
+
+/*
+* FillBenchmarkPattern関数
+* 合成元にするため半透明のグラデーションを書き込む
+* 引数
+* target	: 書き込む描画先(ARGB32)
+* seed		: 模様を変える値
+*/
+static void FillBenchmarkPattern(BENCHMARK_SURFACE* target, int seed)
+{
+	int x, y;
+
+	for(y=0; y<target->height; y++)
+	{
+		uint8 *pixel = &target->pixels[y * target->stride];
+		for(x=0; x<target->width; x++, pixel+=4)
+		{
+			uint8 alpha = (uint8)((x + y + seed) & 0xFF);
+			pixel[0] = (uint8)((x * alpha) >> 8);
+			pixel[1] = (uint8)((y * alpha) >> 8);
+			pixel[2] = (uint8)(((x ^ y) * alpha) >> 8);
+			pixel[3] = alpha;
+		}
+	}
+}
+
+/*
+* BenchmarkBrushDabs関数
+* ブラシの円形のダブを大量に塗りつぶす
+* 引数
+* target	: 描画先
+* 返り値
+*	描画命令数
+*/
+static double BenchmarkBrushDabs(BENCHMARK_SURFACE* target)
+{
+	GRAPHICS_CONTEXT *context = &target->context.base;
+	uint32 seed = 1;
+	int i;
+
+	GraphicsSetOperator(context, GRAPHICS_OPERATOR_OVER);
+	for(i=0; i<BENCHMARK_BRUSH_DABS; i++)
+	{
+		FLOAT_T x = BenchmarkRandom(&seed) * target->width;
+		FLOAT_T y = BenchmarkRandom(&seed) * target->height;
+		// 小さいダブが多くなるように半径を偏らせる
+		FLOAT_T r = 1 + 63 * BenchmarkRandom(&seed) * BenchmarkRandom(&seed);
+
+		GraphicsSetSourceRGBA(context, BenchmarkRandom(&seed), BenchmarkRandom(&seed),
+			BenchmarkRandom(&seed), 0.1 + 0.9 * BenchmarkRandom(&seed));
+		GraphicsArc(context, x, y, r, 0, 2 * M_PI);
+		GraphicsFill(context);
+	}
+
+	return BENCHMARK_BRUSH_DABS;
+}
+
+/*
+* BenchmarkBalloons関数
+* 吹き出しの輪郭(楕円+しっぽ)を塗りつぶして線を描く
+* 引数
+* target	: 描画先
+* 返り値
+*	描画命令数
+*/
+static double BenchmarkBalloons(BENCHMARK_SURFACE* target)
+{
+	GRAPHICS_CONTEXT *context = &target->context.base;
+	uint32 seed = 2;
+	int i;
+
+	GraphicsSetOperator(context, GRAPHICS_OPERATOR_OVER);
+	GraphicsSetLineWidth(context, BENCHMARK_BALLOON_LINE_WIDTH);
+	GraphicsSetLineJoin(context, GRAPHICS_LINE_JOIN_ROUND);
+	GraphicsSetLineCap(context, GRAPHICS_LINE_CAP_ROUND);
+	for(i=0; i<BENCHMARK_BALLOONS; i++)
+	{
+		FLOAT_T x = BenchmarkRandom(&seed) * target->width;
+		FLOAT_T y = BenchmarkRandom(&seed) * target->height;
+		FLOAT_T width = 80 + 320 * BenchmarkRandom(&seed);
+		FLOAT_T height = 60 + 200 * BenchmarkRandom(&seed);
+		FLOAT_T tail_angle = 2 * M_PI * BenchmarkRandom(&seed);
+		FLOAT_T control_x = width * 0.5 * 0.5523, control_y = height * 0.5 * 0.5523;
+		FLOAT_T half_width = width * 0.5, half_height = height * 0.5;
+
+		// 楕円を4本のベジェ曲線で作り、しっぽを付ける
+		GraphicsMoveTo(context, x + half_width, y);
+		GraphicsCurveTo(context, x + half_width, y + control_y,
+			x + control_x, y + half_height, x, y + half_height);
+		GraphicsCurveTo(context, x - control_x, y + half_height,
+			x - half_width, y + control_y, x - half_width, y);
+		GraphicsCurveTo(context, x - half_width, y - control_y,
+			x - control_x, y - half_height, x, y - half_height);
+		GraphicsCurveTo(context, x + control_x, y - half_height,
+			x + half_width, y - control_y, x + half_width, y);
+		GraphicsClosePath(context);
+		GraphicsMoveTo(context, x + cos(tail_angle - 0.2) * half_width * 0.9,
+			y + sin(tail_angle - 0.2) * half_height * 0.9);
+		GraphicsLineTo(context, x + cos(tail_angle) * half_width * 1.6,
+			y + sin(tail_angle) * half_height * 1.6);
+		GraphicsLineTo(context, x + cos(tail_angle + 0.2) * half_width * 0.9,
+			y + sin(tail_angle + 0.2) * half_height * 0.9);
+		GraphicsClosePath(context);
+
+		GraphicsSetSourceRGB(context, 1, 1, 1);
+		GraphicsFillPreserve(context);
+		GraphicsSetSourceRGB(context, 0, 0, 0);
+		GraphicsStroke(context);
+	}
+
+	return BENCHMARK_BALLOONS * 2;
+}
+
+/*
+* BenchmarkRectangles関数
+* 選択範囲・レイヤーのクリア等と同じピクセル境界に揃った矩形を塗りつぶす
+* 引数
+* target	: 描画先
+* 返り値
+*	描画命令数
+*/
+static double BenchmarkRectangles(BENCHMARK_SURFACE* target)
+{
+	GRAPHICS_CONTEXT *context = &target->context.base;
+	uint32 seed = 3;
+	int i;
+
+	GraphicsSetOperator(context, GRAPHICS_OPERATOR_OVER);
+	for(i=0; i<BENCHMARK_RECTANGLES; i++)
+	{
+		FLOAT_T x = floor(BenchmarkRandom(&seed) * target->width);
+		FLOAT_T y = floor(BenchmarkRandom(&seed) * target->height);
+		FLOAT_T width = floor(1 + 511 * BenchmarkRandom(&seed));
+		FLOAT_T height = floor(1 + 511 * BenchmarkRandom(&seed));
+
+		GraphicsSetSourceRGBA(context, BenchmarkRandom(&seed), BenchmarkRandom(&seed),
+			BenchmarkRandom(&seed), (i & 1) ? 1.0 : 0.5);
+		GraphicsRectangle(context, x, y, width, height);
+		GraphicsFill(context);
+	}
+
+	return BENCHMARK_RECTANGLES;
+}
+
+/*
+* BenchmarkLayerBlend関数
+* 通常レイヤーの合成(不透明度付きの全面描画)を行う
+* 引数
+* target	: 合成先
+* source	: 合成元
+* 返り値
+*	描画命令数
+*/
+static double BenchmarkLayerBlend(BENCHMARK_SURFACE* target, BENCHMARK_SURFACE* source)
+{
+	GRAPHICS_SURFACE_PATTERN pattern = {0};
+
+	GraphicsSetOperator(&target->context.base, GRAPHICS_OPERATOR_OVER);
+	GraphicsSetSourceSurface(&target->context.base, &source->surface.base, 0, 0, &pattern);
+	GraphicsPaintWithAlpha(&target->context.base, 0.75);
+
+	return 1;
+}
+
+/*
+* BenchmarkMaskedBlend関数
+* 下のレイヤーでマスキングする合成(GraphicsMaskSurface)を行う
+* 引数
+* target	: 合成先
+* source	: 合成元
+* mask		: マスクに使うサーフェース
+* 返り値
+*	描画命令数
+*/
+static double BenchmarkMaskedBlend(
+	BENCHMARK_SURFACE* target,
+	BENCHMARK_SURFACE* source,
+	BENCHMARK_SURFACE* mask
+)
+{
+	GRAPHICS_SURFACE_PATTERN pattern = {0};
+
+	GraphicsSetOperator(&target->context.base, GRAPHICS_OPERATOR_OVER);
+	GraphicsSetSourceSurface(&target->context.base, &source->surface.base, 0, 0, &pattern);
+	GraphicsMaskSurface(&target->context.base, &mask->surface.base, 0, 0);
+
+	return 1;
+}
+
+/*
+* PrintBenchmarkResult関数
+* 計測結果を1行で表示する
+* 引数
+* result	: 表示する計測結果
+* label		: サイズ等の補足
+*/
+static void PrintBenchmarkResult(const BENCHMARK_RESULT* result, const char* label)
+{
+	double best = result->time.best_seconds;
+
+	(void)printf("%-14s %-4s best %9.3f ms  avg %9.3f ms  %12.1f ops/s",
+		result->name, label, best * 1000, GetBenchmarkAverageTime(&result->time) * 1000,
+			result->operations / best);
+	if(result->pixels > 0)
+	{
+		(void)printf("  %9.1f Mpix/s", result->pixels / best * 1.0e-6);
+	}
+	if(result->fast_fills + result->general_fills > 0)
+	{
+		(void)printf("  fast fills %u/%u", result->fast_fills,
+			result->fast_fills + result->general_fills);
+	}
+	(void)printf("\n");
+}
+
+/*
+* RunBenchmarkSize関数
+* 1つのキャンバスサイズについて全ての項目を計測する
+* 引数
+* graphics		: 描画エンジンの設定
+* width			: キャンバスの幅
+* height		: キャンバスの高さ
+* label			: サイズの表示名
+* iterations	: 繰り返し回数
+* 返り値
+*	成功:TRUE	失敗:FALSE
+*/
+static int RunBenchmarkSize(
+	GRAPHICS* graphics,
+	int width,
+	int height,
+	const char* label,
+	int iterations
+)
+{
+	enum
+	{
+		BENCHMARK_BRUSH,
+		BENCHMARK_BALLOON,
+		BENCHMARK_RECTANGLE,
+		BENCHMARK_BLEND,
+		BENCHMARK_MASKED_BLEND,
+		NUM_BENCHMARK
+	};
+	BENCHMARK_RESULT results[NUM_BENCHMARK] =
+	{
+		{"brush dabs"},
+		{"balloons"},
+		{"rectangles"},
+		{"layer blend"},
+		{"masked blend"}
+	};
+	BENCHMARK_SURFACE target, source, mask;
+	int i, j;
+
+	if(InitializeBenchmarkSurface(&target, graphics, GRAPHICS_FORMAT_ARGB32, width, height) == FALSE
+		|| InitializeBenchmarkSurface(&source, graphics, GRAPHICS_FORMAT_ARGB32, width, height) == FALSE
+		|| InitializeBenchmarkSurface(&mask, graphics, GRAPHICS_FORMAT_ARGB32, width, height) == FALSE)
+	{
+		(void)fprintf(stderr, "%s: failed to allocate %dx%d surfaces\n", label, width, height);
+		ReleaseBenchmarkSurface(&target);
+		ReleaseBenchmarkSurface(&source);
+		ReleaseBenchmarkSurface(&mask);
+		return FALSE;
+	}
+	FillBenchmarkPattern(&source, 0);
+	FillBenchmarkPattern(&mask, 128);
+
+	for(i=0; i<iterations; i++)
+	{
+		for(j=0; j<NUM_BENCHMARK; j++)
+		{
+			GRAPHICS_FILL_STATISTICS statistics;
+			double start;
+
+			(void)memset(target.pixels, 0, (size_t)target.stride * target.height);
+			GraphicsResetFillStatistics(graphics);
+			start = GetBenchmarkTime();
+			switch(j)
+			{
+			case BENCHMARK_BRUSH:
+				results[j].operations = BenchmarkBrushDabs(&target);
+				break;
+			case BENCHMARK_BALLOON:
+				results[j].operations = BenchmarkBalloons(&target);
+				break;
+			case BENCHMARK_RECTANGLE:
+				results[j].operations = BenchmarkRectangles(&target);
+				break;
+			case BENCHMARK_BLEND:
+				results[j].operations = BenchmarkLayerBlend(&target, &source);
+				results[j].pixels = (double)width * height;
+				break;
+			case BENCHMARK_MASKED_BLEND:
+				results[j].operations = BenchmarkMaskedBlend(&target, &source, &mask);
+				results[j].pixels = (double)width * height;
+				break;
+			}
+			(void)AddBenchmarkTime(&results[j].time, start);
+			GraphicsGetFillStatistics(graphics, &statistics);
+			results[j].fast_fills += statistics.solid_fills + statistics.blit_fills;
+			results[j].general_fills += statistics.general_fills;
+		}
+	}
+
+	for(j=0; j<NUM_BENCHMARK; j++)
+	{
+		PrintBenchmarkResult(&results[j], label);
+	}
+
+	ReleaseBenchmarkSurface(&target);
+	ReleaseBenchmarkSurface(&source);
+	ReleaseBenchmarkSurface(&mask);
+
+	return TRUE;
+}
+
+int main(int argc, char** argv)
+{
+	GRAPHICS graphics = {0};
+	int iterations = BENCHMARK_DEFAULT_ITERATIONS;
+	const char *size = "all";
+	int result = TRUE;
+
+	if(argc > 1)
+	{
+		iterations = atoi(argv[1]);
+		if(iterations <= 0)
+		{
+			(void)fprintf(stderr, "usage: %s [iterations] [4k|8k|all]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(argc > 2)
+	{
+		size = argv[2];
+	}
+
+	InitializeGraphics(&graphics);
+
+	(void)printf("graphics benchmark (%d iterations)\n", iterations);
+	if(strcmp(size, "4k") == 0 || strcmp(size, "all") == 0)
+	{
+		result &= RunBenchmarkSize(&graphics, 3840, 2160, "4K", iterations);
+	}
+	if(strcmp(size, "8k") == 0 || strcmp(size, "all") == 0)
+	{
+		result &= RunBenchmarkSize(&graphics, 7680, 4320, "8K", iterations);
+	}
+
+	return (result != FALSE) ? 0 : 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
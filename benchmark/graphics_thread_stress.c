@@ -0,0 +1,382 @@
+/*
+* graphics_thread_stress.c
+* 描画エンジン(graphics/)を複数のスレッドから同時に使うストレステスト
+*  スレッド毎に別のサーフェースへ同じ手順で描画し、1スレッドで描画した結果と
+*  チェックサムが一致するかを確認する
+*  描画エンジンの設定を全スレッドで共有する場合と、スレッド毎に作成する場合の両方を試す
+* 使い方
+*	graphics_thread_stress [スレッド数] [繰り返し回数]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../graphics/graphics.h"
+#include "../graphics/graphics_context.h"
+#include "../graphics/graphics_pattern.h"
+#include "../graphics/graphics_surface.h"
+#include "../memory.h"
+#include "benchmark_common.h"
+
+#if !defined(_WIN32)
+# include <pthread.h>
+#endif
+
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// スレッド数を指定しなかった時の値
+#define STRESS_DEFAULT_THREADS 8
+// 繰り返し回数を指定しなかった時の値
+#define STRESS_DEFAULT_ROUNDS 20
+// 同時に動かせるスレッドの最大数
+#define STRESS_MAX_THREADS 64
+// 描画先のサイズ
+#define STRESS_SURFACE_SIZE 512
+// 1回の描画で塗りつぶす円の数
+#define STRESS_DABS 2000
+// 1回の描画で塗りつぶす矩形の数
+#define STRESS_RECTANGLES 300
+// 1回の描画で描く線の数
+#define STRESS_STROKES 100
+
+/*
+* STRESS_THREAD構造体
+* 1スレッド分の描画設定と結果
+*/
+typedef struct _STRESS_THREAD
+{
+	GRAPHICS *shared_graphics;	// NULLならスレッド内で描画エンジンの設定を作成する
+	uint32 seed;				// 描画内容を決める乱数の初期値
+	uint32 expected;			// 1スレッドで描画した時のチェックサム
+	int rounds;					// 繰り返し回数
+	int mismatches;				// チェックサムが一致しなかった回数
+	int failures;				// 描画先の作成に失敗した回数
+} STRESS_THREAD;
+
+/*
+* StressRandom関数
+* 描画毎に同じ結果になる疑似乱数を取得する
+* 引数
+* seed	: 乱数の状態
+* 返り値
+*	0～1の乱数
+*/
+static FLOAT_T StressRandom(uint32* seed)
+{
+	*seed = *seed * 1664525 + 1013904223;
+	return (FLOAT_T)(*seed >> 8) / (FLOAT_T)(1 << 24);
+}
+
+/*
+* RenderStressScene関数
+* 新しいサーフェースに円・矩形・線・画像の合成を描画してチェックサムを計算する
+* 引数
+* graphics	: 描画エンジンの設定
+* seed		: 描画内容を決める乱数の初期値
+* checksum	: チェックサムを受け取るアドレス
+* 返り値
+*	成功:TRUE	失敗:FALSE
+*/
+static int RenderStressScene(GRAPHICS* graphics, uint32 seed, uint32* checksum)
+{
+	GRAPHICS_IMAGE_SURFACE surface, source;
+	GRAPHICS_DEFAULT_CONTEXT context;
+	GRAPHICS_SURFACE_PATTERN pattern = {0};
+	GRAPHICS_CONTEXT *cr = &context.base;
+	const int size = STRESS_SURFACE_SIZE;
+	int stride = GraphicsFormatStrideForWidth(GRAPHICS_FORMAT_ARGB32, size);
+	uint8 *pixels, *source_pixels;
+	uint32 hash = 2166136261u;
+	int i;
+
+	pixels = (uint8*)MEM_CALLOC_FUNC((size_t)stride * size, 1);
+	source_pixels = (uint8*)MEM_CALLOC_FUNC((size_t)stride * size, 1);
+	if(pixels == NULL || source_pixels == NULL)
+	{
+		MEM_FREE_FUNC(pixels);
+		MEM_FREE_FUNC(source_pixels);
+		return FALSE;
+	}
+	for(i=0; i<stride * size; i+=4)
+	{
+		uint8 alpha = (uint8)((i / 4 + seed) & 0xFF);
+		source_pixels[i] = source_pixels[i+1] = source_pixels[i+2] = (uint8)((alpha * (i & 0x7F)) >> 7);
+		source_pixels[i+3] = alpha;
+	}
+
+	InitializeGraphicsImageSurfaceForData(&surface, pixels, GRAPHICS_FORMAT_ARGB32,
+		size, size, stride, graphics);
+	InitializeGraphicsImageSurfaceForData(&source, source_pixels, GRAPHICS_FORMAT_ARGB32,
+		size, size, stride, graphics);
+	InitializeGraphicsDefaultContext(&context, &surface, graphics);
+
+	GraphicsSetOperator(cr, GRAPHICS_OPERATOR_OVER);
+	for(i=0; i<STRESS_DABS; i++)
+	{
+		FLOAT_T x = StressRandom(&seed) * size;
+		FLOAT_T y = StressRandom(&seed) * size;
+		FLOAT_T r = 1 + 31 * StressRandom(&seed) * StressRandom(&seed);
+		GraphicsSetSourceRGBA(cr, StressRandom(&seed), StressRandom(&seed),
+			StressRandom(&seed), 0.1 + 0.9 * StressRandom(&seed));
+		GraphicsArc(cr, x, y, r, 0, 2 * M_PI);
+		GraphicsFill(cr);
+	}
+
+	for(i=0; i<STRESS_RECTANGLES; i++)
+	{
+		FLOAT_T x = floor(StressRandom(&seed) * size);
+		FLOAT_T y = floor(StressRandom(&seed) * size);
+		GraphicsSetSourceRGBA(cr, StressRandom(&seed), StressRandom(&seed),
+			StressRandom(&seed), (i & 1) ? 1.0 : 0.5);
+		GraphicsRectangle(cr, x, y, floor(1 + 63 * StressRandom(&seed)), floor(1 + 63 * StressRandom(&seed)));
+		GraphicsFill(cr);
+	}
+
+	for(i=0; i<STRESS_STROKES; i++)
+	{
+		GraphicsSetSourceRGBA(cr, StressRandom(&seed), StressRandom(&seed), StressRandom(&seed), 1);
+		GraphicsSetLineWidth(cr, 1 + 7 * StressRandom(&seed));
+		GraphicsMoveTo(cr, StressRandom(&seed) * size, StressRandom(&seed) * size);
+		GraphicsCurveTo(cr, StressRandom(&seed) * size, StressRandom(&seed) * size,
+			StressRandom(&seed) * size, StressRandom(&seed) * size,
+			StressRandom(&seed) * size, StressRandom(&seed) * size);
+		GraphicsStroke(cr);
+	}
+
+	GraphicsSetSourceSurface(cr, &source.base, 0, 0, &pattern);
+	GraphicsPaintWithAlpha(cr, 0.5);
+
+	for(i=0; i<stride * size; i++)
+	{
+		hash = (hash ^ pixels[i]) * 16777619u;
+	}
+	*checksum = hash;
+
+	GraphicsDefaultContextFinish(&context);
+	GraphicsSurfaceFinish(&surface.base);
+	GraphicsSurfaceFinish(&source.base);
+	MEM_FREE_FUNC(pixels);
+	MEM_FREE_FUNC(source_pixels);
+
+	return TRUE;
+}
+
+/*
+* StressThreadMain関数
+* 1スレッド分の描画を繰り返して結果を確認する
+* 引数
+* thread	: スレッドの設定
+*/
+static void StressThreadMain(STRESS_THREAD* thread)
+{
+	GRAPHICS own_graphics;
+	GRAPHICS *graphics = thread->shared_graphics;
+	int i;
+
+	if(graphics == NULL)
+	{
+		(void)memset(&own_graphics, 0, sizeof(own_graphics));
+		InitializeGraphics(&own_graphics);
+		graphics = &own_graphics;
+	}
+
+	for(i=0; i<thread->rounds; i++)
+	{
+		uint32 checksum;
+		if(RenderStressScene(graphics, thread->seed, &checksum) == FALSE)
+		{
+			thread->failures++;
+		}
+		else if(checksum != thread->expected)
+		{
+			thread->mismatches++;
+		}
+	}
+
+	if(graphics == &own_graphics)
+	{
+		ReleaseGraphics(&own_graphics);
+	}
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI StressThreadEntry(LPVOID data)
+{
+	StressThreadMain((STRESS_THREAD*)data);
+	return 0;
+}
+#else
+static void* StressThreadEntry(void* data)
+{
+	StressThreadMain((STRESS_THREAD*)data);
+	return NULL;
+}
+#endif
+
+/*
+* RunStressThreads関数
+* 全てのスレッドを同時に動かして終了を待つ
+* 引数
+* threads		: スレッドの設定
+* num_threads	: スレッド数
+* 返り値
+*	成功:TRUE	失敗:FALSE
+*/
+static int RunStressThreads(STRESS_THREAD* threads, int num_threads)
+{
+#if defined(_WIN32)
+	HANDLE handles[STRESS_MAX_THREADS];
+	int i;
+
+	for(i=0; i<num_threads; i++)
+	{
+		handles[i] = CreateThread(NULL, 0, StressThreadEntry, &threads[i], 0, NULL);
+		if(handles[i] == NULL)
+		{
+			(void)WaitForMultipleObjects(i, handles, TRUE, INFINITE);
+			while(i-- > 0)
+			{
+				(void)CloseHandle(handles[i]);
+			}
+			return FALSE;
+		}
+	}
+	(void)WaitForMultipleObjects(num_threads, handles, TRUE, INFINITE);
+	for(i=0; i<num_threads; i++)
+	{
+		(void)CloseHandle(handles[i]);
+	}
+#else
+	pthread_t handles[STRESS_MAX_THREADS];
+	int i;
+
+	for(i=0; i<num_threads; i++)
+	{
+		if(pthread_create(&handles[i], NULL, StressThreadEntry, &threads[i]) != 0)
+		{
+			while(i-- > 0)
+			{
+				(void)pthread_join(handles[i], NULL);
+			}
+			return FALSE;
+		}
+	}
+	for(i=0; i<num_threads; i++)
+	{
+		(void)pthread_join(handles[i], NULL);
+	}
+#endif
+
+	return TRUE;
+}
+
+/*
+* RunStressTest関数
+* スレッドを同時に動かして全ての描画結果が1スレッドの時と一致するか確認する
+* 引数
+* label			: 表示名
+* shared		: 共有する描画エンジンの設定(NULLならスレッド毎に作成)
+* expected		: スレッド毎の期待するチェックサム
+* num_threads	: スレッド数
+* rounds		: 繰り返し回数
+* 返り値
+*	全て一致:TRUE	不一致あり:FALSE
+*/
+static int RunStressTest(
+	const char* label,
+	GRAPHICS* shared,
+	const uint32* expected,
+	int num_threads,
+	int rounds
+)
+{
+	STRESS_THREAD threads[STRESS_MAX_THREADS];
+	int mismatches = 0, failures = 0;
+	double start, elapsed;
+	int i;
+
+	(void)memset(threads, 0, sizeof(threads));
+	for(i=0; i<num_threads; i++)
+	{
+		threads[i].shared_graphics = shared;
+		threads[i].seed = (uint32)(i + 1);
+		threads[i].expected = expected[i];
+		threads[i].rounds = rounds;
+	}
+
+	start = GetBenchmarkTime();
+	if(RunStressThreads(threads, num_threads) == FALSE)
+	{
+		(void)fprintf(stderr, "%s: failed to start threads\n", label);
+		return FALSE;
+	}
+	elapsed = GetBenchmarkTime() - start;
+
+	for(i=0; i<num_threads; i++)
+	{
+		mismatches += threads[i].mismatches;
+		failures += threads[i].failures;
+	}
+
+	(void)printf("%-10s %3d threads  %8.3f s  %9.1f scenes/s  mismatches %d  failures %d\n",
+		label, num_threads, elapsed, num_threads * rounds / elapsed, mismatches, failures);
+
+	return mismatches == 0 && failures == 0;
+}
+
+int main(int argc, char** argv)
+{
+	GRAPHICS graphics = {0};
+	uint32 expected[STRESS_MAX_THREADS];
+	int num_threads = STRESS_DEFAULT_THREADS;
+	int rounds = STRESS_DEFAULT_ROUNDS;
+	int result = TRUE;
+	int i;
+
+	if(argc > 1)
+	{
+		num_threads = atoi(argv[1]);
+	}
+	if(argc > 2)
+	{
+		rounds = atoi(argv[2]);
+	}
+	if(num_threads <= 0 || num_threads > STRESS_MAX_THREADS || rounds <= 0)
+	{
+		(void)fprintf(stderr, "usage: %s [threads(1-%d)] [rounds]\n", argv[0], STRESS_MAX_THREADS);
+		return 1;
+	}
+
+	InitializeGraphics(&graphics);
+
+	// 1スレッドで描画した結果を正解にする
+	for(i=0; i<num_threads; i++)
+	{
+		if(RenderStressScene(&graphics, (uint32)(i + 1), &expected[i]) == FALSE)
+		{
+			(void)fprintf(stderr, "failed to render the reference scene\n");
+			ReleaseGraphics(&graphics);
+			return 1;
+		}
+	}
+
+	(void)printf("graphics thread stress (%d rounds, %dx%d)\n",
+		rounds, STRESS_SURFACE_SIZE, STRESS_SURFACE_SIZE);
+	result &= RunStressTest("shared", &graphics, expected, num_threads, rounds);
+	result &= RunStressTest("per-thread", NULL, expected, num_threads, rounds);
+
+	ReleaseGraphics(&graphics);
+
+	return (result != FALSE) ? 0 : 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,314 @@
+/*
+* memory_stream_benchmark.c
+* メモリストリーム(memory_stream.c)の書き込み・読み込み速度を計測するコンソールプログラム
+*  保存(小さく作って大きく書き込む)・履歴(容量通りに書き込む)・外部バッファの読み込みを
+*  以前の固定ブロック単位の拡張と比較して、1秒あたりの処理バイト数を表示する
+* 使い方
+*	memory_stream_benchmark [繰り返し回数] [保存データのMB]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../memory_stream.h"
+#include "../memory.h"
+#include "benchmark_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 繰り返し回数を指定しなかった時の値
+#define BENCHMARK_DEFAULT_ITERATIONS 5
+// 保存データのバイト数を指定しなかった時の値(MB)
+#define BENCHMARK_DEFAULT_SAVE_MB 4
+// 保存時のストリームの初期容量(ベクトルレイヤーの履歴と同じ)
+#define BENCHMARK_SAVE_INITIAL_SIZE 8096
+// 保存時に1回で書き込むバイト数(ベクトルの制御点1つ分程度)
+#define BENCHMARK_RECORD_SIZE 48
+// 履歴データの幅と高さ(ブラシの描画範囲)
+#define BENCHMARK_HISTORY_WIDTH 512
+#define BENCHMARK_HISTORY_HEIGHT 512
+// 1回の計測で作成する履歴データの数
+#define BENCHMARK_HISTORIES 64
+
+/*
+* BENCHMARK_RESULT構造体
+* 1項目分の計測結果
+*/
+typedef struct _BENCHMARK_RESULT
+{
+	const char *name;		// 計測項目名
+	BENCHMARK_TIME time;	// 処理時間
+	double bytes;			// 1回あたりの処理バイト数
+} BENCHMARK_RESULT;
+
+/*
+* LegacyCreateMemoryStream関数
+* 以前のCreateMemoryStream(バッファ全体を0クリアする)
+* 引数
+* buff_size	: 確保するバッファのサイズ
+* 返り値
+*	初期化された構造体のアドレス
+*/
+static MEMORY_STREAM_PTR LegacyCreateMemoryStream(size_t buff_size)
+{
+	MEMORY_STREAM_PTR ret = (MEMORY_STREAM_PTR)MEM_CALLOC_FUNC(1, sizeof(*ret));
+	ret->buff_ptr = (unsigned char*)MEM_ALLOC_FUNC(buff_size+1);
+	(void)memset(ret->buff_ptr, 0, buff_size+1);
+	ret->data_size = ret->block_size = buff_size;
+	return ret;
+}
+
+/*
+* LegacyMemWrite関数
+* 以前のMemWrite(固定ブロック単位で確保し直してコピーする)
+* 引数
+* src			: 書き込むデータ
+* block_size	: 1つのブロックのサイズ
+* block_num		: ブロックの数
+* mem			: 書き込み先
+* 返り値
+*	書き込んだブロック数
+*/
+static size_t LegacyMemWrite(const void* src, size_t block_size, size_t block_num, MEMORY_STREAM_PTR mem)
+{
+	size_t required_size = block_size * block_num;
+
+	if(required_size + mem->data_point > mem->data_size)
+	{
+		unsigned char* temp = (unsigned char*)MEM_ALLOC_FUNC(
+			mem->data_size + mem->block_size + (required_size / mem->block_size) * mem->block_size);
+		(void)memcpy(temp, mem->buff_ptr, mem->data_size);
+		(void)memset(&temp[mem->data_size], 0, mem->block_size);
+		MEM_FREE_FUNC(mem->buff_ptr);
+		mem->buff_ptr = temp;
+		mem->data_size += mem->block_size + (required_size / mem->block_size) * mem->block_size;
+	}
+
+	(void)memcpy(&mem->buff_ptr[mem->data_point], src, required_size);
+	mem->data_point += required_size;
+
+	return block_num;
+}
+
+/*
+* BenchmarkSave関数
+* 小さく作ったストリームに細かく書き込んで保存データを作る
+* 引数
+* total_size	: 書き込む総バイト数
+* legacy		: 以前の実装を使うか否か
+* reserve		: 書き込み前に容量を確保するか否か
+* 返り値
+*	書き込んだデータの先頭バイト(最適化で処理が消えないようにする)
+*/
+static unsigned int BenchmarkSave(size_t total_size, int legacy, int reserve)
+{
+	unsigned char record[BENCHMARK_RECORD_SIZE];
+	MEMORY_STREAM_PTR stream;
+	unsigned int result;
+	size_t i;
+
+	for(i=0; i<sizeof(record); i++)
+	{
+		record[i] = (unsigned char)i;
+	}
+
+	stream = (legacy != 0) ? LegacyCreateMemoryStream(BENCHMARK_SAVE_INITIAL_SIZE)
+		: CreateMemoryStream(BENCHMARK_SAVE_INITIAL_SIZE);
+	if(reserve != 0)
+	{
+		(void)MemReserve(stream, total_size);
+	}
+	for(i=0; i<total_size; i+=sizeof(record))
+	{
+		if(legacy != 0)
+		{
+			(void)LegacyMemWrite(record, 1, sizeof(record), stream);
+		}
+		else
+		{
+			(void)MemWrite(record, 1, sizeof(record), stream);
+		}
+	}
+	result = stream->buff_ptr[stream->data_point-1];
+	(void)DeleteMemoryStream(stream);
+
+	return result;
+}
+
+/*
+* BenchmarkHistory関数
+* 必要な容量で作ったストリームに画像の行を書き込む(ブラシの履歴と同じ)
+* 引数
+* pixels	: 書き込む画像
+* legacy	: 以前の実装を使うか否か
+* 返り値
+*	書き込んだデータの先頭バイト
+*/
+static unsigned int BenchmarkHistory(const unsigned char* pixels, int legacy)
+{
+	const size_t stride = BENCHMARK_HISTORY_WIDTH * 4;
+	unsigned int result = 0;
+	int i, y;
+
+	for(i=0; i<BENCHMARK_HISTORIES; i++)
+	{
+		MEMORY_STREAM_PTR stream = (legacy != 0)
+			? LegacyCreateMemoryStream(stride * BENCHMARK_HISTORY_HEIGHT)
+			: CreateMemoryStream(stride * BENCHMARK_HISTORY_HEIGHT);
+		for(y=0; y<BENCHMARK_HISTORY_HEIGHT; y++)
+		{
+			(void)MemWrite(&pixels[y*stride], 1, stride, stream);
+		}
+		result += stream->buff_ptr[0];
+		(void)DeleteMemoryStream(stream);
+	}
+
+	return result;
+}
+
+/*
+* BenchmarkRead関数
+* 既存のデータを細かく読み込む
+* 引数
+* data	: 読み込むデータ
+* size	: データのバイト数
+* copy	: ストリームへコピーしてから読むか否か(以前の読み込み方法)
+* 返り値
+*	読み込んだデータの合計
+*/
+static unsigned int BenchmarkRead(unsigned char* data, size_t size, int copy)
+{
+	unsigned char record[BENCHMARK_RECORD_SIZE];
+	MEMORY_STREAM_PTR stream;
+	unsigned int result = 0;
+
+	if(copy != 0)
+	{
+		stream = LegacyCreateMemoryStream(size);
+		(void)memcpy(stream->buff_ptr, data, size);
+	}
+	else
+	{
+		stream = CreateMemoryStreamForBuffer(data, size);
+	}
+
+	while(MemRead(record, 1, sizeof(record), stream) == sizeof(record))
+	{
+		result += record[0];
+	}
+	(void)DeleteMemoryStream(stream);
+
+	return result;
+}
+
+/*
+* PrintBenchmarkResult関数
+* 計測結果を1行で表示する
+* 引数
+* result	: 計測結果
+*/
+static void PrintBenchmarkResult(const BENCHMARK_RESULT* result)
+{
+	(void)printf("  %-22s %10.3f ms  %10.1f MB/s\n", result->name, result->time.best_seconds * 1000,
+		result->bytes / (1024.0 * 1024.0) / result->time.best_seconds);
+}
+
+int main(int argc, char** argv)
+{
+	BENCHMARK_RESULT results[7] = {0};
+	unsigned char *pixels, *data;
+	size_t save_size = (size_t)BENCHMARK_DEFAULT_SAVE_MB * 1024 * 1024;
+	size_t history_size = (size_t)BENCHMARK_HISTORY_WIDTH * 4 * BENCHMARK_HISTORY_HEIGHT;
+	int iterations = BENCHMARK_DEFAULT_ITERATIONS;
+	volatile unsigned int sink = 0;
+	int i, j;
+
+	if(argc > 1)
+	{
+		iterations = atoi(argv[1]);
+	}
+	if(argc > 2)
+	{
+		save_size = (size_t)atoi(argv[2]) * 1024 * 1024;
+	}
+	if(iterations <= 0 || save_size == 0)
+	{
+		(void)fprintf(stderr, "usage: %s [iterations] [save MB]\n", argv[0]);
+		return 1;
+	}
+
+	pixels = (unsigned char*)MEM_ALLOC_FUNC(history_size);
+	data = (unsigned char*)MEM_ALLOC_FUNC(save_size);
+	for(i=0; i<(int)history_size; i++)
+	{
+		pixels[i] = (unsigned char)(i * 7);
+	}
+	for(i=0; i<(int)save_size; i++)
+	{
+		data[i] = (unsigned char)(i * 13);
+	}
+
+	results[0].name = "save (legacy)";
+	results[1].name = "save";
+	results[2].name = "save (reserved)";
+	results[3].name = "history (legacy)";
+	results[4].name = "history";
+	results[5].name = "read (copy)";
+	results[6].name = "read (external buffer)";
+	for(j=0; j<7; j++)
+	{
+		results[j].bytes = (j < 3) ? (double)save_size
+			: (j < 5) ? (double)history_size * BENCHMARK_HISTORIES : (double)save_size;
+	}
+
+	for(i=0; i<iterations; i++)
+	{
+		for(j=0; j<7; j++)
+		{
+			double start_time = GetBenchmarkTime();
+			switch(j)
+			{
+			case 0:
+				sink += BenchmarkSave(save_size, 1, 0);
+				break;
+			case 1:
+				sink += BenchmarkSave(save_size, 0, 0);
+				break;
+			case 2:
+				sink += BenchmarkSave(save_size, 0, 1);
+				break;
+			case 3:
+				sink += BenchmarkHistory(pixels, 1);
+				break;
+			case 4:
+				sink += BenchmarkHistory(pixels, 0);
+				break;
+			case 5:
+				sink += BenchmarkRead(data, save_size, 1);
+				break;
+			case 6:
+				sink += BenchmarkRead(data, save_size, 0);
+				break;
+			}
+			(void)AddBenchmarkTime(&results[j].time, start_time);
+		}
+	}
+
+	(void)printf("memory stream benchmark (%d iterations, save %.1f MB)\n",
+		iterations, save_size / (1024.0 * 1024.0));
+	for(j=0; j<7; j++)
+	{
+		PrintBenchmarkResult(&results[j]);
+	}
+
+	MEM_FREE_FUNC(pixels);
+	MEM_FREE_FUNC(data);
+
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,7 @@
 #include "application.h"
 #include "bezier.h"
 #include "graphics/graphics.h"
+#include "vector_outline.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +20,11 @@ extern "C" {
 # define LOG log
 #endif
 
+// 3次ベジェ曲線を平坦化する際の1区間の長さ(制御点を結んだ長さ基準)
+#define BEZIER_OUTLINE_STEP 4.0
+// 3次ベジェ曲線1本あたりの最大分割数
+#define BEZIER_OUTLINE_MAX_DIVIDE 1024
+
 /******************************************************
 * MakeBezier3EdgeControlPoint関数					 *
 * 3点の座標から3次ベジェ曲線の端点での座標を決定する  *
@@ -402,178 +408,69 @@ FLOAT_T CalcBezier3Length(BEZIER_POINT* points, FLOAT_T start, FLOAT_T end)
 	return (result * (h / 3.0));
 }
 
-void StrokeBezier3Line(
-	DRAW_WINDOW* window,
-	VECTOR_LINE* line,
+/*
+* AddBezier3Outline関数
+* 3次ベジェ曲線を折れ線に平坦化して可変幅の輪郭の中心線に追加する
+* 引数
+* outline		: 点を追加する中心線
+* vec_points	: 曲線の始点・終点の制御点
+* points		: 3次ベジェ曲線の制御点
+*/
+static void AddBezier3Outline(
+	VECTOR_OUTLINE* outline,
 	VECTOR_POINT* vec_points,
-	BEZIER_POINT* points,
-	VECTOR_LAYER_RECTANGLE* rect
+	BEZIER_POINT* points
 )
 {
 	BEZIER_POINT draw;
-	GRAPHICS *graphics;
-	GRAPHICS_RADIAL_PATTERN brush;
-	FLOAT_T r, oct_r, d, div_d, t = 0, dist = 0;
-	FLOAT_T red, green, blue, alpha;
-	FLOAT_T ad, bd;
-	int32 min_x, min_y, max_x, max_y;
-	int x, y;
-
-	graphics = &window->app->graphics;
+	FLOAT_T r, d, t;
+	int num_divide;
+	int i;
 
-	// d = CalcBezier3Length(points, 0, 1);
+	// 制御点を結んだ長さから分割数を決める
 	d = SQRT((points[0].x-points[1].x)*(points[0].x-points[1].x)
-		+ (points[0].y-points[1].y)*(points[0].y-points[1].y)) * 1.5;
+		+ (points[0].y-points[1].y)*(points[0].y-points[1].y));
 	d += SQRT((points[1].x-points[2].x)*(points[1].x-points[2].x)
-		+ (points[1].y-points[2].y)*(points[1].y-points[2].y)) * 1.5;
+		+ (points[1].y-points[2].y)*(points[1].y-points[2].y));
 	d += SQRT((points[2].x-points[3].x)*(points[2].x-points[3].x)
-		+ (points[2].y-points[3].y)*(points[2].y-points[3].y)) * 1.5;
-
-	div_d = 1.0 / d;
+		+ (points[2].y-points[3].y)*(points[2].y-points[3].y));
+	num_divide = (int)(d / BEZIER_OUTLINE_STEP) + 1;
+	if(num_divide > BEZIER_OUTLINE_MAX_DIVIDE)
+	{
+		num_divide = BEZIER_OUTLINE_MAX_DIVIDE;
+	}
 
-	do
+	// 前の曲線の終点と同じ点は追加しない
+	for(i=(outline->num_points > 0) ? 1 : 0; i<=num_divide; i++)
 	{
-		ad = (d - dist) * div_d, bd = dist * div_d;
-		r = vec_points[0].size * vec_points[0].pressure * 0.01 * ad
-			+ vec_points[1].size * vec_points[1].pressure * 0.01 * bd;
+		t = (FLOAT_T)i / num_divide;
+		r = vec_points[0].size * vec_points[0].pressure * 0.01 * (1 - t)
+			+ vec_points[1].size * vec_points[1].pressure * 0.01 * t;
 		if(r < 0.5)
 		{
 			r = 0.5;
 		}
-		oct_r = r * 0.125;
-		if(oct_r < 0.5)
-		{
-			oct_r = 0.5;
-		}
 
 		CalcBezier3(points, t, &draw);
-		dist += oct_r;
-		t = dist / d;
-
-		min_x = (int32)(draw.x - r - 1);
-		min_y = (int32)(draw.y - r - 1);
-		max_x = (int32)(draw.x + r + 1);
-		max_y = (int32)(draw.y + r + 1);
-
-		if(min_x < 0)
-		{
-			min_x = 0;
-		}
-		else if(min_x > window->width)
-		{
-			min_x = window->width;
-		}
-		if(min_y < 0)
-		{
-			min_y = 0;
-		}
-		else if(min_y > window->height)
-		{
-			min_y = window->height;
-		}
-		if(max_x > window->width)
-		{
-			max_x = window->width;
-		}
-		else if(max_x < 0)
-		{
-			max_x = 0;
-		}
-		if(max_y > window->height)
-		{
-			max_y = window->height;
-		}
-		else if(max_y < 0)
-		{
-			max_y = 0;
-		}
-
-		if(rect->min_x > min_x)
-		{
-			rect->min_x = min_x;
-		}
-		if(rect->min_y > min_y)
-		{
-			rect->min_y = min_y;
-		}
-		if(rect->max_x < max_x)
-		{
-			rect->max_x = max_x;
-		}
-		if(rect->max_y < max_y)
-		{
-			rect->max_y = max_y;
-		}
-
-		for(y=min_y; y<max_y; y++)
-		{
-			(void)memset(&window->temp_layer->pixels[y*window->temp_layer->stride+min_x*window->temp_layer->channel],
-				0, (max_x - min_x)*window->temp_layer->channel);
-		}
-
-		ad *= DIV_PIXEL, bd *= DIV_PIXEL;
-		red = (vec_points[0].color[0] * ad) + (vec_points[1].color[0] * bd);
-		green = (vec_points[0].color[1] * ad) + (vec_points[1].color[1] * bd);
-		blue = (vec_points[0].color[2] * ad) + (vec_points[1].color[2] * bd);
-		alpha = (vec_points[0].color[3] * ad) + (vec_points[1].color[3] * bd);
-
-		InitializeGraphicsPatternRadial(&brush, draw.x, draw.y, 0.0, draw.x, draw.y, r, graphics);
-		GraphicsPatternSetExtend(&brush.base.base, GRAPHICS_EXTEND_NONE);
-		GraphicsPatternAddColorStopRGBA(&brush.base.base, 0.0, red, green, blue, alpha);
-		GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0-line->blur*0.01, red, green, blue, alpha);
-		GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0, red, green, blue, line->outline_hardness*0.01f*alpha);
-		GraphicsSetSource(&window->temp_layer->context.base, &brush.base.base);
-
-		GraphicsArc(&window->temp_layer->context.base, draw.x, draw.y, r, 0, 2*M_PI);
-		GraphicsFill(&window->temp_layer->context.base);
-
-		for(y=min_y; y<max_y; y++)
-		{
-			for(x=min_x; x<max_x; x++)
-			{
-				if(window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->channel+3])
-				{
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel];
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+1]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1];
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+2]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2];
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3];
-				}
-			}
-		}
-
-		DestroyGraphicsPattern(&brush.base.base);
-	} while(t < 1.0);
+		AddVectorOutlinePoint(outline, draw.x, draw.y, r, &vec_points[0], &vec_points[1], t);
+	}
 }
 
-void StrokeBezierLine(
-	DRAW_WINDOW* window,
-	VECTOR_LINE* line,
-	VECTOR_LAYER_RECTANGLE* rect
+/*
+* AddBezierLineOutline関数
+* 開いたベジェ曲線を平坦化して可変幅の輪郭の中心線に追加する
+* 引数
+* outline	: 点を追加する中心線
+* line		: 制御点が3点以上のベジェ曲線
+*/
+void AddBezierLineOutline(
+	VECTOR_OUTLINE* outline,
+	VECTOR_LINE* line
 )
 {
 	BEZIER_POINT calc[4], inter[2];
 	int i, j;
 
-	rect->min_x = rect->max_x = line->points->x;
-	rect->min_y = rect->min_y = line->points->y;
-
 	for(i=0; i<3; i++)
 	{
 		calc[i].x = line->points[i].x;
@@ -583,7 +480,7 @@ void StrokeBezierLine(
 	calc[1].x = line->points[0].x, calc[1].y = line->points[0].y;
 	calc[2] = inter[0];
 	calc[3].x = line->points[1].x, calc[3].y = line->points[1].y;
-	StrokeBezier3Line(window, line, line->points, calc, rect);
+	AddBezier3Outline(outline, line->points, calc);
 
 	for(i=0; i<line->num_points-3; i++)
 	{
@@ -599,7 +496,7 @@ void StrokeBezierLine(
 		calc[3].x = line->points[i+2].x;
 		calc[3].y = line->points[i+2].y;
 
-		StrokeBezier3Line(window, line, &line->points[i+1], calc, rect);
+		AddBezier3Outline(outline, &line->points[i+1], calc);
 	}
 
 	for(j=0; j<3; j++)
@@ -613,20 +510,40 @@ void StrokeBezierLine(
 	calc[1] = inter[1];
 	calc[2].x = line->points[i+2].x, calc[2].y = line->points[i+2].y;
 	calc[3].x = line->points[i+2].x, calc[3].y = line->points[i+2].y;
-	StrokeBezier3Line(window, line, &line->points[i+1], calc, rect);
+	AddBezier3Outline(outline, &line->points[i+1], calc);
 }
 
-void StrokeBezierLineClose(
+void StrokeBezierLine(
 	DRAW_WINDOW* window,
 	VECTOR_LINE* line,
 	VECTOR_LAYER_RECTANGLE* rect
 )
 {
-	BEZIER_POINT calc[4], inter[2];
-	int i, j;
+	VECTOR_OUTLINE outline;
 
 	rect->min_x = rect->max_x = line->points->x;
-	rect->min_y = rect->min_y = line->points->y;
+	rect->min_y = rect->max_y = line->points->y;
+
+	InitializeVectorOutline(&outline);
+	AddBezierLineOutline(&outline, line);
+	FillVectorOutline(window, line, &outline, rect);
+	ReleaseVectorOutline(&outline);
+}
+
+/*
+* AddBezierLineCloseOutline関数
+* 閉じたベジェ曲線を平坦化して可変幅の輪郭の中心線に追加する
+* 引数
+* outline	: 点を追加する中心線
+* line		: 制御点が3点以上のベジェ曲線
+*/
+void AddBezierLineCloseOutline(
+	VECTOR_OUTLINE* outline,
+	VECTOR_LINE* line
+)
+{
+	BEZIER_POINT calc[4], inter[2];
+	int i, j;
 
 	calc[0].x = line->points[line->num_points-1].x;
 	calc[0].y = line->points[line->num_points-1].y;
@@ -639,7 +556,7 @@ void StrokeBezierLineClose(
 	calc[0].x = line->points[0].x, calc[0].y = line->points[0].y;
 	calc[1] = inter[0], calc[2] = inter[1];
 	calc[3].x = line->points[1].x, calc[3].y = line->points[1].y;
-	StrokeBezier3Line(window, line, line->points, calc, rect);
+	AddBezier3Outline(outline, line->points, calc);
 
 	for(i=0; i<line->num_points-3; i++)
 	{
@@ -655,7 +572,7 @@ void StrokeBezierLineClose(
 		calc[3].y = line->points[i+2].y;
 		calc[1] = inter[0], calc[2] = inter[1];
 
-		StrokeBezier3Line(window, line, &line->points[i+1], calc, rect);
+		AddBezier3Outline(outline, &line->points[i+1], calc);
 	}
 
 	for(j=0; j<3; j++)
@@ -668,7 +585,7 @@ void StrokeBezierLineClose(
 	calc[0].x = line->points[i+1].x, calc[0].y = line->points[i+1].y;
 	calc[1] = inter[0], calc[2] = inter[1];
 	calc[3].x = line->points[i+2].x, calc[3].y = line->points[i+2].y;
-	StrokeBezier3Line(window, line, &line->points[i+1], calc, rect);
+	AddBezier3Outline(outline, &line->points[i+1], calc);
 
 	calc[0].x = line->points[i+1].x, calc[0].y = line->points[i+1].y;
 	calc[1].x = line->points[i+2].x, calc[1].y = line->points[i+2].y;
@@ -678,7 +595,24 @@ void StrokeBezierLineClose(
 	calc[0].x = line->points[i+2].x, calc[0].y = line->points[i+2].y;
 	calc[1] = inter[0], calc[2] = inter[1];
 	calc[3].x = line->points[0].x, calc[3].y = line->points[0].y;
-	StrokeBezier3Line(window, line, &line->points[i+1], calc, rect);
+	AddBezier3Outline(outline, &line->points[i+1], calc);
+}
+
+void StrokeBezierLineClose(
+	DRAW_WINDOW* window,
+	VECTOR_LINE* line,
+	VECTOR_LAYER_RECTANGLE* rect
+)
+{
+	VECTOR_OUTLINE outline;
+
+	rect->min_x = rect->max_x = line->points->x;
+	rect->min_y = rect->max_y = line->points->y;
+
+	InitializeVectorOutline(&outline);
+	AddBezierLineCloseOutline(&outline, line);
+	FillVectorOutline(window, line, &outline, rect);
+	ReleaseVectorOutline(&outline);
 }
 
 #ifdef __cplusplus
@@ -3,6 +3,7 @@
 
 #include "vector.h"
 #include "draw_window.h"
+#include "vector_outline.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +42,16 @@ extern void MakeBezier3ControlPoints(BEZIER_POINT* src, BEZIER_POINT* controls);
 
 extern void CalcBezier3(BEZIER_POINT* points, FLOAT_T t, BEZIER_POINT* dest);
 
+extern void AddBezierLineOutline(
+	VECTOR_OUTLINE* outline,
+	VECTOR_LINE* line
+);
+
+extern void AddBezierLineCloseOutline(
+	VECTOR_OUTLINE* outline,
+	VECTOR_LINE* line
+);
+
 extern void StrokeBezierLine(
 	DRAW_WINDOW* window,
 	VECTOR_LINE* line,
@@ -6,6 +6,7 @@
 #include "memory.h"
 #include "brushes.h"
 #include "memory_stream.h"
+#include "stroke_replay.h"
 #include "gui/draw_window.h"
 #include "gui/brushes_gui.h"
 #include "graphics/graphics_matrix.h"
@@ -117,6 +118,8 @@ void BrushCoreSetCirclePattern(
 
 	GraphicsPatternFinish(&radial_pattern.base.base);
 	DestroyGraphicsContext(&context.base);
+
+	core->flags &= ~(BRUSH_FLAG_PATTERN_PENDING);
 }
 
 /*
@@ -192,6 +195,26 @@ void BrushCoreSetGrayCirclePattern(
 
 	GraphicsPatternFinish(&radial_pattern.base.base);
 	DestroyGraphicsContext(&context.base);
+
+	core->flags &= ~(BRUSH_FLAG_PATTERN_PENDING);
+}
+
+/*
+* BrushCoreEnsureCirclePattern関数
+* 作成を後回しにしていた円形画像パターンを現在の設定で作成する
+*  起動時に全ブラシ分のパターンを作らないよう、描画開始時に呼び出す
+* 引数
+* core	: ブラシの基本情報
+*/
+void BrushCoreEnsureCirclePattern(BRUSH_CORE* core)
+{
+	if((core->flags & BRUSH_FLAG_PATTERN_PENDING) == 0)
+	{
+		return;
+	}
+
+	BrushCoreSetCirclePattern(core, core->radius, core->outline_hardness, core->blur,
+		core->opacity, *core->color);
 }
 
 void ClearBeforeCursorPosition(
@@ -780,6 +803,7 @@ void BrushCoreUndoRedo(DRAW_WINDOW* canvas, void* p)
 	{
 		layer = layer->next;
 	}
+	(void)MaterializeLayerPixels(layer);
 
 	before_data = (uint8*)MEM_ALLOC_FUNC(data.height*data.width*layer->channel);
 	for(i=0; i<data.height; i++)
@@ -797,6 +821,9 @@ void BrushCoreUndoRedo(DRAW_WINDOW* canvas, void* p)
 
 	(void)memcpy(data.pixels, before_data, data.height*data.width*layer->channel);
 
+	// 所属するレイヤーセットの変更範囲を記録
+	InvalidateLayerSetCache(layer, data.x, data.y, data.width, data.height);
+
 	MEM_FREE_FUNC(before_data);
 }
 
@@ -807,6 +834,7 @@ void AddBrushHistory(
 {
 	BRUSH_HISTORY_DATA data;
 	MEMORY_STREAM_PTR stream;
+	double start_time = 0;
 	int i;
 
 	data.x = (int32)core->min_x - 1;
@@ -845,6 +873,12 @@ void AddBrushHistory(
 	{
 		data.height = active->height - data.y;
 	}
+	// 入力イベントの再生中は履歴作成の処理時間を計測する
+	if(core->app->stroke_replay != NULL)
+	{
+		start_time = GetStrokeReplayTime();
+	}
+
 	data.name_len = (int32)strlen(active->name) + 1;
 
 	stream = CreateMemoryStream(
@@ -867,6 +901,11 @@ void AddBrushHistory(
 	);
 	(void)DeleteMemoryStream(stream);
 
+	if(core->app->stroke_replay != NULL)
+	{
+		core->app->stroke_replay->history_time += GetStrokeReplayTime() - start_time;
+	}
+
 	{
 		int index, set_bytes;;
 		for(i=0, index = data.y * active->stride + data.x * 4, set_bytes = data.width * 4;
@@ -1051,9 +1090,20 @@ int InitializeBrushTable(APPLICATION* app, INI_FILE_PTR file)
 	{
 		ReadBrushData(app, file, file->section[i].section_name);
 	}
+
+	return 0;
 }
 
-int ReadBrushInitializeFile(APPLICATION* app, const char* file_path)
+/*
+* LoadBrushInitializeFile関数
+* ブラシの初期化ファイルを読み込んで解析する
+*  アプリケーションのデータに触れないので、起動時に別スレッドで呼び出せる
+* 引数
+* file_path	: 初期化ファイルのパス(開けなければ組み込みのデータを使う)
+* 返り値
+*	解析したデータ 失敗時はNULL
+*/
+INI_FILE_PTR LoadBrushInitializeFile(const char* file_path)
 {
 	INI_FILE_PTR file;
 	FILE *fp = NULL;
@@ -1088,13 +1138,12 @@ int ReadBrushInitializeFile(APPLICATION* app, const char* file_path)
 		file_size = sizeof(brushes_default_data);
 		if(mem_stream == NULL)
 		{
-			return -1;
+			return NULL;
 		}
 		(void)memcpy(mem_stream->buff_ptr, brushes_default_data, sizeof(brushes_default_data));
 	}
 	
 	file = CreateIniFile(stream, read_func, file_size, INI_READ);
-	InitializeBrushTable(app, file);
 	
 	if(fp != NULL)
 	{
@@ -1104,7 +1153,18 @@ int ReadBrushInitializeFile(APPLICATION* app, const char* file_path)
 	{
 		DeleteMemoryStream(mem_stream);
 	}
-	return 0;
+	return file;
+}
+
+int ReadBrushInitializeFile(APPLICATION* app, const char* file_path)
+{
+	INI_FILE_PTR file = LoadBrushInitializeFile(file_path);
+
+	if(file == NULL)
+	{
+		return -1;
+	}
+	return InitializeBrushTable(app, file);
 }
 
 #ifdef __cplusplus
@@ -6,6 +6,7 @@
 #include "layer.h"
 #include "draw_window.h"
 #include "utils.h"
+#include "ini_file.h"
 
 INLINE static LAYER* SwitchBrushTemporaryLayer(DRAW_WINDOW* canvas, LAYER* current_temp)
 {
@@ -66,7 +67,8 @@ typedef enum _eBRUSH_FLAGS
 	BRUSH_FLAG_ANTI_ALIAS = 0x20,
 	BRUSH_FLAG_USE_OLD_ANTI_ALIAS = 0x40,
 	BRUSH_FLAG_DRAW_STARTED = 0x80,
-	BRUSH_FLAG_OVERWRITE_DRAW = 0x100
+	BRUSH_FLAG_OVERWRITE_DRAW = 0x100,
+	BRUSH_FLAG_PATTERN_PENDING = 0x200
 } eBRUSH_FLAGS;
 
 typedef struct _BRUSH_UPDATE_INFO
@@ -184,6 +186,29 @@ EXTERN void InitializeBrushCore(BRUSH_CORE* core, APPLICATION* app);
 
 EXTERN int ReadBrushInitializeFile(APPLICATION* app, const char* file_path);
 
+/*
+* LoadBrushInitializeFile関数
+* ブラシの初期化ファイルを読み込んで解析する
+*  アプリケーションのデータに触れないので、起動時に別スレッドで呼び出せる
+* 引数
+* file_path	: 初期化ファイルのパス(開けなければ組み込みのデータを使う)
+* 返り値
+*	解析したデータ 失敗時はNULL
+*/
+EXTERN INI_FILE_PTR LoadBrushInitializeFile(const char* file_path);
+
+/*
+* InitializeBrushTable関数
+* 解析済みの初期化ファイルからブラシのテーブルを作成する
+*  ブラシのGUIを作るのでメインスレッドで呼び出す
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+* file	: LoadBrushInitializeFileで解析したデータ
+* 返り値
+*	正常終了:0
+*/
+EXTERN int InitializeBrushTable(APPLICATION* app, INI_FILE_PTR file);
+
 /*
 * DefaultToolUpdate関数
 * デフォルトのツールアップデートの関数
@@ -233,6 +258,14 @@ EXTERN void BrushCoreSetGrayCirclePattern(
 	FLOAT_T alpha
 );
 
+/*
+* BrushCoreEnsureCirclePattern関数
+* 作成を後回しにしていた円形画像パターンを現在の設定で作成する
+* 引数
+* core	: ブラシの基本情報
+*/
+EXTERN void BrushCoreEnsureCirclePattern(struct _BRUSH_CORE* core);
+
 EXTERN void DummyMouseCallBack(
 	DRAW_WINDOW* canvas,
 	BRUSH_CORE* core,
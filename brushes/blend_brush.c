@@ -64,6 +64,9 @@ void BlendBrushPressCallBack(
 		// c[{bNX̃f[^ւ̃ANZXp
 		APPLICATION* app = canvas->app;
 
+		// 쐬񂵂ɂĂuVp^[p
+		BrushCoreEnsureCirclePattern(core);
+
 		// uVɍ[h̔fs߁AƃC[͏ɒʏ퍇
 		canvas->work_layer->layer_mode = LAYER_BLEND_NORMAL;
 
@@ -79,7 +82,17 @@ void BlendBrushPressCallBack(
 		// ^[Qbgɍ킹ăobt@ɃsNZf[^Rs[
 		if(brush->base_data.target == BLEND_BRUSH_TARGET_UNDER_LAYER && canvas->active_layer->prev != NULL)
 		{
-			(void)memcpy(canvas->brush_buffer, canvas->active_layer->prev->pixels, canvas->pixel_buf_size);
+			LAYER *under = canvas->active_layer->prev;
+			// ^C`̉̃C[̓obt@ɓWJ
+			if(under->tiles != NULL)
+			{
+				LayerTilesToPixels(under->tiles, canvas->brush_buffer, under->stride,
+					0, 0, under->width, under->height);
+			}
+			else
+			{
+				(void)memcpy(canvas->brush_buffer, under->pixels, canvas->pixel_buf_size);
+			}
 		}
 		else
 		{
@@ -177,204 +190,92 @@ void BlendBrushPressCallBack(
 		GraphicsSetOperator(&canvas->work_layer->context.base, GRAPHICS_OPERATOR_OVER);
 
 		mask = canvas->mask_temp->pixels;
-		if(app->textures.active_texture == 0)
+		if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
 		{
-			if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
+			if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&update.base, alpha);
-				}
-				else
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
-				}
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&update.base, alpha);
 			}
 			else
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&canvas->mask_temp->context.base,
-						&canvas->selection->surface.base, -x + r, -y + r);
-				}
-				else
-				{
-					GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-					GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-					GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-					InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-						start_x, start_y, r * 2 + 1, r * 2 + 1);
-					InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &app->graphics);
-
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->temp_layer->pixels[
-							(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-							0, stride
-						);
-					}
-
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-						-x + r, -y + r);
-					GraphicsSetSourceSurface(
-						&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
-
-					mask = canvas->temp_layer->pixels;
-
-					GraphicsSurfaceFinish(&temp_surface.base);
-					DestroyGraphicsContext(&update_temp.base);
-				}
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+				InitializeGraphicsMatrixIdentity(&matrix);
+				GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->temp_pattern.base);
+				GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
+					-x + r, -y + r);
 			}
 		}
 		else
 		{
-			GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-			GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-			GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-			InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-				min_x, min_y, r * 2 + 1, r * 2 + 1);
-			InitializeGraphicsDefaultContext(&update_temp, &temp_surface.base, &app->graphics);
-
-			for(i = 0; i < height; i++)
+			if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
 			{
-				(void)memset(&canvas->temp_layer->pixels[
-					(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-					0, stride
-				);
-			}
-
-			if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
-			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&update_temp.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&update_temp.base, alpha);
-				}
-				else
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update_temp.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
-				}
-
-				GraphicsSetSourceSurface(&update.base, &temp_surface.base, 0, 0, &surface_pattern);
-				GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-					-x + r, -y + r);
-
-				mask = canvas->temp_layer->pixels;
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+				InitializeGraphicsMatrixIdentity(&matrix);
+				GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->temp_pattern.base);
+				GraphicsMaskSurface(&canvas->mask_temp->context.base,
+					&canvas->selection->surface.base, -x + r, -y + r);
 			}
 			else
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-						-x + r, -y + r);
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base, -x + r, -y + r);
+				GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
+				GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
+				GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
 
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->temp_layer->pixels[
-							(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-							0, stride
-						);
-					}
+				InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
+					start_x, start_y, r * 2 + 1, r * 2 + 1);
+				InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &app->graphics);
 
-					GraphicsSetSourceSurface(&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->texture->surface.base, -x + r, -y + r);
-				}
-				else
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+				InitializeGraphicsMatrixIdentity(&matrix);
+				GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->temp_pattern.base);
 
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->temp_layer->pixels[
-							(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-							0, stride
-						);
-					}
+				for(i = 0; i < height; i++)
+				{
+					(void)memset(&canvas->temp_layer->pixels[
+						(i + start_y) * canvas->temp_layer->stride + start_x * 4],
+						0, stride
+					);
+				}
 
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-						-x + r, -y + r);
-					GraphicsSetSourceSurface(&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
+				GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
+					-x + r, -y + r);
+				GraphicsSetSourceSurface(
+					&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
+				GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
+					-x + r, -y + r);
 
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->mask_temp->pixels[
-							(i + start_y) * canvas->mask_temp->stride + start_x * 4],
-							0, stride
-						);
-					}
+				mask = canvas->temp_layer->pixels;
 
-					GraphicsSetSourceSurface(&update.base, &temp_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-						-x + r, -y + r);
-					GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-						-x + r, -y + r);
-				}
+				GraphicsSurfaceFinish(&temp_surface.base);
+				DestroyGraphicsContext(&update_temp.base);
 			}
-
-			GraphicsSurfaceFinish(&temp_surface.base);
-			DestroyGraphicsContext(&update_temp.base);
 		}
 
 		core->before_x = x, core->before_y = y;
 		GraphicsSurfaceFinish(&update_surface.base);
 		DestroyGraphicsContext(&update.base);
 
+		if(app->textures.active_texture != 0)
+		{	// ƃC[͋Ȃ̂ŕ`挋ʂɃeNX`𒼐ڏZ
+			ApplyTextureToBrushPixels(&app->textures, brush_target->pixels, brush_target->stride,
+				start_x, start_y, (int)canvas->update.width, height);
+		}
+
 		// uV̕`挋ʂ̂ŃuVɎw肳ꂽ[hgăyCg	
 		{
 			GRAPHICS_IMAGE_SURFACE update_surface = {0};
@@ -680,117 +581,60 @@ void BlendBrushMotionCallBack(
 
 			GraphicsSetOperator(&canvas->mask_temp->context.base, GRAPHICS_OPERATOR_OVER);
 
-			if(canvas->app->textures.active_texture == 0)
+			if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
 			{
-				if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
+				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
 				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->brush_pattern.base);
-						GraphicsSetOperator(&update.base, GRAPHICS_OPERATOR_SOURCE);
-						GraphicsPaintWithAlpha(&update.base, alpha);
-					}
-					else
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->brush_pattern.base);
+					GraphicsSetOperator(&update.base, GRAPHICS_OPERATOR_SOURCE);
+					GraphicsPaintWithAlpha(&update.base, alpha);
 				}
 				else
 				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
-					else
-					{
-						GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-						GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-						GRAPHICS_SURFACE_PATTERN temp_pattern = { 0 };
-
-						InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-							start_x, start_y, r * 2 + 1, r * 2 + 1);
-						InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &core->app->graphics);
-
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->temp_layer->pixels[
-								(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-						GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-							0, 0, &temp_pattern);
-						GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						brush_target = SwitchBrushTemporaryLayer(canvas, brush_target);
-
-						GraphicsSurfaceFinish(&temp_surface.base);
-						DestroyGraphicsContext(&update_temp.base);
-					}
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+					InitializeGraphicsMatrixIdentity(&matrix);
+					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->temp_pattern.base);
+					GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
+						-draw_x + r, -draw_y + r);
 				}
 			}
 			else
 			{
-				GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-				GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-				GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
+				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
+				{
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+					InitializeGraphicsMatrixIdentity(&matrix);
+					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->temp_pattern.base);
+					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
+						-draw_x + r, -draw_y + r);
+				}
+				else
+				{
+					GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
+					GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
+					GRAPHICS_SURFACE_PATTERN temp_pattern = { 0 };
 
-				InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-					start_x, start_y, r * 2 + 1, r * 2 + 1);
-				InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &core->app->graphics);
+					InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
+						start_x, start_y, r * 2 + 1, r * 2 + 1);
+					InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &core->app->graphics);
 
-				if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
-				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->brush_pattern.base);
-						GraphicsSetOperator(&update.base, GRAPHICS_OPERATOR_SOURCE);
-						GraphicsPaintWithAlpha(&update.base, alpha);
-					}
-					else
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+					InitializeGraphicsMatrixIdentity(&matrix);
+					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->temp_pattern.base);
 
 					for(i = 0; i < height; i++)
 					{
@@ -800,91 +644,29 @@ void BlendBrushMotionCallBack(
 						);
 					}
 
+					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
+						-draw_x + r, -draw_y + r);
 					GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-						0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->texture->surface.base,
+						0, 0, &temp_pattern);
+					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
 						-draw_x + r, -draw_y + r);
 
 					brush_target = SwitchBrushTemporaryLayer(canvas, brush_target);
-				}
-				else
-				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->temp_layer->pixels[
-								(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-							0, 0, &surface_pattern);
-						GraphicsMaskSurface(&update_temp.base, &canvas->texture->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						brush_target = SwitchBrushTemporaryLayer(canvas, brush_target);
-					}
-					else
-					{
-						GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
 
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->temp_layer->pixels[
-								(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-							0, 0, &surface_pattern);
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->mask_temp->pixels[
-								(i + start_y) * canvas->mask_temp->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsSetSourceSurface(&update.base, &temp_surface.base,
-							0, 0, &surface_pattern);
-						GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
+					GraphicsSurfaceFinish(&temp_surface.base);
+					DestroyGraphicsContext(&update_temp.base);
 				}
-
-				GraphicsSurfaceFinish(&temp_surface.base);
-				DestroyGraphicsContext(&update_temp.base);
 			}
 
 			GraphicsSurfaceFinish(&update_surface.base);
 			DestroyGraphicsContext(&update.base);
 
+			if(canvas->app->textures.active_texture != 0)
+			{	// gkE]ς݂̃eNX`uV̌`ɒڏZ
+				ApplyTextureToBrushPixels(&canvas->app->textures, brush_target->pixels, canvas->work_layer->stride,
+					start_x, start_y, width, height);
+			}
+
 			// uV̕`挋ʂ̂ŃuVɎw肳ꂽ[hgăyCg	
 			{
 				GRAPHICS_IMAGE_SURFACE brush_update_surface = { 0 };
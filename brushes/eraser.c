@@ -60,6 +60,9 @@ void EraserPressCallBack(
 		// c[{bNX̃f[^ւ̃ANZXp
 		APPLICATION* app = canvas->app;
 
+		// 쐬񂵂ɂĂuVp^[p
+		BrushCoreEnsureCirclePattern(core);
+
 		// ƃC[̍@ݒ
 		canvas->work_layer->layer_mode = LAYER_BLEND_ALPHA_MINUS;
 
@@ -163,204 +166,92 @@ void EraserPressCallBack(
 		GraphicsSetOperator(&canvas->work_layer->context.base, GRAPHICS_OPERATOR_OVER);
 
 		mask = canvas->mask_temp->pixels;
-		if(app->textures.active_texture == 0)
+		if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
 		{
-			if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
+			if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&update.base, alpha);
-				}
-				else
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
-				}
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&update.base, alpha);
 			}
 			else
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&canvas->mask_temp->context.base,
-						&canvas->selection->surface.base, -x + r, -y + r);
-				}
-				else
-				{
-					GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-					GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-					GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-					InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-						start_x, start_y, r * 2 + 1, r * 2 + 1);
-					InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &app->graphics);
-
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->temp_layer->pixels[
-							(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-							0, stride
-						);
-					}
-
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-						-x + r, -y + r);
-					GraphicsSetSourceSurface(
-						&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
-
-					mask = canvas->temp_layer->pixels;
-
-					GraphicsSurfaceFinish(&temp_surface.base);
-					DestroyGraphicsContext(&update_temp.base);
-				}
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+				InitializeGraphicsMatrixIdentity(&matrix);
+				GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->temp_pattern.base);
+				GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
+					-x + r, -y + r);
 			}
 		}
 		else
 		{
-			GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-			GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-			GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-			InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-				min_x, min_y, r * 2 + 1, r * 2 + 1);
-			InitializeGraphicsDefaultContext(&update_temp, &temp_surface.base, &app->graphics);
-
-			for(i = 0; i < height; i++)
-			{
-				(void)memset(&canvas->temp_layer->pixels[
-					(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-					0, stride
-				);
-			}
-
-			if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
+			if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&update_temp.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&update_temp.base, alpha);
-				}
-				else
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update_temp.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
-				}
-
-				GraphicsSetSourceSurface(&update.base, &temp_surface.base, 0, 0, &surface_pattern);
-				GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-					-x + r, -y + r);
-
-				mask = canvas->temp_layer->pixels;
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+				InitializeGraphicsMatrixIdentity(&matrix);
+				GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->temp_pattern.base);
+				GraphicsMaskSurface(&canvas->mask_temp->context.base,
+					&canvas->selection->surface.base, -x + r, -y + r);
 			}
 			else
 			{
-				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-						-x + r, -y + r);
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base, -x + r, -y + r);
+				GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
+				GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
+				GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
 
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->temp_layer->pixels[
-							(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-							0, stride
-						);
-					}
+				InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
+					start_x, start_y, r * 2 + 1, r * 2 + 1);
+				InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &app->graphics);
 
-					GraphicsSetSourceSurface(&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->texture->surface.base, -x + r, -y + r);
-				}
-				else
-				{
-					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-					InitializeGraphicsMatrixIdentity(&matrix);
-					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-					GraphicsSetSource(&update.base, &core->temp_pattern.base);
+				InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+				GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+				GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+				GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+				InitializeGraphicsMatrixIdentity(&matrix);
+				GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+				GraphicsSetSource(&update.base, &core->temp_pattern.base);
 
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->temp_layer->pixels[
-							(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-							0, stride
-						);
-					}
+				for(i = 0; i < height; i++)
+				{
+					(void)memset(&canvas->temp_layer->pixels[
+						(i + start_y) * canvas->temp_layer->stride + start_x * 4],
+						0, stride
+					);
+				}
 
-					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-						-x + r, -y + r);
-					GraphicsSetSourceSurface(&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-						-x + r, -y + r);
+				GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
+					-x + r, -y + r);
+				GraphicsSetSourceSurface(
+					&update_temp.base, &update_surface.base, 0, 0, &surface_pattern);
+				GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
+					-x + r, -y + r);
 
-					for(i = 0; i < height; i++)
-					{
-						(void)memset(&canvas->mask_temp->pixels[
-							(i + start_y) * canvas->mask_temp->stride + start_x * 4],
-							0, stride
-						);
-					}
+				mask = canvas->temp_layer->pixels;
 
-					GraphicsSetSourceSurface(&update.base, &temp_surface.base, 0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-						-x + r, -y + r);
-					GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-						-x + r, -y + r);
-				}
+				GraphicsSurfaceFinish(&temp_surface.base);
+				DestroyGraphicsContext(&update_temp.base);
 			}
-
-			GraphicsSurfaceFinish(&temp_surface.base);
-			DestroyGraphicsContext(&update_temp.base);
 		}
 
 		eraser->core.before_x = x, eraser->core.before_y = y;
 		GraphicsSurfaceFinish(&update_surface.base);
 		DestroyGraphicsContext(&update.base);
 
+		if(app->textures.active_texture != 0)
+		{	// ƃC[͋Ȃ̂ŕ`挋ʂɃeNX`𒼐ڏZ
+			ApplyTextureToBrushPixels(&app->textures, brush_target->pixels, brush_target->stride,
+				start_x, start_y, (int)canvas->update.width, height);
+		}
+
 		if((core->flags & BRUSH_FLAG_USE_OLD_ANTI_ALIAS) == 0 && (eraser->core.flags & BRUSH_FLAG_ANTI_ALIAS) != 0)
 		{
 			if((canvas->flags & DRAW_WINDOW_DISPLAY_HORIZON_REVERSE) == 0)
@@ -596,117 +487,60 @@ void EraserMotionCallBack(
 
 			GraphicsSetOperator(&canvas->mask_temp->context.base, GRAPHICS_OPERATOR_OVER);
 
-			if(canvas->app->textures.active_texture == 0)
+			if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
 			{
-				if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
+				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
 				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->brush_pattern.base);
-						GraphicsSetOperator(&update.base, GRAPHICS_OPERATOR_SOURCE);
-						GraphicsPaintWithAlpha(&update.base, alpha);
-					}
-					else
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->brush_pattern.base);
+					GraphicsSetOperator(&update.base, GRAPHICS_OPERATOR_SOURCE);
+					GraphicsPaintWithAlpha(&update.base, alpha);
 				}
 				else
 				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
-					else
-					{
-						GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-						GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-						GRAPHICS_SURFACE_PATTERN temp_pattern = { 0 };
-
-						InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-							start_x, start_y, r * 2 + 1, r * 2 + 1);
-						InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &core->app->graphics);
-
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->temp_layer->pixels[
-								(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-						GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-							0, 0, &temp_pattern);
-						GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						mask = canvas->temp_layer->pixels;
-
-						GraphicsSurfaceFinish(&temp_surface.base);
-						DestroyGraphicsContext(&update_temp.base);
-					}
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+					InitializeGraphicsMatrixIdentity(&matrix);
+					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->temp_pattern.base);
+					GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
+						-draw_x + r, -draw_y + r);
 				}
 			}
 			else
 			{
-				GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
-				GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
-				GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
+				if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
+				{
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+					InitializeGraphicsMatrixIdentity(&matrix);
+					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->temp_pattern.base);
+					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
+						-draw_x + r, -draw_y + r);
+				}
+				else
+				{
+					GRAPHICS_IMAGE_SURFACE temp_surface = { 0 };
+					GRAPHICS_DEFAULT_CONTEXT update_temp = { 0 };
+					GRAPHICS_SURFACE_PATTERN temp_pattern = { 0 };
 
-				InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
-					start_x, start_y, r * 2 + 1, r * 2 + 1);
-				InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &core->app->graphics);
+					InitializeGraphicsImageSurfaceForRectangle(&temp_surface, &canvas->temp_layer->surface,
+						start_x, start_y, r * 2 + 1, r * 2 + 1);
+					InitializeGraphicsDefaultContext(&update_temp, &temp_surface, &core->app->graphics);
 
-				if((canvas->flags & DRAW_WINDOW_HAS_SELECTION_AREA) == 0)
-				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->brush_pattern.base);
-						GraphicsSetOperator(&update.base, GRAPHICS_OPERATOR_SOURCE);
-						GraphicsPaintWithAlpha(&update.base, alpha);
-					}
-					else
-					{
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->active_layer->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
+					InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
+					GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
+					GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
+					GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
+					InitializeGraphicsMatrixIdentity(&matrix);
+					GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
+					GraphicsSetSource(&update.base, &core->temp_pattern.base);
 
 					for(i = 0; i < height; i++)
 					{
@@ -716,91 +550,29 @@ void EraserMotionCallBack(
 						);
 					}
 
+					GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
+						-draw_x + r, -draw_y + r);
 					GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-						0, 0, &surface_pattern);
-					GraphicsMaskSurface(&update_temp.base, &canvas->texture->surface.base,
+						0, 0, &temp_pattern);
+					GraphicsMaskSurface(&update_temp.base, &canvas->active_layer->surface.base,
 						-draw_x + r, -draw_y + r);
 
 					mask = canvas->temp_layer->pixels;
-				}
-				else
-				{
-					if((canvas->active_layer->flags & LAYER_LOCK_OPACITY) == 0)
-					{
-						GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->temp_layer->pixels[
-								(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-							0, 0, &surface_pattern);
-						GraphicsMaskSurface(&update_temp.base, &canvas->texture->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						mask = canvas->temp_layer->pixels;
-					}
-					else
-					{
-						GRAPHICS_SURFACE_PATTERN surface_pattern = { 0 };
-
-						InitializeGraphicsMatrixScale(&matrix, zoom, zoom);
-						GraphicsPatternSetMatrix(&core->brush_pattern.base, &matrix);
-						GraphicsSetSource(&core->temp_context.base, &core->brush_pattern.base);
-						GraphicsPaintWithAlpha(&core->temp_context.base, alpha);
-						InitializeGraphicsMatrixIdentity(&matrix);
-						GraphicsPatternSetMatrix(&core->temp_pattern.base, &matrix);
-						GraphicsSetSource(&update.base, &core->temp_pattern.base);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->temp_layer->pixels[
-								(i + start_y) * canvas->temp_layer->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsSetSourceSurface(&update_temp.base, &update_surface.base,
-							0, 0, &surface_pattern);
-						GraphicsMaskSurface(&update.base, &canvas->selection->surface.base,
-							-draw_x + r, -draw_y + r);
-
-						for(i = 0; i < height; i++)
-						{
-							(void)memset(&canvas->mask_temp->pixels[
-								(i + start_y) * canvas->mask_temp->stride + start_x * 4],
-								0, stride
-							);
-						}
-
-						GraphicsSetSourceSurface(&update.base, &temp_surface.base,
-							0, 0, &surface_pattern);
-						GraphicsMaskSurface(&update.base, &canvas->texture->surface.base,
-							-draw_x + r, -draw_y + r);
-					}
-				}
 
-				GraphicsSurfaceFinish(&temp_surface.base);
-				DestroyGraphicsContext(&update_temp.base);
+					GraphicsSurfaceFinish(&temp_surface.base);
+					DestroyGraphicsContext(&update_temp.base);
+				}
 			}
 
 			GraphicsSurfaceFinish(&update_surface.base);
 			DestroyGraphicsContext(&update.base);
 
+			if(canvas->app->textures.active_texture != 0)
+			{	// gkE]ς݂̃eNX`uV̌`ɒڏZ
+				ApplyTextureToBrushPixels(&canvas->app->textures, mask, canvas->work_layer->stride,
+					start_x, start_y, width, height);
+			}
+
 #ifdef _OPENMP
 			if(height <= MINIMUM_PARALLEL_SIZE)
 			{
@@ -13,43 +13,87 @@
 
 #include <math.h>
 #include <string.h>
-#include "application.h"
+// application.hから同名のガードのpixel_manipulate/configure.hが読まれる前に読み込む
 #include "configure.h"
+#include "application.h"
 #include "memory.h"
 #include "color.h"
+#include "gui/gui.h"
 #include "utils.h"
 #include "srgb_profile.h"
 #include "gui/tool_box.h"
 
+#if defined(USE_SSE2) && USE_SSE2 != 0
+# include <emmintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// 1/d(d=1～255)の固定小数点の値(2^31/dの切り上げ)
+	// 65535+255以下の値との積を31ビット右シフトすると割り算の結果に一致する
+static const uint32 g_hsv_reciprocal[256] =
+{
+	0x00000000, 0x80000000, 0x40000000, 0x2AAAAAAB, 0x20000000, 0x1999999A, 0x15555556, 0x12492493,
+	0x10000000, 0x0E38E38F, 0x0CCCCCCD, 0x0BA2E8BB, 0x0AAAAAAB, 0x09D89D8A, 0x0924924A, 0x08888889,
+	0x08000000, 0x07878788, 0x071C71C8, 0x06BCA1B0, 0x06666667, 0x06186187, 0x05D1745E, 0x0590B217,
+	0x05555556, 0x051EB852, 0x04EC4EC5, 0x04BDA130, 0x04924925, 0x0469EE59, 0x04444445, 0x04210843,
+	0x04000000, 0x03E0F83F, 0x03C3C3C4, 0x03A83A84, 0x038E38E4, 0x03759F23, 0x035E50D8, 0x03483484,
+	0x03333334, 0x031F3832, 0x030C30C4, 0x02FA0BE9, 0x02E8BA2F, 0x02D82D83, 0x02C8590C, 0x02B93106,
+	0x02AAAAAB, 0x029CBC15, 0x028F5C29, 0x02828283, 0x02762763, 0x026A43A0, 0x025ED098, 0x0253C826,
+	0x02492493, 0x023EE090, 0x0234F72D, 0x022B63CC, 0x02222223, 0x02192E2A, 0x02108422, 0x02082083,
+	0x02000000, 0x01F81F82, 0x01F07C20, 0x01E9131B, 0x01E1E1E2, 0x01DAE608, 0x01D41D42, 0x01CD8569,
+	0x01C71C72, 0x01C0E071, 0x01BACF92, 0x01B4E81C, 0x01AF286C, 0x01A98EF7, 0x01A41A42, 0x019EC8EA,
+	0x0199999A, 0x01948B10, 0x018F9C19, 0x018ACB91, 0x01861862, 0x01818182, 0x017D05F5, 0x0178A4C9,
+	0x01745D18, 0x01702E06, 0x016C16C2, 0x01681682, 0x01642C86, 0x01605817, 0x015C9883, 0x0158ED24,
+	0x01555556, 0x0151D07F, 0x014E5E0B, 0x014AFD6B, 0x0147AE15, 0x01446F87, 0x01414142, 0x013E22CC,
+	0x013B13B2, 0x01381382, 0x013521D0, 0x01323E35, 0x012F684C, 0x012C9FB5, 0x0129E413, 0x0127350C,
+	0x0124924A, 0x0121FB79, 0x011F7048, 0x011CF06B, 0x011A7B97, 0x01181182, 0x0115B1E6, 0x01135C82,
+	0x01111112, 0x010ECF57, 0x010C9715, 0x010A6811, 0x01084211, 0x010624DE, 0x01041042, 0x01020409,
+	0x01000000, 0x00FE03F9, 0x00FC0FC1, 0x00FA232D, 0x00F83E10, 0x00F6603E, 0x00F4898E, 0x00F2B9D7,
+	0x00F0F0F1, 0x00EF2EB8, 0x00ED7304, 0x00EBBDB3, 0x00EA0EA1, 0x00E865AD, 0x00E6C2B5, 0x00E52599,
+	0x00E38E39, 0x00E1FC79, 0x00E07039, 0x00DEE95D, 0x00DD67C9, 0x00DBEB62, 0x00DA740E, 0x00D901B3,
+	0x00D79436, 0x00D62B81, 0x00D4C77C, 0x00D3680E, 0x00D20D21, 0x00D0B6A0, 0x00CF6475, 0x00CE168B,
+	0x00CCCCCD, 0x00CB8728, 0x00CA4588, 0x00C907DB, 0x00C7CE0D, 0x00C6980D, 0x00C565C9, 0x00C43730,
+	0x00C30C31, 0x00C1E4BC, 0x00C0C0C1, 0x00BFA030, 0x00BE82FB, 0x00BD6911, 0x00BC5265, 0x00BB3EE8,
+	0x00BA2E8C, 0x00B92144, 0x00B81703, 0x00B70FBC, 0x00B60B61, 0x00B509E7, 0x00B40B41, 0x00B30F64,
+	0x00B21643, 0x00B11FD4, 0x00B02C0C, 0x00AF3ADE, 0x00AE4C42, 0x00AD602C, 0x00AC7692, 0x00AB8F6A,
+	0x00AAAAAB, 0x00A9C84B, 0x00A8E840, 0x00A80A81, 0x00A72F06, 0x00A655C5, 0x00A57EB6, 0x00A4A9D0,
+	0x00A3D70B, 0x00A3065F, 0x00A237C4, 0x00A16B32, 0x00A0A0A1, 0x009FD80A, 0x009F1166, 0x009E4CAE,
+	0x009D89D9, 0x009CC8E2, 0x009C09C1, 0x009B4C70, 0x009A90E8, 0x0099D723, 0x00991F1B, 0x009868C9,
+	0x0097B426, 0x0097012F, 0x00964FDB, 0x0095A026, 0x0094F20A, 0x00944581, 0x00939A86, 0x0092F114,
+	0x00924925, 0x0091A2B4, 0x0090FDBD, 0x00905A39, 0x008FB824, 0x008F177A, 0x008E7836, 0x008DDA53,
+	0x008D3DCC, 0x008CA29D, 0x008C08C1, 0x008B7035, 0x008AD8F3, 0x008A42F9, 0x0089AE41, 0x00891AC8,
+	0x00888889, 0x0087F781, 0x008767AC, 0x0086D906, 0x00864B8B, 0x0085BF38, 0x00853409, 0x0084A9FA,
+	0x00842109, 0x00839931, 0x0083126F, 0x00828CC0, 0x00820821, 0x0081848E, 0x00810205, 0x00808081
+};
+
+// 15300(=255*60)の割り算に使う固定小数点の値とシフト量(255*15300以下の値で一致する)
+#define HSV_DIVIDE_15300_MULTIPLIER 2245735
+#define HSV_DIVIDE_15300_SHIFT 35
+
 void RGB2HSV_Pixel(uint8 rgb[3], HSV* hsv)
 {
-#define MAX_IS_RED 0
-#define MAX_IS_GREEN 1
-#define MAX_IS_BLUE 2
-
-	unsigned char maximum, minimum;
-	int channel = MAX_IS_RED;
-	FLOAT_T d;
-	FLOAT_T cr, cg, cb;
-	FLOAT_T h;
-	
-	maximum = rgb[0];
+	int maximum = rgb[0],	minimum = rgb[0];
+	// 最大のチャンネル以外の2つの差と色相の基準
+	int difference = rgb[1] - rgb[2];
+	int base = 0;
+	int delta, hue;
+
 	if(maximum < rgb[1])
 	{
-		channel = MAX_IS_GREEN;
 		maximum = rgb[1];
+		difference = rgb[2] - rgb[0];
+		base = 120;
 	}
 	if(maximum < rgb[2])
 	{
-		channel = MAX_IS_BLUE;
 		maximum = rgb[2];
+		difference = rgb[0] - rgb[1];
+		base = 240;
 	}
 
-	minimum = rgb[0];
 	if(minimum > rgb[1])
 	{
 		minimum = rgb[1];
@@ -59,40 +103,191 @@ void RGB2HSV_Pixel(uint8 rgb[3], HSV* hsv)
 		minimum = rgb[2];
 	}
 
-	d = 1.0 / (maximum - minimum);
-	hsv->v = maximum;
+	delta = maximum - minimum;
+	hsv->v = (uint8)maximum;
 
-	if(maximum == 0)
-	{
+	if(delta == 0)
+	{	// 無彩色は色相0とする
 		hsv->s = 0;
 		hsv->h = 0;
+		return;
 	}
-	else
+
+	hsv->s = (uint8)(255 * delta / maximum);
+	// 60 * difference / deltaの切り捨て(負の値も小さい方へ)
+	difference *= 60;
+	hue = (difference >= 0) ? difference / delta : - ((- difference + delta - 1) / delta);
+	hue += base;
+	if(hue < 0)
 	{
-		hsv->s = (uint8)(255*(maximum - minimum)/(FLOAT_T)maximum);
-		cr = (maximum - rgb[0])*d;
-		cg = (maximum - rgb[1])*d;
-		cb = (maximum - rgb[2])*d;
+		hue += 360;
+	}
+	hsv->h = (int16)hue;
+}
 
-		switch(channel)
-		{
-		case MAX_IS_RED:
-			h = cb - cg;
-			break;
-		case MAX_IS_GREEN:
-			h = 2 + cr - cb;
-			break;
-		default:
-			h = 4 + cg - cr;
-		}
+#if defined(USE_SSE2) && USE_SSE2 != 0
+/*
+* SelectHSVLane関数
+* マスクが立っているレーンはa、それ以外はbを選ぶ
+* 引数
+* mask	: 選択するレーンのマスク
+* a		: マスクが立っているレーンの値
+* b		: それ以外のレーンの値
+* 返り値
+*	選択した値
+*/
+static INLINE __m128i SelectHSVLane(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/*
+* LoadHSVReciprocals関数
+* 32ビットのレーン毎に1/dの固定小数点の値を読み込む
+* 引数
+* divisor	: 割る数(0～255)
+* 返り値
+*	固定小数点の値
+*/
+static INLINE __m128i LoadHSVReciprocals(__m128i divisor)
+{
+	int32 index[4];
+	_mm_storeu_si128((__m128i*)index, divisor);
+	return _mm_setr_epi32((int)g_hsv_reciprocal[index[0]], (int)g_hsv_reciprocal[index[1]],
+		(int)g_hsv_reciprocal[index[2]], (int)g_hsv_reciprocal[index[3]]);
+}
 
-		h *= 60;
-		if(h < 0)
+/*
+* MultiplyShiftHSV関数
+* 32ビットのレーン毎に64ビットで乗算して右シフトする(結果は32ビットに収まること)
+* 引数
+* value			: 掛けられる数
+* multiplier	: 掛ける数
+* shift			: 右シフトするビット数
+* 返り値
+*	計算結果
+*/
+static INLINE __m128i MultiplyShiftHSV(__m128i value, __m128i multiplier, int shift)
+{
+	__m128i count = _mm_cvtsi32_si128(shift);
+	__m128i even = _mm_srl_epi64(_mm_mul_epu32(value, multiplier), count);
+	__m128i odd = _mm_srl_epi64(_mm_mul_epu32(_mm_srli_epi64(value, 32),
+		_mm_srli_epi64(multiplier, 32)), count);
+	return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+#endif
+
+/*
+* RGB2HSV_Line関数
+* 1行分のピクセルを固定小数点でHSVに変換する
+*  1ピクセル4バイトならSSE2で4ピクセルずつ処理する(結果はRGB2HSV_Pixelと同じ)
+* 引数
+* pixels		: R, G, Bの順に並んだピクセルデータ
+* hsv			: 変換結果を入れる配列
+* num_pixels	: ピクセル数
+* channel		: 1ピクセルのバイト数(3以上)
+*/
+void RGB2HSV_Line(const uint8* pixels, HSV* hsv, int num_pixels, int channel)
+{
+	int i = 0;
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	if(channel == 4 && sizeof(HSV) == 4)
+	{
+		const __m128i byte_mask = _mm_set1_epi32(0xFF);
+		const __m128i hue_mask = _mm_set1_epi32(0xFFFF);
+		const __m128i zero = _mm_setzero_si128();
+
+		for( ; i + 4 <= num_pixels; i += 4)
 		{
-			h += 360;
+			__m128i source = _mm_loadu_si128((const __m128i*)&pixels[i*4]);
+			__m128i red = _mm_and_si128(source, byte_mask);
+			__m128i green = _mm_and_si128(_mm_srli_epi32(source, 8), byte_mask);
+			__m128i blue = _mm_and_si128(_mm_srli_epi32(source, 16), byte_mask);
+			// 0～255の値なので16ビット単位の比較で32ビットのレーンの最大・最小になる
+			__m128i red_green = _mm_max_epi16(red, green);
+			__m128i maximum = _mm_max_epi16(red_green, blue);
+			__m128i minimum = _mm_min_epi16(_mm_min_epi16(red, green), blue);
+			__m128i delta = _mm_sub_epi32(maximum, minimum);
+			// 同じ値なら赤→緑→青の順に最大のチャンネルとする
+			__m128i is_blue = _mm_cmpgt_epi32(blue, red_green);
+			__m128i is_green = _mm_andnot_si128(is_blue, _mm_cmpgt_epi32(green, red));
+			__m128i difference, negative, numerator, hue, saturation;
+
+			difference = _mm_sub_epi32(green, blue);
+			difference = SelectHSVLane(is_green, _mm_sub_epi32(blue, red), difference);
+			difference = SelectHSVLane(is_blue, _mm_sub_epi32(red, green), difference);
+
+			// 負の値は絶対値を切り上げて割ってから符号を戻す
+			negative = _mm_cmpgt_epi32(zero, difference);
+			difference = _mm_sub_epi32(_mm_xor_si128(difference, negative), negative);
+			numerator = _mm_add_epi32(_mm_mullo_epi16(difference, _mm_set1_epi32(60)),
+				_mm_and_si128(negative, _mm_sub_epi32(delta, _mm_set1_epi32(1))));
+			hue = MultiplyShiftHSV(numerator, LoadHSVReciprocals(delta), 31);
+			hue = _mm_sub_epi32(_mm_xor_si128(hue, negative), negative);
+			hue = _mm_add_epi32(hue, _mm_or_si128(_mm_and_si128(is_green, _mm_set1_epi32(120)),
+				_mm_and_si128(is_blue, _mm_set1_epi32(240))));
+			hue = _mm_add_epi32(hue, _mm_and_si128(_mm_cmpgt_epi32(zero, hue), _mm_set1_epi32(360)));
+
+			saturation = MultiplyShiftHSV(_mm_mullo_epi16(delta, _mm_set1_epi32(255)),
+				LoadHSVReciprocals(maximum), 31);
+
+			// HSV構造体の並び(h:16ビット, s, v)に詰める
+			_mm_storeu_si128((__m128i*)&hsv[i], _mm_or_si128(_mm_and_si128(hue, hue_mask),
+				_mm_or_si128(_mm_slli_epi32(saturation, 16), _mm_slli_epi32(maximum, 24))));
 		}
-		hsv->h = (int16)h;
 	}
+#endif
+
+	for( ; i<num_pixels; i++)
+	{
+		RGB2HSV_Pixel((uint8*)&pixels[i*channel], &hsv[i]);
+	}
+}
+
+/*
+* HSV_CONVERT_DATA構造体
+* 画像全体のHSV変換をスレッドプールで処理するためのデータ
+*/
+typedef struct _HSV_CONVERT_DATA
+{
+	uint8 *pixels;
+	HSV *hsv;
+	int width;
+	int stride;
+	int channel;
+} HSV_CONVERT_DATA;
+
+/*
+* RGB2HSV_Task関数
+* スレッドプールから呼び出されて1行分のピクセルをHSVに変換する
+* 引数
+* index			: 行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: HSV_CONVERT_DATA構造体のアドレス
+*/
+static void RGB2HSV_Task(int index, int thread_index, void* data)
+{
+	HSV_CONVERT_DATA *convert = (HSV_CONVERT_DATA*)data;
+	(void)thread_index;
+	RGB2HSV_Line(&convert->pixels[index*convert->stride], &convert->hsv[index*convert->width],
+		convert->width, convert->channel);
+}
+
+/*
+* HSV2RGB_Task関数
+* スレッドプールから呼び出されて1行分のHSVをピクセルに変換する
+* 引数
+* index			: 行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: HSV_CONVERT_DATA構造体のアドレス
+*/
+static void HSV2RGB_Task(int index, int thread_index, void* data)
+{
+	HSV_CONVERT_DATA *convert = (HSV_CONVERT_DATA*)data;
+	(void)thread_index;
+	HSV2RGB_Line(&convert->hsv[index*convert->width], &convert->pixels[index*convert->stride],
+		convert->width, convert->channel);
 }
 
 HSV* RGB2HSV(
@@ -102,77 +297,158 @@ HSV* RGB2HSV(
 	int32 channel
 )
 {
-	int stride = width * channel;
-	HSV *ret = (HSV*)MEM_ALLOC_FUNC(sizeof(*ret)*stride*height);
-	int i;
+	HSV_CONVERT_DATA convert;
+	HSV *ret = (HSV*)MEM_ALLOC_FUNC(sizeof(*ret)*width*height);
 
-#ifdef _OPENMP
-#pragma omp parallel for firstprivate(width, pixels, ret, stride, channel)
-#endif
-	for(i=0; i<height; i++)
-	{
-		int j;
-		for(j=0; j<width; j++)
-		{
-			RGB2HSV_Pixel(&pixels[i*stride+j*channel], &ret[i*width+j]);
-		}
-	}
+	convert.pixels = pixels;
+	convert.hsv = ret;
+	convert.width = width;
+	convert.stride = width * channel;
+	convert.channel = channel;
+	ExecuteParallelLoop(height, RGB2HSV_Task, &convert);
 
 	return ret;
 }
 
 void HSV2RGB_Pixel(HSV* hsv, uint8 rgb[3])
 {
-	int tempi, tempm, tempn, tempk;
-	FLOAT_T tempf, div_f, div_s;
+	int hue = hsv->h % 360;
+	int saturation = hsv->s;
+	int value = hsv->v;
+	int sector, fraction;
+	int tempm, tempn, tempk;
 
-	if(hsv->v == 0)
+	if(hue < 0)
 	{
-		rgb[0] = rgb[1] = rgb[2] = 0;
+		hue += 360;
 	}
-	else
+	sector = hue / 60;
+	fraction = hue - sector * 60;
+	tempm = value * (255 - saturation) / 255;
+	tempn = value * (255 * 60 - saturation * fraction) / (255 * 60);
+	tempk = value * (255 * 60 - saturation * (60 - fraction)) / (255 * 60);
+
+	switch(sector)
 	{
-		div_f = hsv->h/(FLOAT_T)60;
-		div_s = hsv->s/(FLOAT_T)255;
-		tempi = (int)div_f;
-		tempf = div_f - tempi;
-		tempm = (int)(hsv->v*(1 - div_s));
-		tempn = (int)(hsv->v*(1 - div_s*tempf));
-		tempk = (int)(hsv->v*(1 - div_s*(1 - tempf)));
-
-		switch(tempi)
+	case 0:
+		rgb[0] = (uint8)value;
+		rgb[1] = (uint8)tempk;
+		rgb[2] = (uint8)tempm;
+		break;
+	case 1:
+		rgb[0] = (uint8)tempn;
+		rgb[1] = (uint8)value;
+		rgb[2] = (uint8)tempm;
+		break;
+	case 2:
+		rgb[0] = (uint8)tempm;
+		rgb[1] = (uint8)value;
+		rgb[2] = (uint8)tempk;
+		break;
+	case 3:
+		rgb[0] = (uint8)tempm;
+		rgb[1] = (uint8)tempn;
+		rgb[2] = (uint8)value;
+		break;
+	case 4:
+		rgb[0] = (uint8)tempk;
+		rgb[1] = (uint8)tempm;
+		rgb[2] = (uint8)value;
+		break;
+	default:
+		rgb[0] = (uint8)value;
+		rgb[1] = (uint8)tempm;
+		rgb[2] = (uint8)tempn;
+	}
+}
+
+/*
+* HSV2RGB_Line関数
+* 1行分のHSVを固定小数点でピクセルに変換する
+*  1ピクセル4バイトならSSE2で4ピクセルずつ処理する(4バイト目はそのまま残す)
+* 引数
+* hsv			: 変換するHSVの配列
+* pixels		: 変換結果をR, G, Bの順に入れるピクセルデータ
+* num_pixels	: ピクセル数
+* channel		: 1ピクセルのバイト数(3以上)
+*/
+void HSV2RGB_Line(const HSV* hsv, uint8* pixels, int num_pixels, int channel)
+{
+	int i = 0;
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	if(channel == 4 && sizeof(HSV) == 4)
+	{
+		const __m128i byte_mask = _mm_set1_epi32(0xFF);
+		const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+		const __m128i zero = _mm_setzero_si128();
+
+		for( ; i + 4 <= num_pixels; i += 4)
 		{
-		case 0:
-			rgb[0] = hsv->v;
-			rgb[1] = (uint8)tempk;
-			rgb[2] = (uint8)tempm;
-			break;
-		case 1:
-			rgb[0] = tempn;
-			rgb[1] = hsv->v;
-			rgb[2] = tempm;
-			break;
-		case 2:
-			rgb[0] = tempm;
-			rgb[1] = hsv->v;
-			rgb[2] = tempk;
-			break;
-		case 3:
-			rgb[0] = tempm;
-			rgb[1] = tempn;
-			rgb[2] = hsv->v;
-			break;
-		case 4:
-			rgb[0] = tempk;
-			rgb[1] = tempm;
-			rgb[2] = hsv->v;
-			break;
-		default:
-			rgb[0] = hsv->v;
-			rgb[1] = tempm;
-			rgb[2] = tempn;
+			__m128i source = _mm_loadu_si128((const __m128i*)&hsv[i]);
+			__m128i hue = _mm_srai_epi32(_mm_slli_epi32(source, 16), 16);
+			__m128i saturation, value, sector, fraction;
+			__m128i tempm, tempn, tempk;
+			__m128i sectors[6];
+			__m128i red, green, blue;
+			int j;
+
+			// 0～359の範囲外の色相は1ピクセルずつ処理する
+			if(_mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi32(zero, hue),
+				_mm_cmpgt_epi32(hue, _mm_set1_epi32(359)))) != 0)
+			{
+				for(j=0; j<4; j++)
+				{
+					HSV2RGB_Pixel((HSV*)&hsv[i+j], &pixels[(i+j)*4]);
+				}
+				continue;
+			}
+
+			saturation = _mm_and_si128(_mm_srli_epi32(source, 16), byte_mask);
+			value = _mm_srli_epi32(source, 24);
+			// hue * 1093 / 65536は360未満でhue / 60の切り捨てに一致する
+			sector = _mm_mulhi_epu16(hue, _mm_set1_epi32(1093));
+			fraction = _mm_sub_epi32(hue, _mm_mullo_epi16(sector, _mm_set1_epi32(60)));
+
+			// 上位16ビットが0なので_mm_madd_epi16でレーン毎の32ビットの積になる
+			tempm = _mm_madd_epi16(value, _mm_sub_epi32(_mm_set1_epi32(255), saturation));
+			tempm = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(tempm, _mm_set1_epi32(1)),
+				_mm_srli_epi32(tempm, 8)), 8);
+			tempn = _mm_madd_epi16(value, _mm_sub_epi32(_mm_set1_epi32(255 * 60),
+				_mm_mullo_epi16(saturation, fraction)));
+			tempn = MultiplyShiftHSV(tempn, _mm_set1_epi32(HSV_DIVIDE_15300_MULTIPLIER),
+				HSV_DIVIDE_15300_SHIFT);
+			tempk = _mm_madd_epi16(value, _mm_sub_epi32(_mm_set1_epi32(255 * 60),
+				_mm_mullo_epi16(saturation, _mm_sub_epi32(_mm_set1_epi32(60), fraction))));
+			tempk = MultiplyShiftHSV(tempk, _mm_set1_epi32(HSV_DIVIDE_15300_MULTIPLIER),
+				HSV_DIVIDE_15300_SHIFT);
+
+			for(j=0; j<6; j++)
+			{
+				sectors[j] = _mm_cmpeq_epi32(sector, _mm_set1_epi32(j));
+			}
+			// HSV2RGB_Pixelのswitch文と同じ組み合わせ
+			red = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_or_si128(sectors[0], sectors[5]), value),
+				_mm_and_si128(sectors[1], tempn)), _mm_or_si128(
+					_mm_and_si128(_mm_or_si128(sectors[2], sectors[3]), tempm), _mm_and_si128(sectors[4], tempk)));
+			green = _mm_or_si128(_mm_or_si128(_mm_and_si128(sectors[0], tempk),
+				_mm_and_si128(_mm_or_si128(sectors[1], sectors[2]), value)), _mm_or_si128(
+					_mm_and_si128(sectors[3], tempn), _mm_and_si128(_mm_or_si128(sectors[4], sectors[5]), tempm)));
+			blue = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_or_si128(sectors[0], sectors[1]), tempm),
+				_mm_and_si128(sectors[2], tempk)), _mm_or_si128(
+					_mm_and_si128(_mm_or_si128(sectors[3], sectors[4]), value), _mm_and_si128(sectors[5], tempn)));
+
+			_mm_storeu_si128((__m128i*)&pixels[i*4], _mm_or_si128(
+				_mm_and_si128(_mm_loadu_si128((const __m128i*)&pixels[i*4]), alpha_mask),
+				_mm_or_si128(red, _mm_or_si128(_mm_slli_epi32(green, 8), _mm_slli_epi32(blue, 16)))));
 		}
 	}
+#endif
+
+	for( ; i<num_pixels; i++)
+	{
+		HSV2RGB_Pixel((HSV*)&hsv[i], &pixels[i*channel]);
+	}
 }
 
 void HSV2RGB(
@@ -183,16 +459,14 @@ void HSV2RGB(
 	int32 channel
 )
 {
-	int stride = width * channel;
-	int i, j;
-
-	for(i=0; i<height; i++)
-	{
-		for(j=0; j<width; j++)
-		{
-			HSV2RGB_Pixel(&hsv[i*width+j], &pixels[i*stride+j*channel]);
-		}
-	}
+	HSV_CONVERT_DATA convert;
+
+	convert.pixels = pixels;
+	convert.hsv = hsv;
+	convert.width = width;
+	convert.stride = width * channel;
+	convert.channel = channel;
+	ExecuteParallelLoop(height, HSV2RGB_Task, &convert);
 }
 
 void RGB2CMYK_Pixel(uint8 rgb[3], CMYK* cmyk)
@@ -118,8 +118,32 @@ EXTERN HSV* RGB2HSV(
 	int32 channel
 );
 
+/*
+* RGB2HSV_Line関数
+* 1行分のピクセルを固定小数点でHSVに変換する
+*  1ピクセル4バイトならSSE2で4ピクセルずつ処理する(結果はRGB2HSV_Pixelと同じ)
+* 引数
+* pixels		: R, G, Bの順に並んだピクセルデータ
+* hsv			: 変換結果を入れる配列
+* num_pixels	: ピクセル数
+* channel		: 1ピクセルのバイト数(3以上)
+*/
+EXTERN void RGB2HSV_Line(const uint8* pixels, HSV* hsv, int num_pixels, int channel);
+
 EXTERN void HSV2RGB_Pixel(HSV* hsv, uint8 rgb[3]);
 
+/*
+* HSV2RGB_Line関数
+* 1行分のHSVを固定小数点でピクセルに変換する
+*  1ピクセル4バイトならSSE2で4ピクセルずつ処理する(4バイト目はそのまま残す)
+* 引数
+* hsv			: 変換するHSVの配列
+* pixels		: 変換結果をR, G, Bの順に入れるピクセルデータ
+* num_pixels	: ピクセル数
+* channel		: 1ピクセルのバイト数(3以上)
+*/
+EXTERN void HSV2RGB_Line(const HSV* hsv, uint8* pixels, int num_pixels, int channel);
+
 EXTERN void HSV2RGB(
 	HSV* hsv,
 	uint8 *pixels,
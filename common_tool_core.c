@@ -50,7 +50,16 @@ void InitializeCommonToolTable(APPLICATION* app, INI_FILE_PTR file)
 	}
 }
 
-int ReadCommonToolInitializeFile(APPLICATION* app, const char* file_path)
+/*
+* LoadCommonToolInitializeFile関数
+* 共通ツールの初期化ファイルを読み込んで解析する
+*  アプリケーションのデータに触れないので、起動時に別スレッドで呼び出せる
+* 引数
+* file_path	: 初期化ファイルのパス(開けなければ組み込みのデータを使う)
+* 返り値
+*	解析したデータ 失敗時はNULL
+*/
+INI_FILE_PTR LoadCommonToolInitializeFile(const char* file_path)
 {
 	INI_FILE_PTR file;
 	FILE *fp = NULL;
@@ -85,13 +94,12 @@ int ReadCommonToolInitializeFile(APPLICATION* app, const char* file_path)
 		file_size = sizeof(comon_tool_default_data);
 		if(mem_stream == NULL)
 		{
-			return -1;
+			return NULL;
 		}
 		(void)memcpy(mem_stream->buff_ptr, comon_tool_default_data, sizeof(comon_tool_default_data));
 	}
 	
 	file = CreateIniFile(stream, read_func, file_size, INI_READ);
-	InitializeCommonToolTable(app, file);
 	
 	if(fp != NULL)
 	{
@@ -101,6 +109,19 @@ int ReadCommonToolInitializeFile(APPLICATION* app, const char* file_path)
 	{
 		(void)DeleteMemoryStream(mem_stream);
 	}
+	return file;
+}
+
+int ReadCommonToolInitializeFile(APPLICATION* app, const char* file_path)
+{
+	INI_FILE_PTR file = LoadCommonToolInitializeFile(file_path);
+
+	if(file == NULL)
+	{
+		return -1;
+	}
+	InitializeCommonToolTable(app, file);
+
 	return 0;
 }
 
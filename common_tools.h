@@ -43,6 +43,27 @@ typedef enum _eCOMMON_TOOL_FLAGS
 } eCOMMON_TOOL_FLAGS;
 
 EXTERN int ReadCommonToolInitializeFile(APPLICATION* app, const char* file_path);
+
+/*
+* LoadCommonToolInitializeFile֐
+* ʃc[̏t@Cǂݍŉ͂
+*  AvP[Ṽf[^ɐGȂ̂ŁANɕʃXbhŌĂяo
+* 
+* file_path	: t@C̃pX(JȂΑgݍ݂̃f[^g)
+* Ԃl
+*	͂f[^ sNULL
+*/
+EXTERN INI_FILE_PTR LoadCommonToolInitializeFile(const char* file_path);
+
+/*
+* InitializeCommonToolTable֐
+* ͍ς݂̏t@C狤ʃc[̃e[u쐬
+*  c[GUÎŃCXbhŌĂяo
+* 
+* app	: AvP[VŜǗ\̂̃AhX
+* file	: LoadCommonToolInitializeFileŉ͂f[^
+*/
+EXTERN void InitializeCommonToolTable(APPLICATION* app, INI_FILE_PTR file);
 extern void LoadCommonToolDetailData(
 	COMMON_TOOL_CORE** core,
 	INI_FILE_PTR file,
@@ -14,6 +14,94 @@ typedef enum _eUPDATE_MODE
 	UPDATE_PART
 } eUPDATE_MODE;
 
+/*
+* UpdateAdjustmentLayers関数
+* レイヤーの上に続く調整レイヤーの結果を更新する
+*  連続する調整レイヤーは一番上の表示中のものにまとめて1回で適用する
+* 引数
+* layer		: 調整レイヤーの直下のレイヤー(一番上の調整レイヤーに進める)
+* mixed		: 下のレイヤーの合成結果
+* start_x	: 更新範囲の左上のX座標
+* start_y	: 更新範囲の左上のY座標
+* width		: 更新範囲の幅
+* height	: 更新範囲の高さ
+* 返り値
+*	合成に使う調整レイヤー 表示中の調整レイヤーが無ければNULL
+*/
+static LAYER* UpdateAdjustmentLayers(
+	LAYER** layer,
+	LAYER* mixed,
+	int start_x,
+	int start_y,
+	int width,
+	int height
+)
+{
+	LAYER *top = NULL;
+
+	while((*layer)->next != NULL && (*layer)->next->layer_type == TYPE_ADJUSTMENT_LAYER)
+	{
+		*layer = (*layer)->next;
+		if(((*layer)->flags & LAYER_FLAG_INVISIBLE) == 0)
+		{
+			top = *layer;
+		}
+	}
+
+	if(top != NULL)
+	{	// 下の調整レイヤーは一番上の調整レイヤーの処理にまとめられる
+		top->layer_data.adjustment_layer->update(top->layer_data.adjustment_layer,
+			top->prev, mixed, start_x, start_y, width, height);
+	}
+
+	return top;
+}
+
+/*
+* CopyLayerRectangle関数
+* レイヤーのピクセルデータを指定した範囲だけコピーする
+*  範囲は端数を含むように広げ、レイヤーの外にはみ出した部分は切り捨てる
+* 引数
+* dst		: コピー先のレイヤー
+* src		: コピー元のレイヤー(dstと同じサイズ)
+* update	: コピーする範囲
+*/
+static void CopyLayerRectangle(LAYER* dst, LAYER* src, UPDATE_RECTANGLE* update)
+{
+	int start_x = (int)update->x;
+	int start_y = (int)update->y;
+	int end_x = (int)(update->x + update->width) + 1;
+	int end_y = (int)(update->y + update->height) + 1;
+	int y;
+
+	if(start_x < 0)
+	{
+		start_x = 0;
+	}
+	if(start_y < 0)
+	{
+		start_y = 0;
+	}
+	if(end_x > src->width)
+	{
+		end_x = src->width;
+	}
+	if(end_y > src->height)
+	{
+		end_y = src->height;
+	}
+	if(start_x >= end_x)
+	{
+		return;
+	}
+
+	for(y=start_y; y<end_y; y++)
+	{
+		(void)memcpy(&dst->pixels[y*dst->stride + start_x*4],
+			&src->pixels[y*src->stride + start_x*4], (end_x - start_x) * 4);
+	}
+}
+
 eDRAW_WINDOW_DIPSLAY_UPDATE_RESULT LayerBlendForDisplay(DRAW_WINDOW* canvas)
 {
 	APPLICATION *app = canvas->app;
@@ -40,6 +128,7 @@ eDRAW_WINDOW_DIPSLAY_UPDATE_RESULT LayerBlendForDisplay(DRAW_WINDOW* canvas)
 			{   // 全レイヤー合成
 				(void)memcpy(canvas->mixed_layer->pixels, canvas->back_ground, canvas->pixel_buf_size);
 				layer = canvas->layer;
+				InvalidateDisplayFilter(&canvas->app->display_filter, 0, 0, canvas->width, canvas->height);
 				result = DRAW_WINDOW_DIPSLAY_UPDATE_RESULT_ALL;
 			}
 			else if((canvas->flags & DRAW_WINDOW_UPDATE_ACTIVE_OVER) != 0)
@@ -56,6 +145,7 @@ eDRAW_WINDOW_DIPSLAY_UPDATE_RESULT LayerBlendForDisplay(DRAW_WINDOW* canvas)
 						(void)memcpy(canvas->mixed_layer->pixels, canvas->under_active->pixels, canvas->pixel_buf_size);
 					}
 					layer = canvas->active_layer;
+					InvalidateDisplayFilter(&canvas->app->display_filter, 0, 0, canvas->width, canvas->height);
 				}
 				result = DRAW_WINDOW_DIPSLAY_UPDATE_RESULT_ALL;
 			}
@@ -127,6 +217,8 @@ eDRAW_WINDOW_DIPSLAY_UPDATE_RESULT LayerBlendForDisplay(DRAW_WINDOW* canvas)
 						}
 					}
 					layer = canvas->active_layer;
+					InvalidateDisplayFilter(&canvas->app->display_filter, (int)canvas->update.x, (int)canvas->update.y,
+						(int)canvas->update.width, (int)canvas->update.height);
 				}
 				clear_part = TRUE;
 				clear_x = (int)canvas->update.x;
@@ -226,19 +318,14 @@ eDRAW_WINDOW_DIPSLAY_UPDATE_RESULT LayerBlendForDisplay(DRAW_WINDOW* canvas)
 						RenderTextLayer(canvas, layer, layer->layer_data.text_layer);
 					}
 
-					while(layer->next != NULL && layer->next->layer_type == TYPE_ADJUSTMENT_LAYER)
-					{
-						if((layer->next->flags & LAYER_FLAG_INVISIBLE) != 0)
+					if(layer->next != NULL && layer->next->layer_type == TYPE_ADJUSTMENT_LAYER)
+					{	// 入力が変わったタイルだけ調整結果を作り直す
+						LAYER *adjustment = UpdateAdjustmentLayers(&layer, canvas->mixed_layer,
+							0, 0, layer->width, layer->height);
+						if(adjustment != NULL)
 						{
-							layer->next->layer_data.adjustment_layer->filter_func(
-								layer->next->layer_data.adjustment_layer, layer->pixels, layer->next->pixels,
-									layer->width * layer->height, layer);
+							blend_layer = adjustment;
 						}
-						layer->next->layer_data.adjustment_layer->update(
-							layer->next->layer_data.adjustment_layer, layer, canvas->mixed_layer,
-								0, 0, layer->width, layer->height);
-						blend_layer = layer->next;
-						layer = layer->next;
 					}
 
 					// サムネイル更新
@@ -247,9 +334,17 @@ eDRAW_WINDOW_DIPSLAY_UPDATE_RESULT LayerBlendForDisplay(DRAW_WINDOW* canvas)
 						UpdateLayerThumbnail(layer);
 					}
 				}
+				else if(layer->tiles != NULL)
+				{	// タイル形式のレイヤーは不透明なタイルを含む範囲のみ展開して合成
+					BlendTiledLayer(layer, canvas->mixed_layer, blend_mode, canvas);
+					blend_layer = NULL;
+				}
 
 				// 合成する対象と方法が確定したので合成を実行する
-				canvas->layer_blend_functions[blend_mode](blend_layer, canvas->mixed_layer);
+				if(blend_layer != NULL)
+				{
+					canvas->layer_blend_functions[blend_mode](blend_layer, canvas->mixed_layer);
+				}
 				// 合成したらデータを元に戻す
 				canvas->temp_layer->alpha = 100;
 				canvas->temp_layer->flags = 0;
@@ -299,8 +394,8 @@ count++;}
 				{
 					if(layer->layer_type == TYPE_NORMAL_LAYER)
 					{	// 通常レイヤーは
-							// 作業レイヤーとアクティブレイヤーを一度合成してから下のレイヤーと合成
-						(void)memcpy(canvas->temp_layer->pixels, layer->pixels, layer->stride*layer->height);
+							// 作業レイヤーとアクティブレイヤーを更新範囲だけ合成してから下のレイヤーと合成
+						CopyLayerRectangle(canvas->temp_layer, layer, &canvas->temp_update);
 						canvas->part_layer_blend_functions[canvas->work_layer->layer_mode](canvas->work_layer, canvas->temp_layer, &canvas->temp_update);
 						blend_layer = canvas->temp_layer;
 						blend_layer->alpha = layer->alpha;
@@ -324,46 +419,29 @@ count++;}
 
 					if(layer->next != NULL && layer->next->layer_type == TYPE_ADJUSTMENT_LAYER)
 					{
-						LAYER *src;
 						int start_x = (int)canvas->temp_update.x;
 						int start_y = (int)canvas->temp_update.y;
 						int update_width = (int)canvas->temp_update.width;
 						int update_height = (int)canvas->temp_update.height;
-						int update_stride = update_width * 4;
+						LAYER *adjustment;
 
-						do
+						// 更新範囲に掛かるタイルのうち入力が変わったものだけ作り直す
+						adjustment = UpdateAdjustmentLayers(&layer, canvas->mixed_layer,
+							start_x, start_y, update_width, update_height);
+						if(adjustment != NULL)
 						{
-							if((layer->next->flags & LAYER_FLAG_INVISIBLE) != 0)
-							{
-								int i;
-
-								src = (layer->next->layer_data.adjustment_layer->target == ADJUSTMENT_LAYER_TARGET_UNDER_LAYER) ?
-										layer : canvas->mixed_layer;
-								for(i=0; i<update_height; i++)
-								{
-									(void)memcpy(&canvas->mask_temp->pixels[i*update_stride],
-													&src->pixels[src->stride*i + start_x *4], update_stride);
-								}
-								layer->next->layer_data.adjustment_layer->filter_func(
-										layer->next->layer_data.adjustment_layer, canvas->mask_temp->pixels, canvas->mask->pixels,
-											update_width * update_height, layer);
-								for(i=0; i<update_height; i++)
-								{
-									(void)memcpy(&layer->next->pixels[src->stride*i + start_x *4],
-													&canvas->mask->pixels[i*update_stride], update_stride);
-								}
-							}
-
-							layer->next->layer_data.adjustment_layer->update(
-									layer->layer_data.adjustment_layer, layer, canvas->mixed_layer,
-										start_x, start_y, update_width, update_height);
-							blend_layer = layer->next;
-							layer = layer->next;
-						} while(layer->next != NULL && layer->next->layer_type == TYPE_ADJUSTMENT_LAYER);
+							blend_layer = adjustment;
+						}
 					}
 
-					// サムネイル更新
-					UpdateLayerThumbnail(layer);
+					// サムネイルは更新範囲のみ縮小し直す
+					UpdateLayerThumbnailRegion(layer, (int)canvas->temp_update.x, (int)canvas->temp_update.y,
+						(int)canvas->temp_update.width + 1, (int)canvas->temp_update.height + 1);
+				}
+				else
+				{	// タイル形式のレイヤーは更新範囲のみ一時保存レイヤーに展開して合成
+					blend_layer = PrepareLayerForBlend(layer, canvas->temp_layer,
+						(int)part_update.x, (int)part_update.y, (int)part_update.width + 1, (int)part_update.height + 1);
 				}
 
 				// 合成する対象と方法が確定したので合成を実行する
@@ -407,7 +485,12 @@ NO_UPDATE_BLEND:
 
 	if(update_mode == UPDATE_ALL)
 	{
-		if(canvas->app->display_filter.filter_funcion != NULL)
+		if(canvas->app->display_filter.filter_rectangle != NULL)
+		{
+			canvas->app->display_filter.filter_rectangle(canvas->mixed_layer->pixels, canvas->mixed_layer->stride,
+				0, 0, canvas->width, canvas->height, canvas->app->display_filter.filter_data);
+		}
+		else if(canvas->app->display_filter.filter_funcion != NULL)
 		{
 			canvas->app->display_filter.filter_funcion(canvas->mixed_layer->pixels,
 				canvas->mixed_layer->pixels, canvas->width*canvas->height, canvas->app->display_filter.filter_data);
@@ -422,7 +505,13 @@ NO_UPDATE_BLEND:
 	{
 		FLOAT_T zoom = canvas->zoom_rate;
 
-		if(app->display_filter.filter_funcion != NULL)
+		if(app->display_filter.filter_rectangle != NULL)
+		{	// 更新範囲にその場で適用
+			app->display_filter.filter_rectangle(canvas->mixed_layer->pixels, canvas->mixed_layer->stride,
+				(int)canvas->update.x, (int)canvas->update.y, (int)canvas->update.width, (int)canvas->update.height,
+					app->display_filter.filter_data);
+		}
+		else if(app->display_filter.filter_funcion != NULL)
 		{
 			int start_x = (int)canvas->update.x;
 			int start_y = (int)canvas->update.y;
@@ -669,6 +758,8 @@ LAYER* MixLayerForSave(DRAW_WINDOW* canvas)
 								4, TYPE_NORMAL_LAYER, NULL, NULL, NULL, canvas);
 	LAYER *source = canvas->layer;
 	LAYER *blend;
+	// タイル形式のレイヤーを展開する作業用レイヤー
+	LAYER *work = NULL;
 	int blend_mode;
 
 	// 非表示以外の全てのレイヤーを合成
@@ -680,32 +771,34 @@ LAYER* MixLayerForSave(DRAW_WINDOW* canvas)
 		if((source->flags & LAYER_FLAG_INVISIBLE) == 0
 			&& source->layer_type != TYPE_LAYER_SET)
 		{
-			while(source->next != NULL && source->next->layer_type == TYPE_ADJUSTMENT_LAYER)
+			if(source->next != NULL && source->next->layer_type == TYPE_ADJUSTMENT_LAYER)
 			{
-				if((source->next->flags & LAYER_FLAG_INVISIBLE) != 0)
+				LAYER *adjustment = UpdateAdjustmentLayers(&source, result,
+					0, 0, source->width, source->height);
+				if(adjustment != NULL)
 				{
-					source->next->layer_data.adjustment_layer->filter_func(
-						source->layer_data.adjustment_layer, source->pixels, source->next->pixels,
-							source->width * source->height, source);
+					blend = adjustment;
 				}
-				source->next->layer_data.adjustment_layer->update(
-					source->layer_data.adjustment_layer, source, result,
-						0, 0, source->width, source->height
-				);
-				blend = source->next;
-				source = source->next;
 			}
 
 			if(!(blend->layer_set != NULL
 				&& (blend->layer_set->flags & LAYER_FLAG_INVISIBLE) != 0))
 			{
-				canvas->layer_blend_functions[blend_mode](blend, result);
+				if(blend->tiles != NULL && work == NULL)
+				{
+					work = CreateLayer(0, 0, canvas->width, canvas->height,
+						4, TYPE_NORMAL_LAYER, NULL, NULL, NULL, canvas);
+				}
+				canvas->layer_blend_functions[blend_mode](
+					PrepareLayerForBlend(blend, work, 0, 0, canvas->width, canvas->height), result);
 			}
 		}
 
 		source = source->next;
 	}
 
+	DeleteLayer(&work);
+
 	return result;
 }
 
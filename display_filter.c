@@ -0,0 +1,1056 @@
+#include <string.h>
+#include "configure.h"
+#include "display_filter.h"
+#include "draw_window.h"
+#include "application.h"
+#include "color.h"
+#include "memory.h"
+#include "gui/gui.h"
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+# include <emmintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// YIQの輝度計算の係数(15ビット固定小数点)
+#define YIQ_COEFFICIENT_R 9794
+#define YIQ_COEFFICIENT_G 19221
+#define YIQ_COEFFICIENT_B 3751
+
+/*
+* GrayScaleLine関数
+* 1行分のピクセルをRGBの平均値でグレースケール化する
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ(sourceと同じでも可)
+* num_pixels	: ピクセル数
+*/
+static void GrayScaleLine(const uint8* source, uint8* destination, int num_pixels)
+{
+	int i = 0;
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i byte_mask = _mm_set1_epi32(0xFF);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+	// x / 3 = (x * 0xAAAB) >> 17 (x < 65536)
+	const __m128i divide3 = _mm_set1_epi16((short)0xAAAB);
+	const __m128i zero = _mm_setzero_si128();
+
+	for( ; i + 8 <= num_pixels; i += 8)
+	{
+		__m128i pixels0 = _mm_loadu_si128((const __m128i*)&source[i*4]);
+		__m128i pixels1 = _mm_loadu_si128((const __m128i*)&source[i*4+16]);
+		__m128i sum0 = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(pixels0, byte_mask),
+			_mm_and_si128(_mm_srli_epi32(pixels0, 8), byte_mask)), _mm_and_si128(_mm_srli_epi32(pixels0, 16), byte_mask));
+		__m128i sum1 = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(pixels1, byte_mask),
+			_mm_and_si128(_mm_srli_epi32(pixels1, 8), byte_mask)), _mm_and_si128(_mm_srli_epi32(pixels1, 16), byte_mask));
+		__m128i gray = _mm_srli_epi16(_mm_mulhi_epu16(_mm_packs_epi32(sum0, sum1), divide3), 1);
+		__m128i gray0 = _mm_unpacklo_epi16(gray, zero);
+		__m128i gray1 = _mm_unpackhi_epi16(gray, zero);
+
+		gray0 = _mm_or_si128(_mm_or_si128(gray0, _mm_slli_epi32(gray0, 8)), _mm_slli_epi32(gray0, 16));
+		gray1 = _mm_or_si128(_mm_or_si128(gray1, _mm_slli_epi32(gray1, 8)), _mm_slli_epi32(gray1, 16));
+		_mm_storeu_si128((__m128i*)&destination[i*4], _mm_or_si128(gray0, _mm_and_si128(pixels0, alpha_mask)));
+		_mm_storeu_si128((__m128i*)&destination[i*4+16], _mm_or_si128(gray1, _mm_and_si128(pixels1, alpha_mask)));
+	}
+#endif
+
+	for( ; i < num_pixels; i++)
+	{
+		uint8 value = (uint8)(((source[i*4] + source[i*4+1] + source[i*4+2]) * 0xAAAB) >> 17);
+		destination[i*4] = destination[i*4+1] = destination[i*4+2] = value;
+		destination[i*4+3] = source[i*4+3];
+	}
+}
+
+/*
+* GrayScaleYIQLine関数
+* 1行分のピクセルをYIQの輝度でグレースケール化する
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ(sourceと同じでも可)
+* num_pixels	: ピクセル数
+*/
+static void GrayScaleYIQLine(const uint8* source, uint8* destination, int num_pixels)
+{
+#if defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
+# define COEFFICIENT0 YIQ_COEFFICIENT_B
+# define COEFFICIENT2 YIQ_COEFFICIENT_R
+#else
+# define COEFFICIENT0 YIQ_COEFFICIENT_R
+# define COEFFICIENT2 YIQ_COEFFICIENT_B
+#endif
+	int i = 0;
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i even_mask = _mm_set1_epi32(0x00FF00FF);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+	// 0番目と2番目のチャンネル、1番目のチャンネルをそれぞれ積和演算
+	const __m128i coefficient02 = _mm_set1_epi32((COEFFICIENT2 << 16) | COEFFICIENT0);
+	const __m128i coefficient1 = _mm_set1_epi32(YIQ_COEFFICIENT_G);
+	const __m128i round = _mm_set1_epi32(1 << 14);
+
+	for( ; i + 4 <= num_pixels; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)&source[i*4]);
+		__m128i channel02 = _mm_and_si128(pixels, even_mask);
+		__m128i channel13 = _mm_and_si128(_mm_srli_epi32(pixels, 8), even_mask);
+		__m128i gray = _mm_add_epi32(_mm_madd_epi16(channel02, coefficient02),
+							_mm_madd_epi16(channel13, coefficient1));
+		gray = _mm_srli_epi32(_mm_add_epi32(gray, round), 15);
+		gray = _mm_or_si128(_mm_or_si128(gray, _mm_slli_epi32(gray, 8)), _mm_slli_epi32(gray, 16));
+		_mm_storeu_si128((__m128i*)&destination[i*4], _mm_or_si128(gray, _mm_and_si128(pixels, alpha_mask)));
+	}
+#endif
+
+	for( ; i < num_pixels; i++)
+	{
+		uint8 value = (uint8)((source[i*4] * COEFFICIENT0 + source[i*4+1] * YIQ_COEFFICIENT_G
+						+ source[i*4+2] * COEFFICIENT2 + (1 << 14)) >> 15);
+		destination[i*4] = destination[i*4+1] = destination[i*4+2] = value;
+		destination[i*4+3] = source[i*4+3];
+	}
+#undef COEFFICIENT0
+#undef COEFFICIENT2
+}
+
+// 並列に変換する1区画のピクセル数
+#define DISPLAY_FILTER_BLOCK_SIZE 4096
+
+/*
+* DISPLAY_LINE_FILTER_DATA構造体
+* 1行単位の変換をスレッドプールで処理するためのデータ
+*/
+typedef struct _DISPLAY_LINE_FILTER_DATA
+{
+	void (*line_filter)(const uint8*, uint8*, int);
+	const uint8 *source;
+	uint8 *destination;
+	int size;
+	int stride;
+	int x;
+	int y;
+	int width;
+} DISPLAY_LINE_FILTER_DATA;
+
+/*
+* DisplayLineFilterBlock関数
+* スレッドプールから呼び出されて1区画分のピクセルを変換する
+* 引数
+* index			: 区画の番号
+* thread_index	: 処理しているスレッドの番号
+* data			: DISPLAY_LINE_FILTER_DATA構造体のアドレス
+*/
+static void DisplayLineFilterBlock(int index, int thread_index, void* data)
+{
+	DISPLAY_LINE_FILTER_DATA *filter = (DISPLAY_LINE_FILTER_DATA*)data;
+	int start = index * DISPLAY_FILTER_BLOCK_SIZE;
+	int length = (start + DISPLAY_FILTER_BLOCK_SIZE > filter->size)
+		? filter->size - start : DISPLAY_FILTER_BLOCK_SIZE;
+
+	(void)thread_index;
+
+	filter->line_filter(&filter->source[start * 4], &filter->destination[start * 4], length);
+}
+
+/*
+* DisplayLineFilterRow関数
+* スレッドプールから呼び出されて矩形範囲の1行分をその場で変換する
+* 引数
+* index			: 範囲の上端からの行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: DISPLAY_LINE_FILTER_DATA構造体のアドレス
+*/
+static void DisplayLineFilterRow(int index, int thread_index, void* data)
+{
+	DISPLAY_LINE_FILTER_DATA *filter = (DISPLAY_LINE_FILTER_DATA*)data;
+	uint8 *line = &filter->destination[(filter->y + index) * filter->stride + filter->x * 4];
+
+	(void)thread_index;
+
+	filter->line_filter(line, line, filter->width);
+}
+
+/*
+* ApplyDisplayLineFilter関数
+* 1行単位の変換関数を並列でピクセル列全体に適用する
+* 引数
+* line_filter	: 1行単位の変換関数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+*/
+static void ApplyDisplayLineFilter(
+	void (*line_filter)(const uint8*, uint8*, int),
+	const uint8* source,
+	uint8* destination,
+	int size
+)
+{
+	DISPLAY_LINE_FILTER_DATA filter;
+
+	filter.line_filter = line_filter;
+	filter.source = source;
+	filter.destination = destination;
+	filter.size = size;
+	ExecuteParallelLoop((size + DISPLAY_FILTER_BLOCK_SIZE - 1) / DISPLAY_FILTER_BLOCK_SIZE,
+		DisplayLineFilterBlock, &filter);
+}
+
+/*
+* ApplyDisplayLineFilterRectangle関数
+* 1行単位の変換関数を行ごとに並列で矩形範囲に適用する
+* 引数
+* line_filter	: 1行単位の変換関数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+*/
+static void ApplyDisplayLineFilterRectangle(
+	void (*line_filter)(const uint8*, uint8*, int),
+	uint8* pixels,
+	int stride,
+	int x,
+	int y,
+	int width,
+	int height
+)
+{
+	DISPLAY_LINE_FILTER_DATA filter;
+	int i;
+
+	if(width <= 0)
+	{
+		return;
+	}
+
+	filter.line_filter = line_filter;
+	filter.destination = pixels;
+	filter.stride = stride;
+	filter.x = x;
+	filter.y = y;
+	filter.width = width;
+
+	// 行数が少なければスレッドに分ける手間の方が大きい
+	if(height < DISPLAY_FILTER_MINIMUM_PARALLEL_ROWS)
+	{
+		for(i=0; i<height; i++)
+		{
+			DisplayLineFilterRow(i, 0, &filter);
+		}
+		return;
+	}
+
+	ExecuteParallelLoop(height, DisplayLineFilterRow, &filter);
+}
+
+/*
+* GrayScaleFilter関数
+* RGBの平均値でグレースケール化する
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+* filter_data	: 使用しない
+*/
+void GrayScaleFilter(uint8* source, uint8* destination, int size, void* filter_data)
+{
+	(void)filter_data;
+	ApplyDisplayLineFilter(GrayScaleLine, source, destination, size);
+}
+
+/*
+* GrayScaleFilterRectangle関数
+* 矩形範囲にRGBの平均値でのグレースケール化をその場で適用する
+* 引数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+* filter_data	: 使用しない
+*/
+void GrayScaleFilterRectangle(uint8* pixels, int stride,
+	int x, int y, int width, int height, void* filter_data)
+{
+	(void)filter_data;
+	ApplyDisplayLineFilterRectangle(GrayScaleLine, pixels, stride, x, y, width, height);
+}
+
+/*
+* GrayScaleFilterYIQ関数
+* YIQカラーモデルの輝度でグレースケール化する
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+* filter_data	: 使用しない
+*/
+void GrayScaleFilterYIQ(uint8* source, uint8* destination, int size, void* filter_data)
+{
+	(void)filter_data;
+	ApplyDisplayLineFilter(GrayScaleYIQLine, source, destination, size);
+}
+
+/*
+* GrayScaleFilterYIQRectangle関数
+* 矩形範囲にYIQの輝度でのグレースケール化をその場で適用する
+* 引数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+* filter_data	: 使用しない
+*/
+void GrayScaleFilterYIQRectangle(uint8* pixels, int stride,
+	int x, int y, int width, int height, void* filter_data)
+{
+	(void)filter_data;
+	ApplyDisplayLineFilterRectangle(GrayScaleYIQLine, pixels, stride, x, y, width, height);
+}
+
+/*
+* CreateDisplayIccLut関数
+* ICCプロファイルの変換から表示用の3次元LUTを作成する
+* 引数
+* transform	: 4チャンネル8ビット同士の色変換
+* width		: キャッシュするキャンバスの幅
+* height	: キャッシュするキャンバスの高さ
+* 返り値
+*	作成したLUT 失敗時はNULL
+*/
+DISPLAY_ICC_LUT* CreateDisplayIccLut(cmsHTRANSFORM transform, int width, int height)
+{
+#define GRID DISPLAY_ICC_LUT_GRID_SIZE
+	DISPLAY_ICC_LUT *ret;
+	uint8 *input, *output;
+	uint8 grid_value[GRID];
+	int num_points = GRID * GRID * GRID;
+	int i, j, k;
+
+	if(transform == NULL)
+	{
+		return NULL;
+	}
+
+	ret = (DISPLAY_ICC_LUT*)MEM_CALLOC_FUNC(1, sizeof(*ret));
+	ret->table = (int16*)MEM_ALLOC_FUNC(sizeof(*ret->table) * num_points * 4);
+	input = (uint8*)MEM_ALLOC_FUNC(num_points * 4);
+	output = (uint8*)MEM_ALLOC_FUNC(num_points * 4);
+
+	// 格子点の入力値
+	for(i=0; i<GRID; i++)
+	{
+		grid_value[i] = (uint8)((i * 255 + (GRID - 1) / 2) / (GRID - 1));
+	}
+
+	// 入力値から格子点の番号と補間係数を求めるテーブル
+	for(i=0; i<256; i++)
+	{
+		int position = (i * (GRID - 1) * 256) / 255;
+		int index = position >> 8;
+		int fraction = position & 0xFF;
+		if(index >= GRID - 1)
+		{
+			index = GRID - 2;
+			fraction = 256;
+		}
+		ret->grid_index[i] = (uint8)index;
+		ret->grid_fraction[i] = (uint16)fraction;
+	}
+
+	// 全格子点をまとめて一度だけ変換する
+	for(i=0; i<GRID; i++)
+	{
+		for(j=0; j<GRID; j++)
+		{
+			for(k=0; k<GRID; k++)
+			{
+				uint8 *point = &input[((i * GRID + j) * GRID + k) * 4];
+				point[0] = grid_value[i];
+				point[1] = grid_value[j];
+				point[2] = grid_value[k];
+				point[3] = 0xFF;
+			}
+		}
+	}
+	cmsDoTransform(transform, input, output, num_points);
+
+	for(i=0; i<num_points; i++)
+	{
+		ret->table[i*4+0] = output[i*4+0];
+		ret->table[i*4+1] = output[i*4+1];
+		ret->table[i*4+2] = output[i*4+2];
+		ret->table[i*4+3] = 0;
+	}
+
+	MEM_FREE_FUNC(input);
+	MEM_FREE_FUNC(output);
+
+	// タイルキャッシュの準備
+	if(width > 0 && height > 0)
+	{
+		ret->width = width;
+		ret->height = height;
+		ret->tile_columns = (width + DISPLAY_FILTER_TILE_SIZE - 1) / DISPLAY_FILTER_TILE_SIZE;
+		ret->tile_rows = (height + DISPLAY_FILTER_TILE_SIZE - 1) / DISPLAY_FILTER_TILE_SIZE;
+		ret->tile_dirty = (uint8*)MEM_ALLOC_FUNC(ret->tile_columns * ret->tile_rows);
+		(void)memset(ret->tile_dirty, TRUE, ret->tile_columns * ret->tile_rows);
+		ret->tile_slot = (int*)MEM_ALLOC_FUNC(sizeof(*ret->tile_slot) * ret->tile_columns * ret->tile_rows);
+		for(i=0; i<ret->tile_columns * ret->tile_rows; i++)
+		{
+			ret->tile_slot[i] = -1;
+		}
+		// キャッシュのピクセルデータは表示したタイルの分だけ後で確保する
+		ret->max_slots = MINIMUM(ret->tile_columns * ret->tile_rows, DISPLAY_FILTER_MAX_CACHE_TILES);
+		ret->slot_pixels = (uint8**)MEM_CALLOC_FUNC(ret->max_slots, sizeof(*ret->slot_pixels));
+		ret->slot_tile = (int*)MEM_ALLOC_FUNC(sizeof(*ret->slot_tile) * ret->max_slots);
+		ret->slot_used = (unsigned int*)MEM_CALLOC_FUNC(ret->max_slots, sizeof(*ret->slot_used));
+	}
+
+	return ret;
+#undef GRID
+}
+
+/*
+* DeleteDisplayIccLut関数
+* 表示用の3次元LUTを開放する
+* 引数
+* lut	: 開放するLUTのポインタのアドレス
+*/
+void DeleteDisplayIccLut(DISPLAY_ICC_LUT** lut)
+{
+	int i;
+
+	if(lut == NULL || *lut == NULL)
+	{
+		return;
+	}
+
+	for(i=0; i<(*lut)->num_slots; i++)
+	{
+		MEM_FREE_FUNC((*lut)->slot_pixels[i]);
+	}
+	MEM_FREE_FUNC((*lut)->table);
+	MEM_FREE_FUNC((*lut)->tile_dirty);
+	MEM_FREE_FUNC((*lut)->tile_slot);
+	MEM_FREE_FUNC((*lut)->slot_pixels);
+	MEM_FREE_FUNC((*lut)->slot_tile);
+	MEM_FREE_FUNC((*lut)->slot_used);
+	MEM_FREE_FUNC(*lut);
+
+	*lut = NULL;
+}
+
+/*
+* IccLutConvertPixels関数
+* 3次元LUTの四面体補間で1行分のピクセルを変換する
+*  直前と同じ色は補間を省略する
+* 引数
+* lut			: 表示用の3次元LUT
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ(sourceと同じでも可)
+* num_pixels	: ピクセル数
+*/
+static void IccLutConvertPixels(
+	const DISPLAY_ICC_LUT* lut,
+	const uint8* source,
+	uint8* destination,
+	int num_pixels
+)
+{
+#define GRID DISPLAY_ICC_LUT_GRID_SIZE
+	const int step0 = GRID * GRID * 4;
+	const int step1 = GRID * 4;
+	const int step2 = 4;
+	uint32 before_source = 0;
+	uint32 before_result = 0;
+	int has_before = FALSE;
+	int i;
+
+	for(i=0; i<num_pixels; i++, source += 4, destination += 4)
+	{
+		const int16 *base;
+		const int16 *vertex1, *vertex2, *vertex3;
+		uint32 current;
+		uint32 result;
+		uint8 alpha = source[3];
+		int f0, f1, f2;
+		int w0, w1, w2, w3;
+
+		current = (uint32)source[0] | ((uint32)source[1] << 8) | ((uint32)source[2] << 16);
+		if(has_before != FALSE && current == before_source)
+		{
+			destination[0] = (uint8)before_result;
+			destination[1] = (uint8)(before_result >> 8);
+			destination[2] = (uint8)(before_result >> 16);
+			destination[3] = alpha;
+			continue;
+		}
+
+		base = &lut->table[lut->grid_index[source[0]] * step0
+			+ lut->grid_index[source[1]] * step1 + lut->grid_index[source[2]] * step2];
+		f0 = lut->grid_fraction[source[0]];
+		f1 = lut->grid_fraction[source[1]];
+		f2 = lut->grid_fraction[source[2]];
+		vertex3 = base + step0 + step1 + step2;
+
+		// 補間係数の大小で使用する四面体を決める
+		if(f0 >= f1)
+		{
+			if(f1 >= f2)
+			{
+				vertex1 = base + step0,	vertex2 = base + step0 + step1;
+				w0 = 256 - f0,	w1 = f0 - f1,	w2 = f1 - f2,	w3 = f2;
+			}
+			else if(f0 >= f2)
+			{
+				vertex1 = base + step0,	vertex2 = base + step0 + step2;
+				w0 = 256 - f0,	w1 = f0 - f2,	w2 = f2 - f1,	w3 = f1;
+			}
+			else
+			{
+				vertex1 = base + step2,	vertex2 = base + step0 + step2;
+				w0 = 256 - f2,	w1 = f2 - f0,	w2 = f0 - f1,	w3 = f1;
+			}
+		}
+		else
+		{
+			if(f0 >= f2)
+			{
+				vertex1 = base + step1,	vertex2 = base + step0 + step1;
+				w0 = 256 - f1,	w1 = f1 - f0,	w2 = f0 - f2,	w3 = f2;
+			}
+			else if(f1 >= f2)
+			{
+				vertex1 = base + step1,	vertex2 = base + step1 + step2;
+				w0 = 256 - f1,	w1 = f1 - f2,	w2 = f2 - f0,	w3 = f0;
+			}
+			else
+			{
+				vertex1 = base + step2,	vertex2 = base + step1 + step2;
+				w0 = 256 - f2,	w1 = f2 - f1,	w2 = f1 - f0,	w3 = f0;
+			}
+		}
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+		{
+			// 2頂点ずつ16ビット値を交互に並べて積和演算
+			__m128i vertices01 = _mm_unpacklo_epi16(
+				_mm_loadl_epi64((const __m128i*)base), _mm_loadl_epi64((const __m128i*)vertex1));
+			__m128i vertices23 = _mm_unpacklo_epi16(
+				_mm_loadl_epi64((const __m128i*)vertex2), _mm_loadl_epi64((const __m128i*)vertex3));
+			__m128i sum = _mm_add_epi32(
+				_mm_madd_epi16(vertices01, _mm_set1_epi32((w1 << 16) | w0)),
+				_mm_madd_epi16(vertices23, _mm_set1_epi32((w3 << 16) | w2)));
+			sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+			sum = _mm_packs_epi32(sum, sum);
+			sum = _mm_packus_epi16(sum, sum);
+			result = (uint32)_mm_cvtsi128_si32(sum) & 0xFFFFFF;
+		}
+#else
+		result = (uint32)((base[0] * w0 + vertex1[0] * w1 + vertex2[0] * w2 + vertex3[0] * w3 + 128) >> 8)
+			| ((uint32)((base[1] * w0 + vertex1[1] * w1 + vertex2[1] * w2 + vertex3[1] * w3 + 128) >> 8) << 8)
+			| ((uint32)((base[2] * w0 + vertex1[2] * w1 + vertex2[2] * w2 + vertex3[2] * w3 + 128) >> 8) << 16);
+#endif
+
+		destination[0] = (uint8)result;
+		destination[1] = (uint8)(result >> 8);
+		destination[2] = (uint8)(result >> 16);
+		destination[3] = alpha;
+
+		before_source = current;
+		before_result = result;
+		has_before = TRUE;
+	}
+#undef GRID
+}
+
+/*
+* ICC_LUT_FILTER_DATA構造体
+* 3次元LUTでの変換をスレッドプールで処理するためのデータ
+*/
+typedef struct _ICC_LUT_FILTER_DATA
+{
+	DISPLAY_ICC_LUT *lut;
+	const uint8 *source;
+	uint8 *destination;
+	int size;
+	int stride;
+	int x;
+	int y;
+	int width;
+	int height;
+	int start_column;
+	int start_row;
+	int num_columns;
+} ICC_LUT_FILTER_DATA;
+
+/*
+* IccLutFilterBlock関数
+* スレッドプールから呼び出されて1区画分のピクセルを変換する
+* 引数
+* index			: 区画の番号
+* thread_index	: 処理しているスレッドの番号
+* data			: ICC_LUT_FILTER_DATA構造体のアドレス
+*/
+static void IccLutFilterBlock(int index, int thread_index, void* data)
+{
+	ICC_LUT_FILTER_DATA *filter = (ICC_LUT_FILTER_DATA*)data;
+	int start = index * DISPLAY_FILTER_BLOCK_SIZE;
+	int length = (start + DISPLAY_FILTER_BLOCK_SIZE > filter->size)
+		? filter->size - start : DISPLAY_FILTER_BLOCK_SIZE;
+
+	(void)thread_index;
+
+	IccLutConvertPixels(filter->lut, &filter->source[start * 4], &filter->destination[start * 4], length);
+}
+
+/*
+* IccLutFilterRow関数
+* スレッドプールから呼び出されて矩形範囲の1行分をその場で変換する
+* 引数
+* index			: 範囲の上端からの行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: ICC_LUT_FILTER_DATA構造体のアドレス
+*/
+static void IccLutFilterRow(int index, int thread_index, void* data)
+{
+	ICC_LUT_FILTER_DATA *filter = (ICC_LUT_FILTER_DATA*)data;
+	uint8 *line = &filter->destination[(filter->y + index) * filter->stride + filter->x * 4];
+
+	(void)thread_index;
+
+	IccLutConvertPixels(filter->lut, line, line, filter->width);
+}
+
+/*
+* IccLutFilterTile関数
+* スレッドプールから呼び出されて矩形範囲に含まれるタイル1枚分を変換する
+*  タイル全体が範囲に含まれ、再変換が不要ならキャッシュを使う
+* 引数
+* index			: 範囲内のタイルの番号
+* thread_index	: 処理しているスレッドの番号
+* data			: ICC_LUT_FILTER_DATA構造体のアドレス
+*/
+static void IccLutFilterTile(int index, int thread_index, void* data)
+{
+#define TILE_SIZE DISPLAY_FILTER_TILE_SIZE
+	ICC_LUT_FILTER_DATA *filter = (ICC_LUT_FILTER_DATA*)data;
+	DISPLAY_ICC_LUT *lut = filter->lut;
+	uint8 *pixels = filter->destination;
+	int stride = filter->stride;
+	int column = filter->start_column + index % filter->num_columns;
+	int row = filter->start_row + index / filter->num_columns;
+	int tile_index = row * lut->tile_columns + column;
+	int tile_x = column * TILE_SIZE,	tile_y = row * TILE_SIZE;
+	int tile_width = MINIMUM(TILE_SIZE, lut->width - tile_x);
+	int tile_height = MINIMUM(TILE_SIZE, lut->height - tile_y);
+	int part_x = MAXIMUM(tile_x, filter->x),	part_y = MAXIMUM(tile_y, filter->y);
+	int part_width = MINIMUM(tile_x + tile_width, filter->x + filter->width) - part_x;
+	int part_height = MINIMUM(tile_y + tile_height, filter->y + filter->height) - part_y;
+	uint8 *cache = NULL;
+	int j;
+
+	(void)thread_index;
+
+	if(lut->tile_slot[tile_index] >= 0)
+	{
+		cache = lut->slot_pixels[lut->tile_slot[tile_index]];
+	}
+
+	if(cache != NULL && part_width == tile_width && part_height == tile_height)
+	{	// タイル全体が範囲内なら合成し直したタイルのみ変換
+		if(lut->tile_dirty[tile_index] == FALSE)
+		{
+			for(j=0; j<tile_height; j++)
+			{
+				(void)memcpy(&pixels[(tile_y + j) * stride + tile_x * 4],
+					&cache[j * TILE_SIZE * 4], tile_width * 4);
+			}
+		}
+		else
+		{
+			for(j=0; j<tile_height; j++)
+			{
+				uint8 *line = &pixels[(tile_y + j) * stride + tile_x * 4];
+				IccLutConvertPixels(lut, line, line, tile_width);
+				(void)memcpy(&cache[j * TILE_SIZE * 4], line, tile_width * 4);
+			}
+			lut->tile_dirty[tile_index] = FALSE;
+		}
+	}
+	else
+	{	// タイルの一部のみ変換し、キャッシュがあれば反映する
+		for(j=0; j<part_height; j++)
+		{
+			uint8 *line = &pixels[(part_y + j) * stride + part_x * 4];
+			IccLutConvertPixels(lut, line, line, part_width);
+			if(cache != NULL)
+			{
+				(void)memcpy(&cache[(part_y - tile_y + j) * TILE_SIZE * 4 + (part_x - tile_x) * 4],
+					line, part_width * 4);
+			}
+		}
+	}
+#undef TILE_SIZE
+}
+
+/*
+* AssignIccLutTileSlot関数
+* タイルにキャッシュを割り当てる
+*  上限に達していれば今回の変換で使っていない最も古いキャッシュを使い回す
+* 引数
+* lut			: 表示用の3次元LUT
+* tile_index	: キャッシュを割り当てるタイルの番号
+*/
+static void AssignIccLutTileSlot(DISPLAY_ICC_LUT* lut, int tile_index)
+{
+	int slot = lut->tile_slot[tile_index];
+	int i;
+
+	if(slot < 0)
+	{
+		if(lut->num_slots < lut->max_slots)
+		{
+			slot = lut->num_slots++;
+			lut->slot_pixels[slot] = (uint8*)MEM_ALLOC_FUNC(
+				DISPLAY_FILTER_TILE_SIZE * DISPLAY_FILTER_TILE_SIZE * 4);
+		}
+		else
+		{
+			for(i=0; i<lut->num_slots; i++)
+			{
+				if(lut->slot_used[i] != lut->use_count
+					&& (slot < 0 || lut->slot_used[i] < lut->slot_used[slot]))
+				{
+					slot = i;
+				}
+			}
+			// 全てのキャッシュを今回の変換で使っていればキャッシュ無しで変換する
+			if(slot < 0)
+			{
+				return;
+			}
+			lut->tile_slot[lut->slot_tile[slot]] = -1;
+			lut->tile_dirty[lut->slot_tile[slot]] = TRUE;
+		}
+		lut->slot_tile[slot] = tile_index;
+		lut->tile_slot[tile_index] = slot;
+		lut->tile_dirty[tile_index] = TRUE;
+	}
+
+	lut->slot_used[slot] = lut->use_count;
+}
+
+/*
+* IccProfileFilter関数
+* 3次元LUTの四面体補間でICCプロファイルの変換を行う
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+* filter_data	: DISPLAY_ICC_LUT構造体のアドレス
+*/
+void IccProfileFilter(uint8* source, uint8* destination, int size, void* filter_data)
+{
+	ICC_LUT_FILTER_DATA filter;
+
+	filter.lut = (DISPLAY_ICC_LUT*)filter_data;
+	filter.source = source;
+	filter.destination = destination;
+	filter.size = size;
+	ExecuteParallelLoop((size + DISPLAY_FILTER_BLOCK_SIZE - 1) / DISPLAY_FILTER_BLOCK_SIZE,
+		IccLutFilterBlock, &filter);
+}
+
+/*
+* IccProfileFilterRectangle関数
+* 矩形範囲にICCプロファイルの変換を適用する
+*  タイル全体が範囲に含まれ、再変換が不要ならキャッシュを使う
+* 引数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+* filter_data	: DISPLAY_ICC_LUT構造体のアドレス
+*/
+void IccProfileFilterRectangle(uint8* pixels, int stride,
+	int x, int y, int width, int height, void* filter_data)
+{
+#define TILE_SIZE DISPLAY_FILTER_TILE_SIZE
+	DISPLAY_ICC_LUT *lut = (DISPLAY_ICC_LUT*)filter_data;
+	ICC_LUT_FILTER_DATA filter;
+	int end_column, end_row;
+	int column, row;
+
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	filter.lut = lut;
+	filter.destination = pixels;
+	filter.stride = stride;
+	filter.x = x;
+	filter.y = y;
+	filter.width = width;
+	filter.height = height;
+
+	// キャッシュが使えなければ行単位で変換
+	if(lut->tile_slot == NULL || stride != lut->width * 4
+		|| x + width > lut->width || y + height > lut->height)
+	{
+		ExecuteParallelLoop(height, IccLutFilterRow, &filter);
+		return;
+	}
+
+	// 別の画像を変換する場合はキャッシュを全て作り直す
+	if(pixels != lut->cache_pixels)
+	{
+		(void)memset(lut->tile_dirty, TRUE, lut->tile_columns * lut->tile_rows);
+		lut->cache_pixels = pixels;
+	}
+
+	filter.start_column = x / TILE_SIZE,	end_column = (x + width - 1) / TILE_SIZE;
+	filter.start_row = y / TILE_SIZE,	end_row = (y + height - 1) / TILE_SIZE;
+	filter.num_columns = end_column - filter.start_column + 1;
+
+	// 範囲内のタイルにキャッシュを割り当ててから並列に変換する
+	lut->use_count++;
+	for(row=filter.start_row; row<=end_row; row++)
+	{
+		for(column=filter.start_column; column<=end_column; column++)
+		{
+			AssignIccLutTileSlot(lut, row * lut->tile_columns + column);
+		}
+	}
+
+	ExecuteParallelLoop(filter.num_columns * (end_row - filter.start_row + 1),
+		IccLutFilterTile, &filter);
+#undef TILE_SIZE
+}
+
+/*
+* InvalidateDisplayFilter関数
+* 合成し直した範囲の表示フィルターのキャッシュを無効にする
+* 引数
+* filter	: 現在の表示フィルター
+* x			: 範囲の左上のX座標
+* y			: 範囲の左上のY座標
+* width		: 範囲の幅
+* height	: 範囲の高さ
+*/
+void InvalidateDisplayFilter(DISPLAY_FILTER* filter, int x, int y, int width, int height)
+{
+	DISPLAY_ICC_LUT *lut;
+	int start_column, end_column;
+	int start_row, end_row;
+	int column, row;
+
+	if(filter->filter_rectangle != IccProfileFilterRectangle
+		|| (lut = (DISPLAY_ICC_LUT*)filter->filter_data) == NULL || lut->tile_dirty == NULL)
+	{
+		return;
+	}
+
+	if(x < 0)
+	{
+		width += x;
+		x = 0;
+	}
+	if(y < 0)
+	{
+		height += y;
+		y = 0;
+	}
+	if(x + width > lut->width)
+	{
+		width = lut->width - x;
+	}
+	if(y + height > lut->height)
+	{
+		height = lut->height - y;
+	}
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	// 一部のみ含まれるタイルは変換時にキャッシュへ書き戻すので全体が含まれるタイルのみ
+	start_column = (x + DISPLAY_FILTER_TILE_SIZE - 1) / DISPLAY_FILTER_TILE_SIZE;
+	start_row = (y + DISPLAY_FILTER_TILE_SIZE - 1) / DISPLAY_FILTER_TILE_SIZE;
+	end_column = (x + width == lut->width) ? lut->tile_columns : (x + width) / DISPLAY_FILTER_TILE_SIZE;
+	end_row = (y + height == lut->height) ? lut->tile_rows : (y + height) / DISPLAY_FILTER_TILE_SIZE;
+	for(row=start_row; row<end_row; row++)
+	{
+		for(column=start_column; column<end_column; column++)
+		{
+			lut->tile_dirty[row * lut->tile_columns + column] = TRUE;
+		}
+	}
+}
+
+/*
+* UpdateDisplayIccLut関数
+* キャンバスの色変換に合わせて表示用のLUTを作り直す
+* 引数
+* canvas	: ICCプロファイルを設定したキャンバス
+*/
+void UpdateDisplayIccLut(DRAW_WINDOW* canvas)
+{
+	APPLICATION *app = canvas->app;
+	DISPLAY_ICC_LUT *before = canvas->icc_lut;
+
+	canvas->icc_lut = CreateDisplayIccLut(canvas->icc_transform, canvas->width, canvas->height);
+
+	// 現在の表示フィルターが古いLUTを参照していれば差し替える
+	if(app != NULL && before != NULL && app->display_filter.filter_data == (void*)before)
+	{
+		SetDisplayFilter(app, canvas, DISPLAY_FUNC_TYPE_ICC_PROFILE);
+	}
+
+	DeleteDisplayIccLut(&before);
+}
+
+/*
+* SetupDisplayIccTransform関数
+* キャンバスのICCプロファイルでソフトプルーフ用の色変換とLUTを作成する
+* 引数
+* canvas	: 色変換を作成するキャンバス
+* 返り値
+*	LUTを作成できればTRUE
+*/
+int SetupDisplayIccTransform(DRAW_WINDOW* canvas)
+{
+#if defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
+# define PIXEL_TYPE TYPE_BGRA_8
+#else
+# define PIXEL_TYPE TYPE_RGBA_8
+#endif
+	if(canvas->icc_lut != NULL)
+	{
+		return TRUE;
+	}
+
+	if(canvas->icc_transform == NULL)
+	{
+		cmsHPROFILE work_profile, display_profile;
+
+		// 確認する出力先のプロファイル(無ければsRGB)
+		if(canvas->input_icc == NULL && canvas->icc_profile_data != NULL)
+		{
+			canvas->input_icc = cmsOpenProfileFromMem(canvas->icc_profile_data, canvas->icc_profile_size);
+		}
+		if(canvas->input_icc == NULL)
+		{
+			canvas->input_icc = CreateDefaultSrgbProfile();
+		}
+
+		work_profile = CreateDefaultSrgbProfile();
+		display_profile = GetPrimaryMonitorProfile();
+		canvas->icc_transform = cmsCreateProofingTransform(work_profile, PIXEL_TYPE,
+			display_profile, PIXEL_TYPE, canvas->input_icc, INTENT_PERCEPTUAL,
+				INTENT_ABSOLUTE_COLORIMETRIC, cmsFLAGS_SOFTPROOFING);
+		cmsCloseProfile(work_profile);
+		cmsCloseProfile(display_profile);
+	}
+
+	UpdateDisplayIccLut(canvas);
+
+	return canvas->icc_lut != NULL;
+#undef PIXEL_TYPE
+}
+
+/*
+* ReleaseDisplayIccTransform関数
+* キャンバスの色変換とLUTを開放する
+* 引数
+* canvas	: 色変換を開放するキャンバス
+*/
+void ReleaseDisplayIccTransform(DRAW_WINDOW* canvas)
+{
+	APPLICATION *app = canvas->app;
+
+	// 開放するLUTを表示フィルターが参照していればフィルターを外す
+	if(app != NULL && canvas->icc_lut != NULL
+		&& app->display_filter.filter_data == (void*)canvas->icc_lut)
+	{
+		SetDisplayFilter(app, canvas, DISPLAY_FUNC_TYPE_NO_CONVERT);
+	}
+
+	DeleteDisplayIccLut(&canvas->icc_lut);
+	if(canvas->icc_transform != NULL)
+	{
+		cmsDeleteTransform(canvas->icc_transform);
+		canvas->icc_transform = NULL;
+	}
+	if(canvas->input_icc != NULL)
+	{
+		cmsCloseProfile(canvas->input_icc);
+		canvas->input_icc = NULL;
+	}
+}
+
+/*
+* SetDisplayFilter関数
+* 表示時に適用するフィルターを切り替える
+* 引数
+* app		: アプリケーションを管理する構造体のアドレス
+* canvas	: フィルターを適用するキャンバス
+* type		: フィルターの種類
+*/
+void SetDisplayFilter(APPLICATION* app, DRAW_WINDOW* canvas, eDISPLAY_FUNCION_TYPE type)
+{
+	app->display_filter.filter_funcion = NULL;
+	app->display_filter.filter_rectangle = NULL;
+	app->display_filter.filter_data = NULL;
+
+	switch(type)
+	{
+	case DISPLAY_FUNC_TYPE_GRAY_SCALE:
+		app->display_filter.filter_funcion = GrayScaleFilter;
+		app->display_filter.filter_rectangle = GrayScaleFilterRectangle;
+		break;
+	case DISPLAY_FUNC_TYPE_GRAY_SCALE_YIQ:
+		app->display_filter.filter_funcion = GrayScaleFilterYIQ;
+		app->display_filter.filter_rectangle = GrayScaleFilterYIQRectangle;
+		break;
+	case DISPLAY_FUNC_TYPE_ICC_PROFILE:
+		if(canvas != NULL && canvas->icc_lut != NULL)
+		{
+			app->display_filter.filter_funcion = IccProfileFilter;
+			app->display_filter.filter_rectangle = IccProfileFilterRectangle;
+			app->display_filter.filter_data = (void*)canvas->icc_lut;
+		}
+		else
+		{
+			type = DISPLAY_FUNC_TYPE_NO_CONVERT;
+		}
+		break;
+	default:
+		type = DISPLAY_FUNC_TYPE_NO_CONVERT;
+		break;
+	}
+
+	if(canvas != NULL)
+	{
+		canvas->display_filter_mode = (uint8)type;
+		canvas->flags |= DRAW_WINDOW_UPDATE_ACTIVE_UNDER;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
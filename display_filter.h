@@ -2,6 +2,16 @@
 #define _INCLUDED_DISPLAY_FILTER_H_
 
 #include "types.h"
+#include "lcms/lcms2.h"
+
+// ICCプロファイル変換用3次元LUTの一辺の格子点数
+#define DISPLAY_ICC_LUT_GRID_SIZE 33
+// 表示フィルター結果をキャッシュするタイルの一辺のピクセル数
+#define DISPLAY_FILTER_TILE_SIZE 64
+// 表示フィルター結果をキャッシュするタイルの最大数(64x64なら16MB)
+#define DISPLAY_FILTER_MAX_CACHE_TILES 1024
+// 表示フィルターを並列処理する最小の行数
+#define DISPLAY_FILTER_MINIMUM_PARALLEL_ROWS 32
 
 typedef enum _eDISPLAY_FUNCION_TYPE
 {
@@ -20,8 +30,198 @@ typedef struct _DISPLAY_FILTER
 {
 	void (*filter_funcion)(
 		uint8* source, uint8* destination, int size, void* filter_data);
+	// 画像中の矩形範囲にその場で適用する関数(NULLの場合はfilter_funcionを使用)
+	void (*filter_rectangle)(uint8* pixels, int stride,
+		int x, int y, int width, int height, void* filter_data);
 	void *filter_data;
 } DISPLAY_FILTER;
 
-#endif /* #ifndef _INCLUDED_DISPLAY_FILTER_H_ */
+/*
+* DISPLAY_ICC_LUT構造体
+* ICCプロファイルによる色変換を格子点で事前計算したテーブル
+*  変換結果はタイル単位でキャッシュする
+*  キャッシュは表示したタイルの分だけ確保し、上限を超えたら最も古いものを使い回す
+*/
+typedef struct _DISPLAY_ICC_LUT
+{
+	// 格子点の変換結果(1点につき4チャンネル分の16ビット値)
+	int16 *table;
+	// 入力値に対する格子点の番号と補間係数(0～256)
+	uint8 grid_index[256];
+	uint16 grid_fraction[256];
+	// タイルキャッシュの幅・高さ(ピクセル数とタイル数)
+	int width, height;
+	int tile_columns, tile_rows;
+	// タイルごとの再変換が必要かのフラグ
+	uint8 *tile_dirty;
+	// タイルごとのキャッシュの番号(キャッシュが無ければ-1)
+	int *tile_slot;
+	// 確保したキャッシュの数と上限
+	int num_slots, max_slots;
+	// キャッシュごとの変換済みのピクセルデータ(1行DISPLAY_FILTER_TILE_SIZEピクセル)
+	uint8 **slot_pixels;
+	// キャッシュごとの使用しているタイルの番号と最後に使った時の番号
+	int *slot_tile;
+	unsigned int *slot_used;
+	// 矩形範囲を変換する度に増やす番号
+	unsigned int use_count;
+	// キャッシュを作成したピクセルデータ(別の画像ならキャッシュを使わない)
+	uint8 *cache_pixels;
+} DISPLAY_ICC_LUT;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* GrayScaleFilter関数
+* RGBの平均値でグレースケール化する
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+* filter_data	: 使用しない
+*/
+EXTERN void GrayScaleFilter(uint8* source, uint8* destination, int size, void* filter_data);
+
+/*
+* GrayScaleFilterRectangle関数
+* 矩形範囲にRGBの平均値でのグレースケール化をその場で適用する
+* 引数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+* filter_data	: 使用しない
+*/
+EXTERN void GrayScaleFilterRectangle(uint8* pixels, int stride,
+	int x, int y, int width, int height, void* filter_data);
+
+/*
+* GrayScaleFilterYIQ関数
+* YIQカラーモデルの輝度でグレースケール化する
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+* filter_data	: 使用しない
+*/
+EXTERN void GrayScaleFilterYIQ(uint8* source, uint8* destination, int size, void* filter_data);
+
+/*
+* GrayScaleFilterYIQRectangle関数
+* 矩形範囲にYIQの輝度でのグレースケール化をその場で適用する
+* 引数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+* filter_data	: 使用しない
+*/
+EXTERN void GrayScaleFilterYIQRectangle(uint8* pixels, int stride,
+	int x, int y, int width, int height, void* filter_data);
+
+/*
+* CreateDisplayIccLut関数
+* ICCプロファイルの変換から表示用の3次元LUTを作成する
+* 引数
+* transform	: 4チャンネル8ビット同士の色変換
+* width		: キャッシュするキャンバスの幅
+* height	: キャッシュするキャンバスの高さ
+* 返り値
+*	作成したLUT 失敗時はNULL
+*/
+EXTERN DISPLAY_ICC_LUT* CreateDisplayIccLut(cmsHTRANSFORM transform, int width, int height);
+
+/*
+* DeleteDisplayIccLut関数
+* 表示用の3次元LUTを開放する
+* 引数
+* lut	: 開放するLUTのポインタのアドレス
+*/
+EXTERN void DeleteDisplayIccLut(DISPLAY_ICC_LUT** lut);
 
+/*
+* IccProfileFilter関数
+* 3次元LUTの四面体補間でICCプロファイルの変換を行う
+* 引数
+* source		: 変換元のピクセルデータ
+* destination	: 変換結果を入れるピクセルデータ
+* size			: ピクセル数
+* filter_data	: DISPLAY_ICC_LUT構造体のアドレス
+*/
+EXTERN void IccProfileFilter(uint8* source, uint8* destination, int size, void* filter_data);
+
+/*
+* IccProfileFilterRectangle関数
+* 矩形範囲にICCプロファイルの変換を適用する
+*  タイル全体が範囲に含まれ、再変換が不要ならキャッシュを使う
+* 引数
+* pixels		: キャンバス全体のピクセルデータ
+* stride		: 1行分のバイト数
+* x				: 範囲の左上のX座標
+* y				: 範囲の左上のY座標
+* width			: 範囲の幅
+* height		: 範囲の高さ
+* filter_data	: DISPLAY_ICC_LUT構造体のアドレス
+*/
+EXTERN void IccProfileFilterRectangle(uint8* pixels, int stride,
+	int x, int y, int width, int height, void* filter_data);
+
+/*
+* InvalidateDisplayFilter関数
+* 合成し直した範囲の表示フィルターのキャッシュを無効にする
+* 引数
+* filter	: 現在の表示フィルター
+* x			: 範囲の左上のX座標
+* y			: 範囲の左上のY座標
+* width		: 範囲の幅
+* height	: 範囲の高さ
+*/
+EXTERN void InvalidateDisplayFilter(DISPLAY_FILTER* filter, int x, int y, int width, int height);
+
+/*
+* UpdateDisplayIccLut関数
+* キャンバスの色変換に合わせて表示用のLUTを作り直す
+* 引数
+* canvas	: ICCプロファイルを設定したキャンバス
+*/
+EXTERN void UpdateDisplayIccLut(DRAW_WINDOW* canvas);
+
+/*
+* SetupDisplayIccTransform関数
+* キャンバスのICCプロファイルでソフトプルーフ用の色変換とLUTを作成する
+* 引数
+* canvas	: 色変換を作成するキャンバス
+* 返り値
+*	LUTを作成できればTRUE
+*/
+EXTERN int SetupDisplayIccTransform(DRAW_WINDOW* canvas);
+
+/*
+* ReleaseDisplayIccTransform関数
+* キャンバスの色変換とLUTを開放する
+* 引数
+* canvas	: 色変換を開放するキャンバス
+*/
+EXTERN void ReleaseDisplayIccTransform(DRAW_WINDOW* canvas);
+
+/*
+* SetDisplayFilter関数
+* 表示時に適用するフィルターを切り替える
+* 引数
+* app		: アプリケーションを管理する構造体のアドレス
+* canvas	: フィルターを適用するキャンバス
+* type		: フィルターの種類
+*/
+EXTERN void SetDisplayFilter(APPLICATION* app, DRAW_WINDOW* canvas, eDISPLAY_FUNCION_TYPE type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _INCLUDED_DISPLAY_FILTER_H_ */
@@ -62,6 +62,8 @@ DRAW_WINDOW* CreateDrawWindow(
 	// 最初のレイヤーを作成する
 	ret->active_layer = ret->layer = CreateLayer(0, 0, width, height,
 		channel, TYPE_NORMAL_LAYER, NULL, NULL, layer_name, ret);
+	// 最初のレイヤーは編集対象になるのでピクセルデータを確保する
+	(void)MaterializeLayerPixels(ret->layer);
 	ret->num_layer++;
 
 	// 作業用のレイヤーを作成
@@ -235,16 +237,14 @@ LAYER* SearchLayerByCursorColor(DRAW_WINDOW* canvas, int x, int y)
 
 				if(mask == NULL)
 				{
-					if(previous->pixels[(y - previous->y) * previous->stride
-						+ (x - previous->x) * 4 + 3] > 0)
+					if(GetLayerPixelAlpha(previous, x - previous->x, y - previous->y) > 0)
 					{
 						return previous;
 					}
 				}
 				else
 				{
-					if(mask->pixels[(y - mask->y) * mask->stride
-						+ (x - mask->x) * 4 + 3] > 0)
+					if(GetLayerPixelAlpha(mask, x - mask->x, y - mask->y) > 0)
 					{
 						return previous;
 					}
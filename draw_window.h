@@ -10,6 +10,7 @@
 #include "selection_area.h"
 #include "history.h"
 #include "perspective_ruler.h"
+#include "display_filter.h"
 
 typedef enum _eDRAW_WINDOW_FLAGS
 {
@@ -190,6 +191,8 @@ struct _DRAW_WINDOW
 	cmsHPROFILE input_icc;
 	// ICCプロファイルによる色変換用
 	cmsHTRANSFORM icc_transform;
+	// 色変換を事前計算した表示用のLUT
+	DISPLAY_ICC_LUT *icc_lut;
 
 	// 局所キャンバス
 	struct _DRAW_WINDOW *focal_window;
@@ -347,6 +350,18 @@ EXTERN void DisplayTextLayerRange(DRAW_WINDOW* window, TEXT_LAYER* layer);
 */
 EXTERN void MixLayerSet(LAYER* bottom, LAYER** next, DRAW_WINDOW* canvas);
 
+/*
+* InvalidateLayerSetCache関数
+* レイヤーが所属するレイヤーセットの合成結果のキャッシュを無効化する
+* 引数
+* layer		: 内容を変更したレイヤー
+* x			: 変更範囲の左上のX座標
+* y			: 変更範囲の左上のY座標
+* width		: 変更範囲の幅(0以下ならキャンバス全体)
+* height	: 変更範囲の高さ
+*/
+EXTERN void InvalidateLayerSetCache(LAYER* layer, int x, int y, int width, int height);
+
 /*
 * MixLayerSetActiveOver関数
 * レイヤーセット中のアクティブレイヤー以上のレイヤーを合成する
@@ -16,6 +16,11 @@
 
 #define USE_TBB 1
 
+// SSE2命令による高速化
+#if !defined(USE_SSE2) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+# define USE_SSE2 1
+#endif
+
 #define FRAME_RATE 60
 #define AUTO_SAVE_INTERVAL 60
 
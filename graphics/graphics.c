@@ -55,7 +55,7 @@ int InitializeGraphics(GRAPHICS* graphics)
 		const GRAPHICS_SOLID_PATTERN clear_pattern =
 		{
 			{
-				0,	/* ref_count */
+				-1,	/* ref_count (static, shared between threads) */
 				GRAPHICS_STATUS_SUCCESS,		/* status */
 				{ NULL, NULL },			/* observers */
 
@@ -77,7 +77,7 @@ int InitializeGraphics(GRAPHICS* graphics)
 		const GRAPHICS_SOLID_PATTERN white_pattern =
 		{
 			{
-				0,
+				-1,
 				GRAPHICS_STATUS_SUCCESS,
 				{NULL, NULL},
 				GRAPHICS_PATTERN_TYPE_SOLID,
@@ -98,7 +98,7 @@ int InitializeGraphics(GRAPHICS* graphics)
 		const GRAPHICS_SOLID_PATTERN black_pattern =
 		{
 			{
-				0,
+				-1,
 				GRAPHICS_STATUS_SUCCESS,
 		{NULL, NULL},
 		GRAPHICS_PATTERN_TYPE_SOLID,
@@ -125,10 +125,28 @@ int InitializeGraphics(GRAPHICS* graphics)
 
 	InitializeGraphicsUnboundedRectangle(&graphics->unbounded_rectangle);
 	graphics->empty_rectangle = empty_rectangle;
+	GraphicsResetFillStatistics(graphics);
 
 	return TRUE;
 }
 
+void ReleaseGraphics(GRAPHICS* graphics)
+{
+	ReleasePixelManipulate(&graphics->pixel_manipulate);
+}
+
+void GraphicsGetFillStatistics(GRAPHICS* graphics, GRAPHICS_FILL_STATISTICS* statistics)
+{
+	*statistics = graphics->fill_statistics;
+}
+
+void GraphicsResetFillStatistics(GRAPHICS* graphics)
+{
+	graphics->fill_statistics.solid_fills = 0;
+	graphics->fill_statistics.blit_fills = 0;
+	graphics->fill_statistics.general_fills = 0;
+}
+
 INLINE static int GraphicsStatusIsError(eGRAPHICS_STATUS status)
 {
 	return (status != GRAPHICS_STATUS_SUCCESS && status < NUM_GRAPHICS_STATUS);
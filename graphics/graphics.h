@@ -113,6 +113,13 @@ typedef struct _GRAPHICS_BACKEND
 	eGRAPHICS_STATUS (*fill_extents)(void* context, FLOAT_T* x1, FLOAT_T* y1, FLOAT_T* x2, FLOAT_T* y2);
 } GRAPHICS_BACKEND;
 
+typedef struct _GRAPHICS_FILL_STATISTICS
+{
+	unsigned int solid_fills;
+	unsigned int blit_fills;
+	unsigned int general_fills;
+} GRAPHICS_FILL_STATISTICS;
+
 struct _GRAPHICS
 {
 	PIXEL_MANIPULATE pixel_manipulate;
@@ -137,6 +144,7 @@ struct _GRAPHICS
 	GRAPHICS_BACKEND context_backend;
 	GRAPHICS_RECTANGLE_INT unbounded_rectangle;
 	GRAPHICS_RECTANGLE_INT empty_rectangle;
+	GRAPHICS_FILL_STATISTICS fill_statistics;
 };
 
 typedef struct _GRAPHICS_CONTEXT
@@ -159,6 +167,9 @@ typedef struct _GRAPHICS_DEFAULT_CONTEXT
 	GRAPHICS_STATE *state_free_list;
 
 	GRAPHICS_PATH_FIXED path;
+
+	GRAPHICS_RECTANGLE_INT painted_extents;
+	int track_painted_extents;
 } GRAPHICS_DEFAULT_CONTEXT;
 
 #define GRAPHICS_ALPHA_SHORT_IS_CLEAR(alpha) ((alpha) <= 0x00ff)
@@ -181,8 +192,13 @@ extern "C" {
 #endif
 
 extern int InitializeGraphics(GRAPHICS* graphics);
+extern void ReleaseGraphics(GRAPHICS* graphics);
+extern void GraphicsGetFillStatistics(GRAPHICS* graphics, GRAPHICS_FILL_STATISTICS* statistics);
+extern void GraphicsResetFillStatistics(GRAPHICS* graphics);
 extern eGRAPHICS_STATUS InitializeGraphicsDefaultContext(GRAPHICS_DEFAULT_CONTEXT* context, void* target, void* graphics);
 extern GRAPHICS_CONTEXT* GraphicsDefaultContextCreate(void* target, void* graphics);
+extern void GraphicsBeginPaintedExtents(GRAPHICS_CONTEXT* context);
+extern int GraphicsGetPaintedExtents(GRAPHICS_CONTEXT* context, GRAPHICS_RECTANGLE_INT* extents);
 extern void GraphicsClip(GRAPHICS_CONTEXT* context);
 
 extern void GraphicsSetSource(GRAPHICS_CONTEXT* context, GRAPHICS_PATTERN* source);
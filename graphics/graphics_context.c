@@ -1,3 +1,4 @@
+#include <string.h>
 #include "graphics.h"
 #include "graphics_private.h"
 #include "graphics_pattern.h"
@@ -865,11 +866,95 @@ static eGRAPHICS_STATUS GraphicsDefaultContextAppendPath(void* abstract_context,
 	return GraphicsPathAppendToContext(path, &context->base);
 }
 
+static void GraphicsDefaultContextAddPaintedExtents(
+	GRAPHICS_DEFAULT_CONTEXT* context,
+	const GRAPHICS_RECTANGLE_INT* extents
+)
+{
+	GRAPHICS_RECTANGLE_INT target_extents;
+	int x2, y2;
+
+	if(context->track_painted_extents == FALSE)
+	{
+		return;
+	}
+
+	// unbounded operations cover the whole target
+	if(extents == NULL)
+	{
+		if(GraphicsSurfaceGetExtents(context->state->original_target, &target_extents) == FALSE)
+		{
+			InitializeGraphicsUnboundedRectangle(&target_extents);
+		}
+		extents = &target_extents;
+	}
+
+	if(extents->width <= 0 || extents->height <= 0)
+	{
+		return;
+	}
+
+	if(context->painted_extents.width <= 0 || context->painted_extents.height <= 0)
+	{
+		context->painted_extents = *extents;
+		return;
+	}
+
+	x2 = context->painted_extents.x + context->painted_extents.width;
+	y2 = context->painted_extents.y + context->painted_extents.height;
+	if(x2 < extents->x + extents->width)
+	{
+		x2 = extents->x + extents->width;
+	}
+	if(y2 < extents->y + extents->height)
+	{
+		y2 = extents->y + extents->height;
+	}
+	if(context->painted_extents.x > extents->x)
+	{
+		context->painted_extents.x = extents->x;
+	}
+	if(context->painted_extents.y > extents->y)
+	{
+		context->painted_extents.y = extents->y;
+	}
+	context->painted_extents.width = x2 - context->painted_extents.x;
+	context->painted_extents.height = y2 - context->painted_extents.y;
+}
+
+static void GraphicsDefaultContextAddFillExtents(GRAPHICS_DEFAULT_CONTEXT* context)
+{
+	GRAPHICS_RECTANGLE_INT extents;
+
+	if(context->track_painted_extents == FALSE)
+	{
+		return;
+	}
+
+	GraphicsPathFixedApproximateFillExtents(&context->path, &extents);
+	GraphicsDefaultContextAddPaintedExtents(context, &extents);
+}
+
+static void GraphicsDefaultContextAddStrokeExtents(GRAPHICS_DEFAULT_CONTEXT* context)
+{
+	GRAPHICS_RECTANGLE_INT extents;
+
+	if(context->track_painted_extents == FALSE)
+	{
+		return;
+	}
+
+	GraphicsPathFixedApproximateStrokeExtents(&context->path, &context->state->stroke_style,
+		&context->state->matrix, FALSE, &extents);
+	GraphicsDefaultContextAddPaintedExtents(context, &extents);
+}
+
 static eGRAPHICS_STATUS GraphicsDefaultContextPaint(void* abstract_context)
 {
 	GRAPHICS_DEFAULT_CONTEXT *context = (GRAPHICS_DEFAULT_CONTEXT*)abstract_context;
 	eGRAPHICS_STATUS status;
 
+	GraphicsDefaultContextAddPaintedExtents(context, NULL);
 	status = GraphicsStatePaint(context->state);
 	context->state->source = &context->base.graphics->nil_pattern;
 
@@ -885,6 +970,7 @@ static eGRAPHICS_STATUS GraphicsDefaultContextPaintWithAlpha(void* abstract_cont
 
 	if(GRAPHICS_ALPHA_IS_OPAQUE(alpha))
 	{
+		GraphicsDefaultContextAddPaintedExtents(context, NULL);
 		return GraphicsStatePaint(context->state);
 	}
 
@@ -893,6 +979,8 @@ static eGRAPHICS_STATUS GraphicsDefaultContextPaintWithAlpha(void* abstract_cont
 		return GRAPHICS_STATUS_SUCCESS;
 	}
 
+	GraphicsDefaultContextAddPaintedExtents(context, NULL);
+
 	InitializeGraphicsColorRGBA(&color, 0, 0, 0, alpha);
 	InitializeGraphicsPatternSolid(&pattern, &color, context->base.graphics);
 
@@ -909,6 +997,7 @@ static eGRAPHICS_STATUS GraphicsDefaultContextMask(void* abstract_context, GRAPH
 	GRAPHICS_DEFAULT_CONTEXT *context = (GRAPHICS_DEFAULT_CONTEXT*)abstract_context;
 	eGRAPHICS_STATUS status;
 
+	GraphicsDefaultContextAddPaintedExtents(context, NULL);
 	status = GraphicsStateMask(context->state, mask);
 	context->state->source = &context->base.graphics->nil_pattern;
 
@@ -920,6 +1009,7 @@ static eGRAPHICS_STATUS GraphicsDefaultContextStroke(void* abstract_context)
 	GRAPHICS_DEFAULT_CONTEXT *context = (GRAPHICS_DEFAULT_CONTEXT*)abstract_context;
 	eGRAPHICS_STATUS status;
 
+	GraphicsDefaultContextAddStrokeExtents(context);
 	status = GraphicsStateStroke(context->state, &context->path);
 	if(UNLIKELY(status))
 	{
@@ -933,6 +1023,7 @@ static eGRAPHICS_STATUS GraphicsDefaultContextStrokePreserve(void* abstract_cont
 {
 	GRAPHICS_DEFAULT_CONTEXT *context = (GRAPHICS_DEFAULT_CONTEXT*)abstract_context;
 
+	GraphicsDefaultContextAddStrokeExtents(context);
 	return GraphicsStateStroke(context->state, context->path);
 }
 
@@ -1011,6 +1102,7 @@ static eGRAPHICS_STATUS GraphicsDefaultContextFill(void* abstract_context)
 	GRAPHICS_DEFAULT_CONTEXT *context = (GRAPHICS_DEFAULT_CONTEXT*)abstract_context;
 	eGRAPHICS_STATUS status;
 
+	GraphicsDefaultContextAddFillExtents(context);
 	status = GraphicsStateFill(context->state, &context->path);
 	if(UNLIKELY(status))
 	{
@@ -1024,6 +1116,7 @@ static eGRAPHICS_STATUS GraphicsDefaultContextFillPreserve(void* abstract_contex
 {
 	GRAPHICS_DEFAULT_CONTEXT *context = (GRAPHICS_DEFAULT_CONTEXT*)abstract_context;
 
+	GraphicsDefaultContextAddFillExtents(context);
 	return GraphicsStateFill(context->state, &context->path);
 }
 
@@ -1165,9 +1258,29 @@ eGRAPHICS_STATUS InitializeGraphicsDefaultContext(GRAPHICS_DEFAULT_CONTEXT* cont
 	context->state_free_list = &context->state_tail[1];
 	context->state_tail[1].next = NULL;
 
+	context->track_painted_extents = FALSE;
+	(void)memset(&context->painted_extents, 0, sizeof(context->painted_extents));
+
 	return InitializeGraphicsState(context->state, target);
 }
 
+void GraphicsBeginPaintedExtents(GRAPHICS_CONTEXT* context)
+{
+	GRAPHICS_DEFAULT_CONTEXT *default_context = (GRAPHICS_DEFAULT_CONTEXT*)context;
+
+	default_context->track_painted_extents = TRUE;
+	(void)memset(&default_context->painted_extents, 0, sizeof(default_context->painted_extents));
+}
+
+int GraphicsGetPaintedExtents(GRAPHICS_CONTEXT* context, GRAPHICS_RECTANGLE_INT* extents)
+{
+	GRAPHICS_DEFAULT_CONTEXT *default_context = (GRAPHICS_DEFAULT_CONTEXT*)context;
+
+	*extents = default_context->painted_extents;
+
+	return (extents->width > 0 && extents->height > 0) ? TRUE : FALSE;
+}
+
 GRAPHICS_CONTEXT* GraphicsDefaultContextCreate(void* target, void* graphics)
 {
 	GRAPHICS_CONTEXT *context;
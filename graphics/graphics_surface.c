@@ -8,11 +8,18 @@
 #include "graphics.h"
 #include "graphics_matrix.h"
 #include "graphics_inline.h"
+#include "graphics_region.h"
+#include "graphics_path.h"
+#include "graphics_clip.h"
 #include "../pixel_manipulate/pixel_manipulate.h"
 #include "../pixel_manipulate/pixel_manipulate_format.h"
 #include "../pixel_manipulate/pixel_manipulate_composite.h"
 #include "memory.h"
 
+#if defined(USE_SSE2) && USE_SSE2 != 0
+# include <emmintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -1397,6 +1404,334 @@ eGRAPHICS_INTEGER_STATUS GraphicsImageSurfaceStroke(
 		matrix, matrix_inverse, tolerance, antialias, clip);
 }
 
+/* dst = src (solid color) */
+static void GraphicsFillSpanSolid(uint32* dst, int width, uint32 pixel)
+{
+	int x = 0;
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i src = _mm_set1_epi32((int)pixel);
+	for( ; x + 4 <= width; x += 4)
+	{
+		_mm_storeu_si128((__m128i*)&dst[x], src);
+	}
+#endif
+	for( ; x < width; x++)
+	{
+		dst[x] = pixel;
+	}
+}
+
+/* x * a / 255 per 8bit channel, rounded */
+static INLINE uint32 GraphicsMultiplyUnit8x4(uint32 x, uint32 a)
+{
+	uint32 rb = (x & 0x00FF00FF) * a + 0x00800080;
+	uint32 ag = ((x >> 8) & 0x00FF00FF) * a + 0x00800080;
+	rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+	ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+	return rb | ag;
+}
+
+/* x + y per 8bit channel, saturated */
+static INLINE uint32 GraphicsAddUnit8x4(uint32 x, uint32 y)
+{
+	uint32 rb = (x & 0x00FF00FF) + (y & 0x00FF00FF);
+	uint32 ag = ((x >> 8) & 0x00FF00FF) + ((y >> 8) & 0x00FF00FF);
+	rb |= 0x01000100 - ((rb >> 8) & 0x00010001);
+	ag |= 0x01000100 - ((ag >> 8) & 0x00010001);
+	return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+}
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+/* x * a / 255 on 16bit lanes, rounded */
+static INLINE __m128i GraphicsMultiplyUnit8x8(__m128i x, __m128i a)
+{
+	return _mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(0x80)), _mm_set1_epi16(0x0101));
+}
+
+static INLINE __m128i GraphicsOver4(__m128i src, __m128i dst, __m128i inverse_alpha_lo, __m128i inverse_alpha_hi)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = GraphicsMultiplyUnit8x8(_mm_unpacklo_epi8(dst, zero), inverse_alpha_lo);
+	__m128i hi = GraphicsMultiplyUnit8x8(_mm_unpackhi_epi8(dst, zero), inverse_alpha_hi);
+	return _mm_adds_epu8(src, _mm_packus_epi16(lo, hi));
+}
+#endif
+
+/* dst = src + dst * (1 - src_alpha) (solid color) */
+static void GraphicsFillSpanSolidOver(uint32* dst, int width, uint32 pixel)
+{
+	const uint32 inverse_alpha = 0xFF - (pixel >> 24);
+	int x = 0;
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i src = _mm_set1_epi32((int)pixel);
+	const __m128i inverse = _mm_set1_epi16((short)inverse_alpha);
+	for( ; x + 4 <= width; x += 4)
+	{
+		_mm_storeu_si128((__m128i*)&dst[x],
+			GraphicsOver4(src, _mm_loadu_si128((__m128i*)&dst[x]), inverse, inverse));
+	}
+#endif
+	for( ; x < width; x++)
+	{
+		dst[x] = GraphicsAddUnit8x4(pixel, GraphicsMultiplyUnit8x4(dst[x], inverse_alpha));
+	}
+}
+
+/* dst = src + dst * (1 - src_alpha) (per pixel alpha) */
+static void GraphicsBlitSpanOver(uint32* dst, const uint32* src, int width)
+{
+	int x = 0;
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(0xFF);
+	for( ; x + 4 <= width; x += 4)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)&src[x]);
+		__m128i alpha = _mm_and_si128(s, alpha_mask);
+		__m128i lo, hi;
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF)
+		{
+			continue;
+		}
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFF)
+		{
+			_mm_storeu_si128((__m128i*)&dst[x], s);
+			continue;
+		}
+		lo = _mm_unpacklo_epi8(s, zero);
+		hi = _mm_unpackhi_epi8(s, zero);
+		lo = _mm_xor_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one);
+		hi = _mm_xor_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one);
+		_mm_storeu_si128((__m128i*)&dst[x],
+			GraphicsOver4(s, _mm_loadu_si128((__m128i*)&dst[x]), lo, hi));
+	}
+#endif
+	for( ; x < width; x++)
+	{
+		const uint32 alpha = src[x] >> 24;
+		if(alpha == 0xFF)
+		{
+			dst[x] = src[x];
+		}
+		else if(alpha != 0)
+		{
+			dst[x] = GraphicsAddUnit8x4(src[x], GraphicsMultiplyUnit8x4(dst[x], 0xFF - alpha));
+		}
+	}
+}
+
+static INLINE void GraphicsFillStatisticsIncrement(volatile unsigned int* counter)
+{
+	(void)ATOMIC_INCREMENT(counter);
+}
+
+/*
+ * Pixel aligned boxes (rectangle selections, layer clears, blits of
+ * integer translated images...) do not need the span compositor at all.
+ * Write them straight into the 32bit destination and fall back to the
+ * compositor for everything else.
+ */
+static eGRAPHICS_INTEGER_STATUS GraphicsImageSurfaceFillBoxes(
+	GRAPHICS_IMAGE_SURFACE* surface,
+	eGRAPHICS_OPERATOR op,
+	const GRAPHICS_PATTERN* source,
+	const GRAPHICS_PATH_FIXED* path,
+	eGRAPHICS_FILL_RULE fill_rule,
+	eGRAPHICS_ANTIALIAS antialias,
+	const GRAPHICS_CLIP* clip
+)
+{
+	GRAPHICS *graphics = (GRAPHICS*)surface->base.graphics;
+	GRAPHICS_IMAGE_SURFACE *image = NULL;
+	GRAPHICS_BOXES boxes;
+	GRAPHICS_BOXES_CHUNK *chunk;
+	GRAPHICS_BOX limit, extents;
+	uint32 pixel = 0;
+	int over = FALSE;
+	int tx = 0, ty = 0;
+	int i;
+
+	if(FALSE == path->fill_is_rectilinear || surface->data == NULL)
+	{
+		return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+	}
+	if(surface->pixel_format != PIXEL_MANIPULATE_FORMAT_A8R8G8B8
+		&& surface->pixel_format != PIXEL_MANIPULATE_FORMAT_X8R8G8B8)
+	{
+		return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+	}
+
+	limit.point1.x = limit.point1.y = 0;
+	limit.point2.x = GraphicsFixedFromInteger(surface->width);
+	limit.point2.y = GraphicsFixedFromInteger(surface->height);
+	if(clip != NULL)
+	{
+		if(clip->path != NULL || clip->num_boxes != 1)
+		{
+			return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+		}
+		if(FALSE == GRAPHICS_FIXED_IS_INTEGER(clip->boxes[0].point1.x)
+			|| FALSE == GRAPHICS_FIXED_IS_INTEGER(clip->boxes[0].point1.y)
+			|| FALSE == GRAPHICS_FIXED_IS_INTEGER(clip->boxes[0].point2.x)
+			|| FALSE == GRAPHICS_FIXED_IS_INTEGER(clip->boxes[0].point2.y))
+		{
+			return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+		}
+		limit.point1.x = MAXIMUM(limit.point1.x, clip->boxes[0].point1.x);
+		limit.point1.y = MAXIMUM(limit.point1.y, clip->boxes[0].point1.y);
+		limit.point2.x = MINIMUM(limit.point2.x, clip->boxes[0].point2.x);
+		limit.point2.y = MINIMUM(limit.point2.y, clip->boxes[0].point2.y);
+		if(limit.point1.x >= limit.point2.x || limit.point1.y >= limit.point2.y)
+		{
+			return GRAPHICS_INTEGER_STATUS_SUCCESS;
+		}
+	}
+
+	switch(op)
+	{
+	case GRAPHICS_OPERATOR_CLEAR:
+		break;
+	case GRAPHICS_OPERATOR_SOURCE:
+	case GRAPHICS_OPERATOR_OVER:
+		if(source->type == GRAPHICS_PATTERN_TYPE_SOLID)
+		{
+			const GRAPHICS_COLOR *color = &((const GRAPHICS_SOLID_PATTERN*)source)->color;
+			pixel = ((uint32)(color->alpha_short >> 8) << 24) | ((uint32)(color->red_short >> 8) << 16)
+				| (color->green_short & 0xFF00) | (color->blue_short >> 8);
+			if(op == GRAPHICS_OPERATOR_OVER)
+			{
+				if(GRAPHICS_COLOR_IS_CLEAR(color))
+				{
+					return GRAPHICS_INTEGER_STATUS_SUCCESS;
+				}
+				over = FALSE == GRAPHICS_ALPHA_SHORT_IS_OPAQUE(color->alpha_short);
+			}
+		}
+		else if(source->type == GRAPHICS_PATTERN_TYPE_SURFACE)
+		{
+			GRAPHICS_SURFACE *source_surface = ((const GRAPHICS_SURFACE_PATTERN*)source)->surface;
+			if(source_surface->type != GRAPHICS_SURFACE_TYPE_IMAGE || source->opacity < 1
+				|| source->extend != GRAPHICS_EXTEND_NONE
+				|| FALSE == GraphicsMatrixIsIntegerTranslation(&source->matrix, &tx, &ty))
+			{
+				return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+			}
+			image = (GRAPHICS_IMAGE_SURFACE*)source_surface;
+			if(image == surface || image->data == NULL
+				|| image->pixel_format != PIXEL_MANIPULATE_FORMAT_A8R8G8B8)
+			{
+				return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+			}
+			over = op == GRAPHICS_OPERATOR_OVER;
+		}
+		else
+		{
+			return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+		}
+		break;
+	default:
+		return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+	}
+
+	InitializeGraphicsBoxes(&boxes);
+	GraphicsBoxesLimit(&boxes, &limit, 1);
+	if(GraphicsPathFixedFillRectilinearToBoxes(path, fill_rule, antialias, &boxes) != GRAPHICS_STATUS_SUCCESS
+		|| FALSE == boxes.is_pixel_aligned)
+	{
+		GraphicsBoxesFinish(&boxes);
+		return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+	}
+
+	if(image != NULL)
+	{	// the source has to cover every box, otherwise EXTEND_NONE would bring in transparency
+		for(chunk = &boxes.chunks; chunk != NULL; chunk = chunk->next)
+		{
+			for(i=0; i<chunk->count; i++)
+			{
+				const GRAPHICS_BOX *box = &chunk->base[i];
+				if(GraphicsFixedIntegerPart(box->point1.x) + tx < 0
+					|| GraphicsFixedIntegerPart(box->point1.y) + ty < 0
+					|| GraphicsFixedIntegerPart(box->point2.x) + tx > image->width
+					|| GraphicsFixedIntegerPart(box->point2.y) + ty > image->height)
+				{
+					GraphicsBoxesFinish(&boxes);
+					return GRAPHICS_INTEGER_STATUS_UNSUPPORTED;
+				}
+			}
+		}
+	}
+
+	for(chunk = &boxes.chunks; chunk != NULL; chunk = chunk->next)
+	{
+		for(i=0; i<chunk->count; i++)
+		{
+			const GRAPHICS_BOX *box = &chunk->base[i];
+			int x = GraphicsFixedIntegerPart(box->point1.x);
+			int y = GraphicsFixedIntegerPart(box->point1.y);
+			int width = GraphicsFixedIntegerPart(box->point2.x) - x;
+			int height = GraphicsFixedIntegerPart(box->point2.y) - y;
+			uint8 *dst = &surface->data[y * surface->stride + x * 4];
+			int j;
+
+			if(width <= 0 || height <= 0)
+			{
+				continue;
+			}
+
+			if(image != NULL)
+			{
+				const uint8 *src = &image->data[(y + ty) * image->stride + (x + tx) * 4];
+				for(j=0; j<height; j++, dst += surface->stride, src += image->stride)
+				{
+					if(over != FALSE)
+					{
+						GraphicsBlitSpanOver((uint32*)dst, (const uint32*)src, width);
+					}
+					else
+					{
+						(void)memcpy(dst, src, width * 4);
+					}
+				}
+			}
+			else
+			{
+				for(j=0; j<height; j++, dst += surface->stride)
+				{
+					if(over != FALSE)
+					{
+						GraphicsFillSpanSolidOver((uint32*)dst, width, pixel);
+					}
+					else
+					{
+						GraphicsFillSpanSolid((uint32*)dst, width, pixel);
+					}
+				}
+			}
+		}
+	}
+
+	if(surface->base.damage != NULL && boxes.num_boxes > 0)
+	{
+		GRAPHICS_RECTANGLE_INT rectangle = {0};
+		GraphicsBoxesExtents(&boxes, &extents);
+		rectangle.x = GraphicsFixedIntegerPart(extents.point1.x);
+		rectangle.y = GraphicsFixedIntegerPart(extents.point1.y);
+		rectangle.width = GraphicsFixedIntegerPart(extents.point2.x) - rectangle.x;
+		rectangle.height = GraphicsFixedIntegerPart(extents.point2.y) - rectangle.y;
+		surface->base.damage = GraphicsDamageAddRectangle(surface->base.damage, &rectangle);
+	}
+	GraphicsBoxesFinish(&boxes);
+
+	if(graphics != NULL)
+	{
+		GraphicsFillStatisticsIncrement((image != NULL)
+			? &graphics->fill_statistics.blit_fills : &graphics->fill_statistics.solid_fills);
+	}
+
+	return GRAPHICS_INTEGER_STATUS_SUCCESS;
+}
+
 eGRAPHICS_INTEGER_STATUS GraphicsImageSurfaceFill(
 	void* abstract_surface,
 	eGRAPHICS_OPERATOR op,
@@ -1409,7 +1744,19 @@ eGRAPHICS_INTEGER_STATUS GraphicsImageSurfaceFill(
 )
 {
 	GRAPHICS_IMAGE_SURFACE *surface = (GRAPHICS_IMAGE_SURFACE*)abstract_surface;
+	GRAPHICS *graphics = (GRAPHICS*)surface->base.graphics;
+	eGRAPHICS_INTEGER_STATUS status;
 
+	status = GraphicsImageSurfaceFillBoxes(surface, op, source, path, fill_rule, antialias, clip);
+	if(status != GRAPHICS_INTEGER_STATUS_UNSUPPORTED)
+	{
+		return status;
+	}
+
+	if(graphics != NULL)
+	{
+		GraphicsFillStatisticsIncrement(&graphics->fill_statistics.general_fills);
+	}
 	return GraphicsCompositorFill(surface->compositor, &surface->base, op, source, path,
 		fill_rule, tolerance, antialias, clip);
 }
@@ -1451,7 +1798,7 @@ void InitializeGraphicsSurface(
 	void* graphics
 )
 {
-	static unsigned int id = 1;
+	static volatile unsigned int id = 0;
 	surface->backend = backend;
 	// TODO surface->device = device
 	surface->content = content;
@@ -1460,7 +1807,7 @@ void InitializeGraphicsSurface(
 
 	surface->reference_count = 1;
 	surface->status = GRAPHICS_STATUS_SUCCESS;
-	surface->unique_id = id++;
+	surface->unique_id = (unsigned int)ATOMIC_INCREMENT(&id);
 
 	surface->finished = FALSE;
 	surface->finishing = FALSE;
@@ -13,13 +13,33 @@ BrushButton::BrushButton(
 	const QString& text,
 	BRUSH_CORE* core
 )	: QPushButton(parent),
-	  pixmap(image_file_path)
+	  image_file_path(image_file_path),
+	  icon(NULL),
+	  pixmap_loaded(false)
 {
 	setCheckable(true);
 	
 	name = text;
 
-	QString path = QDir().absolutePath();
+	setMinimumSize(BRUSH_BUTTON_SIZE, BRUSH_BUTTON_SIZE);
+
+	this->core = core;
+	if(core != NULL)
+	{
+		core->button = (void*)this;
+	}
+}
+
+/*
+* loadPixmap
+* ボタンの画像を読み込む
+*  起動時に全ボタン分を読み込まないよう、最初の描画時に呼び出す
+*/
+void BrushButton::loadPixmap()
+{
+	pixmap_loaded = true;
+	pixmap = QPixmap(image_file_path);
+
 	const QChar *path_data = image_file_path.data();
 	if(pixmap.isNull() && QDir(image_file_path).isAbsolute() == false && path_data->unicode() != '\0')
 	{
@@ -35,15 +55,8 @@ BrushButton::BrushButton(
 		pixmap = QPixmap(absolute_path);
 	}
 
-	setMinimumSize(BRUSH_BUTTON_SIZE, BRUSH_BUTTON_SIZE);
-
 	icon = new QIcon(pixmap);
 	// this->setIcon(*icon);
-	this->core = core;
-	if(core != NULL)
-	{
-		core->button = (void*)this;
-	}
 }
 
 BrushButton::~BrushButton()
@@ -58,6 +71,11 @@ void BrushButton::paintEvent(QPaintEvent* event)
 #define BUTTON_PIXMAP_MARGIN 2
 	QPushButton::paintEvent(event);
 
+	if(pixmap_loaded == false)
+	{
+		loadPixmap();
+	}
+
 	QFont font = this->font();
 	font.setPointSize(BUTTON_FONT_SIZE);
 	QFontMetrics metrics(font);
@@ -23,10 +23,14 @@ protected:
 	void mousePressEvent(QMouseEvent* event) override;
 
 private:
+	void loadPixmap();
+
+	QString image_file_path;
 	QPixmap pixmap;
 	QIcon *icon;
 	BRUSH_CORE *core;
 	QString name;
+	bool pixmap_loaded;
 };
 
 #endif // #ifndef _INCLUDED_BRUSH_BUTTON_QT_H_
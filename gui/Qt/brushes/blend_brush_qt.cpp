@@ -14,8 +14,6 @@ extern "C" {
 
 BlendBrushGUI::BlendBrushGUI(BRUSH_CORE* core) : DefaultBrushGUI(core)
 {
-	BrushCoreSetCirclePattern(core, core->radius, core->outline_hardness, core->blur,
-		core->opacity, *core->color);
 }
 
 QWidget* BlendBrushGUI::createDetailUI()
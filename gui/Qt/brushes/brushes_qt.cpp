@@ -99,8 +99,8 @@ int BrushGUI_Base::baseScale()
 DefaultBrushGUI::DefaultBrushGUI(BRUSH_CORE* core)
 					: BrushGUI_Base(core)
 {
-	BrushCoreSetCirclePattern(core, core->radius, core->outline_hardness * 0.01, core->blur,
-								core->opacity * 0.01, *core->color);
+	// パターンは最初の描画時に作成する
+	core->flags |= BRUSH_FLAG_PATTERN_PENDING;
 }
 
 void DefaultBrushGUI::brushScaleChanged(FLOAT_T scale)
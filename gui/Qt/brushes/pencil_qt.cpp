@@ -12,8 +12,6 @@ extern "C" {
 
 PencilGUI::PencilGUI(BRUSH_CORE* core) : DefaultBrushGUI(core)
 {
-	BrushCoreSetCirclePattern(core, core->radius, core->outline_hardness, core->blur,
-								core->opacity, *core->color);
 }
 
 QWidget* PencilGUI::createDetailUI()
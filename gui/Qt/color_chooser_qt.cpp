@@ -20,16 +20,23 @@ void DrawColorCircle(
 	QPen pen;
 	QRectF rect(line_width * 0.5, line_width * 0.5,
 				width - line_width, height - line_width);
-	HSV hsv = {360, 255, 255};
-	uint8 color[3];
+	HSV hsv[360];
+	uint8 colors[360*4] = {0};
 	pen.setWidthF(line_width);
 
+	// 円周の全ての色相を1度にまとめて変換する
+	for(int i = 0; i < 360; i++)
+	{
+		hsv[i].h = 360 - i - 1;
+		hsv[i].s = hsv[i].v = 255;
+	}
+	HSV2RGB_Line(hsv, colors, 360, 4);
+
 	(void)painter.begin(pixmap);
 	painter.fillRect(QRect(0, 0, width, height), background_color);
 	for(int arc = -210 * 16, i = 0; i < 360; arc += 16, i++)
 	{
-		hsv.h = 360 - i - 1;
-		HSV2RGB_Pixel(&hsv, color);
+		const uint8 *color = &colors[i*4];
 		pen.setColor(QColor(color[0], color[1], color[2]));
 		painter.setPen(pen);
 		painter.drawArc(rect, arc, -16);
@@ -1,5 +1,6 @@
 #include <QPainter>
 #include <Qdir>
+#include <QImageReader>
 #include "../../common_tools.h"
 #include "common_tool_button_qt.h"
 #include "tool_box_qt.h"
@@ -9,15 +10,15 @@ CommonToolButton::CommonToolButton(
 	QWidget* parent,
 	const QString& image_file_path,
 	COMMON_TOOL_CORE* core
-) : QPushButton(parent)
+) : QPushButton(parent),
+	icon(NULL),
+	pixmap_loaded(false)
 {
 	setCheckable(true);
 
-	QString path = QDir().absolutePath();
 	const QChar *path_data = image_file_path.data();
-	if(pixmap.isNull() && QDir(image_file_path).isAbsolute() == false && path_data->unicode() != '\0')
+	if(QDir(image_file_path).isAbsolute() == false && path_data->unicode() != '\0')
 	{
-		QString absolute_path;
 		if(image_file_path.data()[0] == '.')
 		{
 			absolute_path = QDir().absolutePath() + QString(&image_file_path.data()[1]);
@@ -26,14 +27,31 @@ CommonToolButton::CommonToolButton(
 		{
 			absolute_path = QDir(QDir().absolutePath()).filePath(QString(image_file_path));
 		}
-		pixmap = QPixmap(absolute_path);
 	}
 
-	icon = new QIcon(pixmap);
 	this->core = core;
 
-	QSize icon_size = pixmap.size();
-	setMinimumSize(icon_size);
+	// 画像の読み込みは最初の描画まで待ち、大きさはヘッダーだけ読んで決める
+	QSize icon_size;
+	if(absolute_path.isEmpty() == false)
+	{
+		icon_size = QImageReader(absolute_path).size();
+	}
+	setMinimumSize(icon_size.isValid() ? icon_size : QSize(0, 0));
+}
+
+/*
+* loadPixmap
+* ボタンの画像を読み込む
+*/
+void CommonToolButton::loadPixmap()
+{
+	pixmap_loaded = true;
+	if(absolute_path.isEmpty() == false)
+	{
+		pixmap = QPixmap(absolute_path);
+	}
+	icon = new QIcon(pixmap);
 }
 
 CommonToolButton::~CommonToolButton()
@@ -45,6 +63,11 @@ void CommonToolButton::paintEvent(QPaintEvent* event)
 {
 	QPushButton::paintEvent(event);
 
+	if(pixmap_loaded == false)
+	{
+		loadPixmap();
+	}
+
 	QPainter painter(this);
 	painter.drawPixmap(QRect(0, 0, pixmap.size().width(), pixmap.size().height()), pixmap);
 
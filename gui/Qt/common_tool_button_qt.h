@@ -21,9 +21,13 @@ protected:
 	void mousePressEvent(QMouseEvent* event) override;
 
 private:
+	void loadPixmap();
+
+	QString absolute_path;
 	QPixmap pixmap;
 	QIcon *icon;
 	COMMON_TOOL_CORE *core;
+	bool pixmap_loaded;
 };
 
 #endif	/* #ifndef _INCLUDED_COMMON_TOOL_BUTTON_QT_H_ */
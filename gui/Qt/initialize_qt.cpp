@@ -2,47 +2,201 @@
 #include <QApplication>
 #include <QTranslator>
 #include <QSplashScreen>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
 #include "mainwindow.h"
 #include "qt_widgets.h"
 #include "../../memory.h"
 #include "tool_box_qt.h"
 #include "brush_button_qt.h"
+#include "../tool_box.h"
+#include "../../stroke_replay.h"
+#include "../../batch_export.h"
+#include "../../utils.h"
+#include "../../image_file/image_file.h"
+
+// 起動時に別スレッドの処理を待つ間、スプラッシュ画面のイベントを処理する間隔(ミリ秒)
+#define STARTUP_WAIT_INTERVAL 10
 
 /*
-* InitializeApplication関数
-* アプリケーションの初期化
+* eSTARTUP_PHASE列挙体
+* 起動処理の段階
+*/
+typedef enum _eSTARTUP_PHASE
+{
+	STARTUP_PHASE_SETTINGS,
+	STARTUP_PHASE_GRAPHICS,
+	STARTUP_PHASE_RESOURCE_WAIT,
+	STARTUP_PHASE_MAIN_WINDOW,
+	STARTUP_PHASE_TOOL_TABLE,
+	STARTUP_PHASE_TOOL_BUTTON,
+	STARTUP_PHASE_DETAIL_UI,
+	NUM_STARTUP_PHASE
+} eSTARTUP_PHASE;
+
+/*
+* STARTUP_TIMES構造体
+* 起動処理の段階毎の処理時間(ナノ秒)
+*/
+typedef struct _STARTUP_TIMES
+{
+	qint64 phase[NUM_STARTUP_PHASE];	// メインスレッドの各段階
+	qint64 labels;						// ラベルの作成(別スレッド)
+	qint64 common_tool_file;			// 共通ツールの初期化ファイルの解析(別スレッド)
+	qint64 brush_file;					// ブラシの初期化ファイルの解析(別スレッド)
+	qint64 total;						// 起動処理全体
+} STARTUP_TIMES;
+
+/*
+* StartupLabelsTask
+* 起動時にラベルの文字列を作成する処理
+*/
+class StartupLabelsTask : public QRunnable
+{
+public:
+	StartupLabelsTask(APPLICATION* app, qint64* elapsed) : app(app), elapsed(elapsed) {}
+
+	void run() override
+	{
+		QElapsedTimer timer;
+		timer.start();
+		LoadLabels(app->labels, app->fractal_labels, NULL);
+		*elapsed = timer.nsecsElapsed();
+	}
+
+private:
+	APPLICATION *app;
+	qint64 *elapsed;
+};
+
+/*
+* StartupIniFileTask
+* 起動時に初期化ファイル1つを読み込んで解析する処理
+*/
+class StartupIniFileTask : public QRunnable
+{
+public:
+	StartupIniFileTask(INI_FILE_PTR (*load_function)(const char*), const char* file_path,
+		INI_FILE_PTR* result, qint64* elapsed)
+		: load_function(load_function), file_path(file_path), result(result), elapsed(elapsed) {}
+
+	void run() override
+	{
+		QElapsedTimer timer;
+		timer.start();
+		*result = load_function(file_path);
+		*elapsed = timer.nsecsElapsed();
+	}
+
+private:
+	INI_FILE_PTR (*load_function)(const char*);
+	const char *file_path;
+	INI_FILE_PTR *result;
+	qint64 *elapsed;
+};
+
+/*
+* EndStartupPhase関数
+* 起動処理の1段階分の処理時間を記録し、次の段階の計測を始める
 * 引数
-* app				: アプリケーション全体を管理する構造体のアドレス
-* argv				: main関数の第一引数
-* argc				: main関数の第二引数
-* init_file_name	: 初期化ファイルの名前
+* times	: 処理時間を記録する構造体のアドレス
+* phase	: 終了した段階
+* timer	: 段階の開始から計測しているタイマー
 */
-void InitializeApplication(APPLICATION* app, char** argv, int argc, char* init_file_name)
+static void EndStartupPhase(STARTUP_TIMES* times, eSTARTUP_PHASE phase, QElapsedTimer* timer)
+{
+	times->phase[phase] = timer->nsecsElapsed();
+	timer->restart();
+}
+
+/*
+* PrintStartupTimes関数
+* 起動処理の段階毎の処理時間を表示する
+* 引数
+* times	: 処理時間を記録した構造体のアドレス
+* fp	: 出力先
+*/
+static void PrintStartupTimes(const STARTUP_TIMES* times, FILE* fp)
+{
+	const char *phase_names[NUM_STARTUP_PHASE] =
+	{
+		"settings", "graphics", "resource wait", "main window",
+		"tool table", "tool buttons", "detail ui"
+	};
+	int i;
+
+	for(i=0; i<NUM_STARTUP_PHASE; i++)
+	{
+		(void)fprintf(fp, "%-16s %10.3f ms\n", phase_names[i], times->phase[i] * 1.0e-6);
+	}
+	(void)fprintf(fp, "  labels         %10.3f ms (background)\n", times->labels * 1.0e-6);
+	(void)fprintf(fp, "  common tools   %10.3f ms (background)\n", times->common_tool_file * 1.0e-6);
+	(void)fprintf(fp, "  brushes        %10.3f ms (background)\n", times->brush_file * 1.0e-6);
+	(void)fprintf(fp, "total            %10.3f ms\n", times->total * 1.0e-6);
+}
+
+/*
+* SetupApplication関数
+* 設定ファイルを読み込み、メインウィンドウとツールを初期化する
+*  互いに依存しないラベルと初期化ファイルの解析は別スレッドで並行して行う
+* 引数
+* app			: アプリケーション全体を管理する構造体のアドレス
+* show_window	: メインウィンドウを表示するか否か
+* times			: 段階毎の処理時間を記録する構造体のアドレス(不要ならNULL)
+*/
+static void SetupApplication(APPLICATION* app, int show_window, STARTUP_TIMES* times)
 {
 #define INITIALIZE_FILE_NAME "application.ini"
-	Application *application = new Application(argc, argv);
-	QTranslator translator;
-	QPixmap pixmap("./image/splash.png");
-	QSplashScreen splash(pixmap);
-	splash.show();
+	STARTUP_TIMES local_times = {0};
+	INI_FILE_PTR common_tool_file = NULL, brush_file = NULL;
+	QElapsedTimer total_timer, phase_timer;
+	QThreadPool pool;
+
+	if(times == NULL)
+	{
+		times = &local_times;
+	}
+	total_timer.start();
+	phase_timer.start();
 
-	translator.load("KABURAGI");
-	application->installTranslator(&translator);
-	
 	(void)ReadInitializeFile(app, INITIALIZE_FILE_NAME);
+	InitializeVectorScriptStatePool(&app->vector_script_pool);
+	EndStartupPhase(times, STARTUP_PHASE_SETTINGS, &phase_timer);
+
+	// ツールのテーブル作成はGUIを作るのでメインスレッドで行い、ファイルの解析だけを任せる
+	pool.start(new StartupLabelsTask(app, &times->labels));
+	pool.start(new StartupIniFileTask(LoadCommonToolInitializeFile,
+		app->common_tool_file_path, &common_tool_file, &times->common_tool_file));
+	pool.start(new StartupIniFileTask(LoadBrushInitializeFile,
+		BRUSH_INITIALIZE_FILE_PATH, &brush_file, &times->brush_file));
 	
 	SetLayerBlendFunctionsArray(app->layer_blend_functions);
 	SetPartLayerBlendFunctionsArray(app->part_layer_blend_functions);
 
 	InitializeGraphics(&app->graphics);
+	EndStartupPhase(times, STARTUP_PHASE_GRAPHICS, &phase_timer);
 
-	LoadLabels(app->labels, app->fractal_labels, NULL);
+	while(pool.waitForDone(STARTUP_WAIT_INTERVAL) == false)
+	{
+		QCoreApplication::processEvents();
+	}
+	EndStartupPhase(times, STARTUP_PHASE_RESOURCE_WAIT, &phase_timer);
 
 	app->widgets = CreateMainWindowWidgets(app);
 
 	app->widgets->main_window = new MainWindow(NULL, app);
 	app->widgets->main_window->CreateNormalMenuBar();
-	app->widgets->main_window->show();
+	if(show_window != FALSE)
+	{
+		app->widgets->main_window->show();
+	}
+	EndStartupPhase(times, STARTUP_PHASE_MAIN_WINDOW, &phase_timer);
 	
 	app->tool_box.active_common_tool = app->tool_box.common_tools[0][0];
 	app->tool_box.active_brush[0] = app->tool_box.brushes[0][0];
@@ -50,14 +204,21 @@ void InitializeApplication(APPLICATION* app, char** argv, int argc, char* init_f
 	app->tool_box.active_vector_brush[0] = app->tool_box.vector_brushes[0][0];
 	app->tool_box.active_vector_brush[1] = app->tool_box.vector_brushes[0][0];
 
-	(void)ReadCommonToolInitializeFile(app, app->common_tool_file_path);
-	//(void)ReadBrushInitializeFile(app, app->brush_file_path);
-	(void)ReadBrushInitializeFile(app, BRUSH_INITIALIZE_FILE_PATH);
+	if(common_tool_file != NULL)
+	{
+		InitializeCommonToolTable(app, common_tool_file);
+	}
+	if(brush_file != NULL)
+	{
+		(void)InitializeBrushTable(app, brush_file);
+	}
 
 	SetDefaultColorPickerCallbacks(app);
+	EndStartupPhase(times, STARTUP_PHASE_TOOL_TABLE, &phase_timer);
 
 	app->widgets->tool_box->createCommonToolButtonTable();
 	app->widgets->tool_box->createBrushButtonTable();
+	EndStartupPhase(times, STARTUP_PHASE_TOOL_BUTTON, &phase_timer);
 
 	QCoreApplication::setAttribute(Qt::AA_CompressHighFrequencyEvents);
 
@@ -105,8 +266,379 @@ void InitializeApplication(APPLICATION* app, char** argv, int argc, char* init_f
 	button->setChecked(true);
 	app->tool_box.active_brush[INPUT_PEN]->create_detail_ui(app, app->tool_box.active_brush[INPUT_PEN]);
 	app->tool_box.flags |= TOOL_USING_BRUSH;
+	EndStartupPhase(times, STARTUP_PHASE_DETAIL_UI, &phase_timer);
+
+	times->total = total_timer.nsecsElapsed();
+#undef INITIALIZE_FILE_NAME
+}
+
+/*
+* ReleaseApplicationResources関数
+* アプリケーション終了時に全体で共有しているリソースを開放する
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+*/
+static void ReleaseApplicationResources(APPLICATION* app)
+{
+	ReleaseVectorScriptStatePool(&app->vector_script_pool);
+	ReleaseTextureCache(&app->textures);
+}
+
+/*
+* InitializeApplication関数
+* アプリケーションの初期化
+*  コマンドラインに--startup-timeを指定すると起動処理の段階毎の時間を表示する
+* 引数
+* app				: アプリケーション全体を管理する構造体のアドレス
+* argv				: main関数の第一引数
+* argc				: main関数の第二引数
+* init_file_name	: 初期化ファイルの名前
+*/
+void InitializeApplication(APPLICATION* app, char** argv, int argc, char* init_file_name)
+{
+	Application *application = new Application(argc, argv);
+	QTranslator translator;
+	QPixmap pixmap("./image/splash.png");
+	QSplashScreen splash(pixmap);
+	STARTUP_TIMES times = {0};
+	int print_startup_time = FALSE;
+	int i;
+
+	for(i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "--startup-time") == 0)
+		{
+			print_startup_time = TRUE;
+		}
+	}
+
+	splash.show();
+	QCoreApplication::processEvents();
+
+	translator.load("KABURAGI");
+	application->installTranslator(&translator);
+
+	SetupApplication(app, TRUE, &times);
+	splash.finish(app->widgets->main_window);
+
+	if(print_startup_time != FALSE)
+	{
+		PrintStartupTimes(&times, stderr);
+	}
 
 	application->exec();
+	ReleaseApplicationResources(app);
+}
+
+/*
+* FindBrushByName関数
+* ブラシテーブルから名前の一致するブラシを探す
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+* name	: ブラシの名前
+* 返り値
+*	見つかったブラシ 無ければNULL
+*/
+static BRUSH_CORE* FindBrushByName(APPLICATION* app, const char* name)
+{
+	int x, y;
+
+	for(y=0; y<BRUSH_TABLE_HEIGHT; y++)
+	{
+		for(x=0; x<BRUSH_TABLE_WIDTH; x++)
+		{
+			BRUSH_CORE *brush = app->tool_box.brushes[y][x];
+			if(brush != NULL && brush->name != NULL && strcmp(brush->name, name) == 0)
+			{
+				return brush;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* ExecuteStrokeReplayMode関数
+* ウィンドウを表示せずに文書を開き、記録された入力イベントを再生して処理時間を表示する
+*  コマンドライン: --replay-stroke 文書ファイル イベントファイル [--brush ブラシ名]
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+* argv	: main関数の第一引数
+* argc	: main関数の第二引数
+* 返り値
+*	正常終了:0	失敗:0以外
+*/
+int ExecuteStrokeReplayMode(APPLICATION* app, char** argv, int argc)
+{
+	const char *document_path = NULL;
+	const char *event_path = NULL;
+	const char *brush_name = NULL;
+	DRAW_WINDOW *canvas, **store_canvas;
+	STROKE_REPLAY *replay;
+	int i;
+
+	for(i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "--replay-stroke") == 0)
+		{
+			continue;
+		}
+		else if(strcmp(argv[i], "--brush") == 0 && i + 1 < argc)
+		{
+			brush_name = argv[++i];
+		}
+		else if(document_path == NULL)
+		{
+			document_path = argv[i];
+		}
+		else if(event_path == NULL)
+		{
+			event_path = argv[i];
+		}
+	}
+	if(document_path == NULL || event_path == NULL)
+	{
+		(void)fprintf(stderr, "usage: %s --replay-stroke document events [--brush name]\n", argv[0]);
+		return 1;
+	}
+
+	if((replay = ReadStrokeReplayFile(event_path)) == NULL)
+	{
+		(void)fprintf(stderr, "failed to read events: %s\n", event_path);
+		return 1;
+	}
+
+	// ウィンドウシステムに接続せずに実行する
+	qputenv("QT_QPA_PLATFORM", "offscreen");
+	Application *application = new Application(argc, argv);
+	SetupApplication(app, FALSE, NULL);
+
+	if(brush_name != NULL)
+	{
+		BRUSH_CORE *brush = FindBrushByName(app, brush_name);
+		if(brush == NULL)
+		{
+			(void)fprintf(stderr, "brush not found: %s\n", brush_name);
+			DeleteStrokeReplay(&replay);
+			delete application;
+			return 1;
+		}
+		app->tool_box.active_brush[INPUT_PEN] = brush;
+		ChangeDetailUI(TYPE_NORMAL_LAYER, brush, FALSE, app);
+	}
+
+	// CreateDrawWindow内でapp->window_numが更新される関係上
+		// アドレスの保存先を記録しておく
+	store_canvas = &app->draw_window[app->window_num];
+	*store_canvas = canvas = ReadImageFile(app, (char*)document_path);
+	if(canvas == NULL)
+	{
+		(void)fprintf(stderr, "failed to open document: %s\n", document_path);
+		DeleteStrokeReplay(&replay);
+		delete application;
+		return 1;
+	}
+	if(canvas->active_layer == NULL)
+	{
+		canvas->active_layer = canvas->layer;
+	}
+	canvas->widgets = CreateDrawWindowWidgets(app, canvas);
+	AddDrawWindow2MainWindow(app->widgets, canvas);
+
+	ExecuteStrokeReplay(replay, canvas);
+	PrintStrokeReplayResult(replay, stdout);
+
+	DeleteStrokeReplay(&replay);
+	ReleaseApplicationResources(app);
+	delete application;
+
+	return 0;
+}
+
+/*
+* BatchExportBudget
+* 同時に処理する文書のメモリ使用量を上限内に抑える
+*/
+class BatchExportBudget
+{
+public:
+	BatchExportBudget(size_t limit) : limit(limit), used(0) {}
+
+	// 見積もり分のメモリが空くまで待って確保する
+	// 単独で上限を超える文書は他の文書が終わってから処理する
+	void acquire(size_t bytes)
+	{
+		QMutexLocker locker(&mutex);
+		while(used > 0 && used + bytes > limit)
+		{
+			released.wait(&mutex);
+		}
+		used += bytes;
+	}
+
+	void release(size_t bytes)
+	{
+		QMutexLocker locker(&mutex);
+		used -= bytes;
+		released.wakeAll();
+	}
+
+private:
+	QMutex mutex;
+	QWaitCondition released;
+	size_t limit;
+	size_t used;
+};
+
+/*
+* BatchExportTask
+* 文書1つ分の書き出し処理
+*/
+class BatchExportTask : public QRunnable
+{
+public:
+	BatchExportTask(APPLICATION* app, BATCH_EXPORT_ITEM* item, BatchExportBudget* budget,
+		int compression, ePNG_STREAM_FILTER filter)
+		: app(app), item(item), budget(budget), compression(compression), filter(filter) {}
+
+	void run() override
+	{
+		budget->acquire(item->estimated_bytes);
+		(void)ExportDocumentToPNG(app, item, compression, filter);
+		budget->release(item->estimated_bytes);
+	}
+
+private:
+	APPLICATION *app;
+	BATCH_EXPORT_ITEM *item;
+	BatchExportBudget *budget;
+	int compression;
+	ePNG_STREAM_FILTER filter;
+};
+
+/*
+* ExecuteBatchExportMode関数
+* ウィンドウを表示せずに複数の文書をPNGファイルに書き出し、処理時間を表示する
+*  メモリ使用量の上限内で複数の文書を同時に処理する
+*  コマンドライン: --batch-export [--output 出力先フォルダ] [--jobs 同時処理数]
+*		[--memory-mb 上限(MB)] [--compression 圧縮レベル] [--png-filter fast|all] 文書ファイル...
+* 引数
+* app	: アプリケーション全体を管理する構造体のアドレス
+* argv	: main関数の第一引数
+* argc	: main関数の第二引数
+* 返り値
+*	全て成功:0	失敗有り:0以外
+*/
+int ExecuteBatchExportMode(APPLICATION* app, char** argv, int argc)
+{
+	const char *output_directory = NULL;
+	BATCH_EXPORT_ITEM *items;
+	ePNG_STREAM_FILTER filter = PNG_STREAM_FILTER_ALL;
+	size_t memory_limit = (size_t)BATCH_EXPORT_DEFAULT_MEMORY_MB * 1024 * 1024;
+	int num_jobs = QThread::idealThreadCount();
+	int compression = BATCH_EXPORT_DEFAULT_COMPRESSION;
+	int num_items = 0;
+	int num_failed = 0;
+	double start_time;
+	int i;
+
+	items = (BATCH_EXPORT_ITEM*)MEM_CALLOC_FUNC(argc, sizeof(*items));
+	for(i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "--batch-export") == 0)
+		{
+			continue;
+		}
+		else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			output_directory = argv[++i];
+		}
+		else if(strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+		{
+			num_jobs = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--memory-mb") == 0 && i + 1 < argc)
+		{
+			memory_limit = (size_t)atoi(argv[++i]) * 1024 * 1024;
+		}
+		else if(strcmp(argv[i], "--compression") == 0 && i + 1 < argc)
+		{
+			compression = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--png-filter") == 0 && i + 1 < argc)
+		{
+			filter = (StringCompareIgnoreCase(argv[++i], "fast") == 0)
+				? PNG_STREAM_FILTER_FAST : PNG_STREAM_FILTER_ALL;
+		}
+		else
+		{
+			items[num_items++].input_path = argv[i];
+		}
+	}
+	if(num_items == 0)
+	{
+		(void)fprintf(stderr, "usage: %s --batch-export [--output directory] [--jobs n]"
+			" [--memory-mb n] [--compression 0-9] [--png-filter fast|all] documents...\n", argv[0]);
+		MEM_FREE_FUNC(items);
+		return 1;
+	}
+	if(num_jobs < 1)
+	{
+		num_jobs = 1;
+	}
+
+	// ウィンドウシステムに接続せずに実行する
+	qputenv("QT_QPA_PLATFORM", "offscreen");
+	Application *application = new Application(argc, argv);
+	SetupApplication(app, FALSE, NULL);
+
+	for(i=0; i<num_items; i++)
+	{
+		QFileInfo input(QFile::decodeName(items[i].input_path));
+		QDir directory = (output_directory != NULL) ? QDir(QFile::decodeName(output_directory)) : input.dir();
+		QString output = directory.filePath(input.completeBaseName() + ".png");
+		// 入力のPNGファイルを上書きしない
+		if(QFileInfo(output).absoluteFilePath() == input.absoluteFilePath())
+		{
+			output = directory.filePath(input.completeBaseName() + "_export.png");
+		}
+		items[i].output_path = MEM_STRDUP_FUNC(QFile::encodeName(output).constData());
+		items[i].estimated_bytes = EstimateBatchExportMemory(items[i].input_path);
+	}
+
+	start_time = GetStrokeReplayTime();
+	{
+		QThreadPool pool;
+		BatchExportBudget budget(memory_limit);
+
+		pool.setMaxThreadCount(num_jobs);
+		for(i=0; i<num_items; i++)
+		{
+			// 読み込めないファイルはキャンバスを作らずに失敗とする
+			if(items[i].estimated_bytes == 0)
+			{
+				continue;
+			}
+			pool.start(new BatchExportTask(app, &items[i], &budget, compression, filter));
+		}
+		pool.waitForDone();
+	}
+	PrintBatchExportResult(items, num_items, GetStrokeReplayTime() - start_time, stdout);
+
+	for(i=0; i<num_items; i++)
+	{
+		if(items[i].result == FALSE)
+		{
+			num_failed++;
+		}
+		MEM_FREE_FUNC(items[i].output_path);
+	}
+	MEM_FREE_FUNC(items);
+	ReleaseApplicationResources(app);
+	delete application;
+
+	return (num_failed == 0) ? 0 : 1;
 }
 
 MAIN_WINDOW_WIDGETS_PTR CreateMainWindowWidgets(APPLICATION* app)
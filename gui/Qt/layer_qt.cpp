@@ -4,6 +4,10 @@
 #include <QMimeData>
 #include <QApplication>
 #include <QScrollBar>
+#include <QPromise>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <memory>
 #include "layer_qt.h"
 #include "qt_widgets.h"
 #include "mainwindow.h"
@@ -117,6 +121,7 @@ void LayerVisibilityCheckBox::mousePressEvent(QMouseEvent* event)
 		layer->flags |= LAYER_FLAG_INVISIBLE;
 	}
 
+	InvalidateLayerSetCache(layer, 0, 0, 0, 0);
 	layer->window->flags |= DRAW_WINDOW_UPDATE_ACTIVE_UNDER;
 	ForceUpdateCanvasWidget(layer->window->widgets);
 }
@@ -229,7 +234,7 @@ void LayerMainWidget::mousePressEvent(QMouseEvent* event)
 	{
 		DRAW_WINDOW *canvas = layer->window;
 		APPLICATION *app = canvas->app;
-		canvas->active_layer = layer;
+		ChangeActiveLayer(canvas, layer);
 		app->widgets->layer_window->getLayerViewWidget()->setCurrentItem(
 			layer->widget->widget);
 		in_dragging = true;
@@ -360,7 +365,17 @@ LAYER* LayerWidget::getLayer()
 
 void LayerWidget::updateLayerThumbnail()
 {
-	thumbnail.update();
+	thumbnail.requestUpdate(0, 0, layer->width, layer->height);
+}
+
+void LayerWidget::updateLayerThumbnail(int x, int y, int width, int height)
+{
+	thumbnail.requestUpdate(x, y, width, height);
+}
+
+void LayerWidget::waitThumbnailUpdate()
+{
+	thumbnail.waitResize();
 }
 
 void LayerWidget::updateLayerName(QString name)
@@ -591,7 +606,12 @@ LayerThumbnailWidget::LayerThumbnailWidget(
 	FLOAT_T scale,
 	LayerWindowWidget* window_widget
 )
-	: QGraphicsView(parent)
+	: QGraphicsView(parent),
+	  layer_pixels(NULL),
+	  layer_width(0),
+	  layer_height(0),
+	  source_width(0),
+	  source_height(0)
 {
 	int int_size = (int)(LAYER_THUMBNAIL_SIZE * scale);
 	this->layer = layer;
@@ -601,6 +621,35 @@ LayerThumbnailWidget::LayerThumbnailWidget(
 	this->image = QImage(this->pixels, int_size, int_size, int_size * 4, QImage::Format_ARGB32);
 	this->window_widget = window_widget;
 
+	resetLayerImage();
+
+	// k̊Ԋu󂯂邽߂̃^C}[
+	throttle_timer.setSingleShot(true);
+	connect(&throttle_timer, &QTimer::timeout, this, &LayerThumbnailWidget::startResize);
+
+	this->setFixedSize(this->size, this->size);
+	this->setSizePolicy(QSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed));
+}
+
+LayerThumbnailWidget::~LayerThumbnailWidget()
+{
+	throttle_timer.stop();
+	// ʃXbhł̏kI܂ő҂
+	resize_future.waitForFinished();
+
+	MEM_FREE_FUNC(layer_pixels);
+	MEM_FREE_FUNC(pixels);
+}
+
+/*
+* LayerThumbnailWidget::resetLayerImage֐
+* C[̃TCYɍ킹ďk摜̃obt@蒼
+*  kɌĂł͂ȂȂ
+*/
+void LayerThumbnailWidget::resetLayerImage()
+{
+	QMutexLocker locker(&pixels_mutex);
+
 	if(layer->width > layer->height)
 	{
 		this->zoom = (LAYER_THUMBNAIL_SIZE * scale) / layer->width;
@@ -610,13 +659,333 @@ LayerThumbnailWidget::LayerThumbnailWidget(
 		this->zoom = (LAYER_THUMBNAIL_SIZE * scale) / layer->height;
 	}
 
-	this->setFixedSize(this->size, this->size);
-	this->setSizePolicy(QSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed));
+	source_width = layer->width;
+	source_height = layer->height;
+	layer_width = (int)(layer->width * zoom);
+	layer_height = (int)(layer->height * zoom);
+	if(layer_width < 1)
+	{
+		layer_width = 1;
+	}
+	if(layer_height < 1)
+	{
+		layer_height = 1;
+	}
+
+	layer_pixels = (uint8*)MEM_REALLOC_FUNC(layer_pixels, layer_width * layer_height * 4);
+	(void)memset(layer_pixels, 0, layer_width * layer_height * 4);
+	layer_image = QImage(layer_pixels, layer_width, layer_height,
+							layer_width * 4, QImage::Format_ARGB32_Premultiplied);
 }
 
-LayerThumbnailWidget::~LayerThumbnailWidget()
+/*
+* LayerThumbnailWidget::requestUpdate֐
+* TlC̍XV͈͂ǉ
+*  Ȍk莞ԌoĂȂ΂܂Ƃ߂Čŏ
+* 
+* x			: XV͈͂̍XW(C[W)
+* y			: XV͈͂̍YW(C[W)
+* width		: XV͈͂̕
+* height	: XV͈͂̍
+*/
+void LayerThumbnailWidget::requestUpdate(int x, int y, int width, int height)
 {
-	MEM_FREE_FUNC(pixels);
+	QRect region = QRect(x, y, width, height).intersected(QRect(0, 0, layer->width, layer->height));
+	qint64 elapsed;
+
+	if(region.isEmpty())
+	{
+		return;
+	}
+
+	dirty_rect = dirty_rect.united(region);
+
+	// k܂͑ҋ@ȂIɂ܂Ƃ߂ď
+	if(resize_future.isRunning() || throttle_timer.isActive())
+	{
+		return;
+	}
+
+	elapsed = (last_update.isValid() == false) ? LAYER_THUMBNAIL_UPDATE_INTERVAL : last_update.elapsed();
+	if(elapsed >= LAYER_THUMBNAIL_UPDATE_INTERVAL)
+	{
+		startResize();
+	}
+	else
+	{
+		throttle_timer.start((int)(LAYER_THUMBNAIL_UPDATE_INTERVAL - elapsed));
+	}
+}
+
+/*
+* LayerThumbnailWidget::startResize֐
+* ܂XV͈͂̏kʃXbhŊJn
+*/
+void LayerThumbnailWidget::startResize()
+{
+	std::shared_ptr<QPromise<void> > promise;
+	QRect region, source_rect;
+	uint8 *source;
+
+	if(dirty_rect.isEmpty())
+	{
+		return;
+	}
+
+	// Ȍ̃Xbh܂IĂȂΏ҂
+	if(resize_future.isRunning())
+	{
+		throttle_timer.start(1);
+		return;
+	}
+
+	// C[̃TCYςĂŜ蒼
+	if(layer->width != source_width || layer->height != source_height)
+	{
+		resetLayerImage();
+		dirty_rect = QRect(0, 0, layer->width, layer->height);
+	}
+
+	region = dirty_rect;
+	dirty_rect = QRect();
+	last_update.start();
+
+	// k̕`obt@̊mۂɉeȂ悤AKvȔ͈͂UIXbhŕēn
+	source = copyLayerRegion(region, &source_rect);
+	if(source == NULL)
+	{
+		return;
+	}
+
+	promise = std::make_shared<QPromise<void> >();
+	resize_future = promise->future();
+	promise->start();
+
+	QThreadPool::globalInstance()->start([this, region, source, source_rect, promise]()
+	{
+		resizeLayerRegion(region, source, source_rect);
+		MEM_FREE_FUNC(source);
+		QMetaObject::invokeMethod(this, [this]() {finishResize();}, Qt::QueuedConnection);
+		promise->finish();
+	});
+}
+
+/*
+* LayerThumbnailWidget::waitResize֐
+* ʃXbhł̏kI܂ő҂
+*/
+void LayerThumbnailWidget::waitResize()
+{
+	resize_future.waitForFinished();
+}
+
+/*
+* LayerThumbnailWidget::finishResize֐
+* kIUIXbhŌĂ΂Aĕ`s
+*/
+void LayerThumbnailWidget::finishResize()
+{
+	viewport()->update();
+
+	// ɒǉꂽ͈͎͂̊Ԋuŏ
+	if(dirty_rect.isEmpty() == false && throttle_timer.isActive() == false)
+	{
+		throttle_timer.start(LAYER_THUMBNAIL_UPDATE_INTERVAL);
+	}
+}
+
+/*
+* LayerThumbnailWidget::thumbnailRect֐
+* C[͈̔͂ɑΉk摜͈̔͂߂
+* 
+* region	: C[͈̔
+* Ԃl
+*	k摜͈̔(Ή͈͂΋)
+*/
+QRect LayerThumbnailWidget::thumbnailRect(const QRect& region)
+{
+	int start_x = (int)(region.left() * zoom);
+	int start_y = (int)(region.top() * zoom);
+	int end_x = (int)ceil((region.right() + 1) * zoom);
+	int end_y = (int)ceil((region.bottom() + 1) * zoom);
+
+	if(end_x > layer_width)
+	{
+		end_x = layer_width;
+	}
+	if(end_y > layer_height)
+	{
+		end_y = layer_height;
+	}
+	if(end_x <= start_x || end_y <= start_y)
+	{
+		return QRect();
+	}
+
+	return QRect(start_x, start_y, end_x - start_x, end_y - start_y);
+}
+
+/*
+* LayerThumbnailWidget::copyLayerRegion֐
+* kɕKvȃC[̃sNZf[^𕡐
+*  UIXbhĂ
+* 
+* region		: k郌C[͈̔
+* source_rect	: C[͈̔͂󂯎
+* Ԃl
+*	sNZf[^(MEM_FREE_FUNCŊJ) k͈͂NULL
+*/
+uint8* LayerThumbnailWidget::copyLayerRegion(const QRect& region, QRect* source_rect)
+{
+	const FLOAT_T rev_zoom = 1.0 / zoom;
+	QRect destination = thumbnailRect(region);
+	uint8 *copy;
+	int left, top, right, bottom;
+	int stride;
+	int y;
+
+	if(destination.isEmpty())
+	{
+		return NULL;
+	}
+
+	left = (int)(destination.left() * rev_zoom);
+	top = (int)(destination.top() * rev_zoom);
+	right = (int)ceil((destination.right() + 1) * rev_zoom) + 1;
+	bottom = (int)ceil((destination.bottom() + 1) * rev_zoom) + 1;
+	if(left >= source_width)
+	{
+		left = source_width - 1;
+	}
+	if(top >= source_height)
+	{
+		top = source_height - 1;
+	}
+	if(right > source_width)
+	{
+		right = source_width;
+	}
+	if(bottom > source_height)
+	{
+		bottom = source_height;
+	}
+
+	*source_rect = QRect(left, top, right - left, bottom - top);
+	stride = source_rect->width() * 4;
+	copy = (uint8*)MEM_ALLOC_FUNC(stride * source_rect->height());
+
+	// ^C`̃C[͏kɕKvȔ͈͂WJ
+	if(layer->pixels == NULL)
+	{
+		LayerTilesToPixels(layer->tiles, copy, stride, left, top,
+			source_rect->width(), source_rect->height());
+	}
+	else
+	{
+		for(y=0; y<source_rect->height(); y++)
+		{
+			(void)memcpy(&copy[y * stride], &layer->pixels[(top + y) * layer->stride + left * 4], stride);
+		}
+	}
+
+	return copy;
+}
+
+/*
+* LayerThumbnailWidget::resizeLayerRegion֐
+* C[̎w͈͂ʐϕςŏkďk摜ɔf
+*  ʃXbhĂ΂
+* 
+* region		: k郌C[͈̔
+* source		: copyLayerRegionŕsNZf[^
+* source_rect	: sourceɑΉ郌C[͈̔
+*/
+void LayerThumbnailWidget::resizeLayerRegion(const QRect& region, const uint8* source, const QRect& source_rect)
+{
+	const FLOAT_T rev_zoom = 1.0 / zoom;
+	const int source_stride = source_rect.width() * 4;
+	QRect destination = thumbnailRect(region);
+	const int start_x = destination.left();
+	const int start_y = destination.top();
+	const int width = destination.width();
+	const int height = destination.height();
+	uint8 *buffer;
+	int x, y;
+
+	if(destination.isEmpty())
+	{
+		return;
+	}
+
+	buffer = (uint8*)MEM_ALLOC_FUNC(width * height * 4);
+
+	for(y=0; y<height; y++)
+	{
+		uint8 *destination = &buffer[y * width * 4];
+		int source_y0 = (int)((start_y + y) * rev_zoom);
+		int source_y1 = (int)((start_y + y + 1) * rev_zoom);
+
+		if(source_y0 >= source_height)
+		{
+			source_y0 = source_height - 1;
+		}
+		if(source_y1 > source_height)
+		{
+			source_y1 = source_height;
+		}
+		if(source_y1 <= source_y0)
+		{
+			source_y1 = source_y0 + 1;
+		}
+
+		for(x=0; x<width; x++, destination += 4)
+		{
+			unsigned int sum[4] = {0};
+			unsigned int count;
+			int source_x0 = (int)((start_x + x) * rev_zoom);
+			int source_x1 = (int)((start_x + x + 1) * rev_zoom);
+			int i, j;
+
+			if(source_x0 >= source_width)
+			{
+				source_x0 = source_width - 1;
+			}
+			if(source_x1 > source_width)
+			{
+				source_x1 = source_width;
+			}
+			if(source_x1 <= source_x0)
+			{
+				source_x1 = source_x0 + 1;
+			}
+
+			for(i=source_y0; i<source_y1; i++)
+			{
+				const uint8 *src = &source[(i - source_rect.top()) * source_stride
+					+ (source_x0 - source_rect.left()) * 4];
+				for(j=source_x0; j<source_x1; j++, src += 4)
+				{
+					sum[0] += src[0],	sum[1] += src[1];
+					sum[2] += src[2],	sum[3] += src[3];
+				}
+			}
+
+			count = (unsigned int)((source_x1 - source_x0) * (source_y1 - source_y0));
+			destination[0] = (uint8)(sum[0] / count),	destination[1] = (uint8)(sum[1] / count);
+			destination[2] = (uint8)(sum[2] / count),	destination[3] = (uint8)(sum[3] / count);
+		}
+	}
+
+	// kʂ\p̉摜֔f
+	pixels_mutex.lock();
+	for(y=0; y<height; y++)
+	{
+		(void)memcpy(&layer_pixels[((start_y + y) * layer_width + start_x) * 4],
+						&buffer[y * width * 4], width * 4);
+	}
+	pixels_mutex.unlock();
+
+	MEM_FREE_FUNC(buffer);
 }
 
 void LayerThumbnailWidget::paintEvent(QPaintEvent* event)
@@ -629,8 +998,9 @@ void LayerThumbnailWidget::paintEvent(QPaintEvent* event)
 
 	painter.drawImage(0, 0, image);
 
-	painter.scale(zoom, zoom);
-	painter.drawImage(0, 0, image);
+	pixels_mutex.lock();
+	painter.drawImage((size - layer_width) / 2, (size - layer_height) / 2, layer_image);
+	pixels_mutex.unlock();
 }
 
 LayerViewWidget::LayerViewWidget(QWidget* parent)
@@ -998,9 +1368,48 @@ void LayerWindowWidget::maskUnderLayerChanged(bool state)
 
 void UpdateLayerThumbnail(LAYER* layer)
 {
+	if(layer->widget == NULL)
+	{
+		return;
+	}
 	layer->widget->widget->updateLayerThumbnail();
 }
 
+/*
+* UpdateLayerThumbnailRegion֐
+* C[̃TlC̎w͈͂XV
+*  k͈Ԋuȏł܂Ƃ߂ĕʃXbhŎs
+* 
+* layer		: TlCXV郌C[
+* x			: XV͈͂̍XW
+* y			: XV͈͂̍YW
+* width		: XV͈͂̕
+* height	: XV͈͂̍
+*/
+void UpdateLayerThumbnailRegion(LAYER* layer, int x, int y, int width, int height)
+{
+	if(layer->widget == NULL)
+	{
+		return;
+	}
+	layer->widget->widget->updateLayerThumbnail(x, y, width, height);
+}
+
+/*
+* WaitLayerThumbnailUpdate֐
+* ʃXbhł̃TlC̏k̏I҂
+* 
+* layer	: TlCXṼC[
+*/
+void WaitLayerThumbnailUpdate(LAYER* layer)
+{
+	if(layer->widget == NULL)
+	{
+		return;
+	}
+	layer->widget->widget->waitThumbnailUpdate();
+}
+
 void UpdateLayerNameLabel(LAYER* layer)
 {
 	QString str = QString::fromUtf8(layer->name);
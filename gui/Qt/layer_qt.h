@@ -19,6 +19,11 @@
 #include <QDockWidget>
 #include <QPushButton>
 #include <QCheckBox>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QRect>
+#include <QFuture>
 #include "../../layer.h"
 #include "qt_widgets.h"
 
@@ -74,15 +79,35 @@ public:
 	LayerThumbnailWidget(QWidget* parent = NULL, LAYER* layer = NULL,
 						 FLOAT_T scale = 1.0, LayerWindowWidget* window_widget = NULL);
 	~LayerThumbnailWidget();
+	void requestUpdate(int x, int y, int width, int height);
+	void waitResize();
 protected:
 	void paintEvent(QPaintEvent* event) override;
 private:
+	void resetLayerImage();
+	void startResize();
+	void finishResize();
+	QRect thumbnailRect(const QRect& region);
+	uint8* copyLayerRegion(const QRect& region, QRect* source_rect);
+	void resizeLayerRegion(const QRect& region, const uint8* source, const QRect& source_rect);
 	LAYER *layer;
 	FLOAT_T scale;
 	FLOAT_T zoom;
 	int size;
 	uint8 *pixels;
 	QImage image;
+	// 縮小済みのレイヤーのピクセルデータ
+	uint8 *layer_pixels;
+	int layer_width, layer_height;
+	int source_width, source_height;
+	QImage layer_image;
+	// 次回縮小する範囲(レイヤー座標)
+	QRect dirty_rect;
+	QTimer throttle_timer;
+	QElapsedTimer last_update;
+	QMutex pixels_mutex;
+	// 別スレッドでの縮小処理の終了待ち用
+	QFuture<void> resize_future;
 	LayerWindowWidget *window_widget;
 };
 
@@ -111,6 +136,8 @@ public:
 	bool operator < (const LayerWidget& other) const;
 	LAYER* getLayer();
 	void updateLayerThumbnail();
+	void updateLayerThumbnail(int x, int y, int width, int height);
+	void waitThumbnailUpdate();
 	void updateLayerName(QString name);
 	void updateWidget();
 	void setLayerOpacityText(int opacity);
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <QMenuBar>
+#include <QActionGroup>
 #include <QPalette>
 #include "mainwindow.h"
 #include "tool_box_qt.h"
@@ -12,6 +13,8 @@
 #include "../../memory.h"
 #include "../../image_file/png_file.h"
 #include "../../brushes.h"
+#include "../../display_filter.h"
+#include "../draw_window.h"
 
 MainWindow::MainWindow(QWidget* parent, APPLICATION* app)
 	: QMainWindow(parent),
@@ -29,7 +32,10 @@ MainWindow::MainWindow(QWidget* parent, APPLICATION* app)
 	  save_as_action(NULL),
 	  edit_menu(NULL),
 	  undo_action(NULL),
-	  redo_action(NULL)
+	  redo_action(NULL),
+	  view_menu(NULL),
+	  display_filter_menu(NULL),
+	  display_filter_group(NULL)
 {
 #define SPLITTER_WIDTH 4
 	this->app = app;
@@ -111,6 +117,32 @@ void MainWindow::CreateNormalMenuBar(void)
 	redo_action = new QAction(tr("&Redo"), this);
 	redo_action->setShortcut(QKeySequence(tr("Ctrl+Y")));
 	(void)connect(redo_action, &QAction::triggered, this, &MainWindow::redo);
+
+	view_menu = menuBar()->addMenu(tr("&View"));
+	display_filter_menu = view_menu->addMenu(tr("Display Filter"));
+	display_filter_group = new QActionGroup(this);
+	{
+		const struct
+		{
+			const char *name;
+			eDISPLAY_FUNCION_TYPE type;
+		} filters[] =
+		{
+			{QT_TR_NOOP("View No Filter"), DISPLAY_FUNC_TYPE_NO_CONVERT},
+			{QT_TR_NOOP("Gray Scale"), DISPLAY_FUNC_TYPE_GRAY_SCALE},
+			{QT_TR_NOOP("Gray Scale YIQ"), DISPLAY_FUNC_TYPE_GRAY_SCALE_YIQ},
+			{QT_TR_NOOP("ICC Profile Soft Proof"), DISPLAY_FUNC_TYPE_ICC_PROFILE}
+		};
+		for(unsigned int i=0; i<sizeof(filters)/sizeof(*filters); i++)
+		{
+			QAction *action = display_filter_menu->addAction(tr(filters[i].name));
+			action->setCheckable(true);
+			action->setChecked(filters[i].type == DISPLAY_FUNC_TYPE_NO_CONVERT);
+			action->setData((int)filters[i].type);
+			display_filter_group->addAction(action);
+		}
+	}
+	(void)connect(display_filter_group, &QActionGroup::triggered, this, &MainWindow::change_display_filter);
 }
 
 void MainWindow::MakeToolBar(QHBoxLayout* tool_bar_layout)
@@ -204,6 +236,34 @@ void MainWindow::redo(void)
 	ExecuteRedo(app);
 }
 
+void MainWindow::change_display_filter(QAction* action)
+{
+	DRAW_WINDOW *canvas = (app->window_num > 0) ? GetActiveDrawWindow(app) : NULL;
+	eDISPLAY_FUNCION_TYPE type = (eDISPLAY_FUNCION_TYPE)action->data().toInt();
+
+	// \tgv[t͐FϊȂ΃tB^[ɂ
+	if(type == DISPLAY_FUNC_TYPE_ICC_PROFILE
+		&& (canvas == NULL || SetupDisplayIccTransform(canvas) == FALSE))
+	{
+		type = DISPLAY_FUNC_TYPE_NO_CONVERT;
+	}
+	SetDisplayFilter(app, canvas, type);
+
+	QList<QAction*> actions = display_filter_group->actions();
+	for(int i=0; i<actions.size(); i++)
+	{
+		if(actions[i]->data().toInt() == (int)type)
+		{
+			actions[i]->setChecked(true);
+		}
+	}
+
+	if(canvas != NULL)
+	{
+		UpdateCanvasWidget(canvas->widgets);
+	}
+}
+
 QTabWidget* MainWindow::GetCanvasTabWidget(void)
 {
 	return &this->canvas_tab;
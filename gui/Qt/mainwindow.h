@@ -48,6 +48,9 @@ private:
 	QMenu *edit_menu;
 	QAction *undo_action;
 	QAction *redo_action;
+	QMenu *view_menu;
+	QMenu *display_filter_menu;
+	QActionGroup *display_filter_group;
 
 private slots:
 	void new_canvas(void);
@@ -56,6 +59,7 @@ private slots:
 	void save_as(void);
 	void undo(void);
 	void redo(void);
+	void change_display_filter(QAction* action);
 };
 
 class ToolBoxWidget;
@@ -13,6 +13,10 @@
 #include <QLayoutItem>
 #include <QTimer>
 #include <QFileDialog>
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 #include "qt_widgets.h"
 #include "../../types.h"
 #include "../../application.h"
@@ -241,6 +245,110 @@ void DeleteTimer(void* timer)
 	delete t;
 }
 
+typedef struct _PARALLEL_LOOP
+{
+	parallel_loop_func_t function;
+	void *data;
+	int count;
+	QAtomicInt next_index;
+	QSemaphore finished;
+} PARALLEL_LOOP;
+
+static void RunParallelLoop(PARALLEL_LOOP* loop, int thread_index)
+{
+	int index;
+
+	while((index = loop->next_index.fetchAndAddOrdered(1)) < loop->count)
+	{
+		loop->function(index, thread_index, loop->data);
+	}
+}
+
+class ParallelLoopTask : public QRunnable
+{
+public:
+	ParallelLoopTask(PARALLEL_LOOP* loop, int thread_index) : loop(loop), thread_index(thread_index)
+	{
+		setAutoDelete(false);
+	}
+
+	void run() override
+	{
+		RunParallelLoop(loop, thread_index);
+		loop->finished.release();
+	}
+
+private:
+	PARALLEL_LOOP *loop;
+	int thread_index;
+};
+
+static QThreadPool* GetParallelLoopPool(void)
+{
+	static QThreadPool pool;
+	return &pool;
+}
+
+int GetParallelLoopThreads(void)
+{
+	int num_threads = QThread::idealThreadCount();
+	return (num_threads > 1) ? num_threads : 1;
+}
+
+void ExecuteParallelLoop(int count, parallel_loop_func_t function, void* data)
+{
+	QThreadPool *pool = GetParallelLoopPool();
+	ParallelLoopTask **tasks;
+	PARALLEL_LOOP loop;
+	int num_threads = GetParallelLoopThreads();
+	int num_started = 0;
+	int i;
+
+	if(num_threads > count)
+	{
+		num_threads = count;
+	}
+	if(num_threads <= 1)
+	{
+		for(i=0; i<count; i++)
+		{
+			function(i, 0, data);
+		}
+		return;
+	}
+
+	loop.function = function;
+	loop.data = data;
+	loop.count = count;
+	loop.next_index = 0;
+
+	tasks = new ParallelLoopTask*[num_threads - 1];
+	for(i=0; i<num_threads-1; i++)
+	{
+		tasks[i] = new ParallelLoopTask(&loop, i + 1);
+		pool->start(tasks[i]);
+	}
+
+	RunParallelLoop(&loop, 0);
+
+	// Tasks still waiting in the queue have nothing left to do, so take them back
+	// instead of waiting for a free thread (this also keeps nested loops from deadlocking)
+	for(i=0; i<num_threads-1; i++)
+	{
+		if(pool->tryTake(tasks[i]) == false)
+		{
+			num_started++;
+		}
+	}
+	loop.finished.acquire(num_started);
+
+	for(i=0; i<num_threads-1; i++)
+	{
+		delete tasks[i];
+	}
+	delete[] tasks;
+}
+
 char* GetImageFileSaveaPath(APPLICATION* app)
 {
 	QString selected_filter;
@@ -36,6 +36,14 @@ struct _TOOL_WINDOW_WIDGETS
 	void *tool_box;
 };
 
+/*
+* 並列処理で呼び出す関数の型
+* index			: 処理する番号
+* thread_index	: 処理しているスレッドの番号(0からGetParallelLoopThreads()-1まで)
+* data			: ExecuteParallelLoopに渡したデータ
+*/
+typedef void (*parallel_loop_func_t)(int index, int thread_index, void* data);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -55,6 +63,26 @@ EXTERN void DeleteTimer(void* timer);
 
 EXTERN char* GetImageFileSaveaPath(APPLICATION* app);
 
+/*
+* GetParallelLoopThreads関数
+* ExecuteParallelLoopで同時に処理するスレッドの最大数を取得する
+* 返り値
+*	スレッド数(1以上)
+*/
+EXTERN int GetParallelLoopThreads(void);
+
+/*
+* ExecuteParallelLoop関数
+* 0からcount-1までの番号をスレッドプールで分担して処理する
+*  呼び出したスレッドも処理に加わり、全ての番号の処理が終わるまで戻らない
+*  同じthread_indexの処理が同時に実行されることは無い
+* 引数
+* count		: 処理する数
+* function	: 番号毎に呼び出す関数
+* data		: 関数に渡すデータ
+*/
+EXTERN void ExecuteParallelLoop(int count, parallel_loop_func_t function, void* data);
+
 #ifdef __cplusplus
 }
 #endif
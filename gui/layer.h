@@ -14,6 +14,25 @@ typedef struct _TEXT_LAYER_WIDGETS
 } TEXT_LAYER_WIDGETS;
 
 EXTERN void UpdateLayerThumbnail(LAYER* layer);
+/*
+* UpdateLayerThumbnailRegion関数
+* レイヤーのサムネイルの指定範囲を更新する
+*  縮小処理は一定間隔以上でまとめて別スレッドで実行
+* 引数
+* layer		: サムネイルを更新するレイヤー
+* x			: 更新範囲の左上のX座標
+* y			: 更新範囲の左上のY座標
+* width		: 更新範囲の幅
+* height	: 更新範囲の高さ
+*/
+EXTERN void UpdateLayerThumbnailRegion(LAYER* layer, int x, int y, int width, int height);
+/*
+* WaitLayerThumbnailUpdate関数
+* 別スレッドでのサムネイルの縮小処理の終了を待つ
+* 引数
+* layer	: サムネイルを更新中のレイヤー
+*/
+EXTERN void WaitLayerThumbnailUpdate(LAYER* layer);
 EXTERN void UpdateLayerNameLabel(LAYER* layer);
 
 EXTERN void UpdateLayerNameLabel(LAYER* layer);
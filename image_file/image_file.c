@@ -103,60 +103,40 @@ void WriteCanvasToImageFile(
 DRAW_WINDOW* ReadImageFile(APPLICATION* app, char* file_path)
 {
 	DRAW_WINDOW *canvas = NULL;
-	FILE *fp;
+	// t@C̓e̓Rs[Ƀ}bv̈QƂ
+	FILE_MAPPING mapping;
+	MEMORY_STREAM stream;
 	char *file_extention;
 
-	if(file_path == NULL)
+	if(file_path == NULL || MapFileToMemory(&mapping, file_path) != 0)
 	{
 		return NULL;
 	}
 
-	fp = fopen(file_path, "rb");
-
 	file_extention = GetFileExtention(file_path);
 	if(StringCompareIgnoreCase(file_extention, ".kab") == 0)
 	{
 		char *file_name = GetFileName(file_path);
-		size_t file_size;
-		(void)fseek(fp, 0, SEEK_END);
-		file_size = ftell(fp);
-		rewind(fp);
-		canvas = ReadOriginalFormat((void*)fp, (stream_func_t)fread, file_size, app, file_name);
+		canvas = ReadOriginalFormatMemory(mapping.data, mapping.size, app, file_name);
 	}
 	else if(StringCompareIgnoreCase(file_extention, ".png") == 0)
 	{
-		int32 width, height, stride;
-		uint8 *pixels;
-		int channel;
-		int i;
+		int32 width = 0, height = 0;
 
-		pixels = ReadPNGStream((void*)fp, (stream_func_t)fread, &width, &height, &stride);
-		channel = stride / width;
-		if(channel == 1)
-		{
-			uint8 *old_pixels = pixels;
-			pixels = (uint8*)MEM_ALLOC_FUNC(width * 4 * height);
-			GrapyPixels_to_RGBApixels(old_pixels, pixels, width, height, stride);
-			MEM_FREE_FUNC(old_pixels);
-		}
-		else if(channel == 3)
-		{
-			uint8* old_pixels = pixels;
-			pixels = (uint8*)MEM_ALLOC_FUNC(width * 4 * height);
-			RGBpixels_to_RGBApixels(old_pixels, pixels, width, height, stride);
-			MEM_FREE_FUNC(old_pixels);
-			stride = width * 4;
-		}
-		canvas = CreateDrawWindow(width, height, 4, file_path, app->widgets, app->window_num, app);
-		for(i=0; i<height; i++)
+		InitializeMemoryStreamView(&stream, mapping.data, mapping.size);
+		ReadPNGHeader((void*)&stream, (stream_func_t)MemRead, &width, &height,
+			NULL, NULL, NULL, NULL, NULL);
+		if(width > 0 && height > 0)
 		{
-			(void)memcpy(&canvas->layer->pixels[i*canvas->layer->stride],
-							&pixels[i*stride], stride);
+			canvas = CreateDrawWindow(width, height, 4, file_path, app->widgets, app->window_num, app);
+			// O[XP[/RGB̓C[̃sNZf[^RGBAɓWJ
+			InitializeMemoryStreamView(&stream, mapping.data, mapping.size);
+			(void)ReadPNGStreamToPixels((void*)&stream, (stream_func_t)MemRead, canvas->layer->pixels,
+				canvas->layer->width, canvas->layer->height, canvas->layer->stride, 4);
 		}
-		MEM_FREE_FUNC(pixels);
 	}
 
-	(void)fclose(fp);
+	UnmapFileFromMemory(&mapping);
 
 	return canvas;
 }
@@ -83,6 +83,27 @@ void StoreAdjustmentLayerData(
 		write_data = layer->filter_data.hue_saturation.v;
 		(void)write_function(&write_data, sizeof(write_data), 1, stream);
 		break;
+	case ADJUSTMENT_LAYER_TYPE_LEVELS:
+		(void)write_function(layer->filter_data.levels.input_black, 1, sizeof(layer->filter_data.levels.input_black), stream);
+		(void)write_function(layer->filter_data.levels.input_white, 1, sizeof(layer->filter_data.levels.input_white), stream);
+		(void)write_function(layer->filter_data.levels.output_black, 1, sizeof(layer->filter_data.levels.output_black), stream);
+		(void)write_function(layer->filter_data.levels.output_white, 1, sizeof(layer->filter_data.levels.output_white), stream);
+		(void)write_function(layer->filter_data.levels.gamma, 1, sizeof(layer->filter_data.levels.gamma), stream);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_CURVES:
+		(void)write_function(layer->filter_data.curves.num_points, 1, sizeof(layer->filter_data.curves.num_points), stream);
+		(void)write_function(layer->filter_data.curves.points, 1, sizeof(layer->filter_data.curves.points), stream);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_GRADIENT_MAP:
+		(void)write_function(&layer->filter_data.gradient_map.num_colors, 1, sizeof(layer->filter_data.gradient_map.num_colors), stream);
+		(void)write_function(layer->filter_data.gradient_map.positions, 1, sizeof(layer->filter_data.gradient_map.positions), stream);
+		(void)write_function(layer->filter_data.gradient_map.colors, 1, sizeof(layer->filter_data.gradient_map.colors), stream);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_COLOR_BALANCE:
+		(void)write_function(layer->filter_data.color_balance.shadows, 1, sizeof(layer->filter_data.color_balance.shadows), stream);
+		(void)write_function(layer->filter_data.color_balance.midtones, 1, sizeof(layer->filter_data.color_balance.midtones), stream);
+		(void)write_function(layer->filter_data.color_balance.highlights, 1, sizeof(layer->filter_data.color_balance.highlights), stream);
+		break;
 	}
 }
 
@@ -254,8 +275,19 @@ void StoreLayerData(
 	{
 	case TYPE_NORMAL_LAYER:
 	default:
-		WritePNGStream(stream, (stream_func_t)MemWrite, NULL, layer->pixels, layer->width, layer->height,
-							layer->stride, 4, FALSE, compress_level);
+		if(layer->tiles != NULL)
+		{	// ^C`̃C[͈ꎞIɓWJďo
+			uint8 *pixels = (uint8*)MEM_ALLOC_FUNC(layer->stride * layer->height);
+			LayerTilesToPixels(layer->tiles, pixels, layer->stride, 0, 0, layer->width, layer->height);
+			WritePNGStream(stream, (stream_func_t)MemWrite, NULL, pixels, layer->width, layer->height,
+								layer->stride, 4, FALSE, compress_level);
+			MEM_FREE_FUNC(pixels);
+		}
+		else
+		{
+			WritePNGStream(stream, (stream_func_t)MemWrite, NULL, layer->pixels, layer->width, layer->height,
+								layer->stride, 4, FALSE, compress_level);
+		}
 		break;
 	case TYPE_VECTOR_LAYER:
 		{
@@ -632,6 +664,27 @@ void ReadAdjustmentLayerData(
 		(void)read_function(&read_data, sizeof(read_data), 1, stream);
 		layer->filter_data.hue_saturation.v = read_data;
 		break;
+	case ADJUSTMENT_LAYER_TYPE_LEVELS:
+		(void)read_function(layer->filter_data.levels.input_black, 1, sizeof(layer->filter_data.levels.input_black), stream);
+		(void)read_function(layer->filter_data.levels.input_white, 1, sizeof(layer->filter_data.levels.input_white), stream);
+		(void)read_function(layer->filter_data.levels.output_black, 1, sizeof(layer->filter_data.levels.output_black), stream);
+		(void)read_function(layer->filter_data.levels.output_white, 1, sizeof(layer->filter_data.levels.output_white), stream);
+		(void)read_function(layer->filter_data.levels.gamma, 1, sizeof(layer->filter_data.levels.gamma), stream);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_CURVES:
+		(void)read_function(layer->filter_data.curves.num_points, 1, sizeof(layer->filter_data.curves.num_points), stream);
+		(void)read_function(layer->filter_data.curves.points, 1, sizeof(layer->filter_data.curves.points), stream);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_GRADIENT_MAP:
+		(void)read_function(&layer->filter_data.gradient_map.num_colors, 1, sizeof(layer->filter_data.gradient_map.num_colors), stream);
+		(void)read_function(layer->filter_data.gradient_map.positions, 1, sizeof(layer->filter_data.gradient_map.positions), stream);
+		(void)read_function(layer->filter_data.gradient_map.colors, 1, sizeof(layer->filter_data.gradient_map.colors), stream);
+		break;
+	case ADJUSTMENT_LAYER_TYPE_COLOR_BALANCE:
+		(void)read_function(layer->filter_data.color_balance.shadows, 1, sizeof(layer->filter_data.color_balance.shadows), stream);
+		(void)read_function(layer->filter_data.color_balance.midtones, 1, sizeof(layer->filter_data.color_balance.midtones), stream);
+		(void)read_function(layer->filter_data.color_balance.highlights, 1, sizeof(layer->filter_data.color_balance.highlights), stream);
+		break;
 	}
 }
 
@@ -739,23 +792,35 @@ LAYER* ReadOriginalFormatLayer(
 	switch(base.layer_type)
 	{
 	case TYPE_NORMAL_LAYER:
-		{	// PNGkꂽsNZf[^WJēǂݍ
-			MEMORY_STREAM_PTR image;
+		{	// PNGkꂽsNZf[^WJ
+				// kf[^̓Rs[ɓǂݍ݌QƂ
+			MEMORY_STREAM image;
 			uint8 *pixels;
-			int32 width, height, stride;
+			int result;
 			(void)MemRead(&data_size, sizeof(data_size), 1, stream);
+			if(data_size > stream->data_size - stream->data_point)
+			{
+				*before_error = TRUE;
+				return layer;
+			}
 			next_data_point = (uint32)(stream->data_point + data_size);
-			image = CreateMemoryStream(data_size);
-			(void)MemRead(image->buff_ptr, 1, data_size, stream);
-			pixels = ReadPNGStream(image, (stream_func_t)MemRead,
-									&width, &height, &stride);
-			(void)DeleteMemoryStream(image);
-			if(pixels != NULL)
+			InitializeMemoryStreamView(&image, &stream->buff_ptr[stream->data_point], data_size);
+			// ^C`̃C[͈ꎞۑC[ɓWJĂ瓧Ȃĕێ
+			if(layer->tiles != NULL && layer->stride * layer->height <= canvas->pixel_buf_size)
 			{
-				(void)memcpy(layer->pixels, pixels, height * stride);
-				MEM_FREE_FUNC(pixels);
+				pixels = canvas->temp_layer->pixels;
 			}
 			else
+			{
+				pixels = MaterializeLayerPixels(layer);
+			}
+			result = ReadPNGStreamToPixels(&image, (stream_func_t)MemRead, pixels,
+				layer->width, layer->height, layer->stride, layer->channel);
+			if(pixels != layer->pixels)
+			{
+				StoreLayerPixels(layer, pixels, layer->stride);
+			}
+			if(result == FALSE)
 			{
 				*before_error = TRUE;
 				return layer;
@@ -830,7 +895,12 @@ LAYER* ReadOriginalFormatLayer(
 		ASSERT(0);
 		break;
 	case TYPE_ADJUSTMENT_LAYER:
-		ReadAdjustmentLayerData(layer, (stream_func_t)MemRead, layer->layer_data.adjustment_layer);
+		layer->layer_data.adjustment_layer = CreateAdjustmentLayer(ADJUSTMENT_LAYER_TYPE_BRIGHT_CONTRAST,
+			ADJUSTMENT_LAYER_TARGET_UNDER_LAYER, layer->prev, layer);
+		ReadAdjustmentLayerData((void*)stream, (stream_func_t)MemRead, layer->layer_data.adjustment_layer);
+		// ǂݍ񂾃^Cvɍ킹ĕϊݒ肵
+		SetAdjustmentLayerType(layer->layer_data.adjustment_layer,
+			(eADJUSTMENT_LAYER_TYPE)layer->layer_data.adjustment_layer->type);
 		break;
 	}
 
@@ -912,44 +982,38 @@ LAYER* ReadOriginaFormatLayers(
 }
 
 /*
-* ReadOriginalFormat֐
-* Ǝ`̃f[^ǂݍ
+* ReadOriginalFormatMemory֐
+* (t@C}bv̈擙)̓Ǝ`̃f[^ǂݍ
+*  sNZf[^͓ǂݍ݌𒼐ڎQƂăC[֓WJ
 * 
-* stream		: ǂݍ݌f[^Xg[
-* read_function	: ǂݍݗp֐
-* stream_size	: f[^̑oCg
+* data			: ǂݍ݌f[^
+* data_length	: f[^̑oCg
 * app			: ǂݍݐi\&LoX쐬ׁ̈AAvP[VǗf[^n
 * data_name		: t@C
 * Ԃl
 *	ǂݍ񂾃f[^KpLoXBsNULL
 */
-DRAW_WINDOW* ReadOriginalFormat(
-	void* stream,
-	stream_func_t read_function,
-	size_t stream_size,
+DRAW_WINDOW* ReadOriginalFormatMemory(
+	const uint8* data,
+	size_t data_length,
 	APPLICATION* app,
 	const char* data_name
 )
 {
 	DRAW_WINDOW *canvas = NULL;
-	// C[r[֒ǉׂɃAhXۑ
-	LAYER *layer;
-	// f[^xSăɓǂݍłemF
-	MEMORY_STREAM_PTR mem_stream = CreateMemoryStream(stream_size);
+	// ǂݍ݌f[^QƂXg[
+	MEMORY_STREAM stream;
+	MEMORY_STREAM_PTR mem_stream = &stream;
 	// sNZf[^PNGkf[^ǂݍނ߂̃Xg[	
-	MEMORY_STREAM_PTR image;
+	MEMORY_STREAM image;
 	// LoX̕ƍ(IWi)
 	int32 original_width, original_height;
 	// LoX̕ƍ(4̔{)
 	int32 width, height;
-	// 摜s̃oCg
-	int32 stride;
 	// C[̐
 	uint16 num_layer;
 	// `lAJ[[h
 	uint8 channel, color_mode;
-	// 摜f[^
-	uint8 *pixels;
 	// 摜f[^̃oCg
 	uint32 data_size;
 	// Kf[^p̕
@@ -957,15 +1021,13 @@ DRAW_WINDOW* ReadOriginalFormat(
 	// t@Co[W
 	uint32 file_version;
 
-	int i;
-
-	(void)read_function(mem_stream->buff_ptr, 1, stream_size, stream);
-
 	// t@Cɖߍ񂾕ŃIWitH[}bg̃f[^ł邩mF
-	if(memcmp(mem_stream->buff_ptr, format_string, sizeof(format_string)/sizeof(format_string[0])) != 0)
+	if(data_length < sizeof(format_string)
+		|| memcmp(data, format_string, sizeof(format_string)/sizeof(format_string[0])) != 0)
 	{
-		goto ERROR_END;
+		return NULL;
 	}
+	InitializeMemoryStreamView(mem_stream, data, data_length);
 
 	// t@CtH[}bgo[Wǂݍ
 	mem_stream->data_point = sizeof(format_string) / sizeof(format_string[0]);
@@ -999,35 +1061,76 @@ DRAW_WINDOW* ReadOriginalFormat(
 	// C[̐ǂݍ
 	(void)MemRead(&num_layer, sizeof(num_layer), 1, mem_stream);
 
+	// ꊇoł͕̃Xbhǂݍނ̂Ŕԍ̓Ag~bNɐi߂
 	canvas = CreateDrawWindow(original_width, original_height, channel, data_name,
-				app->widgets, app->window_num+1, app);
-	app->window_num++;
+				app->widgets, (int)ATOMIC_INCREMENT(&app->window_num), app);
 
-	// wi摜f[^ǂݍ
+	// wi摜f[^LoX̔wi֒ړWJ
 	(void)MemRead(&data_size, sizeof(data_size), 1, mem_stream);
-	image = CreateMemoryStream(data_size);
-	(void)MemRead(image->buff_ptr, 1, data_size, mem_stream);
-	pixels = ReadPNGStream(image, (stream_func_t)MemRead, &width, &height, &stride);
-	// LoX̔wif[^փRs[
-	(void)memcpy(canvas->back_ground, pixels, height * stride);
-	// J
-	(void)DeleteMemoryStream(image);
-	MEM_FREE_FUNC(pixels);
+	if(data_size > mem_stream->data_size - mem_stream->data_point)
+	{
+		data_size = (uint32)(mem_stream->data_size - mem_stream->data_point);
+	}
+	InitializeMemoryStreamView(&image, &mem_stream->buff_ptr[mem_stream->data_point], data_size);
+	(void)ReadPNGStreamToPixels(&image, (stream_func_t)MemRead, canvas->back_ground,
+		canvas->width, canvas->height, canvas->stride, canvas->channel);
+	mem_stream->data_point += data_size;
 
 	// C[̏ǂݎ
 		// ԉɎō郌C[폜
 	DeleteLayer(&canvas->layer);
+	canvas->active_layer = NULL;
 	if(file_version == FILE_VERSION)
 	{
 		canvas->layer = ReadOriginaFormatLayers(mem_stream, canvas, app, num_layer);
 	}
 	canvas->num_layer = num_layer;
 
+	// ԉ̃C[ANeBuɂ
+		// sNZf[^𒼐ڎQƂ郌C[^C`߂
+	if(canvas->layer != NULL)
+	{
+		canvas->active_layer = canvas->layer;
+		MaterializeReferencedLayers(canvas);
+	}
+
 	return canvas;
+}
 
-ERROR_END:
+/*
+* ReadOriginalFormat֐
+* Ǝ`̃f[^ǂݍ
+* 
+* stream		: ǂݍ݌f[^Xg[
+* read_function	: ǂݍݗp֐
+* stream_size	: f[^̑oCg
+* app			: ǂݍݐi\&LoX쐬ׁ̈AAvP[VǗf[^n
+* data_name		: t@C
+* Ԃl
+*	ǂݍ񂾃f[^KpLoXBsNULL
+*/
+DRAW_WINDOW* ReadOriginalFormat(
+	void* stream,
+	stream_func_t read_function,
+	size_t stream_size,
+	APPLICATION* app,
+	const char* data_name
+)
+{
+	DRAW_WINDOW *canvas;
+	// f[^xSăɓǂݍłemF
+	MEMORY_STREAM_PTR mem_stream = CreateMemoryStream(stream_size);
+
+	if(mem_stream == NULL)
+	{
+		return NULL;
+	}
+
+	(void)read_function(mem_stream->buff_ptr, 1, stream_size, stream);
+	canvas = ReadOriginalFormatMemory(mem_stream->buff_ptr, stream_size, app, data_name);
 	(void)DeleteMemoryStream(mem_stream);
-	return NULL;
+
+	return canvas;
 }
 
 #ifdef __cplusplus
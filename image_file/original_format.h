@@ -30,6 +30,25 @@ EXTERN DRAW_WINDOW* ReadOriginalFormat(
 	const char* data_name
 );
 
+/*
+* ReadOriginalFormatMemory֐
+* (t@C}bv̈擙)̓Ǝ`̃f[^ǂݍ
+*  sNZf[^͓ǂݍ݌𒼐ڎQƂăC[֓WJ
+* 
+* data			: ǂݍ݌f[^
+* data_length	: f[^̑oCg
+* app			: ǂݍݐi\&LoX쐬ׁ̈AAvP[VǗf[^n
+* data_name		: t@C
+* Ԃl
+*	ǂݍ񂾃f[^KpLoXBsNULL
+*/
+EXTERN DRAW_WINDOW* ReadOriginalFormatMemory(
+	const uint8* data,
+	size_t data_length,
+	APPLICATION* app,
+	const char* data_name
+);
+
 EXTERN void StoreCanvas(
 	void* stream,
 	stream_func_t write_function,
@@ -1,13 +1,40 @@
+#include <string.h>
 #include <png.h>
+#include <zlib.h>
 #include "../types.h"
 #include "../memory.h"
 #include "../memory_stream.h"
+#include "../gui/gui.h"
 #include "png_file.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#ifndef FALSE
+# define FALSE (0)
+#endif
+#ifndef TRUE
+# define TRUE (1)
+#endif
+
+// 並列に圧縮する1区画の目安のバイト数
+#define PNG_PARALLEL_SLICE_BYTES (256 * 1024)
+// deflateの辞書(スライド窓)のサイズ
+#define PNG_DEFLATE_WINDOW_SIZE 32768
+
+/*
+* PNG_SLICE構造体
+* 並列に圧縮する行のまとまり1つ分の結果
+*/
+typedef struct _PNG_SLICE
+{
+	uint8 *data;		// 圧縮後のデータ(先頭/末尾の区画はzlibのヘッダ/チェックサムを含む)
+	size_t size;		// 圧縮後のバイト数
+	uLong adler;		// フィルタ後のデータのAdler-32
+	uLong length;		// フィルタ後のバイト数
+	int error;			// 失敗したらTRUE
+} PNG_SLICE;
 
 /*
 * PNG_IO構造体
@@ -138,6 +165,143 @@ uint8* ReadPNGStream(
 	return pixels;
 }
 
+/*
+* ReadPNGStreamToPixels関数
+* PNGイメージデータを指定したピクセルデータへ直接展開する
+*  4チャンネルを指定した場合はグレースケール/RGBをRGBAに展開する
+*  (チャンネルの並びはPNGのまま)
+* 引数
+* stream	: データストリーム
+* read_func	: 読み込み用の関数ポインタ
+* pixels	: 展開先のピクセルデータ
+* width		: 展開先の幅
+* height	: 展開先の高さ
+* stride	: 展開先の一行分のバイト数
+* channel	: 展開先のチャンネル数
+* 返り値
+*	成功:TRUE	失敗:FALSE(イメージが展開先より大きい場合も失敗)
+*/
+int ReadPNGStreamToPixels(
+	void* stream,
+	stream_func_t read_func,
+	uint8* pixels,
+	int32 width,
+	int32 height,
+	int32 stride,
+	uint8 channel
+)
+{
+	PNG_IO io;
+	png_structp png_p;
+	png_infop info_p;
+	uint32 local_width, local_height;
+	int32 bit_depth, color_type, interlace_type;
+	uint8 **image;
+	uint32 i;
+
+	if(width <= 0 || height <= 0)
+	{
+		return FALSE;
+	}
+
+	// ストリームのアドレスと関数ポインタをセット
+	io.data = stream;
+	io.rw_func = read_func;
+
+	// pnglibでは2次元配列にする必要があるので
+		// 展開先の各行を指すポインタ配列を作成
+	image = (uint8**)MEM_ALLOC_FUNC(sizeof(*image)*height);
+	if(image == NULL)
+	{
+		return FALSE;
+	}
+
+	// PNG展開用のデータを生成
+	png_p = png_create_read_struct(
+		PNG_LIBPNG_VER_STRING,
+		NULL, NULL, NULL
+	);
+
+	// 画像情報を格納するデータ領域作成
+	info_p = png_create_info_struct(png_p);
+
+	if(setjmp(png_jmpbuf(png_p)) != 0)
+	{
+		png_destroy_read_struct(&png_p, &info_p, NULL);
+		MEM_FREE_FUNC(image);
+
+		return FALSE;
+	}
+
+	// 読み込み用のストリーム、関数ポインタをセット
+	png_set_read_fn(png_p, (void*)&io, PngReadWrite);
+
+	// 画像情報の読み込み
+	png_read_info(png_p, info_p);
+	png_get_IHDR(png_p, info_p, &local_width, &local_height,
+		&bit_depth, &color_type, &interlace_type, NULL, NULL
+	);
+	if(local_width > (uint32)width || local_height > (uint32)height)
+	{
+		png_destroy_read_struct(&png_p, &info_p, NULL);
+		MEM_FREE_FUNC(image);
+
+		return FALSE;
+	}
+
+	// 1チャンネル8ビットに揃える
+	png_set_strip_16(png_p);
+	if(color_type == PNG_COLOR_TYPE_PALETTE)
+	{
+		png_set_palette_to_rgb(png_p);
+	}
+	if(color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+	{
+		png_set_expand_gray_1_2_4_to_8(png_p);
+	}
+	if(png_get_valid(png_p, info_p, PNG_INFO_tRNS) != 0)
+	{
+		png_set_tRNS_to_alpha(png_p);
+	}
+	// 展開先の行に直接RGBAで書き込む
+	if(channel == 4)
+	{
+		if((color_type & PNG_COLOR_MASK_COLOR) == 0)
+		{
+			png_set_gray_to_rgb(png_p);
+		}
+		if((color_type & PNG_COLOR_MASK_ALPHA) == 0
+			&& png_get_valid(png_p, info_p, PNG_INFO_tRNS) == 0)
+		{
+			png_set_filler(png_p, 0xFF, PNG_FILLER_AFTER);
+		}
+	}
+	png_read_update_info(png_p, info_p);
+
+	if(png_get_channels(png_p, info_p) != channel
+		|| png_get_rowbytes(png_p, info_p) > (png_size_t)stride)
+	{
+		png_destroy_read_struct(&png_p, &info_p, NULL);
+		MEM_FREE_FUNC(image);
+
+		return FALSE;
+	}
+
+	// 2次元配列になるようアドレスをセット
+	for(i=0; i<local_height; i++)
+	{
+		image[i] = &pixels[stride*i];
+	}
+	// 画像データの読み込み
+	png_read_image(png_p, image);
+
+	// メモリの開放
+	png_destroy_read_struct(&png_p, &info_p, NULL);
+	MEM_FREE_FUNC(image);
+
+	return TRUE;
+}
+
 /*
 * ReadPNGHeader関数
 * PNGイメージのヘッダ情報を読み込む
@@ -402,6 +566,511 @@ uint8* ReadPNGDetailData(
 	return pixels;
 }
 
+/*
+* PngPaethPredictor関数
+* Paethフィルタの予測値を計算する
+* 引数
+* left		: 左のピクセルの値
+* up		: 上のピクセルの値
+* up_left	: 左上のピクセルの値
+* 返り値
+*	予測値
+*/
+static INLINE int PngPaethPredictor(int left, int up, int up_left)
+{
+	int p = left + up - up_left;
+	int pa = p - left, pb = p - up, pc = p - up_left;
+
+	if(pa < 0) pa = -pa;
+	if(pb < 0) pb = -pb;
+	if(pc < 0) pc = -pc;
+
+	if(pa <= pb && pa <= pc)
+	{
+		return left;
+	}
+	return (pb <= pc) ? up : up_left;
+}
+
+/*
+* PngFilterCost関数
+* フィルタ後の1行の評価値(符号付きとみなした絶対値の合計)を計算する
+* 引数
+* data		: フィルタ後のデータ
+* length	: バイト数
+* 返り値
+*	評価値(小さい程圧縮しやすい)
+*/
+static INLINE unsigned int PngFilterCost(const uint8* data, int length)
+{
+	unsigned int sum = 0;
+	int i;
+
+	for(i=0; i<length; i++)
+	{
+		sum += (data[i] < 128) ? data[i] : 256 - data[i];
+	}
+
+	return sum;
+}
+
+/*
+* FilterPNGRow関数
+* 1行分にフィルタをかける
+*  評価値が最小になるフィルタを選ぶ(libpngのPNG_ALL_FILTERSと同じ基準)
+* 引数
+* row		: フィルタをかける行
+* previous	: 1つ上の行(先頭行は全て0の行)
+* row_bytes	: 1行のバイト数
+* bpp		: 1ピクセルのバイト数
+* filter	: 試すフィルタの範囲
+* out		: フィルタの種類(1バイト)+フィルタ後のデータを書き込むアドレス
+* work		: 作業領域(row_bytes*4バイト)
+*/
+static void FilterPNGRow(
+	const uint8* row,
+	const uint8* previous,
+	int row_bytes,
+	int bpp,
+	ePNG_STREAM_FILTER filter,
+	uint8* out,
+	uint8* work
+)
+{
+	uint8 *sub = work, *up = &work[row_bytes];
+	uint8 *average = &work[row_bytes*2], *paeth = &work[row_bytes*3];
+	const uint8 *best = row;
+	unsigned int best_cost, cost;
+	int best_type = PNG_FILTER_VALUE_NONE;
+	int i;
+
+	for(i=0; i<bpp; i++)
+	{
+		sub[i] = row[i];
+		up[i] = (uint8)(row[i] - previous[i]);
+	}
+	for( ; i<row_bytes; i++)
+	{
+		sub[i] = (uint8)(row[i] - row[i-bpp]);
+		up[i] = (uint8)(row[i] - previous[i]);
+	}
+
+	best_cost = PngFilterCost(row, row_bytes);
+	if((cost = PngFilterCost(sub, row_bytes)) < best_cost)
+	{
+		best = sub,	best_cost = cost,	best_type = PNG_FILTER_VALUE_SUB;
+	}
+	if((cost = PngFilterCost(up, row_bytes)) < best_cost)
+	{
+		best = up,	best_cost = cost,	best_type = PNG_FILTER_VALUE_UP;
+	}
+
+	if(filter == PNG_STREAM_FILTER_ALL)
+	{
+		for(i=0; i<bpp; i++)
+		{
+			average[i] = (uint8)(row[i] - (previous[i] >> 1));
+			paeth[i] = (uint8)(row[i] - previous[i]);
+		}
+		for( ; i<row_bytes; i++)
+		{
+			average[i] = (uint8)(row[i] - ((row[i-bpp] + previous[i]) >> 1));
+			paeth[i] = (uint8)(row[i] - PngPaethPredictor(row[i-bpp], previous[i], previous[i-bpp]));
+		}
+
+		if((cost = PngFilterCost(average, row_bytes)) < best_cost)
+		{
+			best = average,	best_cost = cost,	best_type = PNG_FILTER_VALUE_AVG;
+		}
+		if((cost = PngFilterCost(paeth, row_bytes)) < best_cost)
+		{
+			best = paeth,	best_cost = cost,	best_type = PNG_FILTER_VALUE_PAETH;
+		}
+	}
+
+	out[0] = (uint8)best_type;
+	(void)memcpy(&out[1], best, row_bytes);
+}
+
+/*
+* CompressPNGSlice関数
+* 行のまとまり1つ分にフィルタをかけて生のdeflateデータに圧縮する
+*  直前の32KB分の行もフィルタをかけて辞書に設定し、区画の境界での圧縮率の低下を抑える
+*  最後の区画以外はZ_SYNC_FLUSHでバイト境界に揃えて終わるので、結果を連結すれば1つのdeflateデータになる
+* 引数
+* slice			: 結果を格納する区画
+* pixels		: ピクセルデータ
+* stride		: ピクセルデータ一行分のバイト数
+* row_bytes		: PNGの1行のバイト数
+* bpp			: 1ピクセルのバイト数
+* start_row		: 区画の最初の行
+* end_row		: 区画の次の行
+* height		: 画像の高さ
+* compression	: 圧縮レベル
+* filter		: 試すフィルタの範囲
+* zero_row		: 全て0の行(先頭行の上の行)
+*/
+static void CompressPNGSlice(
+	PNG_SLICE* slice,
+	const uint8* pixels,
+	int stride,
+	int row_bytes,
+	int bpp,
+	int start_row,
+	int end_row,
+	int height,
+	int compression,
+	ePNG_STREAM_FILTER filter,
+	const uint8* zero_row
+)
+{
+	const int filtered_bytes = row_bytes + 1;
+	int dictionary_rows = (PNG_DEFLATE_WINDOW_SIZE + filtered_bytes - 1) / filtered_bytes;
+	z_stream z = {0};
+	uint8 *filtered, *work;
+	size_t capacity, dictionary_size;
+	int header_size = (start_row == 0) ? 2 : 0;
+	int last = end_row >= height;
+	int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+	int ret;
+	int y;
+
+	if(dictionary_rows > start_row)
+	{
+		dictionary_rows = start_row;
+	}
+
+	filtered = (uint8*)MEM_ALLOC_FUNC((size_t)(end_row - start_row + dictionary_rows) * filtered_bytes);
+	work = (uint8*)MEM_ALLOC_FUNC((size_t)row_bytes * 4);
+	if(filtered == NULL || work == NULL)
+	{
+		MEM_FREE_FUNC(filtered);
+		MEM_FREE_FUNC(work);
+		slice->error = TRUE;
+		return;
+	}
+
+	for(y=start_row - dictionary_rows; y<end_row; y++)
+	{
+		FilterPNGRow(&pixels[y*stride], (y == 0) ? zero_row : &pixels[(y-1)*stride],
+			row_bytes, bpp, filter, &filtered[(y - start_row + dictionary_rows) * filtered_bytes], work);
+	}
+	MEM_FREE_FUNC(work);
+
+	slice->length = (uLong)(end_row - start_row) * filtered_bytes;
+	dictionary_size = (size_t)dictionary_rows * filtered_bytes;
+	slice->adler = adler32(adler32(0, NULL, 0), &filtered[dictionary_size], (uInt)slice->length);
+
+	if(deflateInit2(&z, compression, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		MEM_FREE_FUNC(filtered);
+		slice->error = TRUE;
+		return;
+	}
+	if(dictionary_size > PNG_DEFLATE_WINDOW_SIZE)
+	{
+		(void)deflateSetDictionary(&z, &filtered[dictionary_size - PNG_DEFLATE_WINDOW_SIZE], PNG_DEFLATE_WINDOW_SIZE);
+	}
+	else if(dictionary_size > 0)
+	{
+		(void)deflateSetDictionary(&z, filtered, (uInt)dictionary_size);
+	}
+
+	// 先頭にzlibのヘッダ、末尾にAdler-32を書き込む余白を取っておく
+	capacity = deflateBound(&z, slice->length) + 16 + header_size + 4;
+	slice->data = (uint8*)MEM_ALLOC_FUNC(capacity);
+	z.next_in = &filtered[dictionary_size];
+	z.avail_in = (uInt)slice->length;
+	z.next_out = slice->data != NULL ? &slice->data[header_size] : NULL;
+	z.avail_out = (uInt)(capacity - header_size - 4);
+
+	while(slice->data != NULL)
+	{
+		ret = deflate(&z, flush);
+		if(ret == Z_STREAM_ERROR)
+		{
+			slice->error = TRUE;
+			break;
+		}
+		if(last ? (ret == Z_STREAM_END) : (z.avail_in == 0 && z.avail_out != 0))
+		{
+			break;
+		}
+		// 出力先が足りなかったので広げる
+		{
+			size_t used = z.next_out - slice->data;
+			uint8 *data = (uint8*)MEM_REALLOC_FUNC(slice->data, capacity * 2);
+			if(data == NULL)
+			{
+				slice->error = TRUE;
+				break;
+			}
+			slice->data = data;
+			capacity *= 2;
+			z.next_out = &slice->data[used];
+			z.avail_out = (uInt)(capacity - used - 4);
+		}
+	}
+
+	if(slice->data == NULL)
+	{
+		slice->error = TRUE;
+	}
+	else
+	{
+		slice->size = z.next_out - slice->data;
+	}
+
+	(void)deflateEnd(&z);
+	MEM_FREE_FUNC(filtered);
+}
+
+/*
+* WritePNGChunk関数
+* PNGのチャンクを1つ書き込む
+* 引数
+* stream		: データストリーム
+* write_func	: 書き込み用の関数ポインタ
+* type			: チャンクの種類(4文字)
+* data			: チャンクのデータ
+* size			: チャンクのデータのバイト数
+*/
+static void WritePNGChunk(
+	void* stream,
+	stream_func_t write_func,
+	const char* type,
+	const uint8* data,
+	uint32 size
+)
+{
+	uint8 buffer[8];
+	uLong crc;
+
+	buffer[0] = (uint8)(size >> 24),	buffer[1] = (uint8)(size >> 16);
+	buffer[2] = (uint8)(size >> 8),	buffer[3] = (uint8)size;
+	(void)memcpy(&buffer[4], type, 4);
+	(void)write_func(buffer, 1, 8, stream);
+	if(size > 0)
+	{
+		(void)write_func((void*)data, 1, size, stream);
+	}
+
+	crc = crc32(crc32(0, NULL, 0), &buffer[4], 4);
+	if(size > 0)
+	{
+		crc = crc32(crc, data, size);
+	}
+	buffer[0] = (uint8)(crc >> 24),	buffer[1] = (uint8)(crc >> 16);
+	buffer[2] = (uint8)(crc >> 8),	buffer[3] = (uint8)crc;
+	(void)write_func(buffer, 1, 4, stream);
+}
+
+/*
+* PNG_SLICE_TASK構造体
+* 区画の圧縮をスレッドプールで処理するためのデータ
+*/
+typedef struct _PNG_SLICE_TASK
+{
+	PNG_SLICE *slices;
+	const uint8 *pixels;
+	const uint8 *zero_row;
+	int stride;
+	int row_bytes;
+	int bpp;
+	int slice_rows;
+	int height;
+	int compression;
+	ePNG_STREAM_FILTER filter;
+} PNG_SLICE_TASK;
+
+/*
+* CompressPNGSliceTask関数
+* スレッドプールから呼び出されて区画1つ分を圧縮する
+* 引数
+* index			: 区画の番号
+* thread_index	: 処理しているスレッドの番号
+* data			: PNG_SLICE_TASK構造体のアドレス
+*/
+static void CompressPNGSliceTask(int index, int thread_index, void* data)
+{
+	PNG_SLICE_TASK *task = (PNG_SLICE_TASK*)data;
+	int end_row = (index + 1) * task->slice_rows;
+
+	(void)thread_index;
+
+	CompressPNGSlice(&task->slices[index], task->pixels, task->stride, task->row_bytes,
+		task->bpp, index * task->slice_rows, (end_row < task->height) ? end_row : task->height,
+		task->height, task->compression, task->filter, task->zero_row);
+}
+
+/*
+* WritePNGStreamParallel関数
+* PNGのデータを複数スレッドで圧縮してストリームに書き込む
+*  行のまとまり毎にフィルタと圧縮を並列に行い、1つのzlibストリームに連結する(インターレース無し)
+* 引数
+* stream		: データストリーム
+* write_func	: 書き込み用の関数ポインタ
+* flush_func	: バッファをフラッシュする関数ポインタ(NULL可)
+* pixels		: ピクセルデータ
+* width			: 画像の幅
+* height		: 画像の高さ
+* stride		: 画像データ一行分のバイト数
+* channel		: 画像のチャンネル数
+* compression	: 圧縮レベル
+* filter		: 行毎に試すフィルタの範囲
+* 返り値
+*	成功:TRUE	失敗:FALSE(ストリームには何も書き込まない)
+*/
+int WritePNGStreamParallel(
+	void* stream,
+	stream_func_t write_func,
+	void (*flush_func)(void*),
+	uint8* pixels,
+	int32 width,
+	int32 height,
+	int32 stride,
+	uint8 channel,
+	int32 compression,
+	ePNG_STREAM_FILTER filter
+)
+{
+	const uint8 signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+	uint8 header[13];
+	PNG_SLICE *slices;
+	PNG_SLICE_TASK task;
+	uint8 *zero_row;
+	uLong adler;
+	int row_bytes = width * channel;
+	int slice_rows, num_slices;
+	int color_type;
+	int level_flag;
+	int result = TRUE;
+	int i;
+
+	switch(channel)
+	{
+	case 1:
+		color_type = PNG_COLOR_TYPE_GRAY;
+		break;
+	case 2:
+		color_type = PNG_COLOR_TYPE_GRAY_ALPHA;
+		break;
+	case 3:
+		color_type = PNG_COLOR_TYPE_RGB;
+		break;
+	case 4:
+		color_type = PNG_COLOR_TYPE_RGBA;
+		break;
+	default:
+		return FALSE;
+	}
+	if(width <= 0 || height <= 0)
+	{
+		return FALSE;
+	}
+	if(compression < Z_DEFAULT_COMPRESSION || compression > Z_BEST_COMPRESSION)
+	{
+		compression = Z_DEFAULT_COMPRESSION;
+	}
+
+	slice_rows = PNG_PARALLEL_SLICE_BYTES / (row_bytes + 1);
+	if(slice_rows < 1)
+	{
+		slice_rows = 1;
+	}
+	num_slices = (height + slice_rows - 1) / slice_rows;
+
+	slices = (PNG_SLICE*)MEM_CALLOC_FUNC(num_slices, sizeof(*slices));
+	zero_row = (uint8*)MEM_CALLOC_FUNC(row_bytes, 1);
+	if(slices == NULL || zero_row == NULL)
+	{
+		MEM_FREE_FUNC(slices);
+		MEM_FREE_FUNC(zero_row);
+		return FALSE;
+	}
+
+	task.slices = slices;
+	task.pixels = pixels;
+	task.zero_row = zero_row;
+	task.stride = stride;
+	task.row_bytes = row_bytes;
+	task.bpp = channel;
+	task.slice_rows = slice_rows;
+	task.height = height;
+	task.compression = compression;
+	task.filter = filter;
+	ExecuteParallelLoop(num_slices, CompressPNGSliceTask, &task);
+	MEM_FREE_FUNC(zero_row);
+
+	for(i=0; i<num_slices; i++)
+	{
+		if(slices[i].error != FALSE)
+		{
+			result = FALSE;
+			break;
+		}
+	}
+
+	if(result != FALSE)
+	{
+		// zlibのヘッダ(圧縮レベルの目安とチェックビット)
+		if(compression == Z_DEFAULT_COMPRESSION || compression == 6)
+		{
+			level_flag = 2;
+		}
+		else
+		{
+			level_flag = (compression < 2) ? 0 : (compression < 6) ? 1 : 3;
+		}
+		slices[0].data[0] = 0x78;
+		slices[0].data[1] = (uint8)(level_flag << 6);
+		slices[0].data[1] += (uint8)(31 - ((0x78 * 256 + slices[0].data[1]) % 31));
+
+		// 区画毎のAdler-32を結合して末尾に付ける
+		adler = slices[0].adler;
+		for(i=1; i<num_slices; i++)
+		{
+			adler = adler32_combine(adler, slices[i].adler, (z_off_t)slices[i].length);
+		}
+		slices[num_slices-1].data[slices[num_slices-1].size++] = (uint8)(adler >> 24);
+		slices[num_slices-1].data[slices[num_slices-1].size++] = (uint8)(adler >> 16);
+		slices[num_slices-1].data[slices[num_slices-1].size++] = (uint8)(adler >> 8);
+		slices[num_slices-1].data[slices[num_slices-1].size++] = (uint8)adler;
+
+		header[0] = (uint8)(width >> 24),	header[1] = (uint8)(width >> 16);
+		header[2] = (uint8)(width >> 8),	header[3] = (uint8)width;
+		header[4] = (uint8)(height >> 24),	header[5] = (uint8)(height >> 16);
+		header[6] = (uint8)(height >> 8),	header[7] = (uint8)height;
+		header[8] = 8;
+		header[9] = (uint8)color_type;
+		header[10] = PNG_COMPRESSION_TYPE_BASE;
+		header[11] = PNG_FILTER_TYPE_BASE;
+		header[12] = PNG_INTERLACE_NONE;
+
+		(void)write_func((void*)signature, 1, sizeof(signature), stream);
+		WritePNGChunk(stream, write_func, "IHDR", header, sizeof(header));
+		// 区画毎に1つのIDATチャンクにする
+		for(i=0; i<num_slices; i++)
+		{
+			WritePNGChunk(stream, write_func, "IDAT", slices[i].data, (uint32)slices[i].size);
+		}
+		WritePNGChunk(stream, write_func, "IEND", NULL, 0);
+
+		if(flush_func != NULL)
+		{
+			flush_func(stream);
+		}
+	}
+
+	for(i=0; i<num_slices; i++)
+	{
+		MEM_FREE_FUNC(slices[i].data);
+	}
+	MEM_FREE_FUNC(slices);
+
+	return result;
+}
+
 /*
 * WritePNGStream関数
 * PNGのデータをストリームに書き込む
@@ -436,6 +1105,14 @@ void WritePNGStream(
 	int color_type;
 	int i;
 
+	// インターレース無しなら複数スレッドで圧縮する
+	if(interlace == PNG_INTERLACE_NONE
+		&& WritePNGStreamParallel(stream, write_func, flush_func, pixels, width, height,
+			stride, channel, compression, PNG_STREAM_FILTER_ALL) != FALSE)
+	{
+		return;
+	}
+
 	// チャンネル数に合わせてカラータイプを設定
 	switch(channel)
 	{
@@ -3,6 +3,16 @@
 
 #include "../types.h"
 
+/*
+* ePNG_STREAM_FILTER列挙体
+* PNGの書き込み時に行毎に試すフィルタの範囲
+*/
+typedef enum _ePNG_STREAM_FILTER
+{
+	PNG_STREAM_FILTER_ALL,	// None/Sub/Up/Average/Paethの全てを試す(圧縮率優先)
+	PNG_STREAM_FILTER_FAST	// None/Sub/Upのみを試す(速度優先)
+} ePNG_STREAM_FILTER;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,6 +37,89 @@ EXTERN uint8* ReadPNGStream(
 	int32* stride
 );
 
+/*
+* ReadPNGHeader関数
+* PNGイメージのヘッダ情報を読み込む
+* 引数
+* stream	: データストリーム
+* read_func	: 読み込み用の関数ポインタ
+* width		: イメージの幅を格納するアドレス
+* height	: イメージの高さを格納するアドレス
+* stride	: イメージの一行分のバイト数を格納するアドレス
+* dpi		: イメージの解像度(DPI)を格納するアドレス
+* icc_profile_name	: ICCプロファイルの名前を受けるポインタ
+* icc_profile_data	: ICCプロファイルのデータを受けるポインタ
+* icc_profile_size	: ICCプロファイルのデータのバイト数を格納するアドレス
+*/
+EXTERN void ReadPNGHeader(
+	void* stream,
+	stream_func_t read_func,
+	int32* width,
+	int32* height,
+	int32* stride,
+	int32* dpi,
+	char** icc_profile_name,
+	uint8** icc_profile_data,
+	uint32* icc_profile_size
+);
+
+/*
+* ReadPNGStreamToPixels関数
+* PNGイメージデータを指定したピクセルデータへ直接展開する
+*  4チャンネルを指定した場合はグレースケール/RGBをRGBAに展開する
+*  (チャンネルの並びはPNGのまま)
+* 引数
+* stream	: データストリーム
+* read_func	: 読み込み用の関数ポインタ
+* pixels	: 展開先のピクセルデータ
+* width		: 展開先の幅
+* height	: 展開先の高さ
+* stride	: 展開先の一行分のバイト数
+* channel	: 展開先のチャンネル数
+* 返り値
+*	成功:TRUE	失敗:FALSE(イメージが展開先より大きい場合も失敗)
+*/
+EXTERN int ReadPNGStreamToPixels(
+	void* stream,
+	stream_func_t read_func,
+	uint8* pixels,
+	int32 width,
+	int32 height,
+	int32 stride,
+	uint8 channel
+);
+
+/*
+* WritePNGStreamParallel関数
+* PNGのデータを複数スレッドで圧縮してストリームに書き込む
+*  行のまとまり毎にフィルタと圧縮を並列に行い、1つのzlibストリームに連結する(インターレース無し)
+* 引数
+* stream		: データストリーム
+* write_func	: 書き込み用の関数ポインタ
+* flush_func	: バッファをフラッシュする関数ポインタ(NULL可)
+* pixels		: ピクセルデータ
+* width			: 画像の幅
+* height		: 画像の高さ
+* stride		: 画像データ一行分のバイト数
+* channel		: 画像のチャンネル数
+* compression	: 圧縮レベル
+* filter		: 行毎に試すフィルタの範囲
+* 返り値
+*	成功:TRUE	失敗:FALSE(ストリームには何も書き込まない)
+*/
+EXTERN int WritePNGStreamParallel(
+	void* stream,
+	stream_func_t write_func,
+	void (*flush_func)(void*),
+	uint8* pixels,
+	int32 width,
+	int32 height,
+	int32 stride,
+	uint8 channel,
+	int32 compression,
+	ePNG_STREAM_FILTER filter
+);
+
 /*
 * WritePNGStream関数
 * PNGのデータをストリームに書き込む
@@ -38,7 +131,7 @@ EXTERN uint8* ReadPNGStream(
 * height		: 画像の高さ
 * stride		: 画像データ一行分のバイト数
 * channel		: 画像のチャンネル数
-* interlace		: インターレースの有無
+* interlace		: インターレースの有無(無しの場合はWritePNGStreamParallelで全てのフィルタを試す)
 * compression	: 圧縮レベル
 */
 EXTERN void WritePNGStream(
@@ -689,7 +689,7 @@ int MouseMotionNotifyEvent(
 
 				if(canvas->transform != NULL)
 				{
-					canvas->transform->trans_point = TRANSFORM_POINT_NONE;
+					TransformButtonRelease(canvas->transform);
 					goto func_end;
 				}
 
@@ -916,7 +916,7 @@ int MouseMotionNotifyEvent(
 
 			if(canvas->transform != NULL)
 			{
-				canvas->transform->trans_point = TRANSFORM_POINT_NONE;
+				TransformButtonRelease(canvas->transform);
 				update_function(canvas, x0, y0, update_data);
 				goto func_end;
 			}
@@ -1341,7 +1341,7 @@ void MouseButtonReleaseEvent(
 
 	if(canvas->transform != NULL)
 	{
-		canvas->transform->trans_point = TRANSFORM_POINT_NONE;
+		TransformButtonRelease(canvas->transform);
 		update_function(canvas, event_state->cursor_x, event_state->cursor_y, update_data);
 		goto func_end;
 	}
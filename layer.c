@@ -7,6 +7,7 @@
 #include "memory.h"
 #include "image_file/original_format.h"
 #include "gui/draw_window.h"
+#include "gui/layer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,10 +43,20 @@ LAYER* CreateLayer(
 		ret->channel = 4;
 		ret->stride = width * 4;
 	}
-	ret->pixels = (uint8*)MEM_CALLOC_FUNC(sizeof(uint8)*width*height*channel, 1);
-	InitializeGraphicsImageSurfaceForData(&ret->surface, ret->pixels, GRAPHICS_FORMAT_ARGB32,
-											width, height, ret->stride, &window->app->graphics);
-	InitializeGraphicsDefaultContext(&ret->context, &ret->surface, &window->app->graphics);
+	// 名前のある通常レイヤー(作業用以外)は透明なタイル形式で作成し
+		// 編集対象になった時点でピクセルデータを確保する
+	if(layer_type == TYPE_NORMAL_LAYER && channel == 4 && name != NULL)
+	{
+		ret->tiles = CreateLayerTiles(NULL, width, height, ret->stride);
+		ret->compact_checked = TRUE;
+	}
+	else
+	{
+		ret->pixels = (uint8*)MEM_CALLOC_FUNC(sizeof(uint8)*width*height*channel, 1);
+		InitializeGraphicsImageSurfaceForData(&ret->surface, ret->pixels, GRAPHICS_FORMAT_ARGB32,
+												width, height, ret->stride, &window->app->graphics);
+		InitializeGraphicsDefaultContext(&ret->context, &ret->surface, &window->app->graphics);
+	}
 	ret->alpha = 100;
 	ret->window = window;
 
@@ -153,9 +164,12 @@ void DeleteLayer(LAYER** layer)
 	}
 	else if((*layer)->layer_type == TYPE_ADJUSTMENT_LAYER)
 	{
-		DeleteAdjustmentLayer(&(*layer)->layer_data.adjustment_layer);
+		ReleaseAdjustmentLayer(&(*layer)->layer_data.adjustment_layer);
 	}
 
+	// 所属していたレイヤーセットの合成結果を作り直す
+	InvalidateLayerSetCache(*layer, 0, 0, 0, 0);
+
 	if((*layer)->next != NULL)
 	{
 		(*layer)->next->prev = (*layer)->prev;
@@ -178,6 +192,7 @@ void DeleteLayer(LAYER** layer)
 	MEM_FREE_FUNC((*layer)->name);
 
 	MEM_FREE_FUNC((*layer)->pixels);
+	DeleteLayerTiles(&(*layer)->tiles);
 	MEM_FREE_FUNC(*layer);
 
 	*layer = NULL;
@@ -215,8 +230,41 @@ int CorrectLayerName(const LAYER* bottom_layer, const char* name)
 	return TRUE;
 }
 
+/*
+* MaterializeMaskSource関数
+* 下のレイヤーでマスクするレイヤーのマスクに使うレイヤーをタイル形式から戻す
+*  マスクに使うレイヤーはピクセルデータを直接参照される
+* 引数
+* layer	: マスクを確認するレイヤー
+*/
+static void MaterializeMaskSource(LAYER* layer)
+{
+	LAYER *mask_source;
+
+	if((layer->flags & LAYER_MASKING_WITH_UNDER_LAYER) == 0)
+	{
+		return;
+	}
+
+	mask_source = layer->prev;
+	while(mask_source != NULL && (mask_source->flags & LAYER_MASKING_WITH_UNDER_LAYER) != 0)
+	{
+		mask_source = mask_source->prev;
+	}
+	if(mask_source != NULL)
+	{
+		(void)MaterializeLayerPixels(mask_source);
+	}
+}
+
 void ChangeLayerOrder(LAYER* change_layer, LAYER* new_prev, LAYER** bottom)
 {
+	// 移動前に上にあったレイヤー
+	LAYER *old_next = change_layer->next;
+
+	// 移動前に所属していたレイヤーセットの合成結果を無効化
+	InvalidateLayerSetCache(change_layer, 0, 0, 0, 0);
+
 	if(change_layer->prev != NULL)
 	{
 		change_layer->prev->next = change_layer->next;
@@ -257,6 +305,27 @@ void ChangeLayerOrder(LAYER* change_layer, LAYER* new_prev, LAYER** bottom)
 
 	change_layer->prev = new_prev;
 
+	// 移動先のレイヤーセットの合成結果を無効化
+	if(new_prev != NULL)
+	{
+		InvalidateLayerSetCache(new_prev, 0, 0, 0, 0);
+	}
+	if(change_layer->next != NULL)
+	{
+		InvalidateLayerSetCache(change_layer->next, 0, 0, 0, 0);
+	}
+
+	// 並び替えでマスクの参照先になったレイヤーをタイル形式から戻す
+	MaterializeMaskSource(change_layer);
+	if(change_layer->next != NULL)
+	{
+		MaterializeMaskSource(change_layer->next);
+	}
+	if(old_next != NULL)
+	{
+		MaterializeMaskSource(old_next);
+	}
+
 	// 局所キャンバスモードなら親キャンバスの順序も変更
 	if((change_layer->window->flags & DRAW_WINDOW_IS_FOCAL_WINDOW) != 0)
 	{
@@ -361,7 +430,14 @@ void ChangeActiveLayer(DRAW_WINDOW* canvas, LAYER* layer)
 		app->tool_box.current_tool_type = layer->layer_type;
 	}
 
+	// 編集対象になるのでタイル形式を通常のピクセルデータに戻す
+	(void)MaterializeLayerPixels(layer);
+	layer->compact_checked = FALSE;
+
 	canvas->active_layer = layer;
+
+	// 編集されなくなったレイヤーのメモリを節約する
+	CompactInactiveLayers(canvas);
 }
 
 void SetLayerLockOpacity(APPLICATION* app, int lock)
@@ -432,6 +508,7 @@ void SetLayerMaskUnder(APPLICATION* app, int mask)
 	if(mask)
 	{
 		active_layer->flags |= LAYER_MASKING_WITH_UNDER_LAYER;
+		MaterializeMaskSource(active_layer);
 	}
 	else
 	{
@@ -524,6 +601,7 @@ static void AddNewColorLayerRedo(DRAW_WINDOW* canvas, void* history_data)
 
 	new_layer = CreateLayer(data.x, data.y, data.width, data.height, data.channel,
 					data.layer_type, previous, next, data.layer_name, canvas);
+	InvalidateLayerSetCache(new_layer, 0, 0, 0, 0);
 
 	canvas->num_layer++;
 	LayerViewAddLayer(new_layer, canvas->layer, canvas->app->layer_view, canvas->num_layer);
@@ -644,9 +722,7 @@ static void DeleteLayerUndo(DRAW_WINDOW* canvas, void* history_data)
 	// 履歴データは最初の4バイトがデータバイト数
 		// 読み取り用ストリームの位置を4バイトに設定しておく
 		// データサイズはmemcpyで取得済
-	stream.block_size = 1;
-	stream.data_size = data_size;
-	stream.buff_ptr = (uint8*)history_data;
+	InitializeMemoryStreamView(&stream, history_data, data_size);
 	stream.data_point = sizeof(data_size);
 
 	// 局所キャンバス有無を読み込む
@@ -677,6 +753,7 @@ static void DeleteLayerUndo(DRAW_WINDOW* canvas, void* history_data)
 				history.layer_type, previous, (previous == NULL) ? canvas->layer : previous->next, history.layer_name, canvas);
 
 	ReadLayerData();
+	InvalidateLayerSetCache(layer, 0, 0, 0, 0);
 
 	// 局所キャンバスモードの場合は元キャンバスのレイヤーも復活させる
 	if(has_focal_canvas)
@@ -728,11 +805,9 @@ static void DeleteLayerRedo(DRAW_WINDOW* canvas, void* history_data)
 	uint32 data_size;
 	int32 has_focal_canvas;
 
-	stream.block_size = 1;
 	(void)memcpy(&data_size, history_data, sizeof(data_size));
-	stream.data_size = data_size;
+	InitializeMemoryStreamView(&stream, history_data, data_size);
 	stream.data_point = offsetof(DELETE_LAYER_HISTORY, layer_name_length) + sizeof(data_size);
-	stream.buff_ptr = (uint8*)history_data;
 
 	(void)MemRead(&has_focal_canvas, sizeof(has_focal_canvas), 1, &stream);
 
@@ -855,6 +930,8 @@ void ResizeLayerBuffer(
 	const GRAPHICS_DEFAULT_CONTEXT zero_context = {0};
 	const GRAPHICS_IMAGE_SURFACE zero_surface = {0};
 
+	(void)MaterializeLayerPixels(target);
+
 	target->width = new_width;
 	target->height = new_height;
 	target->stride = new_width * 4;
@@ -870,6 +947,271 @@ void ResizeLayerBuffer(
 	InitializeGraphicsImageSurfaceForData(&target->surface, target->pixels,
 					GRAPHICS_FORMAT_ARGB32, target->width, target->height ,target->stride, &app->graphics);
 	InitializeGraphicsDefaultContext(&target->context, &target->surface, &app->graphics);
+
+	if(target->layer_type == TYPE_LAYER_SET)
+	{
+		target->layer_data.layer_set->cache_flags &= ~(LAYER_SET_CACHE_VALID);
+	}
+}
+
+/*
+* IsLayerPixelsReferenced関数
+* レイヤーのピクセルデータが直接参照されるかを判定する
+* 引数
+* layer	: 判定するレイヤー
+* 返り値
+*	直接参照される:TRUE	タイル形式でも良い:FALSE
+*/
+static int IsLayerPixelsReferenced(LAYER* layer)
+{
+	// 描画対象になるアクティブレイヤー
+	if(layer == layer->window->active_layer)
+	{
+		return TRUE;
+	}
+
+	// 上のレイヤーのマスクに使われている場合もピクセルデータを直接参照される
+	if(layer->next != NULL && (layer->next->flags & LAYER_MASKING_WITH_UNDER_LAYER) != 0)
+	{
+		return TRUE;
+	}
+
+	// 上の調整レイヤーの入力になる場合もピクセルデータを直接参照される
+	if(layer->next != NULL && layer->next->layer_type == TYPE_ADJUSTMENT_LAYER)
+	{
+		return TRUE;
+	}
+
+	// ピン留めされたレイヤーは変形でピクセルデータを直接書き換える
+	if((layer->flags & LAYER_CHAINED) != 0)
+	{
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+* CompactLayerPixels関数
+* 透明部分の多いレイヤーのピクセルデータをタイル形式にしてメモリを節約する
+* 引数
+* layer	: ピクセルデータを変換するレイヤー
+* 返り値
+*	タイル形式にした:TRUE	変換しなかった:FALSE
+*/
+int CompactLayerPixels(LAYER* layer)
+{
+	const GRAPHICS_DEFAULT_CONTEXT zero_context = {0};
+	const GRAPHICS_IMAGE_SURFACE zero_surface = {0};
+	LAYER_TILES *tiles;
+
+	layer->compact_checked = TRUE;
+
+	// 通常レイヤー以外と、ピクセルデータを直接参照されるレイヤーはそのまま
+	if(layer->pixels == NULL || layer->layer_type != TYPE_NORMAL_LAYER
+		|| IsLayerPixelsReferenced(layer) != FALSE)
+	{
+		return FALSE;
+	}
+
+	tiles = CreateLayerTiles(layer->pixels, layer->width, layer->height, layer->stride);
+	// 節約できるメモリが少なければ変換しない
+	if(LayerTilesMemorySize(tiles) > (size_t)layer->stride * layer->height / 2)
+	{
+		DeleteLayerTiles(&tiles);
+		return FALSE;
+	}
+
+	// サムネイルの縮小処理がピクセルデータを参照し終わるのを待つ
+	WaitLayerThumbnailUpdate(layer);
+
+	GraphicsDefaultContextFinish(&layer->context);
+	layer->context = zero_context;
+	GraphicsSurfaceFinish(&layer->surface.base);
+	layer->surface = zero_surface;
+
+	MEM_FREE_FUNC(layer->pixels);
+	layer->pixels = NULL;
+	layer->tiles = tiles;
+
+	return TRUE;
+}
+
+/*
+* MaterializeLayerPixels関数
+* タイル形式のレイヤーを通常のピクセルデータに戻す
+* 引数
+* layer	: ピクセルデータを戻すレイヤー
+* 返り値
+*	レイヤーのピクセルデータ
+*/
+uint8* MaterializeLayerPixels(LAYER* layer)
+{
+	APPLICATION *app;
+
+	if(layer->tiles == NULL)
+	{
+		return layer->pixels;
+	}
+
+	app = layer->window->app;
+	WaitLayerThumbnailUpdate(layer);
+
+	layer->pixels = (uint8*)MEM_ALLOC_FUNC(layer->stride * layer->height);
+	LayerTilesToPixels(layer->tiles, layer->pixels, layer->stride,
+		0, 0, layer->width, layer->height);
+	DeleteLayerTiles(&layer->tiles);
+
+	InitializeGraphicsImageSurfaceForData(&layer->surface, layer->pixels,
+		GRAPHICS_FORMAT_ARGB32, layer->width, layer->height, layer->stride, &app->graphics);
+	InitializeGraphicsDefaultContext(&layer->context, &layer->surface, &app->graphics);
+	layer->compact_checked = FALSE;
+
+	return layer->pixels;
+}
+
+/*
+* StoreLayerPixels関数
+* 作業用のバッファに用意したピクセルデータをレイヤーに設定する
+*  タイル形式のレイヤーは透明部分が多ければタイル形式のまま保持する
+* 引数
+* layer		: ピクセルデータを設定するレイヤー
+* pixels	: 設定するピクセルデータ
+* stride	: 設定するピクセルデータの1行分のバイト数
+*/
+void StoreLayerPixels(LAYER* layer, const uint8* pixels, int stride)
+{
+	int y;
+
+	if(layer->tiles != NULL)
+	{
+		LAYER_TILES *tiles = CreateLayerTiles(pixels, layer->width, layer->height, stride);
+		if(LayerTilesMemorySize(tiles) <= (size_t)layer->stride * layer->height / 2)
+		{
+			WaitLayerThumbnailUpdate(layer);
+			DeleteLayerTiles(&layer->tiles);
+			layer->tiles = tiles;
+			layer->compact_checked = TRUE;
+			return;
+		}
+		DeleteLayerTiles(&tiles);
+	}
+
+	// 節約できるメモリが少なければ通常のピクセルデータにしてコピーする
+	(void)MaterializeLayerPixels(layer);
+	for(y=0; y<layer->height; y++)
+	{
+		(void)memcpy(&layer->pixels[y*layer->stride], &pixels[y*stride], layer->stride);
+	}
+}
+
+/*
+* MaterializeReferencedLayers関数
+* ピクセルデータを直接参照されるレイヤーをタイル形式から戻す
+*  (アクティブレイヤー、マスクや調整レイヤーの入力、ピン留めされたレイヤー)
+* 引数
+* canvas	: 描画領域を管理する構造体のアドレス
+*/
+void MaterializeReferencedLayers(DRAW_WINDOW* canvas)
+{
+	LAYER *layer;
+
+	for(layer = canvas->layer; layer != NULL; layer = layer->next)
+	{
+		if(layer->tiles != NULL && IsLayerPixelsReferenced(layer) != FALSE)
+		{
+			(void)MaterializeLayerPixels(layer);
+		}
+	}
+}
+
+/*
+* CompactInactiveLayers関数
+* アクティブレイヤー以外で未確認のレイヤーをタイル形式にする
+* 引数
+* canvas	: 描画領域を管理する構造体のアドレス
+*/
+void CompactInactiveLayers(DRAW_WINDOW* canvas)
+{
+	LAYER *layer;
+
+	for(layer = canvas->layer; layer != NULL; layer = layer->next)
+	{
+		if(layer->compact_checked == FALSE && layer->pixels != NULL)
+		{
+			(void)CompactLayerPixels(layer);
+		}
+	}
+}
+
+/*
+* PrepareLayerForBlend関数
+* 合成に使うレイヤーを用意する
+*  タイル形式のレイヤーは作業用レイヤーに指定範囲を展開する
+* 引数
+* layer		: 合成するレイヤー
+* work		: 展開先の作業用レイヤー
+* x			: 合成する範囲の左上のX座標
+* y			: 合成する範囲の左上のY座標
+* width		: 合成する範囲の幅
+* height	: 合成する範囲の高さ
+* 返り値
+*	合成に使うレイヤー
+*/
+LAYER* PrepareLayerForBlend(LAYER* layer, LAYER* work, int x, int y, int width, int height)
+{
+	if(layer->tiles == NULL)
+	{
+		return layer;
+	}
+
+	LayerTilesToPixels(layer->tiles, &work->pixels[y * work->stride + x * 4],
+		work->stride, x, y, width, height);
+	work->alpha = layer->alpha;
+	work->flags = layer->flags;
+	work->prev = layer->prev;
+
+	return work;
+}
+
+/*
+* BlendTiledLayer関数
+* タイル形式のレイヤーを不透明なタイルを含む範囲のみ展開して合成する
+* 引数
+* layer			: 合成するタイル形式のレイヤー
+* target		: 合成先のレイヤー
+* blend_mode	: 合成方法
+* canvas		: 描画領域を管理する構造体のアドレス
+*/
+void BlendTiledLayer(LAYER* layer, LAYER* target, int blend_mode, DRAW_WINDOW* canvas)
+{
+	UPDATE_RECTANGLE update = {0};
+	int x, y, width, height;
+
+	// 透明部分でも合成先が変わる内部用の合成方法は全体を展開して合成
+	if(blend_mode >= LAYER_BLEND_SLELECTABLE_NUM)
+	{
+		canvas->layer_blend_functions[blend_mode](PrepareLayerForBlend(layer, canvas->temp_layer,
+			0, 0, canvas->width, canvas->height), target);
+		return;
+	}
+
+	// 全て透明なら合成しても変化しない
+	if(GetLayerTilesBounds(layer->tiles, &x, &y, &width, &height) == FALSE)
+	{
+		return;
+	}
+
+	InitializeGraphicsImageSurfaceForRectangle(&update.surface, &target->surface, x, y, width, height);
+	InitializeGraphicsDefaultContext(&update.context, &update.surface, &canvas->app->graphics);
+	update.x = x, update.y = y;
+	update.width = width, update.height = height;
+
+	canvas->part_layer_blend_functions[blend_mode](PrepareLayerForBlend(layer, canvas->temp_layer,
+		x, y, width, height), target, &update);
+
+	DestroyGraphicsSurface(&update.surface.base);
+	DestroyGraphicsContext(&update.context.base);
 }
 
 #ifdef __cplusplus
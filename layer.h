@@ -8,6 +8,7 @@
 #include "text_layer.h"
 #include "layer_set.h"
 #include "adjustment_layer.h"
+#include "layer_tiles.h"
 
 #define LAYER_CHAIN_BUFFER_SIZE 1024
 #define MAX_LAYER_EXTRA_DATA_NUM 8
@@ -126,6 +127,11 @@ typedef struct _LAYER
 	void *last_write_data;
 	size_t last_write_data_size;
 
+	// タイル形式で保持している時のピクセルデータ(pixelsはNULLになる)
+	LAYER_TILES *tiles;
+	// タイル形式への変換を試してから変更されていなければTRUE
+	int8 compact_checked;
+
 	// 描画領域へのポインタ
 	struct _DRAW_WINDOW *window;
 };
@@ -152,6 +158,27 @@ static INLINE eGRAPHICS_OPERATOR LayerBlendModeToGraphicsOperator(eLAYER_BLEND_M
 	return (eGRAPHICS_OPERATOR)(GRAPHICS_OPERATOR_COLOR_BLEND_START + blend_mode - 1);
 }
 
+/*
+* GetLayerPixelAlpha関数
+* タイル形式かどうかに関わらずレイヤーのピクセルの不透明度を取得する
+* 引数
+* layer	: 不透明度を取得するレイヤー
+* x		: レイヤー内のX座標
+* y		: レイヤー内のY座標
+* 返り値
+*	ピクセルの不透明度
+*/
+static INLINE uint8 GetLayerPixelAlpha(const LAYER* layer, int x, int y)
+{
+	if(layer->pixels != NULL)
+	{
+		return layer->pixels[y * layer->stride + x * 4 + 3];
+	}
+
+	return GetLayerTile(layer->tiles, x / LAYER_TILE_SIZE, y / LAYER_TILE_SIZE)[
+		((y % LAYER_TILE_SIZE) * LAYER_TILE_SIZE + x % LAYER_TILE_SIZE) * 4 + 3];
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -191,6 +218,81 @@ EXTERN void ResizeLayerBuffer(
 	int32 new_height
 );
 
+/*
+* CompactLayerPixels関数
+* 透明部分の多いレイヤーのピクセルデータをタイル形式にしてメモリを節約する
+* 引数
+* layer	: ピクセルデータを変換するレイヤー
+* 返り値
+*	タイル形式にした:TRUE	変換しなかった:FALSE
+*/
+EXTERN int CompactLayerPixels(LAYER* layer);
+
+/*
+* MaterializeLayerPixels関数
+* タイル形式のレイヤーを通常のピクセルデータに戻す
+* 引数
+* layer	: ピクセルデータを戻すレイヤー
+* 返り値
+*	レイヤーのピクセルデータ
+*/
+EXTERN uint8* MaterializeLayerPixels(LAYER* layer);
+
+/*
+* StoreLayerPixels関数
+* 作業用のバッファに用意したピクセルデータをレイヤーに設定する
+*  タイル形式のレイヤーは透明部分が多ければタイル形式のまま保持する
+* 引数
+* layer		: ピクセルデータを設定するレイヤー
+* pixels	: 設定するピクセルデータ
+* stride	: 設定するピクセルデータの1行分のバイト数
+*/
+EXTERN void StoreLayerPixels(LAYER* layer, const uint8* pixels, int stride);
+
+/*
+* MaterializeReferencedLayers関数
+* ピクセルデータを直接参照されるレイヤーをタイル形式から戻す
+*  (アクティブレイヤー、マスクや調整レイヤーの入力、ピン留めされたレイヤー)
+* 引数
+* canvas	: 描画領域を管理する構造体のアドレス
+*/
+EXTERN void MaterializeReferencedLayers(DRAW_WINDOW* canvas);
+
+/*
+* CompactInactiveLayers関数
+* アクティブレイヤー以外で未確認のレイヤーをタイル形式にする
+* 引数
+* canvas	: 描画領域を管理する構造体のアドレス
+*/
+EXTERN void CompactInactiveLayers(DRAW_WINDOW* canvas);
+
+/*
+* PrepareLayerForBlend関数
+* 合成に使うレイヤーを用意する
+*  タイル形式のレイヤーは作業用レイヤーに指定範囲を展開する
+* 引数
+* layer		: 合成するレイヤー
+* work		: 展開先の作業用レイヤー
+* x			: 合成する範囲の左上のX座標
+* y			: 合成する範囲の左上のY座標
+* width		: 合成する範囲の幅
+* height	: 合成する範囲の高さ
+* 返り値
+*	合成に使うレイヤー
+*/
+EXTERN LAYER* PrepareLayerForBlend(LAYER* layer, LAYER* work, int x, int y, int width, int height);
+
+/*
+* BlendTiledLayer関数
+* タイル形式のレイヤーを不透明なタイルを含む範囲のみ展開して合成する
+* 引数
+* layer			: 合成するタイル形式のレイヤー
+* target		: 合成先のレイヤー
+* blend_mode	: 合成方法
+* canvas		: 描画領域を管理する構造体のアドレス
+*/
+EXTERN void BlendTiledLayer(LAYER* layer, LAYER* target, int blend_mode, DRAW_WINDOW* canvas);
+
 #ifdef __cplusplus
 }
 #endif
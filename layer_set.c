@@ -8,11 +8,194 @@
 #include "draw_window.h"
 #include "application.h"
 #include "memory.h"
+#include "gui/layer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+* LayerSetHasActiveLayer関数
+* レイヤーセット内にアクティブレイヤーが含まれるかを判定する
+* 引数
+* layer_set	: 判定するレイヤーセット
+* canvas	: 描画領域を管理する構造体のアドレス
+* 返り値
+*	含まれる:TRUE	含まれない:FALSE
+*/
+static int LayerSetHasActiveLayer(LAYER* layer_set, DRAW_WINDOW* canvas)
+{
+	LAYER *parent;
+
+	if(canvas->active_layer == NULL)
+	{
+		return FALSE;
+	}
+
+	for(parent = canvas->active_layer->layer_set; parent != NULL; parent = parent->layer_set)
+	{
+		if(parent == layer_set)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/*
+* InvalidateLayerSetCache関数
+* レイヤーが所属するレイヤーセットの合成結果のキャッシュを無効化する
+* 引数
+* layer		: 内容を変更したレイヤー
+* x			: 変更範囲の左上のX座標
+* y			: 変更範囲の左上のY座標
+* width		: 変更範囲の幅(0以下ならキャンバス全体)
+* height	: 変更範囲の高さ
+*/
+void InvalidateLayerSetCache(LAYER* layer, int x, int y, int width, int height)
+{
+	LAYER *parent;
+
+	if(layer == NULL || layer->layer_set == NULL)
+	{
+		return;
+	}
+
+	if(width <= 0 || height <= 0)
+	{
+		x = y = 0;
+		width = layer->window->width;
+		height = layer->window->height;
+	}
+
+	// 所属するレイヤーセットを外側まで辿って変更を記録
+	for(parent = layer->layer_set; parent != NULL; parent = parent->layer_set)
+	{
+		LAYER_SET *cache = parent->layer_data.layer_set;
+
+		cache->generation++;
+		if(cache->dirty_width <= 0 || cache->dirty_height <= 0)
+		{
+			cache->dirty_x = x,	cache->dirty_y = y;
+			cache->dirty_width = width,	cache->dirty_height = height;
+		}
+		else
+		{
+			int right = cache->dirty_x + cache->dirty_width;
+			int bottom = cache->dirty_y + cache->dirty_height;
+
+			if(x + width > right)
+			{
+				right = x + width;
+			}
+			if(y + height > bottom)
+			{
+				bottom = y + height;
+			}
+			if(x < cache->dirty_x)
+			{
+				cache->dirty_x = x;
+			}
+			if(y < cache->dirty_y)
+			{
+				cache->dirty_y = y;
+			}
+			cache->dirty_width = right - cache->dirty_x;
+			cache->dirty_height = bottom - cache->dirty_y;
+		}
+	}
+}
+
+/*
+* MixLayerSetPart関数
+* レイヤーセット内の変更された範囲のみを合成し直す
+* 引数
+* bottom	: レイヤーセットの一番下のレイヤー
+* canvas	: 描画領域を管理する構造体のアドレス
+* 返り値
+*	合成後に次に合成するレイヤー
+*/
+static LAYER* MixLayerSetPart(LAYER* bottom, DRAW_WINDOW* canvas)
+{
+	LAYER *layer_set = bottom->layer_set;
+	LAYER_SET *cache = layer_set->layer_data.layer_set;
+	UPDATE_RECTANGLE update = {0};
+	LAYER *layer = bottom;
+	int x = cache->dirty_x,	y = cache->dirty_y;
+	int width = cache->dirty_width,	height = cache->dirty_height;
+	int i;
+
+	if(x < 0)
+	{
+		width += x;
+		x = 0;
+	}
+	if(y < 0)
+	{
+		height += y;
+		y = 0;
+	}
+	if(x + width > layer_set->width)
+	{
+		width = layer_set->width - x;
+	}
+	if(y + height > layer_set->height)
+	{
+		height = layer_set->height - y;
+	}
+
+	if(width > 0 && height > 0)
+	{
+		// 変更範囲のピクセルデータをリセット
+		for(i=0; i<height; i++)
+		{
+			(void)memset(&layer_set->pixels[(y+i)*layer_set->stride + x*4], 0, width*4);
+		}
+
+		InitializeGraphicsImageSurfaceForRectangle(&update.surface, &layer_set->surface,
+													x, y, width, height);
+		InitializeGraphicsDefaultContext(&update.context, &update.surface, &canvas->app->graphics);
+		update.x = x,	update.y = y;
+		update.width = width,	update.height = height;
+	}
+
+	// 所属レイヤーセットまでループ
+	while(1)
+	{
+		if(width > 0 && height > 0 && (layer->flags & LAYER_FLAG_INVISIBLE) == 0)
+		{
+			canvas->part_layer_blend_functions[layer->layer_mode](
+				PrepareLayerForBlend(layer, canvas->temp_layer, x, y, width, height), layer_set, &update);
+			canvas->temp_layer->alpha = 100;
+			canvas->temp_layer->flags = 0;
+			canvas->temp_layer->prev = NULL;
+		}
+
+		layer = layer->next;
+
+		if(layer->layer_set != layer_set)
+		{
+			// 所属レイヤーセットに到達したら
+			if(layer == layer_set || layer->layer_set == NULL)
+			{
+				break;
+			}
+
+			MixLayerSet(layer, &layer, canvas);
+		}
+	}
+
+	if(width > 0 && height > 0)
+	{
+		DestroyGraphicsSurface(&update.surface.base);
+		DestroyGraphicsContext(&update.context.base);
+		UpdateLayerThumbnailRegion(layer_set, x, y, width, height);
+	}
+
+	return layer;
+}
+
 /*
 * MixLayerSet関数
 * レイヤーセット内を合成
@@ -30,8 +213,34 @@ void MixLayerSet(LAYER* bottom, LAYER** next, DRAW_WINDOW* canvas)
 	// レイヤー合成用
 	LAYER *layer = bottom;
 	LAYER *blend_layer;
+	LAYER_SET *cache = layer_set->layer_data.layer_set;
+	int use_cache = FALSE;
 	int blend_mode;
 
+	// アクティブレイヤーを含まないレイヤーセットは
+		// 前回の合成結果から変更があった部分だけを合成し直す
+	if(LayerSetHasActiveLayer(layer_set, canvas) == FALSE)
+	{
+		if((cache->cache_flags & LAYER_SET_CACHE_VALID) != 0)
+		{
+			if(cache->cached_generation == cache->generation)
+			{
+				*next = layer_set;
+				return;
+			}
+
+			if(cache->dirty_width > 0 && cache->dirty_height > 0
+				&& (size_t)cache->dirty_width * cache->dirty_height < (size_t)layer_set->width * layer_set->height)
+			{
+				*next = MixLayerSetPart(bottom, canvas);
+				cache->cached_generation = cache->generation;
+				cache->dirty_width = cache->dirty_height = 0;
+				return;
+			}
+		}
+		use_cache = TRUE;
+	}
+
 	// レイヤーセットのピクセルデータをリセット
 	(void)memset(layer_set->pixels, 0, pixel_bytes);
 
@@ -112,7 +321,17 @@ void MixLayerSet(LAYER* bottom, LAYER** next, DRAW_WINDOW* canvas)
 			// 可視判定
 			if((blend_layer->flags & LAYER_FLAG_INVISIBLE) == 0)
 			{
-				canvas->layer_blend_functions[blend_mode](blend_layer, layer_set);
+				if(blend_layer->tiles != NULL)
+				{	// タイル形式のレイヤーは不透明なタイルを含む範囲のみ展開して合成
+					BlendTiledLayer(blend_layer, layer_set, blend_mode, canvas);
+				}
+				else
+				{
+					canvas->layer_blend_functions[blend_mode](blend_layer, layer_set);
+				}
+				canvas->temp_layer->alpha = 100;
+				canvas->temp_layer->flags = 0;
+				canvas->temp_layer->prev = NULL;
 			}
 		}
 
@@ -134,6 +353,18 @@ void MixLayerSet(LAYER* bottom, LAYER** next, DRAW_WINDOW* canvas)
 	// サムネイル更新
 	UpdateLayerThumbnail(layer);
 
+	// 作業レイヤーの内容を含む合成結果はキャッシュとして使わない
+	if(use_cache != FALSE)
+	{
+		cache->cache_flags |= LAYER_SET_CACHE_VALID;
+		cache->cached_generation = cache->generation;
+		cache->dirty_width = cache->dirty_height = 0;
+	}
+	else
+	{
+		cache->cache_flags &= ~(LAYER_SET_CACHE_VALID);
+	}
+
 	*next = layer;
 }
 
@@ -212,9 +443,17 @@ void MixLayerSetActiveOver(LAYER* start, LAYER** next, DRAW_WINDOW* canvas)
 				UpdateLayerThumbnail(layer);
 			}	// アクティブレイヤーなら
 					// if(blend_layer == canvas->active_layer)
+			else if(layer->tiles != NULL)
+			{	// タイル形式のレイヤーは不透明なタイルを含む範囲のみ展開して合成
+				BlendTiledLayer(layer, layer_set, blend_mode, canvas);
+				blend_layer = NULL;
+			}
 
 			// 合成する対象と方法が確定したので合成を実行する
-			canvas->layer_blend_functions[blend_mode](blend_layer, layer_set);
+			if(blend_layer != NULL)
+			{
+				canvas->layer_blend_functions[blend_mode](blend_layer, layer_set);
+			}
 			// 合成したらデータを元に戻す
 			canvas->temp_layer->alpha = 100;
 			canvas->temp_layer->flags = 0;
@@ -3,11 +3,24 @@
 
 #include "gui/gui.h"
 
+typedef enum _eLAYER_SET_CACHE_FLAGS
+{
+	LAYER_SET_CACHE_VALID = 0x01
+} eLAYER_SET_CACHE_FLAGS;
+
 typedef struct _LAYER_SET
 {
 	struct _LAYER *active_under;
 	LAYER_SET_WIDGETS *widgets;
 	struct _LAYER_SET *layer_set;
+	// レイヤーセット内が変更される度に増える値と
+		// ピクセルデータの合成結果を作成した時の値
+	unsigned int generation;
+	unsigned int cached_generation;
+	// 前回の合成から変更された範囲
+	int dirty_x, dirty_y;
+	int dirty_width, dirty_height;
+	unsigned int cache_flags;
 } LAYER_SET;
 
 #endif	// #ifndef _INCLUDED_LAYER_SET_H_
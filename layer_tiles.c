@@ -0,0 +1,394 @@
+#include <string.h>
+#include "layer_tiles.h"
+#include "memory.h"
+#include "gui/gui.h"
+
+#ifndef FALSE
+# define FALSE (0)
+#endif
+
+#ifndef TRUE
+# define TRUE (1)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 全てのレイヤーで共有する透明タイル
+static const uint8 g_zero_tile[LAYER_TILE_BYTES] = {0};
+
+/*
+* IsTransparentArea関数
+* 矩形範囲が完全に透明かを判定する
+* 引数
+* pixels	: 判定するピクセルデータの左上
+* stride	: 1行分のバイト数
+* width		: 範囲の幅
+* height	: 範囲の高さ
+* 返り値
+*	透明:TRUE	不透明なピクセル有り:FALSE
+*/
+static int IsTransparentArea(const uint8* pixels, int stride, int width, int height)
+{
+	int x, y;
+
+	// 乗算済みアルファなので全バイトが0かを調べれば良い
+	for(y=0; y<height; y++)
+	{
+		const uint32 *line = (const uint32*)&pixels[y*stride];
+		for(x=0; x<width; x++)
+		{
+			if(line[x] != 0)
+			{
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/*
+* CREATE_LAYER_TILES_DATA構造体
+* タイル形式のデータの作成をスレッドプールで処理するためのデータ
+*/
+typedef struct _CREATE_LAYER_TILES_DATA
+{
+	LAYER_TILES *tiles;
+	const uint8 *pixels;
+	int stride;
+} CREATE_LAYER_TILES_DATA;
+
+/*
+* CreateLayerTile関数
+* スレッドプールから呼び出されて1枚分のタイルを作成する
+* 引数
+* index			: タイルの番号
+* thread_index	: 処理しているスレッドの番号
+* data			: CREATE_LAYER_TILES_DATA構造体のアドレス
+*/
+static void CreateLayerTile(int index, int thread_index, void* data)
+{
+	CREATE_LAYER_TILES_DATA *create = (CREATE_LAYER_TILES_DATA*)data;
+	LAYER_TILES *tiles = create->tiles;
+	int start_x = (index % tiles->tile_columns) * LAYER_TILE_SIZE;
+	int start_y = (index / tiles->tile_columns) * LAYER_TILE_SIZE;
+	int tile_width = (start_x + LAYER_TILE_SIZE > tiles->width) ? tiles->width - start_x : LAYER_TILE_SIZE;
+	int tile_height = (start_y + LAYER_TILE_SIZE > tiles->height) ? tiles->height - start_y : LAYER_TILE_SIZE;
+	const uint8 *source = &create->pixels[start_y * create->stride + start_x * 4];
+	uint8 *tile;
+	int y;
+	(void)thread_index;
+
+	if(IsTransparentArea(source, create->stride, tile_width, tile_height) != FALSE)
+	{
+		return;
+	}
+
+	// 端のタイルもLAYER_TILE_SIZE四方で確保して余白は透明にする
+	tile = (uint8*)MEM_CALLOC_FUNC(1, LAYER_TILE_BYTES);
+	for(y=0; y<tile_height; y++)
+	{
+		(void)memcpy(&tile[y * LAYER_TILE_SIZE * 4], &source[y * create->stride], tile_width * 4);
+	}
+	tiles->tiles[index] = tile;
+}
+
+/*
+* CreateLayerTiles関数
+* ピクセルデータからタイル形式のデータを作成する
+* 引数
+* pixels	: 元のピクセルデータ(NULLなら全て透明)
+* width		: 元のピクセルデータの幅
+* height	: 元のピクセルデータの高さ
+* stride	: 元のピクセルデータの1行分のバイト数
+* 返り値
+*	作成したタイル形式のデータ
+*/
+LAYER_TILES* CreateLayerTiles(const uint8* pixels, int width, int height, int stride)
+{
+	LAYER_TILES *ret = (LAYER_TILES*)MEM_CALLOC_FUNC(1, sizeof(*ret));
+	CREATE_LAYER_TILES_DATA create;
+	int num_tiles;
+	int i;
+
+	ret->width = width,	ret->height = height;
+	ret->tile_columns = (width + LAYER_TILE_SIZE - 1) / LAYER_TILE_SIZE;
+	ret->tile_rows = (height + LAYER_TILE_SIZE - 1) / LAYER_TILE_SIZE;
+	num_tiles = ret->tile_columns * ret->tile_rows;
+	ret->tiles = (uint8**)MEM_CALLOC_FUNC(num_tiles, sizeof(*ret->tiles));
+
+	// 透明なデータは全て共有の透明タイルを使うのでタイルを確保しない
+	if(pixels == NULL)
+	{
+		return ret;
+	}
+
+	create.tiles = ret;
+	create.pixels = pixels;
+	create.stride = stride;
+	ExecuteParallelLoop(num_tiles, CreateLayerTile, &create);
+
+	for(i=0; i<num_tiles; i++)
+	{
+		if(ret->tiles[i] != NULL)
+		{
+			ret->num_allocated++;
+		}
+	}
+
+	return ret;
+}
+
+/*
+* DeleteLayerTiles関数
+* タイル形式のデータを開放する
+* 引数
+* tiles	: 開放するデータのポインタのアドレス
+*/
+void DeleteLayerTiles(LAYER_TILES** tiles)
+{
+	int num_tiles;
+	int i;
+
+	if(tiles == NULL || *tiles == NULL)
+	{
+		return;
+	}
+
+	num_tiles = (*tiles)->tile_columns * (*tiles)->tile_rows;
+	for(i=0; i<num_tiles; i++)
+	{
+		MEM_FREE_FUNC((*tiles)->tiles[i]);
+	}
+	MEM_FREE_FUNC((*tiles)->tiles);
+	MEM_FREE_FUNC(*tiles);
+
+	*tiles = NULL;
+}
+
+/*
+* GetLayerTile関数
+* タイルのピクセルデータを取得する
+* 引数
+* tiles		: タイル形式のデータ
+* column	: タイルの列番号
+* row		: タイルの行番号
+* 返り値
+*	タイルのピクセルデータ(1行LAYER_TILE_SIZE*4バイト)
+*/
+const uint8* GetLayerTile(const LAYER_TILES* tiles, int column, int row)
+{
+	const uint8 *tile = tiles->tiles[row * tiles->tile_columns + column];
+	return (tile != NULL) ? tile : g_zero_tile;
+}
+
+/*
+* LAYER_TILES_EXPAND_DATA構造体
+* タイル形式のデータの展開をスレッドプールで処理するためのデータ
+*/
+typedef struct _LAYER_TILES_EXPAND_DATA
+{
+	const LAYER_TILES *tiles;
+	uint8 *pixels;
+	int stride;
+	int x, y;
+	int width, height;
+	int start_row;
+	int start_column, end_column;
+} LAYER_TILES_EXPAND_DATA;
+
+/*
+* ExpandLayerTilesRow関数
+* スレッドプールから呼び出されて1行分のタイルを展開する
+* 引数
+* index			: 展開する範囲の先頭から数えたタイルの行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: LAYER_TILES_EXPAND_DATA構造体のアドレス
+*/
+static void ExpandLayerTilesRow(int index, int thread_index, void* data)
+{
+	LAYER_TILES_EXPAND_DATA *expand = (LAYER_TILES_EXPAND_DATA*)data;
+	const LAYER_TILES *tiles = expand->tiles;
+	uint8 *pixels = expand->pixels;
+	int stride = expand->stride;
+	int x = expand->x,	y = expand->y;
+	int row = expand->start_row + index;
+	int top = (row * LAYER_TILE_SIZE > y) ? row * LAYER_TILE_SIZE : y;
+	int bottom = ((row + 1) * LAYER_TILE_SIZE < y + expand->height) ? (row + 1) * LAYER_TILE_SIZE : y + expand->height;
+	int column;
+	(void)thread_index;
+
+	for(column=expand->start_column; column<=expand->end_column; column++)
+	{
+		const uint8 *tile = tiles->tiles[row * tiles->tile_columns + column];
+		int left = (column * LAYER_TILE_SIZE > x) ? column * LAYER_TILE_SIZE : x;
+		int right = ((column + 1) * LAYER_TILE_SIZE < x + expand->width) ? (column + 1) * LAYER_TILE_SIZE : x + expand->width;
+		int i;
+
+		if(tile == NULL)
+		{
+			for(i=top; i<bottom; i++)
+			{
+				(void)memset(&pixels[(i - y) * stride + (left - x) * 4], 0, (right - left) * 4);
+			}
+		}
+		else
+		{
+			for(i=top; i<bottom; i++)
+			{
+				(void)memcpy(&pixels[(i - y) * stride + (left - x) * 4],
+					&tile[((i - row * LAYER_TILE_SIZE) * LAYER_TILE_SIZE + left - column * LAYER_TILE_SIZE) * 4],
+						(right - left) * 4);
+			}
+		}
+	}
+}
+
+/*
+* LayerTilesToPixels関数
+* タイル形式のデータの矩形範囲を通常のピクセルデータに展開する
+* 引数
+* tiles		: タイル形式のデータ
+* pixels	: 展開先のピクセルデータ((x, y)に対応する位置)
+* stride	: 展開先の1行分のバイト数
+* x			: 展開する範囲の左上のX座標
+* y			: 展開する範囲の左上のY座標
+* width		: 展開する範囲の幅
+* height	: 展開する範囲の高さ
+*/
+void LayerTilesToPixels(
+	const LAYER_TILES* tiles,
+	uint8* pixels,
+	int stride,
+	int x,
+	int y,
+	int width,
+	int height
+)
+{
+	LAYER_TILES_EXPAND_DATA expand;
+	int end_row;
+
+	if(x < 0)
+	{
+		pixels -= x * 4;
+		width += x;
+		x = 0;
+	}
+	if(y < 0)
+	{
+		pixels -= y * stride;
+		height += y;
+		y = 0;
+	}
+	if(x + width > tiles->width)
+	{
+		width = tiles->width - x;
+	}
+	if(y + height > tiles->height)
+	{
+		height = tiles->height - y;
+	}
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	expand.tiles = tiles;
+	expand.pixels = pixels;
+	expand.stride = stride;
+	expand.x = x,	expand.y = y;
+	expand.width = width,	expand.height = height;
+	expand.start_row = y / LAYER_TILE_SIZE,	end_row = (y + height - 1) / LAYER_TILE_SIZE;
+	expand.start_column = x / LAYER_TILE_SIZE,	expand.end_column = (x + width - 1) / LAYER_TILE_SIZE;
+
+	ExecuteParallelLoop(end_row - expand.start_row + 1, ExpandLayerTilesRow, &expand);
+}
+
+/*
+* LayerTilesMemorySize関数
+* タイル形式のデータが使用しているメモリのバイト数を取得する
+* 引数
+* tiles	: タイル形式のデータ
+* 返り値
+*	使用しているバイト数
+*/
+size_t LayerTilesMemorySize(const LAYER_TILES* tiles)
+{
+	return sizeof(*tiles) + sizeof(*tiles->tiles) * tiles->tile_columns * tiles->tile_rows
+		+ (size_t)LAYER_TILE_BYTES * tiles->num_allocated;
+}
+
+/*
+* GetLayerTilesBounds関数
+* メモリを確保したタイルを全て含む矩形範囲を取得する
+* 引数
+* tiles		: タイル形式のデータ
+* x			: 範囲の左上のX座標を格納するアドレス
+* y			: 範囲の左上のY座標を格納するアドレス
+* width		: 範囲の幅を格納するアドレス
+* height	: 範囲の高さを格納するアドレス
+* 返り値
+*	不透明なタイルがある:TRUE	全て透明:FALSE
+*/
+int GetLayerTilesBounds(const LAYER_TILES* tiles, int* x, int* y, int* width, int* height)
+{
+	int min_column = tiles->tile_columns, min_row = tiles->tile_rows;
+	int max_column = -1, max_row = -1;
+	int row, column;
+
+	if(tiles->num_allocated <= 0)
+	{
+		return FALSE;
+	}
+
+	for(row=0; row<tiles->tile_rows; row++)
+	{
+		for(column=0; column<tiles->tile_columns; column++)
+		{
+			if(tiles->tiles[row * tiles->tile_columns + column] != NULL)
+			{
+				if(column < min_column)
+				{
+					min_column = column;
+				}
+				if(column > max_column)
+				{
+					max_column = column;
+				}
+				if(row < min_row)
+				{
+					min_row = row;
+				}
+				max_row = row;
+			}
+		}
+	}
+
+	if(max_column < 0)
+	{
+		return FALSE;
+	}
+
+	*x = min_column * LAYER_TILE_SIZE;
+	*y = min_row * LAYER_TILE_SIZE;
+	*width = (max_column + 1) * LAYER_TILE_SIZE - *x;
+	*height = (max_row + 1) * LAYER_TILE_SIZE - *y;
+	// 右端・下端のタイルは元の幅・高さまで
+	if(*x + *width > tiles->width)
+	{
+		*width = tiles->width - *x;
+	}
+	if(*y + *height > tiles->height)
+	{
+		*height = tiles->height - *y;
+	}
+
+	return TRUE;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,116 @@
+#ifndef _INCLUDED_LAYER_TILES_H_
+#define _INCLUDED_LAYER_TILES_H_
+
+#include <stddef.h>
+#include "types.h"
+
+// タイルの一辺のピクセル数
+#define LAYER_TILE_SIZE 64
+// タイル1枚分のバイト数
+#define LAYER_TILE_BYTES (LAYER_TILE_SIZE * LAYER_TILE_SIZE * 4)
+
+/*
+* LAYER_TILES構造体
+* レイヤーのピクセルデータをタイル単位で保持する
+*  完全に透明なタイルはメモリを確保せず共有の透明タイルを使う
+*/
+typedef struct _LAYER_TILES
+{
+	// 元のピクセルデータの幅・高さ
+	int width, height;
+	// 横方向・縦方向のタイル数
+	int tile_columns, tile_rows;
+	// タイルのピクセルデータ(NULLは透明タイル)
+	uint8 **tiles;
+	// メモリを確保したタイルの数
+	int num_allocated;
+} LAYER_TILES;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* CreateLayerTiles関数
+* ピクセルデータからタイル形式のデータを作成する
+* 引数
+* pixels	: 元のピクセルデータ(NULLなら全て透明)
+* width		: 元のピクセルデータの幅
+* height	: 元のピクセルデータの高さ
+* stride	: 元のピクセルデータの1行分のバイト数
+* 返り値
+*	作成したタイル形式のデータ
+*/
+EXTERN LAYER_TILES* CreateLayerTiles(const uint8* pixels, int width, int height, int stride);
+
+/*
+* DeleteLayerTiles関数
+* タイル形式のデータを開放する
+* 引数
+* tiles	: 開放するデータのポインタのアドレス
+*/
+EXTERN void DeleteLayerTiles(LAYER_TILES** tiles);
+
+/*
+* GetLayerTile関数
+* タイルのピクセルデータを取得する
+* 引数
+* tiles		: タイル形式のデータ
+* column	: タイルの列番号
+* row		: タイルの行番号
+* 返り値
+*	タイルのピクセルデータ(1行LAYER_TILE_SIZE*4バイト)
+*/
+EXTERN const uint8* GetLayerTile(const LAYER_TILES* tiles, int column, int row);
+
+/*
+* LayerTilesToPixels関数
+* タイル形式のデータの矩形範囲を通常のピクセルデータに展開する
+* 引数
+* tiles		: タイル形式のデータ
+* pixels	: 展開先のピクセルデータ((x, y)に対応する位置)
+* stride	: 展開先の1行分のバイト数
+* x			: 展開する範囲の左上のX座標
+* y			: 展開する範囲の左上のY座標
+* width		: 展開する範囲の幅
+* height	: 展開する範囲の高さ
+*/
+EXTERN void LayerTilesToPixels(
+	const LAYER_TILES* tiles,
+	uint8* pixels,
+	int stride,
+	int x,
+	int y,
+	int width,
+	int height
+);
+
+/*
+* LayerTilesMemorySize関数
+* タイル形式のデータが使用しているメモリのバイト数を取得する
+* 引数
+* tiles	: タイル形式のデータ
+* 返り値
+*	使用しているバイト数
+*/
+EXTERN size_t LayerTilesMemorySize(const LAYER_TILES* tiles);
+
+/*
+* GetLayerTilesBounds関数
+* メモリを確保したタイルを全て含む矩形範囲を取得する
+* 引数
+* tiles		: タイル形式のデータ
+* x			: 範囲の左上のX座標を格納するアドレス
+* y			: 範囲の左上のY座標を格納するアドレス
+* width		: 範囲の幅を格納するアドレス
+* height	: 範囲の高さを格納するアドレス
+* 返り値
+*	不透明なタイルがある:TRUE	全て透明:FALSE
+*/
+EXTERN int GetLayerTilesBounds(const LAYER_TILES* tiles, int* x, int* y, int* width, int* height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _INCLUDED_LAYER_TILES_H_
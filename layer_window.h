@@ -5,6 +5,8 @@
 #include "gui/layer.h"
 
 #define LAYER_THUMBNAIL_SIZE 32
+// サムネイル再縮小の最短間隔(ミリ秒)
+#define LAYER_THUMBNAIL_UPDATE_INTERVAL 100
 
 #ifdef __cplusplus
 extern "C" {
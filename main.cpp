@@ -1,3 +1,4 @@
+#include <string.h>
 #include "application.h"
 
 #include <QDir>
@@ -31,6 +32,16 @@ int main(int argc, char *argv[])
 	app.fractal_labels = &fractal_labels;
 	QString path = QDir::currentPath();
 	char *init_file_path = (char*)"";
+
+	if(argc > 1 && strcmp(argv[1], "--replay-stroke") == 0)
+	{
+		return ExecuteStrokeReplayMode(&app, argv, argc);
+	}
+	if(argc > 1 && strcmp(argv[1], "--batch-export") == 0)
+	{
+		return ExecuteBatchExportMode(&app, argv, argc);
+	}
+
 	InitializeApplication(&app, argv, argc, init_file_path);
 
 	return 0;
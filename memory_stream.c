@@ -3,14 +3,27 @@
 #include "memory.h"
 #include "memory_stream.h"
 
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
 // C++でコンパイルする際のエラー回避
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// バッファを拡張する際の最小の容量
+#define MEMORY_STREAM_MINIMUM_GROW_SIZE 4096
+
 /*********************************************************
 * CreateMemoryStream関数								 *
 * メモリの読み書きを管理する構造体のメモリの確保と初期化 *
+*  バッファは0クリアしない(終端の1バイトのみ0にする)	*
 * 引数												   *
 * buff_size	: 確保するバッファのサイズ				   *
 * 返り値												 *
@@ -47,17 +60,258 @@ MEMORY_STREAM_PTR CreateMemoryStream(
 		return NULL;
 	}
 
-	// バッファを0クリアしておく
-	(void)memset(ret->buff_ptr, 0, buff_size+1);
+	// 書き込まれる部分は0クリアせず、文字列として読めるよう終端のみ0にする
+	ret->buff_ptr[buff_size] = 0;
 
 	// 各種変数の設定
 	ret->data_point = 0;
 	ret->data_size = buff_size;
 	ret->block_size = buff_size;
+	ret->flags = 0;
+
+	return ret;
+}
+
+/*********************************************************
+* CreateMemoryStreamForBuffer関数						*
+* 外部で確保したバッファをコピーせずに扱う構造体を作成   *
+*  DeleteMemoryStreamでバッファは開放しない			 *
+*  容量を超えて書き込んだ場合は新しいバッファに複製する *
+* 引数												   *
+* buffer	: 扱うバッファ							   *
+* size		: バッファのバイト数						 *
+* 返り値												 *
+*	初期化された構造体のアドレス						 *
+*********************************************************/
+MEMORY_STREAM_PTR CreateMemoryStreamForBuffer(
+	void* buffer,
+	size_t size
+)
+{
+	MEMORY_STREAM_PTR ret =
+		(MEMORY_STREAM_PTR)MEM_ALLOC_FUNC(sizeof(MEMORY_STREAM));
+
+	if(ret == NULL)
+	{
+		return NULL;
+	}
+
+	InitializeMemoryStreamView(ret, buffer, size);
 
 	return ret;
 }
 
+/*****************************************************
+* GrowMemoryStream関数								*
+* バッファを倍々に拡張する							 *
+*  外部のバッファは開放せずに新しいバッファへ複製する *
+* 引数											   *
+* mem			: 拡張するメモリストリーム		   *
+* required_size	: 必要な容量(バイト)				 *
+* 返り値											 *
+*	成功(0)、失敗(0以外)							*
+*****************************************************/
+static int GrowMemoryStream(MEMORY_STREAM_PTR mem, size_t required_size)
+{
+	size_t new_size = mem->data_size * 2;
+	unsigned char *buffer;
+
+	if(new_size < mem->data_size + mem->block_size)
+	{
+		new_size = mem->data_size + mem->block_size;
+	}
+	if(new_size < MEMORY_STREAM_MINIMUM_GROW_SIZE)
+	{
+		new_size = MEMORY_STREAM_MINIMUM_GROW_SIZE;
+	}
+	if(new_size < required_size)
+	{
+		new_size = required_size;
+	}
+
+	if((mem->flags & MEMORY_STREAM_EXTERNAL_BUFFER) != 0)
+	{
+		if((buffer = (unsigned char*)MEM_ALLOC_FUNC(new_size+1)) == NULL)
+		{
+			return 1;
+		}
+		(void)memcpy(buffer, mem->buff_ptr, mem->data_size);
+		mem->flags &= ~MEMORY_STREAM_EXTERNAL_BUFFER;
+	}
+	else if((buffer = (unsigned char*)MEM_REALLOC_FUNC(mem->buff_ptr, new_size+1)) == NULL)
+	{
+		return 1;
+	}
+
+	buffer[new_size] = 0;
+	mem->buff_ptr = buffer;
+	mem->data_size = new_size;
+
+	return 0;
+}
+
+/*****************************************************
+* MemReserve関数									 *
+* 書き込み前にバッファの容量を確保しておく		   *
+* 引数											   *
+* mem	: メモリを読み書きを管理する構造体のアドレス *
+* size	: 必要な容量(バイト)						 *
+* 返り値											 *
+*	成功(0)、失敗(0以外)							*
+*****************************************************/
+int MemReserve(MEMORY_STREAM_PTR mem, size_t size)
+{
+	if(size <= mem->data_size)
+	{
+		return 0;
+	}
+
+	return GrowMemoryStream(mem, size);
+}
+
+/*********************************************************
+* InitializeMemoryStreamView関数						 *
+* 既存のデータを読み込み専用で参照するストリームを初期化 *
+*  データのコピーも開放もしない						   *
+* 引数												   *
+* mem	: 初期化する構造体のアドレス					 *
+* data	: 参照するデータ								 *
+* size	: データのバイト数							   *
+*********************************************************/
+void InitializeMemoryStreamView(
+	MEMORY_STREAM_PTR mem,
+	const void* data,
+	size_t size
+)
+{
+	mem->buff_ptr = (unsigned char*)data;
+	mem->data_point = 0;
+	mem->data_size = size;
+	mem->block_size = size;
+	mem->flags = MEMORY_STREAM_EXTERNAL_BUFFER;
+}
+
+/*****************************************************
+* MapFileToMemory関数								*
+* ファイルを読み込み専用でメモリにマップする		 *
+*  マップできない場合はメモリに読み込む			 *
+* 引数											   *
+* mapping	: マップした内容を受け取るアドレス	   *
+* file_path	: ファイルのパス						 *
+* 返り値											 *
+*	成功(0)、失敗(0以外)							*
+*****************************************************/
+int MapFileToMemory(FILE_MAPPING* mapping, const char* file_path)
+{
+	FILE *fp;
+
+	(void)memset(mapping, 0, sizeof(*mapping));
+
+#if defined(_WIN32)
+	{
+		LARGE_INTEGER file_size;
+		HANDLE file = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(file == INVALID_HANDLE_VALUE)
+		{
+			return 1;
+		}
+		if(GetFileSizeEx(file, &file_size) != FALSE && file_size.QuadPart > 0)
+		{
+			HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if(file_mapping != NULL)
+			{
+				mapping->data = (unsigned char*)MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+				if(mapping->data != NULL)
+				{
+					mapping->size = (size_t)file_size.QuadPart;
+					mapping->handle = (void*)file;
+					mapping->mapping = (void*)file_mapping;
+					return 0;
+				}
+				(void)CloseHandle(file_mapping);
+			}
+		}
+		(void)CloseHandle(file);
+	}
+#else
+	{
+		struct stat status;
+		int file = open(file_path, O_RDONLY);
+		if(file < 0)
+		{
+			return 1;
+		}
+		if(fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			void *data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if(data != MAP_FAILED)
+			{
+				// マップした後はファイルを閉じても参照できる
+				(void)close(file);
+				mapping->data = (unsigned char*)data;
+				mapping->size = (size_t)status.st_size;
+				return 0;
+			}
+		}
+		(void)close(file);
+	}
+#endif
+
+	// マップできなかったのでメモリに読み込む
+	if((fp = fopen(file_path, "rb")) == NULL)
+	{
+		return 1;
+	}
+	(void)fseek(fp, 0, SEEK_END);
+	mapping->size = (size_t)ftell(fp);
+	rewind(fp);
+	mapping->data = (unsigned char*)MEM_ALLOC_FUNC(mapping->size + 1);
+	if(mapping->data == NULL
+		|| fread(mapping->data, 1, mapping->size, fp) != mapping->size)
+	{
+		MEM_FREE_FUNC(mapping->data);
+		(void)fclose(fp);
+		(void)memset(mapping, 0, sizeof(*mapping));
+		return 1;
+	}
+	(void)fclose(fp);
+	mapping->allocated = 1;
+
+	return 0;
+}
+
+/*****************************************************
+* UnmapFileFromMemory関数							*
+* MapFileToMemoryでマップしたファイルを開放する	  *
+* 引数											   *
+* mapping	: 開放するマップ						 *
+*****************************************************/
+void UnmapFileFromMemory(FILE_MAPPING* mapping)
+{
+	if(mapping->data == NULL)
+	{
+		return;
+	}
+
+	if(mapping->allocated != 0)
+	{
+		MEM_FREE_FUNC(mapping->data);
+	}
+	else
+	{
+#if defined(_WIN32)
+		(void)UnmapViewOfFile(mapping->data);
+		(void)CloseHandle((HANDLE)mapping->mapping);
+		(void)CloseHandle((HANDLE)mapping->handle);
+#else
+		(void)munmap(mapping->data, mapping->size);
+#endif
+	}
+
+	(void)memset(mapping, 0, sizeof(*mapping));
+}
+
 /*****************************************************
 * DeleteMemoryStream関数							 *
 * メモリの読み書きを管理する構造体のメモリを開放	 *
@@ -70,7 +324,10 @@ int DeleteMemoryStream(MEMORY_STREAM_PTR mem)
 {
 	if(mem != NULL)
 	{
-		MEM_FREE_FUNC(mem->buff_ptr);
+		if((mem->flags & MEMORY_STREAM_EXTERNAL_BUFFER) == 0)
+		{
+			MEM_FREE_FUNC(mem->buff_ptr);
+		}
 		MEM_FREE_FUNC(mem);
 	}
 
@@ -145,33 +402,21 @@ size_t MemWrite(
 	// 書き込みを要求されたバイト数
 	size_t required_size = block_size * block_num;
 
-	// 実際に書き込んだバイト数、ブロック数
-	size_t write_size;
-
-	// 要求されたバイト数書き込んでもバッファの終端に到達しないなら
-	if(required_size + mem->data_point <= mem->data_size)
-	{
-		// 要求されたバイト数分書き込む(コピーする)
-		write_size = required_size;
-	}
-	else
+	// バッファの終端に到達してしまうなら
+	// 容量を倍々に拡張する(書き込み回数に対して償却定数時間)
+	if(required_size + mem->data_point > mem->data_size)
 	{
-		// バッファの終端に到達してしまうので
-		// バッファを確保しなおし
-		unsigned char* temp = (unsigned char*)MEM_ALLOC_FUNC(
-			mem->data_size + mem->block_size + (required_size / mem->block_size) * mem->block_size);
-		(void)memcpy(temp, mem->buff_ptr, mem->data_size);
-		(void)memset(&temp[mem->data_size], 0, mem->block_size);
-		MEM_FREE_FUNC(mem->buff_ptr);
-		mem->buff_ptr = temp;
-		mem->data_size += mem->block_size + (required_size / mem->block_size) * mem->block_size;
-		write_size = required_size;
+		if(GrowMemoryStream(mem, mem->data_point + required_size) != 0)
+		{
+			return 0;
+		}
 	}
 
-	(void)memcpy(&mem->buff_ptr[mem->data_point], src, write_size);
+	// 要求されたバイト数分書き込む(コピーする)
+	(void)memcpy(&mem->buff_ptr[mem->data_point], src, required_size);
 
 	// データの参照位置を更新
-	mem->data_point += write_size;
+	mem->data_point += required_size;
 
 	return block_num;
 }
@@ -22,18 +22,42 @@ extern "C" {
 # define EXTERN extern
 #endif
 
+/*
+* eMEMORY_STREAM_FLAGS列挙体
+* メモリストリームの状態を表すフラグ
+*/
+typedef enum _eMEMORY_STREAM_FLAGS
+{
+	MEMORY_STREAM_EXTERNAL_BUFFER = 0x01	// バッファは外部の所有(開放せず、拡張時は複製する)
+} eMEMORY_STREAM_FLAGS;
+
 typedef struct _MEMORY_STREAM
 {
 	unsigned char* buff_ptr;	// バッファ
 	size_t data_point;			// データの参照位置
 	size_t data_size;			// データの容量
-	size_t block_size;			// 書き込み時の確保ブロック容量
+	size_t block_size;			// 書き込み時に最低限拡張する容量
+	unsigned int flags;			// eMEMORY_STREAM_FLAGSの組み合わせ
 } MEMORY_STREAM, *MEMORY_STREAM_PTR;
 
+/*
+* FILE_MAPPING構造体
+* メモリにマップしたファイルの内容
+*/
+typedef struct _FILE_MAPPING
+{
+	unsigned char* data;		// ファイルの内容
+	size_t size;				// ファイルのバイト数
+	void* handle;				// ファイルのハンドル(Windows)
+	void* mapping;				// マッピングのハンドル(Windows)
+	int allocated;				// マップできずにメモリへ読み込んだ場合は0以外
+} FILE_MAPPING;
+
 // 関数のプロトタイプ宣言
 /*********************************************************
 * CreateMemoryStream関数								 *
 * メモリの読み書きを管理する構造体のメモリの確保と初期化 *
+*  バッファは0クリアしない(終端の1バイトのみ0にする)	*
 * 引数												   *
 * buff_size	: 確保するバッファのサイズ				   *
 * 返り値												 *
@@ -43,6 +67,68 @@ EXTERN MEMORY_STREAM_PTR CreateMemoryStream(
 	size_t buff_size
 );
 
+/*********************************************************
+* CreateMemoryStreamForBuffer関数						*
+* 外部で確保したバッファをコピーせずに扱う構造体を作成   *
+*  DeleteMemoryStreamでバッファは開放しない			 *
+*  容量を超えて書き込んだ場合は新しいバッファに複製する *
+* 引数												   *
+* buffer	: 扱うバッファ							   *
+* size		: バッファのバイト数						 *
+* 返り値												 *
+*	初期化された構造体のアドレス						 *
+*********************************************************/
+EXTERN MEMORY_STREAM_PTR CreateMemoryStreamForBuffer(
+	void* buffer,
+	size_t size
+);
+
+/*****************************************************
+* MemReserve関数									 *
+* 書き込み前にバッファの容量を確保しておく		   *
+* 引数											   *
+* mem	: メモリを読み書きを管理する構造体のアドレス *
+* size	: 必要な容量(バイト)						 *
+* 返り値											 *
+*	成功(0)、失敗(0以外)							*
+*****************************************************/
+EXTERN int MemReserve(MEMORY_STREAM_PTR mem, size_t size);
+
+/*********************************************************
+* InitializeMemoryStreamView関数						 *
+* 既存のデータを読み込み専用で参照するストリームを初期化 *
+*  データのコピーも開放もしない						   *
+* 引数												   *
+* mem	: 初期化する構造体のアドレス					 *
+* data	: 参照するデータ								 *
+* size	: データのバイト数							   *
+*********************************************************/
+EXTERN void InitializeMemoryStreamView(
+	MEMORY_STREAM_PTR mem,
+	const void* data,
+	size_t size
+);
+
+/*****************************************************
+* MapFileToMemory関数								*
+* ファイルを読み込み専用でメモリにマップする		 *
+*  マップできない場合はメモリに読み込む			 *
+* 引数											   *
+* mapping	: マップした内容を受け取るアドレス	   *
+* file_path	: ファイルのパス						 *
+* 返り値											 *
+*	成功(0)、失敗(0以外)							*
+*****************************************************/
+EXTERN int MapFileToMemory(FILE_MAPPING* mapping, const char* file_path);
+
+/*****************************************************
+* UnmapFileFromMemory関数							*
+* MapFileToMemoryでマップしたファイルを開放する	  *
+* 引数											   *
+* mapping	: 開放するマップ						 *
+*****************************************************/
+EXTERN void UnmapFileFromMemory(FILE_MAPPING* mapping);
+
 /*****************************************************
 * DeleteMemoryStream関数							 *
 * メモリの読み書きを管理する構造体のメモリを開放	 *
@@ -7,8 +7,5 @@ int luaopen_lcairo(void* dummy)
 void DeleteLayerSet(void* layer)
 {}
 
-void DeleteAdjustmentLayer(void* layer)
-{}
-
 void ReadLayerData(void)
 {}
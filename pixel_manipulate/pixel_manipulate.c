@@ -767,6 +767,12 @@ void InitializePixelManipulate(PIXEL_MANIPULATE* pixel_manipulate)
 	pixel_manipulate->implementation = *imp;
 }
 
+void ReleasePixelManipulate(PIXEL_MANIPULATE* pixel_manipulate)
+{
+	PixelManipulateImplementationDestroy(pixel_manipulate->implementation.top_level);
+	(void)memset(&pixel_manipulate->implementation, 0, sizeof(pixel_manipulate->implementation));
+}
+
 #ifdef __cplusplus
 }
 #endif
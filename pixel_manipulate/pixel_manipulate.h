@@ -401,6 +401,7 @@ static int PixelManipulateImageUnreference(PIXEL_MANIPULATE_IMAGE* image)
 }
 
 extern void InitializePixelManipulate(PIXEL_MANIPULATE* pixel_manipulate);
+extern void ReleasePixelManipulate(PIXEL_MANIPULATE* pixel_manipulate);
 extern void PixelManipulateSetupAccessors(PIXEL_MANIPULATE_BITS_IMAGE* image);
 extern INLINE void PixelManipulateResetClipRegion(PIXEL_MANIPULATE_IMAGE* image);
 extern int PixelManipulateImageInitialize(
@@ -11,12 +11,18 @@ extern "C" {
 
 static PIXEL_MANIPULATE_IMPLEMENTATION* GetImplementation(void)
 {
-	static PIXEL_MANIPULATE_IMPLEMENTATION *implementation = NULL;
+	static PIXEL_MANIPULATE_IMPLEMENTATION *volatile implementation = NULL;
 
 	if(implementation == NULL)
 	{
-		implementation = PixelManipulateImplementationCreateGeneral();
-		implementation = PixelManipulateX86GetImplementations(implementation);
+		PIXEL_MANIPULATE_IMPLEMENTATION *created;
+		created = PixelManipulateImplementationCreateGeneral();
+		created = PixelManipulateX86GetImplementations(created);
+		// another thread may have set it up first
+		if(FALSE == ATOMIC_COMPARE_EXCHANGE_POINTER(&implementation, NULL, created))
+		{
+			PixelManipulateImplementationDestroy(created);
+		}
 	}
 
 	return implementation;
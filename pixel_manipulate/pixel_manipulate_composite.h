@@ -126,6 +126,7 @@ typedef struct _PIXEL_MANIPULATE_IMPLEMENTATION
 	struct _PIXEL_MANIPULATE_IMPLEMENTATION *top_level;
 	struct _PIXEL_MANIPULATE_IMPLEMENTATION *fallback;
 	const PIXEL_MANIPULATE_FAST_PATH *fast_paths;
+	unsigned int serial;
 	const PIXEL_MANIPULATE_ITERATION_INFO *iteration_info;
 
 	pixel_manipulate_block_transfer_function block_transfer;
@@ -188,6 +189,7 @@ extern uint32* PixelManipulateIteraterationInitializeBitsStride(
 );
 
 extern PIXEL_MANIPULATE_IMPLEMENTATION* PixelManipulateImplementationCreate(PIXEL_MANIPULATE_IMPLEMENTATION* fallback, const PIXEL_MANIPULATE_FAST_PATH* fast_paths);
+extern void PixelManipulateImplementationDestroy(PIXEL_MANIPULATE_IMPLEMENTATION* implementation);
 
 extern void PixelManipulateImplementationIterationInitialize(
 	PIXEL_MANIPULATE_IMPLEMENTATION* implementation,
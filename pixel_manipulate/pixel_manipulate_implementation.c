@@ -14,6 +14,8 @@ typedef struct _CACHE
 {
 	struct
 	{
+		PIXEL_MANIPULATE_IMPLEMENTATION *top_level;
+		unsigned int serial;
 		PIXEL_MANIPULATE_IMPLEMENTATION *implementation;
 		PIXEL_MANIPULATE_FAST_PATH fast_path;
 	} cache[NUM_CACHED_FAST_PATHS];
@@ -37,7 +39,7 @@ void PixelManipulateImplementationLookupComposite(
 	pixel_manipulate_composite_function* out_function
 )
 {
-	static CACHE fast_path_cache;
+	static THREAD_LOCAL CACHE fast_path_cache;
 	PIXEL_MANIPULATE_IMPLEMENTATION *implementation;
 	CACHE *cache;
 	int i;
@@ -48,7 +50,8 @@ void PixelManipulateImplementationLookupComposite(
 	{
 		const PIXEL_MANIPULATE_FAST_PATH *info = &(cache->cache[i].fast_path);
 
-		if(info->op == op
+		if(cache->cache[i].top_level == top_level
+			&& info->op == op
 			&& info->src_format == src_format
 			&& info->mask_format == mask_format
 			&& info->dest_format == dest_format
@@ -56,6 +59,7 @@ void PixelManipulateImplementationLookupComposite(
 			&& info->mask_flags == mask_flags
 			&& info->dest_flags == dest_flags
 			&& info->function != NULL
+			&& cache->cache[i].serial == top_level->serial
 		)
 		{
 			*out_implementation = cache->cache[i].implementation;
@@ -107,6 +111,8 @@ update_cache:
 			cache->cache[i + 1] = cache->cache[i];
 		}
 
+		cache->cache[0].top_level = top_level;
+		cache->cache[0].serial = top_level->serial;
 		cache->cache[0].implementation = *out_implementation;
 		cache->cache[0].fast_path.op = op;
 		cache->cache[0].fast_path.src_format = src_format;
@@ -186,6 +192,7 @@ void PixelManipulateImplementationIterationInitialize(
 
 PIXEL_MANIPULATE_IMPLEMENTATION* PixelManipulateImplementationCreate(PIXEL_MANIPULATE_IMPLEMENTATION* fallback, const PIXEL_MANIPULATE_FAST_PATH* fast_paths)
 {
+	static volatile unsigned int serial = 0;
 	PIXEL_MANIPULATE_IMPLEMENTATION *implementation;
 
 	if((implementation = (PIXEL_MANIPULATE_IMPLEMENTATION*)MEM_ALLOC_FUNC(sizeof(*implementation))))
@@ -196,6 +203,7 @@ PIXEL_MANIPULATE_IMPLEMENTATION* PixelManipulateImplementationCreate(PIXEL_MANIP
 
 		implementation->fallback = fallback;
 		implementation->fast_paths = fast_paths;
+		implementation->serial = (unsigned int)ATOMIC_INCREMENT(&serial);
 
 		for(d = implementation; d != NULL; d = d->fallback)
 		{
@@ -206,6 +214,16 @@ PIXEL_MANIPULATE_IMPLEMENTATION* PixelManipulateImplementationCreate(PIXEL_MANIP
 	return implementation;
 }
 
+void PixelManipulateImplementationDestroy(PIXEL_MANIPULATE_IMPLEMENTATION* implementation)
+{
+	while(implementation != NULL)
+	{
+		PIXEL_MANIPULATE_IMPLEMENTATION *fallback = implementation->fallback;
+		MEM_FREE_FUNC(implementation);
+		implementation = fallback;
+	}
+}
+
 int PixelManipulateImplementationFill(
 	PIXEL_MANIPULATE_IMPLEMENTATION* imp,
 	uint32* bits,
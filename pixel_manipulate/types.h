@@ -84,6 +84,27 @@ typedef int (*seek_func_t)(void*, long, int);
 # endif
 #endif
 
+#ifndef THREAD_LOCAL
+# ifdef _MSC_VER
+#  define THREAD_LOCAL __declspec(thread)
+# else
+#  define THREAD_LOCAL __thread
+# endif
+#endif
+
+#ifndef ATOMIC_COMPARE_EXCHANGE_POINTER
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  define ATOMIC_COMPARE_EXCHANGE_POINTER(DESTINATION, COMPARE, EXCHANGE) \
+	(_InterlockedCompareExchangePointer((void* volatile*)(DESTINATION), (void*)(EXCHANGE), (void*)(COMPARE)) == (void*)(COMPARE))
+#  define ATOMIC_INCREMENT(VALUE) _InterlockedIncrement((volatile long*)(VALUE))
+# else
+#  define ATOMIC_COMPARE_EXCHANGE_POINTER(DESTINATION, COMPARE, EXCHANGE) \
+	__sync_bool_compare_and_swap((DESTINATION), (COMPARE), (EXCHANGE))
+#  define ATOMIC_INCREMENT(VALUE) __sync_add_and_fetch((VALUE), 1)
+# endif
+#endif
+
 #ifndef FALSE
 # define FALSE (0)
 #endif
@@ -0,0 +1,338 @@
+// Visual Studio 2005以降では古いとされる関数を使用するので
+	// 警告が出ないようにする
+#if defined _MSC_VER && _MSC_VER >= 1400
+# define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include "stroke_replay.h"
+#include "application.h"
+#include "display.h"
+#include "utils.h"
+#include "memory.h"
+
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// イベントを確保する単位
+#define STROKE_REPLAY_BUFFER_SIZE 1024
+// 1行の最大文字数
+#define STROKE_REPLAY_LINE_LENGTH 256
+
+/*
+* GetStrokeReplayTime関数
+* 計測用に単調増加する現在時刻を取得する
+* 返り値
+*	現在時刻(秒)
+*/
+double GetStrokeReplayTime(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+	(void)QueryPerformanceFrequency(&frequency);
+	(void)QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1.0e-9;
+#endif
+}
+
+/*
+* ReadStrokeReplayFile関数
+* 入力イベントを記録したテキストファイルを読み込む
+*  1行に「種類(p/m/r) X座標 Y座標 筆圧 時刻(ミリ秒) [pen/eraser/mouse]」を書く
+*  #で始まる行は無視する
+* 引数
+* file_path	: 読み込むファイルのパス
+* 返り値
+*	読み込んだデータ(DeleteStrokeReplayで開放する) 失敗時はNULL
+*/
+STROKE_REPLAY* ReadStrokeReplayFile(const char* file_path)
+{
+	STROKE_REPLAY *ret;
+	FILE *fp;
+	char line[STROKE_REPLAY_LINE_LENGTH];
+	int buffer_size = STROKE_REPLAY_BUFFER_SIZE;
+	int pressed = FALSE;
+	int line_number = 0;
+
+	if((fp = fopen(file_path, "r")) == NULL)
+	{
+		return NULL;
+	}
+
+	ret = (STROKE_REPLAY*)MEM_CALLOC_FUNC(1, sizeof(*ret));
+	ret->events = (STROKE_REPLAY_EVENT*)MEM_ALLOC_FUNC(sizeof(*ret->events) * buffer_size);
+
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		STROKE_REPLAY_EVENT *event;
+		char type;
+		char device[16] = "pen";
+		double x, y, pressure;
+		unsigned int event_time;
+
+		line_number++;
+		if(line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+		{
+			continue;
+		}
+		if(sscanf(line, " %c %lf %lf %lf %u %15s", &type, &x, &y, &pressure, &event_time, device) < 5)
+		{
+			(void)fprintf(stderr, "%s:%d: invalid event\n", file_path, line_number);
+			continue;
+		}
+
+		if(ret->num_events >= buffer_size)
+		{
+			buffer_size *= 2;
+			ret->events = (STROKE_REPLAY_EVENT*)MEM_REALLOC_FUNC(ret->events,
+				sizeof(*ret->events) * buffer_size);
+		}
+		event = &ret->events[ret->num_events];
+
+		switch(type)
+		{
+		case 'p':
+			event->type = STROKE_REPLAY_EVENT_PRESS;
+			pressed = TRUE;
+			break;
+		case 'm':
+			event->type = STROKE_REPLAY_EVENT_MOTION;
+			break;
+		case 'r':
+			event->type = STROKE_REPLAY_EVENT_RELEASE;
+			pressed = FALSE;
+			break;
+		default:
+			(void)fprintf(stderr, "%s:%d: unknown event type '%c'\n", file_path, line_number, type);
+			continue;
+		}
+
+		event->state.cursor_x = x,	event->state.cursor_y = y;
+		event->state.pressure = pressure;
+		event->state.event_time = (uint32)event_time;
+		// 押している間と離した瞬間は左ボタンが押されている状態にする
+		event->state.mouse_key_flag = (pressed != FALSE || type == 'r') ? MOUSE_KEY_FLAG_LEFT : 0;
+		if(StringCompareIgnoreCase(device, "eraser") == 0)
+		{
+			event->state.input_device = CURSOR_INPUT_DEVICE_ERASER;
+		}
+		else if(StringCompareIgnoreCase(device, "mouse") == 0)
+		{
+			event->state.input_device = CURSOR_INPUT_DEVICE_MOUSE;
+		}
+		else
+		{
+			event->state.input_device = CURSOR_INPUT_DEVICE_PEN;
+		}
+		ret->num_events++;
+	}
+
+	(void)fclose(fp);
+
+	if(ret->num_events == 0)
+	{
+		DeleteStrokeReplay(&ret);
+		return NULL;
+	}
+
+	ret->event_times = (double*)MEM_CALLOC_FUNC(ret->num_events, sizeof(*ret->event_times));
+	// 画面更新はイベント毎に最大1回
+	ret->frame_times = (double*)MEM_CALLOC_FUNC(ret->num_events, sizeof(*ret->frame_times));
+
+	return ret;
+}
+
+/*
+* DeleteStrokeReplay関数
+* 入力イベントの再生データを開放する
+* 引数
+* replay	: 開放するデータのポインタのアドレス
+*/
+void DeleteStrokeReplay(STROKE_REPLAY** replay)
+{
+	if(replay == NULL || *replay == NULL)
+	{
+		return;
+	}
+
+	MEM_FREE_FUNC((*replay)->events);
+	MEM_FREE_FUNC((*replay)->event_times);
+	MEM_FREE_FUNC((*replay)->frame_times);
+	MEM_FREE_FUNC(*replay);
+	*replay = NULL;
+}
+
+/*
+* StrokeReplayCanvasToWidget関数
+* キャンバス上の座標を描画領域ウィジェット上の座標に変換する
+*  (マウスイベントの処理で行う回転・拡大縮小の逆変換)
+* 引数
+* canvas	: 描画するキャンバス
+* state		: 座標を変換するイベント
+*/
+static void StrokeReplayCanvasToWidget(DRAW_WINDOW* canvas, EVENT_STATE* state)
+{
+	FLOAT_T x = state->cursor_x;
+	FLOAT_T dx, dy;
+
+	if((canvas->flags & DRAW_WINDOW_DISPLAY_HORIZON_REVERSE) != 0)
+	{
+		x = canvas->width - x;
+	}
+
+	dx = x * canvas->zoom_rate - canvas->add_cursor_x;
+	dy = state->cursor_y * canvas->zoom_rate - canvas->add_cursor_y;
+	state->cursor_x = dx * canvas->cos_value + dy * canvas->sin_value + canvas->half_size;
+	state->cursor_y = - dx * canvas->sin_value + dy * canvas->cos_value + canvas->half_size;
+}
+
+/*
+* ExecuteStrokeReplayFrame関数
+* 一定間隔の画面更新(モーション待ち行列の処理とレイヤー合成)を行う
+* 引数
+* replay	: 計測結果を記録するデータ
+* canvas	: 描画するキャンバス
+*/
+static void ExecuteStrokeReplayFrame(STROKE_REPLAY* replay, DRAW_WINDOW* canvas)
+{
+	APPLICATION *app = canvas->app;
+	double history_time = replay->history_time;
+	double start_time, display_start_time, end_time;
+
+	start_time = GetStrokeReplayTime();
+	if(app->tool_box.motion_queue.num_items > 0)
+	{
+		ExecuteMotionQueue(canvas);
+	}
+	display_start_time = GetStrokeReplayTime();
+	(void)LayerBlendForDisplay(canvas);
+	end_time = GetStrokeReplayTime();
+
+	replay->brush_time += (display_start_time - start_time) - (replay->history_time - history_time);
+	replay->display_time += end_time - display_start_time;
+	replay->frame_times[replay->num_frames] = end_time - start_time;
+	replay->num_frames++;
+}
+
+/*
+* ExecuteStrokeReplay関数
+* 記録された入力イベントをマウスイベントと同じ経路で再生して処理時間を計測する
+*  画面更新はイベントの時刻で一定間隔毎に行う
+* 引数
+* replay	: 再生するデータ(計測結果もここに入る)
+* canvas	: 描画するキャンバス
+*/
+void ExecuteStrokeReplay(STROKE_REPLAY* replay, DRAW_WINDOW* canvas)
+{
+	APPLICATION *app = canvas->app;
+	uint32 last_frame_time = replay->events[0].state.event_time;
+	double replay_start_time;
+	int i;
+
+	replay->brush_time = replay->history_time = replay->display_time = 0;
+	replay->num_frames = 0;
+	app->stroke_replay = replay;
+
+	replay_start_time = GetStrokeReplayTime();
+	for(i=0; i<replay->num_events; i++)
+	{
+		EVENT_STATE state = replay->events[i].state;
+		double history_time = replay->history_time;
+		double start_time, elapsed;
+
+		StrokeReplayCanvasToWidget(canvas, &state);
+
+		start_time = GetStrokeReplayTime();
+		switch(replay->events[i].type)
+		{
+		case STROKE_REPLAY_EVENT_PRESS:
+			MouseButtonPressEvent(canvas, &state);
+			break;
+		case STROKE_REPLAY_EVENT_MOTION:
+			(void)MouseMotionNotifyEvent(canvas, &state);
+			break;
+		case STROKE_REPLAY_EVENT_RELEASE:
+			MouseButtonReleaseEvent(canvas, &state);
+			break;
+		}
+		elapsed = GetStrokeReplayTime() - start_time;
+
+		replay->event_times[i] = elapsed;
+		replay->brush_time += elapsed - (replay->history_time - history_time);
+
+		if(replay->events[i].type == STROKE_REPLAY_EVENT_RELEASE
+			|| state.event_time - last_frame_time >= STROKE_REPLAY_FRAME_MILLISECONDS)
+		{
+			ExecuteStrokeReplayFrame(replay, canvas);
+			last_frame_time = state.event_time;
+		}
+	}
+	replay->total_time = GetStrokeReplayTime() - replay_start_time;
+
+	app->stroke_replay = NULL;
+}
+
+/*
+* CompareStrokeReplayTime関数
+* 処理時間を昇順に並べるための比較関数
+*/
+static int CompareStrokeReplayTime(const void* a, const void* b)
+{
+	double time_a = *(const double*)a, time_b = *(const double*)b;
+	return (time_a > time_b) - (time_a < time_b);
+}
+
+/*
+* PrintStrokeReplayPercentiles関数
+* 処理時間の分位数を1行で出力する
+* 引数
+* name		: 計測項目名
+* times		: 処理時間の配列(並べ替える)
+* num_times	: 配列の要素数
+* fp		: 出力先
+*/
+static void PrintStrokeReplayPercentiles(const char* name, double* times, int num_times, FILE* fp)
+{
+	if(num_times <= 0)
+	{
+		return;
+	}
+
+	qsort(times, num_times, sizeof(*times), CompareStrokeReplayTime);
+	(void)fprintf(fp, "%-8s %6d  p50 %8.3f ms  p90 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n",
+		name, num_times, times[num_times * 50 / 100] * 1000, times[num_times * 90 / 100] * 1000,
+			times[num_times * 99 / 100] * 1000, times[num_times - 1] * 1000);
+}
+
+/*
+* PrintStrokeReplayResult関数
+* 計測結果(処理時間の分位数と段階毎の合計)を出力する
+* 引数
+* replay	: 再生済みのデータ
+* fp		: 出力先
+*/
+void PrintStrokeReplayResult(STROKE_REPLAY* replay, FILE* fp)
+{
+	PrintStrokeReplayPercentiles("events", replay->event_times, replay->num_events, fp);
+	PrintStrokeReplayPercentiles("frames", replay->frame_times, replay->num_frames, fp);
+	(void)fprintf(fp, "brush    %10.3f ms\n", replay->brush_time * 1000);
+	(void)fprintf(fp, "history  %10.3f ms\n", replay->history_time * 1000);
+	(void)fprintf(fp, "display  %10.3f ms\n", replay->display_time * 1000);
+	(void)fprintf(fp, "total    %10.3f ms\n", replay->total_time * 1000);
+}
+
+#ifdef __cplusplus
+}
+#endif
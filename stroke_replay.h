@@ -0,0 +1,110 @@
+#ifndef _INCLUDED_STROKE_REPLAY_H_
+#define _INCLUDED_STROKE_REPLAY_H_
+
+#include <stdio.h>
+#include "types.h"
+#include "draw_window.h"
+
+// 画面更新(モーション待ち行列の処理とレイヤー合成)を行う間隔(ミリ秒)
+#define STROKE_REPLAY_FRAME_MILLISECONDS (1000 / 60)
+
+/*
+* eSTROKE_REPLAY_EVENT_TYPE列挙体
+* 再生するイベントの種類
+*/
+typedef enum _eSTROKE_REPLAY_EVENT_TYPE
+{
+	STROKE_REPLAY_EVENT_PRESS,
+	STROKE_REPLAY_EVENT_MOTION,
+	STROKE_REPLAY_EVENT_RELEASE
+} eSTROKE_REPLAY_EVENT_TYPE;
+
+/*
+* STROKE_REPLAY_EVENT構造体
+* 記録された入力イベント1つ分
+*  座標はキャンバス上の座標
+*/
+typedef struct _STROKE_REPLAY_EVENT
+{
+	eSTROKE_REPLAY_EVENT_TYPE type;
+	EVENT_STATE state;
+} STROKE_REPLAY_EVENT;
+
+/*
+* STROKE_REPLAY構造体
+* 入力イベントの再生と計測結果
+*/
+typedef struct _STROKE_REPLAY
+{
+	// 再生するイベント
+	STROKE_REPLAY_EVENT *events;
+	int num_events;
+	// イベント毎の処理時間(秒)
+	double *event_times;
+	// 画面更新毎の処理時間(秒)
+	double *frame_times;
+	int num_frames;
+	// 段階毎の合計処理時間(秒)
+	double brush_time;
+	double history_time;
+	double display_time;
+	// 再生全体の処理時間(秒)
+	double total_time;
+} STROKE_REPLAY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* GetStrokeReplayTime関数
+* 計測用に単調増加する現在時刻を取得する
+* 返り値
+*	現在時刻(秒)
+*/
+EXTERN double GetStrokeReplayTime(void);
+
+/*
+* ReadStrokeReplayFile関数
+* 入力イベントを記録したテキストファイルを読み込む
+*  1行に「種類(p/m/r) X座標 Y座標 筆圧 時刻(ミリ秒) [pen/eraser/mouse]」を書く
+*  #で始まる行は無視する
+* 引数
+* file_path	: 読み込むファイルのパス
+* 返り値
+*	読み込んだデータ(DeleteStrokeReplayで開放する) 失敗時はNULL
+*/
+EXTERN STROKE_REPLAY* ReadStrokeReplayFile(const char* file_path);
+
+/*
+* DeleteStrokeReplay関数
+* 入力イベントの再生データを開放する
+* 引数
+* replay	: 開放するデータのポインタのアドレス
+*/
+EXTERN void DeleteStrokeReplay(STROKE_REPLAY** replay);
+
+/*
+* ExecuteStrokeReplay関数
+* 記録された入力イベントをマウスイベントと同じ経路で再生して処理時間を計測する
+*  画面更新はイベントの時刻で一定間隔毎に行う
+* 引数
+* replay	: 再生するデータ(計測結果もここに入る)
+* canvas	: 描画するキャンバス
+*/
+EXTERN void ExecuteStrokeReplay(STROKE_REPLAY* replay, DRAW_WINDOW* canvas);
+
+/*
+* PrintStrokeReplayResult関数
+* 計測結果(処理時間の分位数と段階毎の合計)を出力する
+* 引数
+* replay	: 再生済みのデータ
+* fp		: 出力先
+*/
+EXTERN void PrintStrokeReplayResult(STROKE_REPLAY* replay, FILE* fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _INCLUDED_STROKE_REPLAY_H_
@@ -0,0 +1,342 @@
+#include <string.h>
+#include <math.h>
+#include "configure.h"
+#include "texture.h"
+#include "memory.h"
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+# include <emmintrin.h>
+#endif
+
+#ifndef TRUE
+# define TRUE 1
+#endif
+#ifndef FALSE
+# define FALSE 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// タイル座標の固定小数点の桁数
+#define TEXTURE_CACHE_FIXED_SHIFT 16
+#define TEXTURE_CACHE_FIXED_ONE (1 << TEXTURE_CACHE_FIXED_SHIFT)
+// 拡大したタイルの一辺の最大値
+#define TEXTURE_CACHE_MAX_SIZE 4096
+// 回転時に1度に集めるテクスチャのピクセル数
+#define TEXTURE_CACHE_GATHER_SIZE 256
+
+/*
+* UpdateTextureCache関数
+* 選択中のテクスチャと拡大率・角度・濃さが変わっていればキャッシュを作り直す
+* 引数
+* textures	: テクスチャを管理する構造体のアドレス
+* 返り値
+*	キャッシュが使える:TRUE	テクスチャ無し・作成失敗:FALSE
+*/
+int UpdateTextureCache(TEXTURES* textures)
+{
+	TEXTURE_CACHE *cache = &textures->cache;
+	TEXTURE *texture;
+	FLOAT_T scale = textures->scale;
+	FLOAT_T strength = textures->strength;
+	FLOAT_T radian;
+	int32 width, height;
+	int x, y;
+
+	if(textures->active_texture <= 0 || textures->active_texture > textures->num_texture)
+	{
+		return FALSE;
+	}
+
+	if(cache->active_texture == textures->active_texture && cache->scale == textures->scale
+		&& cache->angle == textures->angle && cache->strength == textures->strength)
+	{
+		return TRUE;
+	}
+
+	texture = &textures->texture[textures->active_texture-1];
+	if(texture->pixels == NULL || texture->width <= 0 || texture->height <= 0)
+	{
+		return FALSE;
+	}
+
+	if(scale <= 0)
+	{
+		scale = 1;
+	}
+	if(strength < 0)
+	{
+		strength = 0;
+	}
+	else if(strength > 1)
+	{
+		strength = 1;
+	}
+
+	width = (int32)(texture->width * scale + 0.5);
+	height = (int32)(texture->height * scale + 0.5);
+	if(width < 1)
+	{
+		width = 1;
+	}
+	else if(width > TEXTURE_CACHE_MAX_SIZE)
+	{
+		width = TEXTURE_CACHE_MAX_SIZE;
+	}
+	if(height < 1)
+	{
+		height = 1;
+	}
+	else if(height > TEXTURE_CACHE_MAX_SIZE)
+	{
+		height = TEXTURE_CACHE_MAX_SIZE;
+	}
+
+	if((size_t)width * height > cache->buffer_size)
+	{
+		uint8 *pixels = (uint8*)MEM_REALLOC_FUNC(cache->pixels, (size_t)width * height);
+		if(pixels == NULL)
+		{
+			cache->active_texture = 0;
+			return FALSE;
+		}
+		cache->pixels = pixels;
+		cache->buffer_size = (size_t)width * height;
+	}
+
+	// 端を折り返して補間し、タイルの継ぎ目が出ないようにする
+	for(y=0; y<height; y++)
+	{
+		FLOAT_T source_y = (y + 0.5) * texture->height / height - 0.5;
+		int y0 = (int)floor(source_y);
+		FLOAT_T weight_y = source_y - y0;
+		uint8 *row0, *row1;
+		uint8 *destination = &cache->pixels[y*width];
+
+		y0 = ((y0 % texture->height) + texture->height) % texture->height;
+		row0 = &texture->pixels[y0*texture->stride];
+		row1 = &texture->pixels[((y0 + 1) % texture->height)*texture->stride];
+
+		for(x=0; x<width; x++)
+		{
+			FLOAT_T source_x = (x + 0.5) * texture->width / width - 0.5;
+			int x0 = (int)floor(source_x);
+			FLOAT_T weight_x = source_x - x0;
+			int x1;
+			FLOAT_T gray;
+
+			x0 = ((x0 % texture->width) + texture->width) % texture->width;
+			x1 = (x0 + 1) % texture->width;
+			gray = (row0[x0] * (1 - weight_x) + row0[x1] * weight_x) * (1 - weight_y)
+				+ (row1[x0] * (1 - weight_x) + row1[x1] * weight_x) * weight_y;
+			// 濃さ0でブラシそのまま、1でテクスチャの明るさをそのまま不透明度にする
+			destination[x] = (uint8)(255 - strength * (255 - gray) + 0.5);
+		}
+	}
+
+	// キャンバス座標からタイル座標へは角度の逆回転
+	radian = textures->angle * M_PI / 180;
+	cache->step_x[0] = (int32)floor(cos(radian) * TEXTURE_CACHE_FIXED_ONE + 0.5);
+	cache->step_x[1] = (int32)floor(- sin(radian) * TEXTURE_CACHE_FIXED_ONE + 0.5);
+	cache->step_y[0] = - cache->step_x[1];
+	cache->step_y[1] = cache->step_x[0];
+
+	cache->width = width;
+	cache->height = height;
+	cache->active_texture = textures->active_texture;
+	cache->scale = textures->scale;
+	cache->angle = textures->angle;
+	cache->strength = textures->strength;
+
+	return TRUE;
+}
+
+/*
+* MultiplyTextureLine関数
+* 1行分の乗算済みアルファのピクセルにテクスチャの値を乗算する
+* 引数
+* pixels		: 4チャンネルのピクセルデータ
+* texture		: ピクセル毎のテクスチャの値
+* num_pixels	: ピクセル数
+*/
+static void MultiplyTextureLine(uint8* pixels, const uint8* texture, int num_pixels)
+{
+	int i = 0;
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(128);
+
+	for( ; i + 4 <= num_pixels; i += 4)
+	{
+		__m128i source = _mm_loadu_si128((const __m128i*)&pixels[i*4]);
+		int value;
+		__m128i texture_value, low, high;
+
+		(void)memcpy(&value, &texture[i], sizeof(value));
+		// テクスチャの値をピクセルの4チャンネル分に広げる
+		texture_value = _mm_cvtsi32_si128(value);
+		texture_value = _mm_unpacklo_epi8(texture_value, texture_value);
+		texture_value = _mm_unpacklo_epi16(texture_value, texture_value);
+
+		// (p * t + 128 + ((p * t + 128) >> 8)) >> 8 で255の除算を行う
+		low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(source, zero),
+			_mm_unpacklo_epi8(texture_value, zero)), round);
+		high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(source, zero),
+			_mm_unpackhi_epi8(texture_value, zero)), round);
+		low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+		_mm_storeu_si128((__m128i*)&pixels[i*4], _mm_packus_epi16(low, high));
+	}
+#endif
+
+	for( ; i < num_pixels; i++)
+	{
+		uint8 *p = &pixels[i*4];
+		unsigned int t = texture[i];
+		unsigned int value;
+		int j;
+
+		for(j=0; j<4; j++)
+		{
+			value = p[j] * t + 128;
+			p[j] = (uint8)((value + (value >> 8)) >> 8);
+		}
+	}
+}
+
+/*
+* ApplyTextureToBrushPixels関数
+* ブラシの描画結果(乗算済みアルファの4チャンネル)にテクスチャを乗算する
+* 引数
+* textures	: テクスチャを管理する構造体のアドレス
+* pixels	: キャンバスと同じ大きさのピクセルデータ
+* stride	: pixelsの1行分のバイト数
+* x			: 適用する範囲の左上のX座標
+* y			: 適用する範囲の左上のY座標
+* width		: 適用する範囲の幅
+* height	: 適用する範囲の高さ
+*/
+void ApplyTextureToBrushPixels(
+	TEXTURES* textures,
+	uint8* pixels,
+	int stride,
+	int x,
+	int y,
+	int width,
+	int height
+)
+{
+	TEXTURE_CACHE *cache = &textures->cache;
+	int i;
+
+	if(width <= 0 || height <= 0 || UpdateTextureCache(textures) == FALSE)
+	{
+		return;
+	}
+
+	if(cache->step_x[0] == TEXTURE_CACHE_FIXED_ONE && cache->step_x[1] == 0)
+	{	// 回転無しならタイルの行をそのまま乗算できる
+		for(i=0; i<height; i++)
+		{
+			const uint8 *tile_row = &cache->pixels[((y + i) % cache->height) * cache->width];
+			uint8 *destination = &pixels[(y + i)*stride + x*4];
+			int u = x % cache->width;
+			int rest = width;
+
+			while(rest > 0)
+			{
+				int length = cache->width - u;
+				if(length > rest)
+				{
+					length = rest;
+				}
+				MultiplyTextureLine(destination, &tile_row[u], length);
+				destination += length * 4;
+				rest -= length;
+				u = 0;
+			}
+		}
+	}
+	else
+	{	// 回転していれば固定小数点でタイル座標を進めて集めてから乗算する
+		const int64 period_u = (int64)cache->width << TEXTURE_CACHE_FIXED_SHIFT;
+		const int64 period_v = (int64)cache->height << TEXTURE_CACHE_FIXED_SHIFT;
+		uint8 gather[TEXTURE_CACHE_GATHER_SIZE];
+
+		for(i=0; i<height; i++)
+		{
+			uint8 *destination = &pixels[(y + i)*stride + x*4];
+			int64 u = ((int64)x * cache->step_x[0] + (int64)(y + i) * cache->step_y[0]) % period_u;
+			int64 v = ((int64)x * cache->step_x[1] + (int64)(y + i) * cache->step_y[1]) % period_v;
+			int rest = width;
+
+			if(u < 0)
+			{
+				u += period_u;
+			}
+			if(v < 0)
+			{
+				v += period_v;
+			}
+
+			while(rest > 0)
+			{
+				int length = (rest > TEXTURE_CACHE_GATHER_SIZE) ? TEXTURE_CACHE_GATHER_SIZE : rest;
+				int j;
+
+				for(j=0; j<length; j++)
+				{
+					gather[j] = cache->pixels[(v >> TEXTURE_CACHE_FIXED_SHIFT) * cache->width
+						+ (u >> TEXTURE_CACHE_FIXED_SHIFT)];
+					// 1ピクセルの増分は周期より小さいので1回の補正で収まる
+					u += cache->step_x[0];
+					if(u >= period_u)
+					{
+						u -= period_u;
+					}
+					else if(u < 0)
+					{
+						u += period_u;
+					}
+					v += cache->step_x[1];
+					if(v >= period_v)
+					{
+						v -= period_v;
+					}
+					else if(v < 0)
+					{
+						v += period_v;
+					}
+				}
+
+				MultiplyTextureLine(destination, gather, length);
+				destination += length * 4;
+				rest -= length;
+			}
+		}
+	}
+}
+
+/*
+* ReleaseTextureCache関数
+* 拡大縮小・回転済みテクスチャのキャッシュを開放する
+* 引数
+* textures	: テクスチャを管理する構造体のアドレス
+*/
+void ReleaseTextureCache(TEXTURES* textures)
+{
+	TEXTURE_CACHE *cache = &textures->cache;
+
+	MEM_FREE_FUNC(cache->pixels);
+	cache->pixels = NULL;
+	cache->buffer_size = 0;
+	cache->width = cache->height = 0;
+	cache->active_texture = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,12 +7,30 @@
 
 typedef struct _TEXTURE
 {
-	uint8 *pixels;
+	uint8 *pixels;	// グレースケール(1ピクセル1バイト)
 	char *name;
 	int32 width, height, stride;
 	void *thumbnail;
 } TEXTURE;
 
+/*
+* TEXTURE_CACHE構造体
+* ブラシに適用するテクスチャを拡大縮小・濃さ適用済みで保持するタイル
+*  設定が変わった時だけ作り直し、描画時は回転分の固定小数点の座標を進めて参照する
+*/
+typedef struct _TEXTURE_CACHE
+{
+	uint8 *pixels;			// 拡大縮小したテクスチャ(1ピクセル1バイト、0:透明 255:不透明)
+	int32 width, height;	// タイルの幅と高さ
+	size_t buffer_size;		// 確保済みのバイト数
+	int active_texture;		// 作成元のテクスチャ(0なら未作成)
+	FLOAT_T strength;		// 作成した時の設定
+	FLOAT_T scale;
+	FLOAT_T angle;
+	// キャンバスのx, y方向に1ピクセル進んだ時のタイル座標の増分(16ビット固定小数点)
+	int32 step_x[2], step_y[2];
+} TEXTURE_CACHE;
+
 typedef struct _TEXTURES
 {
 	TEXTURE *texture;
@@ -21,8 +39,13 @@ typedef struct _TEXTURES
 	FLOAT_T strength;
 	FLOAT_T scale;
 	FLOAT_T angle;
+	TEXTURE_CACHE cache;
 } TEXTURES;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*
 * LoadTexture関数
 * テクスチャをロードする
@@ -32,4 +55,48 @@ typedef struct _TEXTURES
 */
 extern void LoadTexture(TEXTURES* textures, char* directly);
 
+/*
+* UpdateTextureCache関数
+* 選択中のテクスチャと拡大率・角度・濃さが変わっていればキャッシュを作り直す
+* 引数
+* textures	: テクスチャを管理する構造体のアドレス
+* 返り値
+*	キャッシュが使える:TRUE	テクスチャ無し・作成失敗:FALSE
+*/
+extern int UpdateTextureCache(TEXTURES* textures);
+
+/*
+* ApplyTextureToBrushPixels関数
+* ブラシの描画結果(乗算済みアルファの4チャンネル)にテクスチャを乗算する
+* 引数
+* textures	: テクスチャを管理する構造体のアドレス
+* pixels	: キャンバスと同じ大きさのピクセルデータ
+* stride	: pixelsの1行分のバイト数
+* x			: 適用する範囲の左上のX座標
+* y			: 適用する範囲の左上のY座標
+* width		: 適用する範囲の幅
+* height	: 適用する範囲の高さ
+*/
+extern void ApplyTextureToBrushPixels(
+	TEXTURES* textures,
+	uint8* pixels,
+	int stride,
+	int x,
+	int y,
+	int width,
+	int height
+);
+
+/*
+* ReleaseTextureCache関数
+* 拡大縮小・回転済みテクスチャのキャッシュを開放する
+* 引数
+* textures	: テクスチャを管理する構造体のアドレス
+*/
+extern void ReleaseTextureCache(TEXTURES* textures);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif	// #ifndef _INCLUDED_TEXTURE_H_
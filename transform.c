@@ -14,12 +14,26 @@
 #include "application.h"
 #include "graphics/graphics.h"
 #include "graphics/graphics_matrix.h"
+#include "configure.h"
+#include "gui/gui.h"
+
+#if defined(USE_SSE2) && USE_SSE2 != 0
+# include <emmintrin.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define UPDATE_DISTANCE 0.5
+// 逆変換できない場合の元画像からのはみ出し量
+#define TRANSFORM_INVALID_DISTANCE 1.0e30
+// ドラッグ中のプレビューで処理する元画像のピクセル数の上限
+#define TRANSFORM_PREVIEW_MAX_PIXELS (1024 * 1024)
+// プレビューの最大の縮小率
+#define TRANSFORM_PREVIEW_MAX_SCALE 16
+// 射影変換をまとめて行う1回分の座標の数
+#define PROJECTION_SCANLINE_LENGTH 256
 
 /*
 * CreateTransformData関数
@@ -76,6 +90,9 @@ TRANSFORM_DATA *CreateTransformData(DRAW_WINDOW* window)
 	InitializeGraphicsMatrixTranslate(&matrix, - ret->x, - ret->y);
 	for(i=0; i<ret->num_layers; i++)
 	{
+		// ピン留めしたレイヤーがタイル形式になっていればピクセルデータに戻す
+		(void)MaterializeLayerPixels(ret->layers[i]);
+
 		copy_stride = ret->width * ret->layers[i]->channel;
 		ret->source_pixels[i] = (uint8*)MEM_ALLOC_FUNC(copy_stride*ret->height);
 		ret->before_pixels[i] = (uint8*)MEM_ALLOC_FUNC(ret->layers[i]->stride*ret->layers[i]->height);
@@ -131,6 +148,16 @@ TRANSFORM_DATA *CreateTransformData(DRAW_WINDOW* window)
 		}
 	}
 
+	// 変形中はピン留めしたレイヤーの内容が変わり続ける
+	for(i=0; i<ret->num_layers; i++)
+	{
+		InvalidateLayerSetCache(ret->layers[i], ret->x, ret->y, ret->width, ret->height);
+	}
+
+	// 最初はレイヤー全体を変形前のピクセルデータに戻す
+	ret->update_min_x = ret->update_min_y = 0;
+	ret->update_max_x = window->width,	ret->update_max_y = window->height;
+
 	// アフィン変換用のデータを初期化
 	ret->move_x = ret->x, ret->move_y = ret->y;
 	ret->angle = 0;
@@ -163,6 +190,14 @@ void DeleteTransformData(TRANSFORM_DATA** transform)
 		MEM_FREE_FUNC((*transform)->source_pixels[i]);
 	}
 	MEM_FREE_FUNC((*transform)->source_pixels);
+	if((*transform)->preview_pixels != NULL)
+	{
+		for(i=0; i<(*transform)->num_layers; i++)
+		{
+			MEM_FREE_FUNC((*transform)->preview_pixels[i]);
+		}
+		MEM_FREE_FUNC((*transform)->preview_pixels);
+	}
 	MEM_FREE_FUNC((*transform)->layers);
 
 	*transform = NULL;
@@ -231,78 +266,76 @@ void Projection(FLOAT_T src[2], FLOAT_T dst[2], FLOAT_T parameter[9])
 			/ (src[0]*parameter[6] + src[1]*parameter[7] + 1);
 }
 
-// 自由変形用パラメータ
-typedef struct _TRANSPUT
-{
-	FLOAT_T length;			// 描画ラインの長さ
-	FLOAT_T dst[2];			// 描画座標
-	FLOAT_T add[2];			// 座標の増分
-	FLOAT_T src_point[2];	// 現在の元画像の座標
-	FLOAT_T src_add[2];		// 元画像の座標の増分
-	int out_add[2];			// 描画位置補正
-} TRANSPUT;
-
 /*
-* TransformDrawLine関数
+* ProjectionScanline関数
+* 水平に並んだ座標をまとめて射影変換する
+*  分子・分母を増分で計算し、分母の逆数はSIMDの近似値をニュートン法で補正する
 * 引数
-* point
-* transform
-* tranput
-* length
-* current_layer	: 現在操作性しているレイヤー
+* parameter	: 射影変換用のパラメーター
+* x			: 変換する最初の座標のX座標
+* y			: 変換する座標のY座標
+* length	: 変換する座標の数
+* out_x		: 変換後のX座標を格納する配列
+* out_y		: 変換後のY座標を格納する配列
 */
-static void TransformDrawLine(
-	int* point,
-	TRANSFORM_DATA* transform,
-	TRANSPUT* transput,
+void ProjectionScanline(
+	const FLOAT_T parameter[9],
+	FLOAT_T x,
+	FLOAT_T y,
 	int length,
-	int current_layer
+	float* out_x,
+	float* out_y
 )
 {
-	DRAW_WINDOW *window = transform->layers[0]->window;
-	int src[2];
-	int src_index, dst_index;
-	int i;
-
-	src[0] = (int)transput->src_point[0];
-	src[1] = (int)transput->src_point[1];
+	FLOAT_T base_x = parameter[1] * y + parameter[2];
+	FLOAT_T base_y = parameter[4] * y + parameter[5];
+	FLOAT_T base_w = parameter[7] * y + 1;
+	int i = 0;
 
-	for(i=0; i<=length; i++)
+#if defined(USE_SSE2) && USE_SSE2 != 0
 	{
-		point[0] = (int)transput->dst[0];
-		point[1] = (int)transput->dst[1];
-
-		if(point[0] >= 0 && point[0] < window->width
-			&& point[1] >= 0 && point[1] < window->height)
+		const __m128 offset = _mm_set_ps(3, 2, 1, 0);
+		const __m128 add_x = _mm_mul_ps(offset, _mm_set1_ps((float)parameter[0]));
+		const __m128 add_y = _mm_mul_ps(offset, _mm_set1_ps((float)parameter[3]));
+		const __m128 add_w = _mm_mul_ps(offset, _mm_set1_ps((float)parameter[6]));
+		const __m128 two = _mm_set1_ps(2);
+
+		// 4点ごとに先頭を倍精度で計算し直して誤差が蓄積しないようにする
+		for( ; i+4<=length; i+=4)
 		{
-			if(src[0] >= 0 && src[1] >= 0
-				&& src[0] < transform->width && src[1] < transform->height)
-			{
-				src_index = src[1] * transform->stride + src[0]*4;
-				dst_index = point[1]*window->temp_layer->stride + point[0]*4;
-				if(window->temp_layer->pixels[dst_index+3]
-					< transform->source_pixels[current_layer][src_index+3])
-				{
-					window->temp_layer->pixels[dst_index+0]
-						= transform->source_pixels[current_layer][src_index+0];
-					window->temp_layer->pixels[dst_index+1]
-						= transform->source_pixels[current_layer][src_index+1];
-					window->temp_layer->pixels[dst_index+2]
-						= transform->source_pixels[current_layer][src_index+2];
-					window->temp_layer->pixels[dst_index+3]
-						= transform->source_pixels[current_layer][src_index+3];
-				}
-			}
+			FLOAT_T position = x + i;
+			__m128 numerator_x = _mm_add_ps(_mm_set1_ps((float)(parameter[0] * position + base_x)), add_x);
+			__m128 numerator_y = _mm_add_ps(_mm_set1_ps((float)(parameter[3] * position + base_y)), add_y);
+			__m128 denominator = _mm_add_ps(_mm_set1_ps((float)(parameter[6] * position + base_w)), add_w);
+			__m128 reciprocal = _mm_rcp_ps(denominator);
+
+			reciprocal = _mm_mul_ps(reciprocal, _mm_sub_ps(two, _mm_mul_ps(denominator, reciprocal)));
+			_mm_storeu_ps(&out_x[i], _mm_mul_ps(numerator_x, reciprocal));
+			_mm_storeu_ps(&out_y[i], _mm_mul_ps(numerator_y, reciprocal));
 		}
+	}
+#endif
 
-		transput->dst[0] += transput->add[0];
-		transput->dst[1] += transput->add[1];
-
-		transput->src_point[0] += transput->src_add[0];
-		src[0] = (int)transput->src_point[0];
+	for( ; i<length; i++)
+	{
+		FLOAT_T position = x + i;
+		FLOAT_T div_w = 1 / (parameter[6] * position + base_w);
+		out_x[i] = (float)((parameter[0] * position + base_x) * div_w);
+		out_y[i] = (float)((parameter[3] * position + base_y) * div_w);
 	}
 }
 
+// 自由変形用パラメータ
+typedef struct _TRANSPUT
+{
+	FLOAT_T length;			// 描画ラインの長さ
+	FLOAT_T dst[2];			// 描画座標
+	FLOAT_T add[2];			// 座標の増分
+	FLOAT_T src_point[2];	// 現在の元画像の座標
+	FLOAT_T src_add[2];		// 元画像の座標の増分
+	int out_add[2];			// 描画位置補正
+} TRANSPUT;
+
 /*
 * TransformDrawLineSelectionArea関数
 * 引数
@@ -357,163 +390,436 @@ static void TransformDrawLineSelectionArea(
 	}
 }
 
+// 自由変形で分割した四角形の1つ
+typedef struct _TRANSFORM_QUAD
+{
+	// 変形後の頂点(元画像の左上、左下、右下、右上の順)
+	FLOAT_T points[4][2];
+	// 元画像での左上の座標と幅・高さ
+	FLOAT_T src_x, src_y, src_width, src_height;
+} TRANSFORM_QUAD;
+
 /*
-* TransformOutput関数
-* 自由変形の描画
+* SetTransformQuads関数
+* 8つの制御点と中心で変形範囲を4つの四角形に分割する
 * 引数
+* transform	: 変形処理用のデータ
+* quads		: 分割した四角形を受け取る配列
 */
-static void TransformOutput(TRANSFORM_DATA* transform, int current_layer)
+static void SetTransformQuads(TRANSFORM_DATA* transform, TRANSFORM_QUAD quads[4])
 {
-	DRAW_WINDOW *window = transform->layers[0]->window;
-	TRANSPUT output_point;
-	int dst_points[4][2];
-	int point[2];
-	FLOAT_T line_points[2][2];
-	FLOAT_T line_add[2][2];
-	FLOAT_T left_length, right_length;
-	FLOAT_T line_length;
-	FLOAT_T ave_x = 0, ave_y = 0;
-	int src_x_start;
-	int loop_length;
+	// 各四角形の頂点に対応する制御点(8は中心)
+	const int indices[4][4] = {{0, 1, 8, 7}, {1, 2, 3, 8}, {8, 3, 4, 5}, {7, 8, 5, 6}};
+	FLOAT_T half_width = transform->width * 0.5,	half_height = transform->height * 0.5;
+	FLOAT_T center[2] = {0, 0};
 	int i, j;
 
 	for(i=0; i<8; i++)
 	{
-		ave_x += transform->trans[i][0];
-		ave_y += transform->trans[i][1];
+		center[0] += transform->trans[i][0];
+		center[1] += transform->trans[i][1];
 	}
-	ave_x *= 0.125,	ave_y *= 0.125;
+	center[0] *= 0.125,	center[1] *= 0.125;
 
 	for(i=0; i<4; i++)
 	{
-		GRAPHICS_SURFACE_PATTERN local_pattern = {0};
-		
-		(void)memset(&output_point, 0, sizeof(output_point));
-		(void)memset(window->temp_layer->pixels, 0, window->pixel_buf_size);
-
-		switch(i)
+		for(j=0; j<4; j++)
 		{
-		case 0:
-			src_x_start = 0;
-			dst_points[0][0] = (int)(transform->trans[0][0]);
-			dst_points[0][1] = (int)(transform->trans[0][1]);
-			dst_points[1][0] = (int)(transform->trans[1][0]);
-			dst_points[1][1] = (int)(transform->trans[1][1]);
-			dst_points[2][0] = (int)ave_x;
-			dst_points[2][1] = (int)ave_y;
-			dst_points[3][0] = (int)(transform->trans[7][0]);
-			dst_points[3][1] = (int)(transform->trans[7][1]);
-
-			break;
-		case 1:
-			output_point.src_point[1] = transform->height / 2;
-			src_x_start = 0;
-			dst_points[0][0] = (int)(transform->trans[1][0]);
-			dst_points[0][1] = (int)(transform->trans[1][1]);
-			dst_points[1][0] = (int)(transform->trans[2][0]);
-			dst_points[1][1] = (int)(transform->trans[2][1]);
-			dst_points[2][0] = (int)(transform->trans[3][0]);
-			dst_points[2][1] = (int)(transform->trans[3][1]);
-			dst_points[3][0] = (int)ave_x;
-			dst_points[3][1] = (int)ave_y;
-
-			break;
-		case 2:
-			src_x_start = (int)(output_point.src_point[0] = transform->width / 2);
-			output_point.src_point[1] = transform->height / 2;
-			dst_points[0][0] = (int)ave_x;
-			dst_points[0][1] = (int)ave_y;
-			dst_points[1][0] = (int)(transform->trans[3][0]);
-			dst_points[1][1] = (int)(transform->trans[3][1]);
-			dst_points[2][0] = (int)(transform->trans[4][0]);
-			dst_points[2][1] = (int)(transform->trans[4][1]);
-			dst_points[3][0] = (int)(transform->trans[5][0]);
-			dst_points[3][1] = (int)(transform->trans[5][1]);
-
-			break;
-		case 3:
-			src_x_start = (int)(output_point.src_point[0] = transform->width / 2);
-			dst_points[0][0] = (int)(transform->trans[7][0]);
-			dst_points[0][1] = (int)(transform->trans[7][1]);
-			dst_points[1][0] = (int)ave_x;
-			dst_points[1][1] = (int)ave_y;
-			dst_points[2][0] = (int)(transform->trans[5][0]);
-			dst_points[2][1] = (int)(transform->trans[5][1]);
-			dst_points[3][0] = (int)(transform->trans[6][0]);
-			dst_points[3][1] = (int)(transform->trans[6][1]);
-
-			break;
+			const FLOAT_T *point = (indices[i][j] == 8) ? center : transform->trans[indices[i][j]];
+			quads[i].points[j][0] = point[0];
+			quads[i].points[j][1] = point[1];
 		}
+		quads[i].src_x = (i >= 2) ? half_width : 0;
+		quads[i].src_y = (i == 1 || i == 2) ? half_height : 0;
+		quads[i].src_width = half_width;
+		quads[i].src_height = half_height;
+	}
+}
 
-		output_point.out_add[0] = (int)transform->move_x;
-		output_point.out_add[1] = (int)transform->move_y;
-
-		left_length = sqrt(
-			(dst_points[0][0]-dst_points[1][0])*(dst_points[0][0]-dst_points[1][0])+(dst_points[0][1]-dst_points[1][1])*(dst_points[0][1]-dst_points[1][1]));
-		right_length = sqrt(
-			(dst_points[2][0]-dst_points[3][0])*(dst_points[2][0]-dst_points[3][0])+(dst_points[2][1]-dst_points[3][1])*(dst_points[2][1]-dst_points[3][1]));
+/*
+* TransformQuadInverse関数
+* 変形後の座標から四角形内での元画像の位置(0～1)を求める
+*  四角形の辺を双線形補間した写像の逆変換
+* 引数
+* quad	: 分割した四角形
+* x		: 変形後のX座標
+* y		: 変形後のY座標
+* u		: 横方向の位置を受け取るアドレス(0～1に丸める)
+* v		: 縦方向の位置を受け取るアドレス(0～1に丸める)
+* 返り値
+*	元画像の範囲からはみ出したピクセル数(範囲内なら0)
+*/
+static FLOAT_T TransformQuadInverse(
+	const TRANSFORM_QUAD* quad,
+	FLOAT_T x,
+	FLOAT_T y,
+	FLOAT_T* u,
+	FLOAT_T* v
+)
+{
+	const FLOAT_T (*p)[2] = quad->points;
+	FLOAT_T ex = p[3][0] - p[0][0],	ey = p[3][1] - p[0][1];
+	FLOAT_T fx = p[1][0] - p[0][0],	fy = p[1][1] - p[0][1];
+	FLOAT_T gx = p[0][0] - p[3][0] + p[2][0] - p[1][0];
+	FLOAT_T gy = p[0][1] - p[3][1] + p[2][1] - p[1][1];
+	FLOAT_T hx = x - p[0][0],	hy = y - p[0][1];
+	FLOAT_T k2 = gx * fy - gy * fx;
+	FLOAT_T k1 = ex * fy - ey * fx + hx * gy - hy * gx;
+	FLOAT_T k0 = hx * ey - hy * ex;
+	FLOAT_T roots[2];
+	FLOAT_T discriminant, q;
+	FLOAT_T result = TRANSFORM_INVALID_DISTANCE;
+	int num_roots = 0;
+	int i;
 
-		line_add[0][0] = (dst_points[1][0]-dst_points[0][0]) / left_length;
-		line_add[1][0] = (dst_points[2][0]-dst_points[3][0]) / right_length;
+	// k2*v^2 + k1*v + k0 = 0 を桁落ちしない形で解く
+	discriminant = k1 * k1 - 4 * k2 * k0;
+	if(discriminant < 0)
+	{
+		discriminant = 0;
+	}
+	q = -0.5 * (k1 + ((k1 < 0) ? - sqrt(discriminant) : sqrt(discriminant)));
+	if(q != 0)
+	{
+		roots[num_roots++] = k0 / q;
+	}
+	if(k2 != 0)
+	{
+		roots[num_roots++] = q / k2;
+	}
 
-		line_points[0][0] = dst_points[0][0];
-		line_points[0][1] = dst_points[0][1];
-		line_points[1][0] = dst_points[3][0];
-		line_points[1][1] = dst_points[3][1];
+	for(i=0; i<num_roots; i++)
+	{
+		FLOAT_T root_v = roots[i];
+		FLOAT_T dx = ex + gx * root_v,	dy = ey + gy * root_v;
+		FLOAT_T root_u, outside;
 
-		if(left_length > right_length)
+		if(fabs(dx) > fabs(dy))
 		{
-			loop_length = (int)left_length;
-			output_point.src_add[1] = (transform->height / 2) / left_length;
-			line_add[0][1] = (dst_points[1][1]-dst_points[0][1]) / left_length;
-			line_add[1][1] = (dst_points[2][1]-dst_points[3][1]) / left_length;
+			root_u = (hx - fx * root_v) / dx;
+		}
+		else if(dy != 0)
+		{
+			root_u = (hy - fy * root_v) / dy;
 		}
 		else
 		{
-			loop_length = (int)right_length;
-			output_point.src_add[1] = (transform->height / 2) / right_length;
-			line_add[0][1] = (dst_points[1][1]-dst_points[0][1]) / right_length;
-			line_add[1][1] = (dst_points[2][1]-dst_points[3][1]) / right_length;
+			continue;
 		}
 
-		for(j=0; j<=loop_length; j++)
+		outside = 0;
+		if(root_u < 0)
 		{
-			line_length = sqrt(
-				(line_points[0][0]-line_points[1][0])*(line_points[0][0]-line_points[1][0]) + (line_points[0][1]-line_points[1][1])*(line_points[0][1]-line_points[1][1]));
+			outside -= root_u * quad->src_width,	root_u = 0;
+		}
+		else if(root_u > 1)
+		{
+			outside += (root_u - 1) * quad->src_width,	root_u = 1;
+		}
+		if(root_v < 0)
+		{
+			outside -= root_v * quad->src_height,	root_v = 0;
+		}
+		else if(root_v > 1)
+		{
+			outside += (root_v - 1) * quad->src_height,	root_v = 1;
+		}
 
-			output_point.dst[0] = line_points[0][0];
-			output_point.dst[1] = line_points[0][1];
+		if(outside < result)
+		{
+			result = outside;
+			*u = root_u,	*v = root_v;
+		}
+	}
 
-			output_point.add[0] = ((line_points[1][0] - line_points[0][0]) / line_length) * 0.5;
-			output_point.add[1] = ((line_points[1][1] - line_points[0][1]) / line_length) * 0.5;
+	return result;
+}
 
-			output_point.src_add[0] = ((transform->width / 2) / line_length) * 0.5;
+/*
+* TransformSample関数
+* 元画像を双線形補間してピクセルの色を取得する
+*  範囲外は端のピクセルを延長する(輪郭はマスクでアンチエイリアスする)
+* 引数
+* source	: 元画像のピクセルデータ
+* stride	: 元画像の1行分のバイト数
+* width		: 元画像の幅
+* height	: 元画像の高さ
+* x			: 取得するX座標(ピクセルの中心が整数)
+* y			: 取得するY座標(ピクセルの中心が整数)
+* 返り値
+*	補間したピクセルの値
+*/
+static INLINE uint32 TransformSample(
+	const uint8* source,
+	int stride,
+	int width,
+	int height,
+	FLOAT_T x,
+	FLOAT_T y
+)
+{
+	FLOAT_T floor_x = floor(x),	floor_y = floor(y);
+	int weight_x = (int)((x - floor_x) * 256 + 0.5);
+	int weight_y = (int)((y - floor_y) * 256 + 0.5);
+	int x0 = (int)floor_x,	y0 = (int)floor_y;
+	int x1 = x0 + 1,	y1 = y0 + 1;
+	uint32 p00, p01, p10, p11;
+
+	if(x0 < 0)
+	{
+		x0 = 0;
+	}
+	else if(x0 > width - 1)
+	{
+		x0 = width - 1;
+	}
+	if(x1 < 0)
+	{
+		x1 = 0;
+	}
+	else if(x1 > width - 1)
+	{
+		x1 = width - 1;
+	}
+	if(y0 < 0)
+	{
+		y0 = 0;
+	}
+	else if(y0 > height - 1)
+	{
+		y0 = height - 1;
+	}
+	if(y1 < 0)
+	{
+		y1 = 0;
+	}
+	else if(y1 > height - 1)
+	{
+		y1 = height - 1;
+	}
 
-			TransformDrawLine(point, transform, &output_point, (int)line_length*2, current_layer);
+	p00 = *(const uint32*)&source[y0*stride+x0*4];
+	p01 = *(const uint32*)&source[y0*stride+x1*4];
+	p10 = *(const uint32*)&source[y1*stride+x0*4];
+	p11 = *(const uint32*)&source[y1*stride+x1*4];
 
-			line_points[0][0] += line_add[0][0];
-			line_points[0][1] += line_add[0][1];
-			line_points[1][0] += line_add[1][0];
-			line_points[1][1] += line_add[1][1];
+#if defined(USE_SSE2) && USE_SSE2 != 0
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(128);
+		__m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi32(
+			_mm_cvtsi32_si128((int)p00), _mm_cvtsi32_si128((int)p01)), zero);
+		__m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi32(
+			_mm_cvtsi32_si128((int)p10), _mm_cvtsi32_si128((int)p11)), zero);
+		__m128i horizontal = _mm_set_epi16(
+			(short)weight_x, (short)weight_x, (short)weight_x, (short)weight_x,
+			(short)(256 - weight_x), (short)(256 - weight_x), (short)(256 - weight_x), (short)(256 - weight_x));
+		__m128i value;
+
+		// 縦方向→横方向の順に補間する(各段階で255*256に収まる)
+		value = _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16((short)(256 - weight_y))),
+			_mm_mullo_epi16(bottom, _mm_set1_epi16((short)weight_y)));
+		value = _mm_srli_epi16(_mm_add_epi16(value, round), 8);
+		value = _mm_mullo_epi16(value, horizontal);
+		value = _mm_add_epi16(value, _mm_srli_si128(value, 8));
+		value = _mm_srli_epi16(_mm_add_epi16(value, round), 8);
+
+		return (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(value, zero));
+	}
+#else
+	{
+		uint32 result = 0;
+		int i;
 
-			output_point.src_point[0] = src_x_start;
-			output_point.src_point[1] += output_point.src_add[1];
+		for(i=0; i<32; i+=8)
+		{
+			uint32 top = (((p00 >> i) & 0xff) * (256 - weight_y) + ((p10 >> i) & 0xff) * weight_y + 128) >> 8;
+			uint32 bottom = (((p01 >> i) & 0xff) * (256 - weight_y) + ((p11 >> i) & 0xff) * weight_y + 128) >> 8;
+			result |= ((top * (256 - weight_x) + bottom * weight_x + 128) >> 8) << i;
+		}
+
+		return result;
+	}
+#endif
+}
+
+/*
+* TRANSFORM_OUTPUT_DATA構造体
+* 自由変形の描画をスレッドプールで処理するためのデータ
+*/
+typedef struct _TRANSFORM_OUTPUT_DATA
+{
+	LAYER *layer;
+	const uint8 *source;
+	const TRANSFORM_QUAD *quads;
+	const uint8 *mask;
+	FLOAT_T div_scale;
+	int source_width;
+	int source_height;
+	int source_stride;
+	int mask_stride;
+	int min_x;
+	int min_y;
+	int width;
+	int height;
+	int scale;
+} TRANSFORM_OUTPUT_DATA;
+
+/*
+* TransformOutputBlockRow関数
+* スレッドプールから呼び出されてscale行分のブロックを描画する
+* 引数
+* block_y		: ブロックの行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: TRANSFORM_OUTPUT_DATA構造体のアドレス
+*/
+static void TransformOutputBlockRow(int block_y, int thread_index, void* data)
+{
+	TRANSFORM_OUTPUT_DATA *output = (TRANSFORM_OUTPUT_DATA*)data;
+	LAYER *layer = output->layer;
+	const TRANSFORM_QUAD *quads = output->quads;
+	const uint8 *mask = output->mask;
+	int mask_stride = output->mask_stride;
+	int width = output->width;
+	int scale = output->scale;
+	int y = block_y * scale;
+	int block_height = (y + scale > output->height) ? output->height - y : scale;
+	FLOAT_T py = y + output->min_y + block_height * 0.5;
+	int quad_index = 0;
+	int x;
+
+	(void)thread_index;
+
+	for(x=0; x<width; x+=scale)
+	{
+		int block_width = (x + scale > width) ? width - x : scale;
+		FLOAT_T px = x + output->min_x + block_width * 0.5;
+		FLOAT_T u, v, best_u = 0, best_v = 0;
+		FLOAT_T outside, best_outside = TRANSFORM_INVALID_DISTANCE;
+		uint32 color;
+		int best_quad = quad_index;
+		int i, j, k;
+
+		if(scale == 1 && mask[y*mask_stride+x] == 0)
+		{
+			continue;
+		}
+
+		// 隣のピクセルと同じ四角形に入っている可能性が高いので前回の四角形から調べる
+		for(k=0; k<4; k++)
+		{
+			int index = (quad_index + k) & 3;
+			outside = TransformQuadInverse(&quads[index], px, py, &u, &v);
+			if(outside < best_outside)
+			{
+				best_outside = outside;
+				best_u = u,	best_v = v;
+				best_quad = index;
+				if(outside <= 0)
+				{
+					break;
+				}
+			}
+		}
+		if(best_outside >= TRANSFORM_INVALID_DISTANCE)
+		{
+			continue;
 		}
+		quad_index = best_quad;
+
+		color = TransformSample(output->source, output->source_stride,
+			output->source_width, output->source_height,
+			(quads[best_quad].src_x + best_u * quads[best_quad].src_width) * output->div_scale - 0.5,
+			(quads[best_quad].src_y + best_v * quads[best_quad].src_height) * output->div_scale - 0.5
+		);
+
+		// マスクを掛けた色を変形前の画像の上に合成する
+		for(i=0; i<block_height; i++)
+		{
+			const uint8 *mask_line = &mask[(y+i)*mask_stride+x];
+			uint8 *destination = &layer->pixels[(y+i+output->min_y)*layer->stride+(x+output->min_x)*4];
 
-		GraphicsSave(&window->mask_temp->context.base);
+			for(j=0; j<block_width; j++, destination+=4)
+			{
+				unsigned int alpha, value;
 
-		GraphicsMoveTo(&window->mask_temp->context.base, dst_points[0][0], dst_points[0][1]);
-		GraphicsLineTo(&window->mask_temp->context.base, dst_points[1][0], dst_points[1][1]);
-		GraphicsLineTo(&window->mask_temp->context.base, dst_points[2][0], dst_points[2][1]);
-		GraphicsLineTo(&window->mask_temp->context.base, dst_points[3][0], dst_points[3][1]);
-		GraphicsClosePath(&window->mask_temp->context.base);
-		GraphicsClip(&window->mask_temp->context.base);
+				if(mask_line[j] == 0)
+				{
+					continue;
+				}
 
-		GraphicsSetSourceSurface(&window->mask_temp->context.base, &window->temp_layer->surface.base, 0, 0, &local_pattern);
-		GraphicsPaint(&window->mask_temp->context.base);
+				value = ((color >> 24) & 0xff) * mask_line[j] + 128;
+				alpha = (value + (value >> 8)) >> 8;
+				for(k=0; k<4; k++)
+				{
+					unsigned int source_value = ((color >> (k*8)) & 0xff) * mask_line[j] + 128;
+					unsigned int destination_value = destination[k] * (255 - alpha) + 128;
+					destination[k] = (uint8)(((source_value + (source_value >> 8)) >> 8)
+						+ ((destination_value + (destination_value >> 8)) >> 8));
+				}
+			}
+		}
+	}
+}
 
-		GraphicsRestore(&window->mask_temp->context.base);
+/*
+* TransformOutput関数
+* 自由変形の描画
+*  変形後の範囲の各ピクセルを元画像へ逆変換して双線形補間し
+*  輪郭のマスクを掛けてレイヤーへ合成する
+*  プレビュー時はscale四方のブロック単位で縮小画像から色を取得する
+*  ブロックの行毎にスレッドプールで分担する
+* 引数
+* transform		: 変形処理用のデータ
+* current_layer	: 描画するレイヤーのインデックス
+* quads			: 分割した四角形
+* mask			: 変形後の輪郭のマスク(描画範囲の大きさ)
+* mask_stride	: マスクの1行分のバイト数
+* min_x			: 描画範囲の左上のX座標
+* min_y			: 描画範囲の左上のY座標
+* width			: 描画範囲の幅
+* height		: 描画範囲の高さ
+* scale			: 元画像の縮小率(1なら原寸で描画)
+*/
+static void TransformOutput(
+	TRANSFORM_DATA* transform,
+	int current_layer,
+	const TRANSFORM_QUAD* quads,
+	const uint8* mask,
+	int mask_stride,
+	int min_x,
+	int min_y,
+	int width,
+	int height,
+	int scale
+)
+{
+	TRANSFORM_OUTPUT_DATA output;
+
+	output.layer = transform->layers[current_layer];
+	output.source = transform->source_pixels[current_layer];
+	output.quads = quads;
+	output.mask = mask;
+	output.div_scale = 1.0 / scale;
+	output.source_width = transform->width;
+	output.source_height = transform->height;
+	output.source_stride = transform->stride;
+	output.mask_stride = mask_stride;
+	output.min_x = min_x;
+	output.min_y = min_y;
+	output.width = width;
+	output.height = height;
+	output.scale = scale;
+
+	if(scale > 1)
+	{
+		output.source = transform->preview_pixels[current_layer];
+		output.source_width = transform->preview_width;
+		output.source_height = transform->preview_height;
+		output.source_stride = transform->preview_width * 4;
 	}
+
+	ExecuteParallelLoop((height + scale - 1) / scale, TransformOutputBlockRow, &output);
 }
 
 static void TransformOutputSelectionArea(TRANSFORM_DATA* transform, uint8* source_pixels)
@@ -655,67 +961,388 @@ static void TransformOutputSelectionArea(TRANSFORM_DATA* transform, uint8* sourc
 }
 
 /*
-* Transform関数
-* 自由変形を実行
+* TransformPreviewScale関数
+* ドラッグ中のプレビューで使う元画像の縮小率を決める
+*  表示倍率で縮小して見える分と処理するピクセル数の上限から2の累乗で決める
 * 引数
 * transform	: 変形処理用のデータ
+* 返り値
+*	縮小率(1なら縮小しない)
 */
-void Transform(TRANSFORM_DATA* transform)
+static int TransformPreviewScale(TRANSFORM_DATA* transform)
 {
 	DRAW_WINDOW *window = transform->layers[0]->window;
-	GRAPHICS_DEFAULT_CONTEXT context = {0};
+	int scale = 1;
+
+	while(scale < TRANSFORM_PREVIEW_MAX_SCALE && scale * 2 * window->zoom <= 100)
+	{
+		scale *= 2;
+	}
+	while(scale < TRANSFORM_PREVIEW_MAX_SCALE
+		&& (FLOAT_T)(transform->width / scale) * (transform->height / scale) * transform->num_layers
+			> TRANSFORM_PREVIEW_MAX_PIXELS)
+	{
+		scale *= 2;
+	}
+
+	return scale;
+}
+
+/*
+* TRANSFORM_PREVIEW_DATA構造体
+* プレビュー用の縮小をスレッドプールで処理するためのデータ
+*/
+typedef struct _TRANSFORM_PREVIEW_DATA
+{
+	TRANSFORM_DATA *transform;
+	const uint8 *source;
+	uint8 *preview;
+	int preview_width;
+	int scale;
+} TRANSFORM_PREVIEW_DATA;
+
+/*
+* ShrinkTransformPreviewRow関数
+* スレッドプールから呼び出されてプレビュー用のデータを1行分作成する
+* 引数
+* y				: プレビュー用のデータの行
+* thread_index	: 処理しているスレッドの番号
+* data			: TRANSFORM_PREVIEW_DATA構造体のアドレス
+*/
+static void ShrinkTransformPreviewRow(int y, int thread_index, void* data)
+{
+	TRANSFORM_PREVIEW_DATA *shrink = (TRANSFORM_PREVIEW_DATA*)data;
+	TRANSFORM_DATA *transform = shrink->transform;
+	const uint8 *source = shrink->source;
+	uint8 *preview = shrink->preview;
+	int preview_width = shrink->preview_width;
+	int scale = shrink->scale;
+	int x;
+
+	(void)thread_index;
+
+	for(x=0; x<preview_width; x++)
+	{
+		unsigned int sum[4] = {0, 0, 0, 0};
+		int count = 0;
+		int j, k;
+
+		for(j=y*scale; j<(y+1)*scale && j<transform->height; j++)
+		{
+			const uint8 *line = &source[j*transform->stride];
+			for(k=x*scale; k<(x+1)*scale && k<transform->width; k++)
+			{
+				sum[0] += line[k*4+0];
+				sum[1] += line[k*4+1];
+				sum[2] += line[k*4+2];
+				sum[3] += line[k*4+3];
+				count++;
+			}
+		}
+
+		for(j=0; j<4; j++)
+		{
+			preview[(y*preview_width+x)*4+j] = (uint8)((sum[j] + count / 2) / count);
+		}
+	}
+}
+
+/*
+* UpdateTransformPreviewPixels関数
+* 変形領域のピクセルデータを縮小したプレビュー用のデータを作成する
+*  縮小率が前回と同じなら作成済みのデータを使う
+* 引数
+* transform	: 変形処理用のデータ
+* scale		: 縮小率
+*/
+static void UpdateTransformPreviewPixels(TRANSFORM_DATA* transform, int scale)
+{
+	int preview_width = (transform->width + scale - 1) / scale;
+	int preview_height = (transform->height + scale - 1) / scale;
+	TRANSFORM_PREVIEW_DATA shrink;
+	unsigned int i;
+
+	if(transform->preview_pixels != NULL && transform->preview_scale == scale)
+	{
+		return;
+	}
+
+	if(transform->preview_pixels == NULL)
+	{
+		transform->preview_pixels = (uint8**)MEM_CALLOC_FUNC(
+			transform->num_layers, sizeof(*transform->preview_pixels));
+	}
+	transform->preview_scale = scale;
+	transform->preview_width = preview_width;
+	transform->preview_height = preview_height;
+
+	shrink.transform = transform;
+	shrink.preview_width = preview_width;
+	shrink.scale = scale;
+	for(i=0; i<transform->num_layers; i++)
+	{
+		MEM_FREE_FUNC(transform->preview_pixels[i]);
+		shrink.source = transform->source_pixels[i];
+		shrink.preview = transform->preview_pixels[i] = (uint8*)MEM_ALLOC_FUNC(
+			preview_width * preview_height * 4);
+
+		// 乗算済みアルファなのでチャンネルごとの平均で縮小できる
+		ExecuteParallelLoop(preview_height, ShrinkTransformPreviewRow, &shrink);
+	}
+}
+
+/*
+* TransformWithScale関数
+* 自由変形を指定した縮小率で実行
+*  変形前後の範囲のみ更新するのでレイヤー全体のコピーや消去は行わない
+* 引数
+* transform	: 変形処理用のデータ
+* scale		: 元画像の縮小率(1なら原寸で描画)
+*/
+static void TransformWithScale(TRANSFORM_DATA* transform, int scale)
+{
+	DRAW_WINDOW *window = transform->layers[0]->window;
+	TRANSFORM_QUAD quads[4];
+	GRAPHICS_DEFAULT_CONTEXT context;
 	GRAPHICS_IMAGE_SURFACE surface;
+	FLOAT_T left, top, right, bottom;
+	uint8 *mask;
+	int min_x, min_y, max_x, max_y;
+	int restore_min_x, restore_min_y, restore_max_x, restore_max_y;
+	int width, height, mask_stride;
 	unsigned int i;
+	int j;
 
-	(void)memset(window->brush_buffer, 0, window->pixel_buf_size);
-	InitializeGraphicsImageSurfaceForData(&surface, window->brush_buffer, GRAPHICS_FORMAT_A8, 
-				window->width, window->height, window->width, &window->app->graphics);
+	// 変形後の範囲を求める
+	left = right = transform->trans[0][0];
+	top = bottom = transform->trans[0][1];
+	for(j=1; j<8; j++)
+	{
+		if(left > transform->trans[j][0])
+		{
+			left = transform->trans[j][0];
+		}
+		if(right < transform->trans[j][0])
+		{
+			right = transform->trans[j][0];
+		}
+		if(top > transform->trans[j][1])
+		{
+			top = transform->trans[j][1];
+		}
+		if(bottom < transform->trans[j][1])
+		{
+			bottom = transform->trans[j][1];
+		}
+	}
+	min_x = (int)floor(left) - 1,	min_y = (int)floor(top) - 1;
+	max_x = (int)ceil(right) + 1,	max_y = (int)ceil(bottom) + 1;
+	if(min_x < 0)
+	{
+		min_x = 0;
+	}
+	if(min_y < 0)
+	{
+		min_y = 0;
+	}
+	if(max_x > window->width)
+	{
+		max_x = window->width;
+	}
+	if(max_y > window->height)
+	{
+		max_y = window->height;
+	}
+	if(max_x < min_x)
+	{
+		max_x = min_x;
+	}
+	if(max_y < min_y)
+	{
+		max_y = min_y;
+	}
+	width = max_x - min_x,	height = max_y - min_y;
+
+	// 前回の描画範囲と今回の描画範囲を変形前のピクセルデータに戻す
+	restore_min_x = (transform->update_min_x < min_x) ? transform->update_min_x : min_x;
+	restore_min_y = (transform->update_min_y < min_y) ? transform->update_min_y : min_y;
+	restore_max_x = (transform->update_max_x > max_x) ? transform->update_max_x : max_x;
+	restore_max_y = (transform->update_max_y > max_y) ? transform->update_max_y : max_y;
+	if(restore_max_x > restore_min_x)
+	{
+		for(i=0; i<transform->num_layers; i++)
+		{
+			LAYER *layer = transform->layers[i];
+			for(j=restore_min_y; j<restore_max_y; j++)
+			{
+				(void)memcpy(&layer->pixels[j*layer->stride+restore_min_x*4],
+					&transform->before_pixels[i][j*layer->stride+restore_min_x*4],
+						(restore_max_x - restore_min_x) * 4);
+			}
+			InvalidateLayerSetCache(layer, restore_min_x, restore_min_y,
+				restore_max_x - restore_min_x, restore_max_y - restore_min_y);
+		}
+	}
+	transform->update_min_x = min_x,	transform->update_min_y = min_y;
+	transform->update_max_x = max_x,	transform->update_max_y = max_y;
+
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	// 変形後の輪郭を描画範囲の大きさのマスクに塗りつぶす
+	mask_stride = GraphicsFormatStrideForWidth(GRAPHICS_FORMAT_A8, width);
+	mask = (uint8*)MEM_CALLOC_FUNC(mask_stride, height);
+	InitializeGraphicsImageSurfaceForData(&surface, mask, GRAPHICS_FORMAT_A8,
+		width, height, mask_stride, &window->app->graphics);
 	InitializeGraphicsDefaultContext(&context, &surface, &window->app->graphics);
+	GraphicsTranslate(&context.base, - min_x, - min_y);
 	GraphicsMoveTo(&context.base, transform->trans[0][0], transform->trans[0][1]);
-	for(i=1; i<8; i++)
+	for(j=1; j<8; j++)
 	{
-		GraphicsLineTo(&context.base, transform->trans[i][0], transform->trans[i][1]);
+		GraphicsLineTo(&context.base, transform->trans[j][0], transform->trans[j][1]);
 	}
 	GraphicsClosePath(&context.base);
 	GraphicsFill(&context.base);
+	DestroyGraphicsContext(&context.base);
+	DestroyGraphicsSurface(&surface.base);
+
+	SetTransformQuads(transform, quads);
 
 	for(i=0; i<transform->num_layers; i++)
 	{
-		GRAPHICS_SURFACE_PATTERN local_pattern;
-		
-		(void)memset(window->mask_temp->pixels, 0, window->pixel_buf_size);
-		(void)memcpy(transform->layers[i]->pixels, transform->before_pixels[i], window->pixel_buf_size);
-		TransformOutput(transform, i);
+		TransformOutput(transform, (int)i, quads, mask, mask_stride, min_x, min_y, width, height, scale);
+	}
 
-		GraphicsSetOperator(&transform->layers[i]->context.base, GRAPHICS_OPERATOR_OVER);
-		GraphicsSetSourceSurface(&transform->layers[i]->context.base, &window->mask_temp->surface.base, 0, 0, &local_pattern);
-		GraphicsMaskSurface(&transform->layers[i]->context.base, &surface.base, 0, 0);
+	MEM_FREE_FUNC(mask);
+}
+
+/*
+* Transform関数
+* 自由変形を実行
+* 引数
+* transform	: 変形処理用のデータ
+*/
+void Transform(TRANSFORM_DATA* transform)
+{
+	TransformWithScale(transform, 1);
+	transform->flags &= ~(TRANSFORM_IN_PREVIEW);
+}
+
+/*
+* TransformPreview関数
+* ドラッグ中の自由変形を縮小画像で実行する
+*  ボタンを離した時にTransformButtonReleaseで原寸で描画し直す
+* 引数
+* transform	: 変形処理用のデータ
+*/
+static void TransformPreview(TRANSFORM_DATA* transform)
+{
+	int scale = TransformPreviewScale(transform);
+
+	if(scale <= 1)
+	{
+		Transform(transform);
+		return;
 	}
 
-	DestroyGraphicsSurface(&surface.base);
-	DestroyGraphicsContext(&context.base);
-	(void)memset(window->brush_buffer, 0, window->pixel_buf_size);
+	UpdateTransformPreviewPixels(transform, scale);
+	TransformWithScale(transform, scale);
+	transform->flags |= TRANSFORM_IN_PREVIEW;
 }
 
 /*
-* ProjectionTransform関数
-* 射影変形処理を実行
+* PROJECTION_TRANSFORM_ROW_DATA構造体
+* 射影変形の描画をスレッドプールで処理するためのデータ
+*/
+typedef struct _PROJECTION_TRANSFORM_ROW_DATA
+{
+	TRANSFORM_DATA *transform;
+	const uint8 *source;
+	LAYER *destination;
+	const FLOAT_T *parameter;
+	int stride;
+	int source_width;
+	int source_height;
+	int start_x;
+	int end_x;
+	int start_y;
+} PROJECTION_TRANSFORM_ROW_DATA;
+
+/*
+* ProjectionTransformRow関数
+* スレッドプールから呼び出されて射影変形を1行分描画する
+* 引数
+* index			: 描画範囲の上端からの行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: PROJECTION_TRANSFORM_ROW_DATA構造体のアドレス
+*/
+static void ProjectionTransformRow(int index, int thread_index, void* data)
+{
+	PROJECTION_TRANSFORM_ROW_DATA *scanline = (PROJECTION_TRANSFORM_ROW_DATA*)data;
+	TRANSFORM_DATA *transform = scanline->transform;
+	float map_x[PROJECTION_SCANLINE_LENGTH], map_y[PROJECTION_SCANLINE_LENGTH];
+	int k = scanline->start_y + index;
+	uint8 *destination = &scanline->destination->pixels[scanline->destination->stride*k];
+	int m, n;
+
+	(void)thread_index;
+
+	for(m=scanline->start_x; m<scanline->end_x; m+=PROJECTION_SCANLINE_LENGTH)
+	{
+		int length = (m + PROJECTION_SCANLINE_LENGTH > scanline->end_x)
+			? scanline->end_x - m : PROJECTION_SCANLINE_LENGTH;
+
+		ProjectionScanline(scanline->parameter, m, k, length, map_x, map_y);
+		for(n=0; n<length; n++)
+		{
+			FLOAT_T source_x = map_x[n] - transform->x;
+			FLOAT_T source_y = map_y[n] - transform->y;
+
+			if(source_x >= -0.5 && source_x < scanline->source_width - 0.5
+				&& source_y >= -0.5 && source_y < scanline->source_height - 0.5)
+			{
+				*(uint32*)&destination[(m+n)*4] = TransformSample(scanline->source, scanline->stride,
+					scanline->source_width, scanline->source_height, source_x, source_y);
+			}
+		}
+	}
+}
+
+/*
+* ProjectionTransformWithScale関数
+* 射影変形処理を指定した縮小率で実行
 * 引数
 * transform			: 変形処理用のデータ
 * projection_param	: 射影変換用のパラメーター
+* scale				: 元画像の縮小率(1なら原寸で描画)
 */
-void ProjectionTransform(TRANSFORM_DATA* transform, FLOAT_T projection_param[4][9])
+static void ProjectionTransformWithScale(
+	TRANSFORM_DATA* transform,
+	FLOAT_T projection_param[4][9],
+	int scale
+)
 {
 	DRAW_WINDOW *window = transform->layers[0]->window;
 	FLOAT_T src[2], dst[2];
 	GRAPHICS_DEFAULT_CONTEXT context = {0};
 	GRAPHICS_IMAGE_SURFACE surface;
+	PROJECTION_TRANSFORM_ROW_DATA scanline;
 	int x, y;
 	int stride = transform->width * 4;
+	int source_width = transform->width,	source_height = transform->height;
 	int start_x, end_x, start_y, end_y;
 	unsigned int i;
 	int j, k, l;
 
+	if(scale > 1)
+	{
+		stride = transform->preview_width * 4;
+		source_width = transform->preview_width;
+		source_height = transform->preview_height;
+	}
+
 	(void)memset(window->brush_buffer, 0, window->pixel_buf_size);
 	InitializeGraphicsImageSurfaceForData(&surface, window->brush_buffer, GRAPHICS_FORMAT_A8, 
 				window->width, window->height, window->width, &window->app->graphics);
@@ -765,41 +1392,150 @@ void ProjectionTransform(TRANSFORM_DATA* transform, FLOAT_T projection_param[4][
 				end_y = transform->layers[i]->height;
 			}
 
-			for(k=transform->min_y[j]; k<transform->max_y[j]; k++)
+			if(scale > 1)
 			{
-				for(l=transform->min_x[j]; l<transform->max_x[j]; l++)
-				{
-					src[0] = l, src[1] = k;
-					Projection(src, dst, projection_param[j]);
-
-					x = (int)(dst[0] + 0.5) - transform->x;
-					y = (int)(dst[1] + 0.5) - transform->y;
+				const uint8 *source = transform->preview_pixels[i];
 
-					if(x >= 0 && x < transform->width
-						&& y >= 0 && y < transform->height)
+				// プレビュー時はブロックの中心で変換した色をブロック全体に書き込む
+				for(k=start_y; k<end_y; k+=scale)
+				{
+					for(l=start_x; l<end_x; l+=scale)
 					{
-						window->temp_layer->pixels[window->temp_layer->stride*k + l*4]
-							= transform->source_pixels[i][y*stride+x*4];
-						window->temp_layer->pixels[window->temp_layer->stride*k + l*4 + 1]
-							= transform->source_pixels[i][y*stride+x*4 + 1];
-						window->temp_layer->pixels[window->temp_layer->stride*k + l*4 + 2]
-							= transform->source_pixels[i][y*stride+x*4 + 2];
-						window->temp_layer->pixels[window->temp_layer->stride*k + l*4 + 3]
-							= transform->source_pixels[i][y*stride+x*4 + 3];
+						int block_width = (l + scale > end_x) ? end_x - l : scale;
+						int block_height = (k + scale > end_y) ? end_y - k : scale;
+						int m, n;
+
+						src[0] = l + block_width * 0.5, src[1] = k + block_height * 0.5;
+						Projection(src, dst, projection_param[j]);
+
+						x = (int)((dst[0] - transform->x) / scale);
+						y = (int)((dst[1] - transform->y) / scale);
+
+						if(dst[0] >= transform->x && x < source_width
+							&& dst[1] >= transform->y && y < source_height)
+						{
+							for(m=0; m<block_height; m++)
+							{
+								for(n=0; n<block_width; n++)
+								{
+									(void)memcpy(&window->temp_layer->pixels[window->temp_layer->stride*(k+m) + (l+n)*4],
+										&source[y*stride+x*4], 4);
+								}
+							}
+						}
 					}
 				}
+				continue;
 			}
+
+			// 1行ずつまとめて射影変換して双線形補間で色を取得する
+			scanline.transform = transform;
+			scanline.source = transform->source_pixels[i];
+			scanline.destination = window->temp_layer;
+			scanline.parameter = projection_param[j];
+			scanline.stride = stride;
+			scanline.source_width = source_width;
+			scanline.source_height = source_height;
+			scanline.start_x = start_x;
+			scanline.end_x = end_x;
+			scanline.start_y = start_y;
+			ExecuteParallelLoop(end_y - start_y, ProjectionTransformRow, &scanline);
 		}
 
 		GraphicsSetOperator(&transform->layers[i]->context.base, GRAPHICS_OPERATOR_OVER);
 		GraphicsSetSourceSurface(&transform->layers[i]->context.base,
 				&window->temp_layer->surface.base, 0, 0, &local_pattern);
 		GraphicsMaskSurface(&transform->layers[i]->context.base, &surface.base, 0, 0);
+		InvalidateLayerSetCache(transform->layers[i], 0, 0, 0, 0);
 	}
 
 	DestroyGraphicsSurface(&surface.base);
 	DestroyGraphicsContext(&context.base);
 	(void)memset(window->brush_buffer, 0, window->pixel_buf_size);
+
+	// レイヤー全体を書き換えたので次の自由変形では全体を戻す
+	transform->update_min_x = transform->update_min_y = 0;
+	transform->update_max_x = window->width,	transform->update_max_y = window->height;
+}
+
+/*
+* ProjectionTransform関数
+* 射影変形処理を実行
+* 引数
+* transform			: 変形処理用のデータ
+* projection_param	: 射影変換用のパラメーター
+*/
+void ProjectionTransform(TRANSFORM_DATA* transform, FLOAT_T projection_param[4][9])
+{
+	if(projection_param != transform->projection_parameter)
+	{
+		(void)memcpy(transform->projection_parameter, projection_param,
+			sizeof(transform->projection_parameter));
+	}
+	ProjectionTransformWithScale(transform, projection_param, 1);
+	transform->flags &= ~(TRANSFORM_IN_PREVIEW);
+}
+
+/*
+* ProjectionTransformPreview関数
+* ドラッグ中の射影変形を縮小画像で実行する
+*  ボタンを離した時にTransformButtonReleaseで原寸で描画し直す
+* 引数
+* transform			: 変形処理用のデータ
+* projection_param	: 射影変換用のパラメーター
+*/
+static void ProjectionTransformPreview(TRANSFORM_DATA* transform, FLOAT_T projection_param[4][9])
+{
+	int scale = TransformPreviewScale(transform);
+
+	if(scale <= 1)
+	{
+		ProjectionTransform(transform, projection_param);
+		return;
+	}
+
+	(void)memcpy(transform->projection_parameter, projection_param,
+		sizeof(transform->projection_parameter));
+	UpdateTransformPreviewPixels(transform, scale);
+	ProjectionTransformWithScale(transform, projection_param, scale);
+	transform->flags |= TRANSFORM_IN_PREVIEW;
+}
+
+/*
+* TransformButtonRelease関数
+* 変形処理中のマウスボタンを離した時の処理
+*  ドラッグ中に縮小画像でプレビューしていれば原寸で描画し直す
+* 引数
+* transform	: 変形処理用のデータ
+*/
+void TransformButtonRelease(TRANSFORM_DATA* transform)
+{
+	DRAW_WINDOW *window = transform->layers[0]->window;
+
+	transform->trans_point = TRANSFORM_POINT_NONE;
+
+	if((transform->flags & TRANSFORM_IN_PREVIEW) == 0)
+	{
+		return;
+	}
+
+	if(transform->trans_type == TRANSFORM_PROJECTION)
+	{
+		ProjectionTransform(transform, transform->projection_parameter);
+	}
+	else
+	{
+		Transform(transform);
+	}
+
+	if(transform->layers[0] == window->active_layer)
+	{
+		window->flags |= DRAW_WINDOW_UPDATE_ACTIVE_OVER;
+	}
+	else
+	{
+		window->flags |= DRAW_WINDOW_UPDATE_ACTIVE_UNDER;
+	}
 }
 
 void TransformButtonPress(TRANSFORM_DATA* transform, FLOAT_T x, FLOAT_T y)
@@ -1238,7 +1974,7 @@ void ProjectionTransformMotionNotify(
 				}
 			}
 
-			ProjectionTransform(transform, parameter);
+			ProjectionTransformPreview(transform, parameter);
 		}
 
 		transform->before_x = x, transform->before_y = y;
@@ -1654,7 +2390,7 @@ void TransformMotionNotify(
 				}
 			}
 
-			Transform(transform);
+			TransformPreview(transform);
 		}
 
 		transform->before_x = x, transform->before_y = y;
@@ -1750,6 +2486,7 @@ void TransformUndoRedo(DRAW_WINDOW *window, void* p)
 		{
 			layer = layer->next;
 		}
+		(void)MaterializeLayerPixels(layer);
 
 		for(j=0; j<(unsigned int)data.height; j++)
 		{
@@ -1766,6 +2503,7 @@ void TransformUndoRedo(DRAW_WINDOW *window, void* p)
 			(void)memcpy(&data.pixels[i][data.width*4*j],
 				&window->temp_layer->pixels[data.width*4*j], data.width*4);
 		}
+		InvalidateLayerSetCache(layer, data.x, data.y, data.width, data.height);
 	}
 	for(j=0; j<(unsigned int)data.height; j++)
 	{
@@ -2065,6 +2803,7 @@ static void ClickedTransformButtonCancel(GtkWidget* button, APPLICATION* app)
 			window->transform->layers[i]->stride * window->transform->layers[i]->height);
 		cairo_set_source_surface(restore_cairo, before_surface, 0, 0);
 		cairo_paint(restore_cairo);
+		InvalidateLayerSetCache(window->transform->layers[i], 0, 0, 0, 0);
 
 		cairo_destroy(restore_cairo);
 		cairo_surface_destroy(before_surface);
@@ -33,12 +33,21 @@ typedef struct _TRANSFORM_DATA
 	FLOAT_T last_x, last_y;			// 最後に変形した座標を記憶
 	// 射影変換を行う範囲
 	int min_x[4], max_x[4], min_y[4], max_y[4];
+	// 自由変形で前回書き込んだ範囲
+	int update_min_x, update_min_y, update_max_x, update_max_y;
+	// ドラッグ中のプレビュー用に縮小したピクセルデータ
+	uint8 **preview_pixels;
+	int preview_scale;				// プレビューの縮小率
+	int preview_width, preview_height;	// 縮小したピクセルデータの幅と高さ
+	// 最後に計算した射影変換のパラメーター
+	FLOAT_T projection_parameter[4][9];
 } TRANSFORM_DATA;
 
 typedef enum _eTRANSFORM_FLAGS
 {
 	TRANSFORM_REVERSE_HORIZONTALLY = 0x01,
-	TRANSFORM_REVERSE_VERTICALLY = 0x02
+	TRANSFORM_REVERSE_VERTICALLY = 0x02,
+	TRANSFORM_IN_PREVIEW = 0x04		// 縮小画像でプレビューしている
 } eTRANSFORM_FLAGS;
 
 typedef enum _eTRANSFORM_POINT
@@ -89,8 +98,38 @@ EXTERN TRANSFORM_DATA *CreateTransformData(DRAW_WINDOW* window);
 */
 EXTERN void DeleteTransformData(TRANSFORM_DATA** transform);
 
+/*
+* ProjectionScanline関数
+* 水平に並んだ座標をまとめて射影変換する
+*  変形処理以外(パース定規等)からも利用できる
+* 引数
+* parameter	: 射影変換用のパラメーター(CalcProjectionParameterで計算)
+* x			: 変換する最初の座標のX座標
+* y			: 変換する座標のY座標
+* length	: 変換する座標の数
+* out_x		: 変換後のX座標を格納する配列
+* out_y		: 変換後のY座標を格納する配列
+*/
+EXTERN void ProjectionScanline(
+	const FLOAT_T parameter[9],
+	FLOAT_T x,
+	FLOAT_T y,
+	int length,
+	float* out_x,
+	float* out_y
+);
+
 EXTERN void TransformButtonPress(TRANSFORM_DATA* transform, FLOAT_T x, FLOAT_T y);
 
+/*
+* TransformButtonRelease関数
+* 変形処理中のマウスボタンを離した時の処理
+*  ドラッグ中に縮小画像でプレビューしていれば原寸で描画し直す
+* 引数
+* transform	: 変形処理用のデータ
+*/
+EXTERN void TransformButtonRelease(TRANSFORM_DATA* transform);
+
 #ifdef __cplusplus
 }
 #endif
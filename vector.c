@@ -20,6 +20,14 @@
 #include "memory_stream.h"
 #include "memory.h"
 #include "vector_brushes.h"
+#include "vector_outline.h"
+
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <pthread.h>
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -104,491 +112,84 @@ void DeleteVectorLineLayer(VECTOR_LINE_LAYER** layer)
 	*layer = NULL;
 }
 
-void StrokeStraightLine(
-	DRAW_WINDOW* window,
-	VECTOR_LINE* line,
-	VECTOR_LAYER_RECTANGLE* rect
-)
+/*
+* AddStraightOutline関数
+* 折れ線の制御点を可変幅の輪郭の中心線に追加する
+* 引数
+* outline	: 点を追加する中心線
+* line		: 折れ線のベクトルデータ
+* close		: 始点に戻って閉じる場合はTRUE
+*/
+static void AddStraightOutline(VECTOR_OUTLINE* outline, VECTOR_LINE* line, int close)
 {
-	FLOAT_T r, half_r, d, div_d, arg, dist;
-	int32 min_x, min_y, max_x, max_y;
-	FLOAT_T draw_x, draw_y;
-	FLOAT_T dx, dy, cos_x, sin_y;
-	FLOAT_T ad, bd;
-	FLOAT_T red, green, blue, alpha;
-	GRAPHICS_RADIAL_PATTERN brush;
-	GRAPHICS *graphics;
-	int i, x, y;
-
-	graphics = &window->app->graphics;
-
-	GraphicsSetOperator(&window->temp_layer->context.base, GRAPHICS_OPERATOR_OVER);
-	rect->min_x = rect->max_x = line->points->x;
-	rect->min_y = rect->max_y = line->points->y;
+	VECTOR_POINT *last = line->points;
+	FLOAT_T dx, dy;
+	int i;
 
-	for(i=0; i<line->num_points-1; i++)
+	AddVectorOutlinePoint(outline, line->points[0].x, line->points[0].y,
+		line->points[0].size * line->points[0].pressure * 0.01f, &line->points[0], &line->points[0], 0);
+	for(i=1; i<=line->num_points; i++)
 	{
-		dx = line->points[i].x-line->points[i+1].x;
-		dy = line->points[i].y-line->points[i+1].y;
-		d = sqrt(dx*dx+dy*dy);
+		VECTOR_POINT *point;
 
-		if(d < 0.5)
+		if(i == line->num_points)
 		{
-			continue;
-		}
-
-		div_d = 1.0 / d;
-		dist = 0.0;
-		arg = atan2(dy, dx);
-		cos_x = cos(arg), sin_y = sin(arg);
-		draw_x = line->points[i].x, draw_y = line->points[i].y;
-
-		dx = d;
-
-		do
-		{
-			ad = (d - dist) * div_d, bd = dist * div_d;
-			r = line->points[i].size * line->points[i].pressure * 0.01f * ad
-				+ line->points[i+1].size * line->points[i+1].pressure * 0.01f * bd;
-			half_r = r * 0.125;
-			if(half_r < 0.5)
-			{
-				half_r = 0.5;
-			}
-			dist += half_r;
-
-			min_x = (int32)(draw_x - r - 1);
-			min_y = (int32)(draw_y - r - 1);
-			max_x = (int32)(draw_x + r + 1);
-			max_y = (int32)(draw_y + r + 1);
-
-			if(min_x < 0)
-			{
-				min_x = 0;
-			}
-			else if(min_x > window->width)
-			{
-				min_x = window->width;
-			}
-			if(min_y < 0)
+			if(close == FALSE)
 			{
-				min_y = 0;
-			}
-			else if(min_y > window->height)
-			{
-				min_y = window->height;
-			}
-			if(max_x > window->width)
-			{
-				max_x = window->width;
-			}
-			else if(max_x < 0)
-			{
-				max_x = 0;
-			}
-			if(max_y > window->height)
-			{
-				max_y = window->height;
-			}
-			else if(max_y < 0)
-			{
-				max_y = 0;
-			}
-
-			if(rect->min_x > min_x)
-			{
-				rect->min_x = min_x;
-			}
-			if(rect->min_y > min_y)
-			{
-				rect->min_y = min_y;
-			}
-			if(rect->max_x < max_x)
-			{
-				rect->max_x = max_x;
-			}
-			if(rect->max_y < max_y)
-			{
-				rect->max_y = max_y;
-			}
-			
-			for(y=min_y; y<max_y; y++)
-			{
-				(void)memset(&window->temp_layer->pixels[y*window->temp_layer->stride+min_x*window->temp_layer->channel],
-					0, (max_x - min_x)*window->temp_layer->channel);
-			}
-
-			ad *= DIV_PIXEL, bd *= DIV_PIXEL;
-			red = (line->points[i].color[0] * ad) + (line->points[i+1].color[0] * bd);
-			green = (line->points[i].color[1] * ad) + (line->points[i+1].color[1] * bd);
-			blue = (line->points[i].color[2] * ad) + (line->points[i+1].color[2] * bd);
-			alpha = (line->points[i].color[3] * ad) + (line->points[i+1].color[3] * bd);
-
-			InitializeGraphicsPatternRadial(&brush, draw_x, draw_y, r * 0.0, draw_x, draw_y, r, graphics);
-			GraphicsPatternSetExtend(&brush.base.base, GRAPHICS_EXTEND_NONE);
-			GraphicsPatternAddColorStopRGBA(&brush.base.base, 0.0, red, green, blue, alpha);
-			GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0-line->blur*0.01,
-												red, green, blue, alpha);
-			GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0, red, green, blue,
-												line->outline_hardness*0.01*alpha);
-			GraphicsSetSource(&window->temp_layer->context.base, &brush.base);
-
-			GraphicsArc(&window->temp_layer->context.base, draw_x, draw_y, r, 0, 2*M_PI);
-			GraphicsFill(&window->temp_layer->context.base);
-
-			for(y=min_y; y<max_y; y++)
-			{
-				for(x=min_x; x<max_x; x++)
-				{
-					if(window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->channel+3])
-					{
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel];
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+1]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1];
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+2]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2];
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3];
-					}
-				}
+				break;
 			}
+			point = line->points;
+		}
+		else
+		{
+			point = &line->points[i];
+		}
 
-			DestroyGraphicsPattern(&brush.base.base);
+		// 短すぎる線分は描画しない
+		dx = point->x - last->x,	dy = point->y - last->y;
+		if(dx*dx + dy*dy < 0.5*0.5)
+		{
+			continue;
+		}
 
-			dx -= half_r;
-			draw_x -= cos_x*half_r, draw_y -= sin_y*half_r;
-		} while(dx >= half_r);
+		AddVectorOutlinePoint(outline, point->x, point->y,
+			point->size * point->pressure * 0.01f, point, point, 0);
+		last = point;
 	}
 }
 
-void StrokeStraightCloseLine(
+void StrokeStraightLine(
 	DRAW_WINDOW* window,
 	VECTOR_LINE* line,
 	VECTOR_LAYER_RECTANGLE* rect
 )
 {
-	FLOAT_T r, half_r, d, div_d, arg, dist;
-	int32 min_x, min_y, max_x, max_y;
-	FLOAT_T draw_x, draw_y;
-	FLOAT_T dx, dy, cos_x, sin_y;
-	FLOAT_T ad, bd;
-	FLOAT_T red, green, blue, alpha;
-	GRAPHICS_RADIAL_PATTERN brush;
-	GRAPHICS *graphics;
-	int i, x, y;
-
-	graphics = &window->app->graphics;
+	VECTOR_OUTLINE outline;
 
-	GraphicsSetOperator(&window->temp_layer->context.base, GRAPHICS_OPERATOR_OVER);
 	rect->min_x = rect->max_x = line->points->x;
 	rect->min_y = rect->max_y = line->points->y;
 
-	for(i=0; i<line->num_points-1; i++)
-	{
-		dx = line->points[i].x-line->points[i+1].x;
-		dy = line->points[i].y-line->points[i+1].y;
-		d = sqrt(dx*dx+dy*dy);
-
-		if(d < 0.5)
-		{
-			continue;
-		}
-
-		div_d = 1.0 / d;
-		dist = 0.0;
-		arg = atan2(dy, dx);
-		cos_x = cos(arg), sin_y = sin(arg);
-		draw_x = line->points[i].x, draw_y = line->points[i].y;
-
-		dx = d;
-
-		do
-		{
-			ad = (d - dist) * div_d, bd = dist * div_d;
-			r = line->points[i].size * line->points[i].pressure * 0.01f * ad
-				+ line->points[i+1].size * line->points[i+1].pressure * 0.01f * bd;
-			half_r = r * 0.125;
-			if(half_r < 0.5)
-			{
-				half_r = 0.5;
-			}
-			dist += half_r;
-
-			min_x = (int32)(draw_x - r - 1);
-			min_y = (int32)(draw_y - r - 1);
-			max_x = (int32)(draw_x + r + 1);
-			max_y = (int32)(draw_y + r + 1);
-
-			if(min_x < 0)
-			{
-				min_x = 0;
-			}
-			else if(min_x > window->width)
-			{
-				min_x = window->width;
-			}
-			if(min_y < 0)
-			{
-				min_y = 0;
-			}
-			else if(min_y > window->height)
-			{
-				min_y = window->height;
-			}
-			if(max_x > window->width)
-			{
-				max_x = window->width;
-			}
-			else if(max_x < 0)
-			{
-				max_x = 0;
-			}
-			if(max_y > window->height)
-			{
-				max_y = window->height;
-			}
-			else if(max_y < 0)
-			{
-				max_y = 0;
-			}
-
-			if(rect->min_x > min_x)
-			{
-				rect->min_x = min_x;
-			}
-			if(rect->min_y > min_y)
-			{
-				rect->min_y = min_y;
-			}
-			if(rect->max_x < max_x)
-			{
-				rect->max_x = max_x;
-			}
-			if(rect->max_y < max_y)
-			{
-				rect->max_y = max_y;
-			}
-			
-			for(y=min_y; y<max_y; y++)
-			{
-				(void)memset(&window->temp_layer->pixels[y*window->temp_layer->stride+min_x*window->temp_layer->channel],
-					0, (max_x - min_x)*window->temp_layer->channel);
-			}
-
-			ad *= DIV_PIXEL, bd *= DIV_PIXEL;
-			red = (line->points[i].color[0] * ad) + (line->points[i+1].color[0] * bd);
-			green = (line->points[i].color[1] * ad) + (line->points[i+1].color[1] * bd);
-			blue = (line->points[i].color[2] * ad) + (line->points[i+1].color[2] * bd);
-			alpha = (line->points[i].color[3] * ad) + (line->points[i+1].color[3] * bd);
-
-			InitializeGraphicsPatternRadial(&brush, draw_x, draw_y, r * 0.0, draw_x, draw_y, r, graphics);
-			GraphicsPatternSetExtend(&brush.base.base, GRAPHICS_EXTEND_NONE);
-			GraphicsPatternAddColorStopRGBA(&brush.base.base, 0.0, red, green, blue, alpha);
-			GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0-line->blur*0.01,
-											red, green, blue, alpha);
-			GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0, red, green, blue,
-											line->outline_hardness*0.01f*alpha);
-			GraphicsSetSource(&window->temp_layer->context.base, &brush.base.base);
-
-			GraphicsArc(&window->temp_layer->context.base, draw_x, draw_y, r, 0, 2 * M_PI);
-			GraphicsFill(&window->temp_layer->context.base);
-
-			for(y=min_y; y<max_y; y++)
-			{
-				for(x=min_x; x<max_x; x++)
-				{
-					if(window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->channel+3])
-					{
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel];
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+1]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1];
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+2]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2];
-						window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3] =
-							(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3]
-							- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3])
-								* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-								+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3];
-					}
-				}
-			}
-
-			DestroyGraphicsPattern(&brush.base.base);
-
-			dx -= half_r;
-			draw_x -= cos_x*half_r, draw_y -= sin_y*half_r;
-		} while(dx >= half_r);
-	}
-
-	dx = line->points[i].x-line->points[0].x;
-	dy = line->points[i].y-line->points[0].y;
-	d = sqrt(dx*dx+dy*dy);
-
-	if(d < 0.5)
-	{
-		return;
-	}
-
-	div_d = 1.0 / d;
-	dist = 0.0;
-	arg = atan2(dy, dx);
-	cos_x = cos(arg), sin_y = sin(arg);
-	draw_x = line->points[i].x, draw_y = line->points[i].y;
-
-	dx = d;
-
-	do
-	{
-		ad = (d - dist) * div_d, bd = dist * div_d;
-		r = line->points[i].size * line->points[i].pressure * 0.01f * ad
-			+ line->points[0].size * line->points[0].pressure * 0.01f * bd;
-		half_r = r * 0.125;
-		if(half_r < 0.5)
-		{
-			half_r = 0.5;
-		}
-		dist += half_r;
-
-		min_x = (int32)(draw_x - r - 1);
-		min_y = (int32)(draw_y - r - 1);
-		max_x = (int32)(draw_x + r + 1);
-		max_y = (int32)(draw_y + r + 1);
-
-		if(min_x < 0)
-		{
-			min_x = 0;
-		}
-		else if(min_x > window->width)
-		{
-			min_x = window->width;
-		}
-		if(min_y < 0)
-		{
-			min_y = 0;
-		}
-		else if(min_y > window->height)
-		{
-			min_y = window->height;
-		}
-		if(max_x > window->width)
-		{
-			max_x = window->width;
-		}
-		else if(max_x < 0)
-		{
-			max_x = 0;
-		}
-		if(max_y > window->height)
-		{
-			max_y = window->height;
-		}
-		else if(max_y < 0)
-		{
-			max_y = 0;
-		}
-
-		if(rect->min_x > min_x)
-		{
-			rect->min_x = min_x;
-		}
-		if(rect->min_y > min_y)
-		{
-			rect->min_y = min_y;
-		}
-		if(rect->max_x < max_x)
-		{
-			rect->max_x = max_x;
-		}
-		if(rect->max_y < max_y)
-		{
-			rect->max_y = max_y;
-		}
-
-		for(y=min_y; y<max_y; y++)
-		{
-			(void)memset(&window->temp_layer->pixels[y*window->temp_layer->stride+min_x*window->temp_layer->channel],
-				0, (max_x - min_x)*window->temp_layer->channel);
-		}
-
-		ad *= DIV_PIXEL, bd *= DIV_PIXEL;
-		red = (line->points[i].color[0] * ad) + (line->points[0].color[0] * bd);
-		green = (line->points[i].color[1] * ad) + (line->points[0].color[1] * bd);
-		blue = (line->points[i].color[2] * ad) + (line->points[0].color[2] * bd);
-		alpha = (line->points[i].color[3] * ad) + (line->points[0].color[3] * bd);
-
-		InitializeGraphicsPatternRadial(&brush, draw_x, draw_y, r * 0.0, draw_x, draw_y, r, graphics);
-		GraphicsPatternSetExtend(&brush.base.base, GRAPHICS_EXTEND_NONE);
-		GraphicsPatternAddColorStopRGBA(&brush.base.base, 0.0, red, green, blue, alpha);
-		GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0-line->blur*0.01,
-											red, green, blue, alpha);
-		GraphicsPatternAddColorStopRGBA(&brush.base.base, 1.0, red, green, blue,
-											line->outline_hardness*0.01f*alpha);
-		GraphicsSetSource(&window->temp_layer->context.base, &brush.base.base);
-
-		GraphicsArc(&window->temp_layer->context.base, draw_x, draw_y, r, 0, 2 * M_PI);
-		GraphicsFill(&window->temp_layer->context.base);
+	InitializeVectorOutline(&outline);
+	AddStraightOutline(&outline, line, FALSE);
+	FillVectorOutline(window, line, &outline, rect);
+	ReleaseVectorOutline(&outline);
+}
 
-		for(y=min_y; y<max_y; y++)
-		{
-			for(x=min_x; x<max_x; x++)
-			{
-				if(window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->channel+3])
-				{
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel];
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+1]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+1];
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+2]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+2];
-					window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3] =
-						(uint8)(((int)window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3]
-						- (int)window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3])
-							* window->temp_layer->pixels[y*window->temp_layer->stride+x*window->temp_layer->channel+3] >> 8)
-							+ window->work_layer->pixels[y*window->work_layer->stride+x*window->work_layer->channel+3];
-				}
-			}
-		}
+void StrokeStraightCloseLine(
+	DRAW_WINDOW* window,
+	VECTOR_LINE* line,
+	VECTOR_LAYER_RECTANGLE* rect
+)
+{
+	VECTOR_OUTLINE outline;
 
-		DestroyGraphicsPattern(&brush.base.base);
+	rect->min_x = rect->max_x = line->points->x;
+	rect->min_y = rect->max_y = line->points->y;
 
-		dx -= half_r;
-		draw_x -= cos_x*half_r, draw_y -= sin_y*half_r;
-	} while(dx >= half_r);
+	InitializeVectorOutline(&outline);
+	AddStraightOutline(&outline, line, TRUE);
+	FillVectorOutline(window, line, &outline, rect);
+	ReleaseVectorOutline(&outline);
 }
 
 void RasterizeVectorSquare(
@@ -733,69 +334,380 @@ void RasterizeVectorEclipse(
 	
 	InitializeGraphicsDefaultContext(&context, &window->work_layer->surface, &window->app->graphics);
 
-	if(eclipse->radius < 0.01)
+	if(eclipse->radius < 0.01)
+	{
+		return;
+	}
+
+	if(eclipse->ratio > 1.0)
+	{
+		x_scale = eclipse->ratio;
+		y_scale = 1;
+	}
+	else
+	{
+		x_scale = 1;
+		y_scale = 1.0 / eclipse->ratio;
+	}
+
+	(void)memset(window->work_layer->pixels, 0, window->pixel_buf_size);
+	GraphicsTranslate(&context.base, eclipse->x + eclipse->radius, eclipse->y + eclipse->radius);
+	GraphicsRotate(&context.base, eclipse->rotate);
+	GraphicsTranslate(&context.base, - eclipse->radius, - eclipse->radius);
+
+	GraphicsSave(&context.base);
+	GraphicsScale(&context.base, x_scale, y_scale);
+	GraphicsArc(&context.base, (1 - cos_value - sin_value) * eclipse->radius / x_scale,
+		(1 - cos_value + sin_value) * eclipse->radius / y_scale, eclipse->radius, 0, 2 * M_PI);
+	GraphicsClosePath(&context.base);
+	GraphicsPathExtents(&context.base, &rectangle->min_x, &rectangle->min_y,
+		&rectangle->max_x, &rectangle->max_y);
+
+	rectangle->min_x += eclipse->x - eclipse->radius * x_scale - eclipse->line_width;
+	rectangle->max_x += eclipse->x + eclipse->radius * x_scale + eclipse->line_width;
+	rectangle->min_y += eclipse->y - eclipse->radius * y_scale - eclipse->line_width;
+	rectangle->max_y += eclipse->y + eclipse->radius * y_scale + eclipse->line_width;
+
+	if(eclipse->fill_color[3] > 0)
+	{
+		GraphicsSetSourceRGBA(&context.base,
+#if 0 //defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
+			eclipse->fill_color[2] * DIV_PIXEL, eclipse->fill_color[1] * DIV_PIXEL, eclipse->fill_color[0] * DIV_PIXEL,
+#else
+			eclipse->fill_color[0] * DIV_PIXEL, eclipse->fill_color[1] * DIV_PIXEL, eclipse->fill_color[2] * DIV_PIXEL,
+#endif
+				eclipse->fill_color[3] * DIV_PIXEL
+		);
+		GraphicsFillPreserve(&context.base);
+	}
+	GraphicsRestore(&context.base);
+	GraphicsSetLineWidth(&context.base, eclipse->line_width);
+	GraphicsSetLineJoin(&context.base, (eGRAPHICS_LINE_JOIN)eclipse->line_joint);
+	if(eclipse->line_color[3] > 0)
+	{
+		GraphicsSetSourceRGBA(&context.base,
+#if 0 //defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
+			eclipse->line_color[2] * DIV_PIXEL, eclipse->line_color[1] * DIV_PIXEL, eclipse->line_color[0] * DIV_PIXEL,
+#else
+			eclipse->line_color[0] * DIV_PIXEL, eclipse->line_color[1] * DIV_PIXEL, eclipse->line_color[2] * DIV_PIXEL,
+#endif
+				eclipse->line_color[3] * DIV_PIXEL
+		);
+		GraphicsStroke(&context.base);
+	}
+
+	DestroyGraphicsContext(&context.base);
+}
+
+/*
+* VectorScriptHash関数
+* スクリプトの文字列のハッシュ値を計算する
+* 引数
+* script	: スクリプトの文字列
+* 返り値
+*	ハッシュ値
+*/
+static uint32 VectorScriptHash(const char* script)
+{
+	uint32 hash = 2166136261u;
+
+	while(*script != '\0')
+	{
+		hash ^= (uint8)*script;
+		hash *= 16777619u;
+		script++;
+	}
+
+	return hash;
+}
+
+/*
+* CreateVectorScriptState関数
+* スクリプトによるベクトルデータを実行するLuaの状態を作成する
+* 返り値
+*	ライブラリを読み込んだLuaの状態
+*/
+static struct lua_State* CreateVectorScriptState(void)
+{
+	struct lua_State *state = luaL_newstate();
+
+	luaL_openlibs(state);
+	(void)luaopen_lcairo(state);
+
+	lua_pushnumber(state, M_PI);
+	lua_setglobal(state, "PI");
+
+	return state;
+}
+
+/*
+* InitializeVectorScriptStatePool関数
+* スクリプトの実行に使うLuaの状態のプールを初期化する
+*  プールの操作は複数のスレッドから行われるのでロックを作成する
+* 引数
+* pool	: Luaの状態のプール
+*/
+void InitializeVectorScriptStatePool(VECTOR_SCRIPT_STATE_POOL* pool)
+{
+	(void)memset(pool, 0, sizeof(*pool));
+
+#if defined(_WIN32)
+	pool->lock = MEM_ALLOC_FUNC(sizeof(CRITICAL_SECTION));
+	InitializeCriticalSection((CRITICAL_SECTION*)pool->lock);
+#else
+	pool->lock = MEM_ALLOC_FUNC(sizeof(pthread_mutex_t));
+	(void)pthread_mutex_init((pthread_mutex_t*)pool->lock, NULL);
+#endif
+}
+
+/*
+* LockVectorScriptStatePool関数
+* Luaの状態のプールの操作を他のスレッドと排他する
+* 引数
+* pool	: Luaの状態のプール
+*/
+static void LockVectorScriptStatePool(VECTOR_SCRIPT_STATE_POOL* pool)
+{
+#if defined(_WIN32)
+	EnterCriticalSection((CRITICAL_SECTION*)pool->lock);
+#else
+	(void)pthread_mutex_lock((pthread_mutex_t*)pool->lock);
+#endif
+}
+
+/*
+* UnlockVectorScriptStatePool関数
+* Luaの状態のプールの排他を解除する
+* 引数
+* pool	: Luaの状態のプール
+*/
+static void UnlockVectorScriptStatePool(VECTOR_SCRIPT_STATE_POOL* pool)
+{
+#if defined(_WIN32)
+	LeaveCriticalSection((CRITICAL_SECTION*)pool->lock);
+#else
+	(void)pthread_mutex_unlock((pthread_mutex_t*)pool->lock);
+#endif
+}
+
+/*
+* DeferVectorScriptUnref関数
+* 使用中のLuaの状態にあるチャンクの参照を返却時に外すよう記録する
+* 引数
+* pool		: Luaの状態のプール
+* index		: プール内の番号
+* reference	: 外すチャンクの参照
+*/
+static void DeferVectorScriptUnref(VECTOR_SCRIPT_STATE_POOL* pool, int index, int reference)
+{
+	if(pool->num_pending_unrefs[index] >= pool->pending_unrefs_size[index])
+	{
+		pool->pending_unrefs_size[index] += VECTOR_SCRIPT_PENDING_UNREF_BUFFER_SIZE;
+		pool->pending_unrefs[index] = (int*)MEM_REALLOC_FUNC(pool->pending_unrefs[index],
+			sizeof(*pool->pending_unrefs[index]) * pool->pending_unrefs_size[index]);
+	}
+	pool->pending_unrefs[index][pool->num_pending_unrefs[index]] = reference;
+	pool->num_pending_unrefs[index]++;
+}
+
+/*
+* AcquireVectorScriptState関数
+* Luaの状態をプールから取り出す
+*  スクリプトのチャンクを読み込み済みの状態を優先する
+* 引数
+* pool		: Luaの状態のプール
+* script	: 実行するスクリプト
+* 返り値
+*	プール内の番号(空きが無い場合は-1)
+*/
+static int AcquireVectorScriptState(VECTOR_SCRIPT_STATE_POOL* pool, VECTOR_SCRIPT* script)
+{
+	int index = -1;
+	int i;
+
+	LockVectorScriptStatePool(pool);
+	for(i=0; i<VECTOR_SCRIPT_STATE_POOL_SIZE; i++)
+	{
+		if(pool->in_use[i] == FALSE && pool->states[i] != NULL
+			&& pool->states[i] == script->chunk_state)
+		{
+			index = i;
+			break;
+		}
+	}
+
+	if(index < 0)
+	{
+		for(i=0; i<VECTOR_SCRIPT_STATE_POOL_SIZE; i++)
+		{
+			if(pool->in_use[i] == FALSE)
+			{
+				index = i;
+				break;
+			}
+		}
+
+		// 別の状態に読み込み直すので前のチャンクは開放する
+		if(index >= 0 && script->chunk_state != NULL)
+		{
+			for(i=0; i<VECTOR_SCRIPT_STATE_POOL_SIZE; i++)
+			{
+				if(pool->states[i] == script->chunk_state)
+				{
+					if(pool->in_use[i] == FALSE)
+					{
+						luaL_unref(script->chunk_state, LUA_REGISTRYINDEX, script->chunk_reference);
+					}
+					else
+					{	// 他のスレッドが使用中なら返却時に外す
+						DeferVectorScriptUnref(pool, i, script->chunk_reference);
+					}
+					break;
+				}
+			}
+			script->chunk_state = NULL;
+		}
+	}
+
+	if(index >= 0)
+	{
+		pool->in_use[index] = TRUE;
+	}
+
+	UnlockVectorScriptStatePool(pool);
+
+	if(index >= 0 && pool->states[index] == NULL)
+	{
+		pool->states[index] = CreateVectorScriptState();
+	}
+
+	return index;
+}
+
+/*
+* ReleaseVectorScriptState関数
+* Luaの状態をプールに戻す
+* 引数
+* pool	: Luaの状態のプール
+* index	: プール内の番号
+*/
+static void ReleaseVectorScriptState(VECTOR_SCRIPT_STATE_POOL* pool, int index)
+{
+	int i;
+
+	lua_settop(pool->states[index], 0);
+	(void)lua_gc(pool->states[index], LUA_GCSTEP, 0);
+
+	LockVectorScriptStatePool(pool);
+	// 使用中に外せなかったチャンクの参照を外す
+	for(i=0; i<pool->num_pending_unrefs[index]; i++)
 	{
-		return;
+		luaL_unref(pool->states[index], LUA_REGISTRYINDEX, pool->pending_unrefs[index][i]);
 	}
+	pool->num_pending_unrefs[index] = 0;
+	pool->in_use[index] = FALSE;
 
-	if(eclipse->ratio > 1.0)
+	UnlockVectorScriptStatePool(pool);
+}
+
+/*
+* ReleaseVectorScriptStatePool関数
+* スクリプトの実行に使うLuaの状態を全て閉じる
+*  アプリケーション終了時に呼び出す
+* 引数
+* pool	: Luaの状態のプール
+*/
+void ReleaseVectorScriptStatePool(VECTOR_SCRIPT_STATE_POOL* pool)
+{
+	int i;
+
+	for(i=0; i<VECTOR_SCRIPT_STATE_POOL_SIZE; i++)
 	{
-		x_scale = eclipse->ratio;
-		y_scale = 1;
+		if(pool->states[i] != NULL)
+		{
+			lua_close(pool->states[i]);
+			pool->states[i] = NULL;
+		}
+		MEM_FREE_FUNC(pool->pending_unrefs[i]);
+		pool->pending_unrefs[i] = NULL;
+		pool->num_pending_unrefs[i] = 0;
+		pool->pending_unrefs_size[i] = 0;
+		pool->in_use[i] = FALSE;
 	}
-	else
+
+	if(pool->lock != NULL)
 	{
-		x_scale = 1;
-		y_scale = 1.0 / eclipse->ratio;
+#if defined(_WIN32)
+		DeleteCriticalSection((CRITICAL_SECTION*)pool->lock);
+#else
+		(void)pthread_mutex_destroy((pthread_mutex_t*)pool->lock);
+#endif
+		MEM_FREE_FUNC(pool->lock);
+		pool->lock = NULL;
 	}
+}
 
-	(void)memset(window->work_layer->pixels, 0, window->pixel_buf_size);
-	GraphicsTranslate(&context.base, eclipse->x + eclipse->radius, eclipse->y + eclipse->radius);
-	GraphicsRotate(&context.base, eclipse->rotate);
-	GraphicsTranslate(&context.base, - eclipse->radius, - eclipse->radius);
+/*
+* LoadVectorScriptChunk関数
+* スクリプトのチャンクをスタックに積む
+*  同じ状態で同じ内容のスクリプトはコンパイル済みのチャンクを使う
+* 引数
+* state		: Luaの状態
+* script	: 実行するスクリプト
+* use_cache	: コンパイル済みのチャンクを保存する場合はTRUE
+* 返り値
+*	正常終了:0	失敗:0以外(スタックにエラーメッセージ)
+*/
+static int LoadVectorScriptChunk(struct lua_State* state, VECTOR_SCRIPT* script, int use_cache)
+{
+	uint32 hash = VectorScriptHash(script->script_data);
 
-	GraphicsSave(&context.base);
-	GraphicsScale(&context.base, x_scale, y_scale);
-	GraphicsArc(&context.base, (1 - cos_value - sin_value) * eclipse->radius / x_scale,
-		(1 - cos_value + sin_value) * eclipse->radius / y_scale, eclipse->radius, 0, 2 * M_PI);
-	GraphicsClosePath(&context.base);
-	GraphicsPathExtents(&context.base, &rectangle->min_x, &rectangle->min_y,
-		&rectangle->max_x, &rectangle->max_y);
+	if(use_cache != FALSE && script->chunk_state == state)
+	{
+		if(script->chunk_hash == hash)
+		{
+			lua_rawgeti(state, LUA_REGISTRYINDEX, script->chunk_reference);
+			return 0;
+		}
 
-	rectangle->min_x += eclipse->x - eclipse->radius * x_scale - eclipse->line_width;
-	rectangle->max_x += eclipse->x + eclipse->radius * x_scale + eclipse->line_width;
-	rectangle->min_y += eclipse->y - eclipse->radius * y_scale - eclipse->line_width;
-	rectangle->max_y += eclipse->y + eclipse->radius * y_scale + eclipse->line_width;
+		luaL_unref(state, LUA_REGISTRYINDEX, script->chunk_reference);
+		script->chunk_state = NULL;
+	}
 
-	if(eclipse->fill_color[3] > 0)
+	if(luaL_loadstring(state, script->script_data) != 0)
 	{
-		GraphicsSetSourceRGBA(&context.base,
-#if 0 //defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
-			eclipse->fill_color[2] * DIV_PIXEL, eclipse->fill_color[1] * DIV_PIXEL, eclipse->fill_color[0] * DIV_PIXEL,
-#else
-			eclipse->fill_color[0] * DIV_PIXEL, eclipse->fill_color[1] * DIV_PIXEL, eclipse->fill_color[2] * DIV_PIXEL,
-#endif
-				eclipse->fill_color[3] * DIV_PIXEL
-		);
-		GraphicsFillPreserve(&context.base);
+		return -1;
 	}
-	GraphicsRestore(&context.base);
-	GraphicsSetLineWidth(&context.base, eclipse->line_width);
-	GraphicsSetLineJoin(&context.base, (eGRAPHICS_LINE_JOIN)eclipse->line_joint);
-	if(eclipse->line_color[3] > 0)
+
+	if(use_cache != FALSE)
 	{
-		GraphicsSetSourceRGBA(&context.base,
-#if 0 //defined(USE_BGR_COLOR_SPACE) && USE_BGR_COLOR_SPACE != 0
-			eclipse->line_color[2] * DIV_PIXEL, eclipse->line_color[1] * DIV_PIXEL, eclipse->line_color[0] * DIV_PIXEL,
-#else
-			eclipse->line_color[0] * DIV_PIXEL, eclipse->line_color[1] * DIV_PIXEL, eclipse->line_color[2] * DIV_PIXEL,
-#endif
-				eclipse->line_color[3] * DIV_PIXEL
-		);
-		GraphicsStroke(&context.base);
+		lua_pushvalue(state, -1);
+		script->chunk_reference = luaL_ref(state, LUA_REGISTRYINDEX);
+		script->chunk_state = state;
+		script->chunk_hash = hash;
 	}
 
-	DestroyGraphicsContext(&context.base);
+	return 0;
+}
+
+/*
+* ShowVectorScriptError関数
+* スクリプトの実行に失敗した旨を表示する
+* 引数
+* app	: アプリケーションを管理する構造体のアドレス
+* state	: スタックにエラーメッセージを積んだLuaの状態
+*/
+static void ShowVectorScriptError(APPLICATION* app, struct lua_State* state)
+{
+	void *dialog;
+	char message[8192];
+
+	(void)sprintf(message, "Failed to rasterize script vector.\n%s",
+		lua_tostring(state, -1));
+	dialog = MessageDialogNew(message, GetMainWindowWidget(app), DIALOG_TYPE_ERROR);
+	MessageDialogMoveToParentCenter(dialog);
+	MessageDialogExecute(dialog);
+	MessageDialogDestroy(dialog);
 }
 
 void RasterizeVectorScript(
@@ -805,12 +717,15 @@ void RasterizeVectorScript(
 )
 {
 	APPLICATION *app;
+	VECTOR_SCRIPT_STATE_POOL *pool;
 	struct lua_State *state;
 	GRAPHICS_DEFAULT_CONTEXT context = {0};
+	GRAPHICS_RECTANGLE_INT extents;
+	int pool_index;
 	int result;
-	int x, y;
 	
 	app = window->app;
+	pool = &app->vector_script_pool;
 
 	if(script->script_data == NULL
 		|| (window->flags & DRAW_WINDOW_IN_RASTERIZING_VECTOR_SCRIPT) != 0)
@@ -820,92 +735,76 @@ void RasterizeVectorScript(
 
 	window->flags |= DRAW_WINDOW_IN_RASTERIZING_VECTOR_SCRIPT;
 
-	state = luaL_newstate();
-	luaL_openlibs(state);
-	(void)luaopen_lcairo(state);
+	// 使い回せるLuaの状態が無ければ一時的に作成する
+	pool_index = AcquireVectorScriptState(pool, script);
+	state = (pool_index >= 0) ? pool->states[pool_index] : CreateVectorScriptState();
 
 	InitializeGraphicsDefaultContext(&context, &window->work_layer->surface, &window->app->graphics);
+	GraphicsBeginPaintedExtents(&context.base);
 	lua_pushlightuserdata(state, &context);
 	lua_setglobal(state, "cr");
 
-	lua_pushnumber(state, M_PI);
-	lua_setglobal(state, "PI");
-
 	(void)memset(window->work_layer->pixels, 0, window->pixel_buf_size);
 
-	if(luaL_loadstring(state, script->script_data) != 0)
-	{
-		void *dialog;
-		char message[8192];
-		(void)sprintf(message, "Failed to rasterize script vector.\n%s",
-			lua_tostring(state, -1));
-		dialog = MessageDialogNew(message, GetMainWindowWidget(app), DIALOG_TYPE_ERROR);
-		MessageDialogMoveToParentCenter(dialog);
-		MessageDialogExecute(dialog);
-		MessageDialogDestroy(dialog);
-		rectangle->min_x = rectangle->max_x = rectangle->min_y = rectangle->max_y = 0;
-		lua_close(state);
-		window->flags &= ~(DRAW_WINDOW_IN_RASTERIZING_VECTOR_SCRIPT);
-		return;
-	}
-
-	result = lua_pcall(state, 0, 0, 0);
+	result = LoadVectorScriptChunk(state, script, pool_index >= 0);
 	if(result == 0)
 	{
-		lua_getglobal(state, "main");
-		if(lua_isfunction(state, -1) != 0)
+		// 実行ごとに独立したグローバル環境を用意して前回の定義を残さない
+		lua_newtable(state);
+		lua_newtable(state);
+		lua_pushglobaltable(state);
+		lua_setfield(state, -2, "__index");
+		(void)lua_setmetatable(state, -2);
+		lua_pushvalue(state, -1);
+		if(lua_setupvalue(state, -3, 1) == NULL)
 		{
-			result = lua_pcall(state, 0, LUA_MULTRET, 0);
+			lua_pop(state, 1);
+		}
+		lua_insert(state, -2);
+
+		result = lua_pcall(state, 0, 0, 0);
+		if(result == 0)
+		{
+			lua_getfield(state, -1, "main");
+			if(lua_isfunction(state, -1) != 0)
+			{
+				result = lua_pcall(state, 0, LUA_MULTRET, 0);
+			}
 		}
 	}
 
 	if(result != 0)
 	{
-		void *dialog;
-		char message[8192];
-		(void)sprintf(message, "Failed to rasterize script vector.\n%s",
-			lua_tostring(state, -1));
-		dialog = MessageDialogNew(message, GetMainWindowWidget(app), DIALOG_TYPE_ERROR);
-		MessageDialogMoveToParentCenter(dialog);
-		MessageDialogExecute(dialog);
-		MessageDialogDestroy(dialog);
+		ShowVectorScriptError(app, state);
 		rectangle->min_x = rectangle->max_x = rectangle->min_y = rectangle->max_y = 0;
-		lua_close(state);
-		window->flags &= ~(DRAW_WINDOW_IN_RASTERIZING_VECTOR_SCRIPT);
-		return;
+	}
+	else if(GraphicsGetPaintedExtents(&context.base, &extents) != FALSE)
+	{
+		// 描画した範囲をコンテキストから受け取る
+		rectangle->min_x = (extents.x < 0) ? 0 : extents.x;
+		rectangle->min_y = (extents.y < 0) ? 0 : extents.y;
+		rectangle->max_x = (extents.x + extents.width > window->width)
+			? window->width - 1 : extents.x + extents.width - 1;
+		rectangle->max_y = (extents.y + extents.height > window->height)
+			? window->height - 1 : extents.y + extents.height - 1;
+	}
+	else
+	{
+		rectangle->min_x = window->width;
+		rectangle->min_y = window->height;
+		rectangle->max_x = 0;
+		rectangle->max_y = 0;
 	}
 
 	DestroyGraphicsContext(&context.base);
-	lua_close(state);
 
-	rectangle->min_x = window->width;
-	rectangle->min_y = window->height;
-	rectangle->max_x = 0;
-	rectangle->max_y = 0;
-	for(y=0; y<window->height; y++)
+	if(pool_index >= 0)
 	{
-		for(x=0; x<window->width; x++)
-		{
-			if(window->work_layer->pixels[y*window->stride+x*4+3] > 0)
-			{
-				if(rectangle->max_x < x)
-				{
-					rectangle->max_x = x;
-				}
-				if(rectangle->min_x > x)
-				{
-					rectangle->min_x = 0;
-				}
-				if(rectangle->max_y < y)
-				{
-					rectangle->max_y = y;
-				}
-				if(rectangle->min_y > y)
-				{
-					rectangle->min_y = y;
-				}
-			}
-		}
+		ReleaseVectorScriptState(pool, pool_index);
+	}
+	else
+	{
+		lua_close(state);
 	}
 
 	window->flags &= ~(DRAW_WINDOW_IN_RASTERIZING_VECTOR_SCRIPT);
@@ -1231,12 +1130,283 @@ void DeleteVectorScript(VECTOR_SCRIPT** script)
 
 	DeleteVectorLineLayer(&(*script)->base_data.layer);
 
+	// Luaの状態はアプリケーション終了まで残るのでチャンクの参照だけ外す
+	if((*script)->chunk_state != NULL)
+	{
+		luaL_unref((*script)->chunk_state, LUA_REGISTRYINDEX, (*script)->chunk_reference);
+	}
+
 	MEM_FREE_FUNC((*script)->script_data);
 	MEM_FREE_FUNC(*script);
 
 	*script = NULL;
 }
 
+/*
+* RenderVectorLineLayer関数
+* ベクトル線を作業レイヤーを使わずに描画範囲分のピクセルデータへラスタライズする
+*  キャンバスの状態を変更しないので複数のスレッドから同時に呼び出せる
+*  サーフェース・コンテキストは作成しないので必要ならInitializeVectorLineLayerSurfaceを呼ぶ
+* 引数
+* window	: 描画するキャンバス
+* line		: ラスタライズするベクトル線
+* graphics	: 呼び出すスレッドで使う描画エンジンの設定
+* 返り値
+*	ラスタライズしたデータ
+*/
+static VECTOR_LINE_LAYER* RenderVectorLineLayer(DRAW_WINDOW* window, VECTOR_LINE* line, GRAPHICS* graphics)
+{
+	VECTOR_LINE_LAYER *ret;
+	VECTOR_OUTLINE outline;
+	int x, y, width, height;
+
+	InitializeVectorOutline(&outline);
+	if(line->num_points < 3 || line->base_data.vector_type == VECTOR_TYPE_STRAIGHT)
+	{
+		AddStraightOutline(&outline, line, FALSE);
+	}
+	else if(line->base_data.vector_type == VECTOR_TYPE_BEZIER_OPEN)
+	{
+		AddBezierLineOutline(&outline, line);
+	}
+	else if(line->base_data.vector_type == VECTOR_TYPE_STRAIGHT_CLOSE)
+	{
+		AddStraightOutline(&outline, line, TRUE);
+	}
+	else
+	{
+		AddBezierLineCloseOutline(&outline, line);
+	}
+
+	// 描画範囲が無くても後で合成できるように1ピクセル分は確保する
+	if(GetVectorOutlineRectangle(&outline, window->width, window->height,
+		&x, &y, &width, &height) == FALSE)
+	{
+		x = (x < window->width) ? x : window->width - 1;
+		y = (y < window->height) ? y : window->height - 1;
+		width = height = 1;
+	}
+
+	ret = (VECTOR_LINE_LAYER*)MEM_CALLOC_FUNC(1, sizeof(*ret));
+	ret->x = x,	ret->y = y;
+	ret->width = width,	ret->height = height;
+	ret->stride = width * 4;
+	ret->pixels = (uint8*)MEM_CALLOC_FUNC(height, ret->stride);
+
+	DrawVectorOutline(graphics, line, &outline,
+		ret->pixels, ret->stride, x, y, width, height);
+	ReleaseVectorOutline(&outline);
+
+	if((line->flags & VECTOR_LINE_ANTI_ALIAS) != 0)
+	{
+		LAYER layer, temp;
+		ANTI_ALIAS_RECTANGLE range;
+
+		(void)memset(&layer, 0, sizeof(layer));
+		(void)memset(&temp, 0, sizeof(temp));
+		layer.pixels = ret->pixels;
+		layer.width = width,	layer.height = height;
+		layer.stride = ret->stride;
+		temp.pixels = (uint8*)MEM_ALLOC_FUNC(height * ret->stride);
+		temp.width = width,	temp.height = height;
+		temp.stride = ret->stride;
+
+		range.x = range.y = 0;
+		range.width = width,	range.height = height;
+		AntiAliasVectorLine(&layer, &temp, &range);
+
+		MEM_FREE_FUNC(temp.pixels);
+	}
+
+	return ret;
+}
+
+/*
+* InitializeVectorLineLayerSurface関数
+* RenderVectorLineLayerで作成したデータに描画用のサーフェース・コンテキストを設定する
+* 引数
+* layer		: ラスタライズしたデータ
+* graphics	: 描画エンジンの設定
+*/
+static void InitializeVectorLineLayerSurface(VECTOR_LINE_LAYER* layer, GRAPHICS* graphics)
+{
+	(void)InitializeGraphicsImageSurfaceForData(&layer->surface, layer->pixels, GRAPHICS_FORMAT_ARGB32,
+		layer->width, layer->height, layer->stride, graphics);
+	(void)InitializeGraphicsDefaultContext(&layer->context, &layer->surface, graphics);
+}
+
+/*
+* VECTOR_LINE_RENDER_DATA構造体
+* 線をスレッドプールでラスタライズするためのデータ
+*/
+typedef struct _VECTOR_LINE_RENDER_DATA
+{
+	DRAW_WINDOW *window;
+	VECTOR_LINE **lines;
+	VECTOR_LINE_LAYER **line_layers;
+	// 描画エンジンの設定(スレッド毎)
+	GRAPHICS *graphics;
+} VECTOR_LINE_RENDER_DATA;
+
+/*
+* RenderVectorLineLayerTask関数
+* スレッドプールから呼び出されて線1本分をラスタライズする
+* 引数
+* index			: 線の番号
+* thread_index	: 処理しているスレッドの番号
+* data			: VECTOR_LINE_RENDER_DATA構造体のアドレス
+*/
+static void RenderVectorLineLayerTask(int index, int thread_index, void* data)
+{
+	VECTOR_LINE_RENDER_DATA *render = (VECTOR_LINE_RENDER_DATA*)data;
+
+	if(render->lines[index]->base_data.vector_type < NUM_VECTOR_LINE_TYPE)
+	{
+		render->line_layers[index] = RenderVectorLineLayer(render->window,
+			render->lines[index], &render->graphics[thread_index]);
+	}
+}
+
+/*
+* RasterizeVectorLayerParallel関数
+* ベクトルレイヤーの全ての線を線ごとに別スレッドでラスタライズし
+*  作成順に合成する
+*  形状・スクリプトは作業レイヤーを使うので合成時に順番に処理する
+* 引数
+* window	: 描画するキャンバス
+* target	: 合成先のレイヤー
+* layer		: ベクトルレイヤーのデータ
+* first		: 最初のベクトルデータ
+* num_data	: ベクトルデータの数
+*/
+static void RasterizeVectorLayerParallel(
+	DRAW_WINDOW* window,
+	LAYER* target,
+	VECTOR_LAYER* layer,
+	VECTOR_LINE* first,
+	int num_data
+)
+{
+	VECTOR_LINE **lines;
+	VECTOR_LINE_LAYER **line_layers;
+	VECTOR_LINE_RENDER_DATA render;
+	VECTOR_LAYER_RECTANGLE rect;
+	LAYER *work = window->work_layer;
+	VECTOR_LINE *rasterize;
+	int num_threads = GetParallelLoopThreads();
+	int i, j;
+
+	lines = (VECTOR_LINE**)MEM_ALLOC_FUNC(sizeof(*lines) * num_data);
+	line_layers = (VECTOR_LINE_LAYER**)MEM_CALLOC_FUNC(num_data, sizeof(*line_layers));
+	for(i=0, rasterize=first; rasterize != NULL && i < num_data;
+		i++, rasterize=(VECTOR_LINE*)rasterize->base_data.next)
+	{
+		lines[i] = rasterize;
+	}
+
+	// 線は互いに独立しているので合成前までは並列に処理できる
+	//	描画エンジンの設定はスレッドごとに用意する
+	if(num_threads > num_data)
+	{
+		num_threads = num_data;
+	}
+	render.window = window;
+	render.lines = lines;
+	render.line_layers = line_layers;
+	render.graphics = (GRAPHICS*)MEM_CALLOC_FUNC(num_threads, sizeof(*render.graphics));
+	for(i=0; i<num_threads; i++)
+	{
+		(void)InitializeGraphics(&render.graphics[i]);
+	}
+
+	ExecuteParallelLoop(num_data, RenderVectorLineLayerTask, &render);
+
+	for(i=0; i<num_threads; i++)
+	{
+		ReleaseGraphics(&render.graphics[i]);
+	}
+	MEM_FREE_FUNC(render.graphics);
+
+	// 作業レイヤーに線の範囲だけ書き込んで通常の合成処理で順番に合成する
+	(void)memset(work->pixels, 0, window->pixel_buf_size);
+	for(i=0; i<num_data; i++)
+	{
+		rasterize = lines[i];
+
+		if(rasterize->base_data.vector_type < NUM_VECTOR_LINE_TYPE)
+		{
+			VECTOR_LINE_LAYER *line_layer = line_layers[i];
+			UPDATE_RECTANGLE update = {0};
+
+			for(j=0; j<line_layer->height; j++)
+			{
+				(void)memcpy(&work->pixels[(line_layer->y+j)*work->stride+line_layer->x*4],
+					&line_layer->pixels[j*line_layer->stride], line_layer->width*4);
+			}
+
+			// 線の描画範囲のみ合成する
+			InitializeGraphicsImageSurfaceForRectangle(&update.surface, &target->surface,
+				line_layer->x, line_layer->y, line_layer->width, line_layer->height);
+			InitializeGraphicsDefaultContext(&update.context, &update.surface, &window->app->graphics);
+			update.x = line_layer->x,	update.y = line_layer->y;
+			update.width = line_layer->width,	update.height = line_layer->height;
+			window->part_layer_blend_functions[LAYER_BLEND_NORMAL](work, target, &update);
+			DestroyGraphicsSurface(&update.surface.base);
+			DestroyGraphicsContext(&update.context.base);
+
+			for(j=0; j<line_layer->height; j++)
+			{
+				(void)memset(&work->pixels[(line_layer->y+j)*work->stride+line_layer->x*4],
+					0, line_layer->width*4);
+			}
+
+			if((layer->flags & VECTOR_LAYER_FIX_LINE) != 0)
+			{
+				DeleteVectorLineLayer(&rasterize->base_data.layer);
+				InitializeVectorLineLayerSurface(line_layer, &window->app->graphics);
+				rasterize->base_data.layer = line_layer;
+			}
+			else
+			{
+				MEM_FREE_FUNC(line_layer->pixels);
+				MEM_FREE_FUNC(line_layer);
+			}
+		}
+		else
+		{
+			if(rasterize->base_data.vector_type == VECTOR_TYPE_SQUARE)
+			{
+				RasterizeVectorSquare(window, (VECTOR_SQUARE*)rasterize, &rect);
+			}
+			else if(rasterize->base_data.vector_type == VECTOR_TYPE_RHOMBUS)
+			{
+				RasterizeVectorRhombus(window, (VECTOR_ECLIPSE*)rasterize, &rect);
+			}
+			else if(rasterize->base_data.vector_type == VECTOR_TYPE_ECLIPSE)
+			{
+				RasterizeVectorEclipse(window, (VECTOR_ECLIPSE*)rasterize, &rect);
+			}
+			else
+			{
+				RasterizeVectorScript(window, (VECTOR_SCRIPT*)rasterize, &rect);
+			}
+
+			if((layer->flags & VECTOR_LAYER_FIX_LINE) != 0)
+			{
+				DeleteVectorLineLayer(&rasterize->base_data.layer);
+				rasterize->base_data.layer = CreateVectorLineLayer(work, rasterize, &rect);
+			}
+
+			window->layer_blend_functions[LAYER_BLEND_NORMAL](work, target);
+
+			(void)memset(work->pixels, 0, window->pixel_buf_size);
+		}
+	}
+
+	MEM_FREE_FUNC(lines);
+	MEM_FREE_FUNC(line_layers);
+}
+
 void RasterizeVectorLayer(
 	struct _DRAW_WINDOW* window,
 	struct _LAYER* target,
@@ -1245,6 +1415,9 @@ void RasterizeVectorLayer(
 {
 	VECTOR_LAYER_RECTANGLE rect;
 
+	// 取り消し・やり直しでは非アクティブなレイヤーもラスタライズし直す
+	InvalidateLayerSetCache(target, 0, 0, 0, 0);
+
 	GraphicsSetOperator(&window->temp_layer->context.base, GRAPHICS_OPERATOR_OVER);
 
 	if((layer->flags & VECTOR_LAYER_RASTERIZE_TOP) != 0
@@ -1411,6 +1584,25 @@ void RasterizeVectorLayer(
 			goto end;
 		}
 
+		if(GetParallelLoopThreads() > 1)
+		{
+			VECTOR_LINE *count = rasterize;
+			int num_data = 0;
+
+			while(count != NULL)
+			{
+				num_data++;
+				count = (VECTOR_LINE*)count->base_data.next;
+			}
+
+			if(num_data >= VECTOR_LAYER_PARALLEL_MINIMUM_LINES)
+			{
+				RasterizeVectorLayerParallel(window, target, layer, rasterize, num_data);
+				(void)memcpy(layer->mix->pixels, target->pixels, window->pixel_buf_size);
+				goto end;
+			}
+		}
+
 		while(rasterize->base_data.next != NULL)
 		{
 			(void)memset(window->work_layer->pixels, 0, window->pixel_buf_size);
@@ -1519,9 +1711,7 @@ uint32 ReadVectorLineData(uint8* data, LAYER* target)
 	(void)memcpy(&data_size, data, sizeof(data_size));
 
 	// 読み込み用データの初期化
-	read_stream.buff_ptr = data + sizeof(data_size);
-	read_stream.data_point = 0;
-	read_stream.data_size = data_size;
+	InitializeMemoryStreamView(&read_stream, data + sizeof(data_size), data_size);
 
 	// 展開後のバイト数を読み込む
 	(void)MemRead(&data32, sizeof(data32), 1, &read_stream);
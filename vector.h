@@ -159,8 +159,33 @@ typedef struct _VECTOR_SCRIPT
 {
 	VECTOR_BASE_DATA base_data;	// ベクトルタイプ等の基本情報
 	char *script_data;			// スクリプトの文字列
+	// コンパイル済みチャンクのキャッシュ
+	struct lua_State *chunk_state;	// チャンクを読み込んだLuaの状態
+	int chunk_reference;			// チャンクのレジストリ上の参照
+	uint32 chunk_hash;				// チャンクを作成した時のスクリプトのハッシュ値
 } VECTOR_SCRIPT;
 
+// スクリプトを実行するLuaの状態を使い回す数
+#define VECTOR_SCRIPT_STATE_POOL_SIZE 4
+// 後で外すチャンクの参照のバッファサイズ
+#define VECTOR_SCRIPT_PENDING_UNREF_BUFFER_SIZE 16
+
+/*********************************************************
+* VECTOR_SCRIPT_STATE_POOL構造体						*
+* スクリプトによるベクトルデータの実行に使うLuaの状態 *
+*********************************************************/
+typedef struct _VECTOR_SCRIPT_STATE_POOL
+{
+	struct lua_State *states[VECTOR_SCRIPT_STATE_POOL_SIZE];
+	int8 in_use[VECTOR_SCRIPT_STATE_POOL_SIZE];
+	// 使用中で外せなかったチャンクの参照(状態を返却する時に外す)
+	int *pending_unrefs[VECTOR_SCRIPT_STATE_POOL_SIZE];
+	int num_pending_unrefs[VECTOR_SCRIPT_STATE_POOL_SIZE];
+	int pending_unrefs_size[VECTOR_SCRIPT_STATE_POOL_SIZE];
+	// 複数のスレッドからの操作を排他するロック
+	void *lock;
+} VECTOR_SCRIPT_STATE_POOL;
+
 /****************************
 * VECTOR_DATA構造体		 *
 * ベクトル形状1つ分のデータ *
@@ -239,6 +264,24 @@ EXTERN void DeleteVectorShape(VECTOR_BASE_DATA** shape);
 
 EXTERN void DeleteVectorScript(VECTOR_SCRIPT** script);
 
+/*
+* InitializeVectorScriptStatePool関数
+* スクリプトの実行に使うLuaの状態のプールを初期化する
+*  プールの操作は複数のスレッドから行われるのでロックを作成する
+* 引数
+* pool	: Luaの状態のプール
+*/
+EXTERN void InitializeVectorScriptStatePool(VECTOR_SCRIPT_STATE_POOL* pool);
+
+/*
+* ReleaseVectorScriptStatePool関数
+* スクリプトの実行に使うLuaの状態を全て閉じる
+*  アプリケーション終了時に呼び出す
+* 引数
+* pool	: Luaの状態のプール
+*/
+EXTERN void ReleaseVectorScriptStatePool(VECTOR_SCRIPT_STATE_POOL* pool);
+
 /*
 * ReadVectorLineData関数
 * ベクトルレイヤーのデータを読み込む
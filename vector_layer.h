@@ -8,6 +8,9 @@
 extern "C" {
 #endif
 
+// 全ての線をラスタライズする際に線ごとに並列処理する最小のデータ数
+#define VECTOR_LAYER_PARALLEL_MINIMUM_LINES 8
+
 typedef enum _eVECTOR_LAYER_FLAGS
 {
 	VECTOR_LAYER_RASTERIZE_ALL = 0x01,
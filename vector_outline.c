@@ -0,0 +1,661 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "vector_outline.h"
+#include "draw_window.h"
+#include "application.h"
+#include "memory.h"
+#include "gui/gui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* VECTOR_OUTLINE_SEGMENT構造体
+* 画素ごとの距離計算に使う中心線の線分
+*/
+typedef struct _VECTOR_OUTLINE_SEGMENT
+{
+	FLOAT_T x, y;			// 始点
+	FLOAT_T dx, dy;			// 始点から終点へのベクトル
+	FLOAT_T div_length2;	// 長さの2乗の逆数(長さ0なら0)
+	FLOAT_T r, dr;			// 始点での半径と終点までの変化量
+	FLOAT_T min_x, max_x;	// 影響するX座標の範囲
+	int index;				// 始点の点番号
+} VECTOR_OUTLINE_SEGMENT;
+
+/*
+* InitializeVectorOutline関数
+* 中心線のデータを初期化する
+* 引数
+* outline	: 初期化するデータ
+*/
+void InitializeVectorOutline(VECTOR_OUTLINE* outline)
+{
+	outline->buffer_size = VECTOR_OUTLINE_BUFFER_SIZE;
+	outline->num_points = 0;
+	outline->points = (VECTOR_OUTLINE_POINT*)MEM_ALLOC_FUNC(
+		sizeof(*outline->points) * outline->buffer_size);
+}
+
+/*
+* ReleaseVectorOutline関数
+* 中心線のデータのメモリを開放する
+* 引数
+* outline	: 開放するデータ
+*/
+void ReleaseVectorOutline(VECTOR_OUTLINE* outline)
+{
+	MEM_FREE_FUNC(outline->points);
+	outline->points = NULL;
+	outline->num_points = outline->buffer_size = 0;
+}
+
+/*
+* AddVectorOutlinePoint関数
+* 中心線に点を追加する
+*  色は2つの制御点の間を線形補間する
+* 引数
+* outline	: 点を追加する中心線
+* x			: 追加する点のX座標
+* y			: 追加する点のY座標
+* r			: 追加する点での線の半径
+* start		: 補間元の制御点
+* end		: 補間先の制御点
+* t			: 補間係数(0～1)
+*/
+void AddVectorOutlinePoint(
+	VECTOR_OUTLINE* outline,
+	FLOAT_T x,
+	FLOAT_T y,
+	FLOAT_T r,
+	const VECTOR_POINT* start,
+	const VECTOR_POINT* end,
+	FLOAT_T t
+)
+{
+	VECTOR_OUTLINE_POINT *point;
+	FLOAT_T ad = (1 - t) * DIV_PIXEL, bd = t * DIV_PIXEL;
+	int i;
+
+	if(outline->num_points >= outline->buffer_size)
+	{
+		outline->buffer_size *= 2;
+		outline->points = (VECTOR_OUTLINE_POINT*)MEM_REALLOC_FUNC(
+			outline->points, sizeof(*outline->points) * outline->buffer_size);
+	}
+
+	point = &outline->points[outline->num_points];
+	point->x = x,	point->y = y;
+	point->r = r;
+	for(i=0; i<4; i++)
+	{
+		point->color[i] = start->color[i] * ad + end->color[i] * bd;
+	}
+	outline->num_points++;
+}
+
+/*
+* AddCapsulePath関数
+* 2点を半径の異なる円で結んだ凸形状をパスに追加する
+*  全ての形状を同じ向きで追加するので非ゼロ規則で和集合になる
+* 引数
+* context	: パスを追加するコンテキスト
+* start		: 始点
+* end		: 終点
+*/
+static void AddCapsulePath(
+	GRAPHICS_CONTEXT* context,
+	const VECTOR_OUTLINE_POINT* start,
+	const VECTOR_OUTLINE_POINT* end
+)
+{
+	FLOAT_T dx = end->x - start->x,	dy = end->y - start->y;
+	FLOAT_T d = sqrt(dx*dx + dy*dy);
+	FLOAT_T arg, offset, angle;
+
+	if(start->r <= 0 && end->r <= 0)
+	{
+		return;
+	}
+
+	// 片方の円がもう片方に含まれる場合は大きい円のみ
+	if(d <= fabs(start->r - end->r) || d < 0.0001)
+	{
+		const VECTOR_OUTLINE_POINT *circle = (start->r > end->r) ? start : end;
+		GraphicsMoveTo(context, circle->x + circle->r, circle->y);
+		GraphicsArc(context, circle->x, circle->y, circle->r, 0, 2*M_PI);
+		GraphicsClosePath(context);
+		return;
+	}
+
+	// 2つの円の共通外接線の接点の角度を求める
+		// 接点の法線と中心を結ぶ方向のなす角のcosが(始点の半径-終点の半径)/距離になる
+	arg = atan2(dy, dx);
+	offset = asin((start->r - end->r) / d);
+	angle = arg + M_PI*0.5 - offset;
+
+#ifdef _DEBUG
+	// 半径が変化する線分で接線が両方の円の半径と直交しているか確認
+	if(start->r != end->r)
+	{
+		FLOAT_T tangent_x = (end->x + end->r * cos(angle)) - (start->x + start->r * cos(angle));
+		FLOAT_T tangent_y = (end->y + end->r * sin(angle)) - (start->y + start->r * sin(angle));
+		if(fabs(tangent_x * cos(angle) + tangent_y * sin(angle)) > 0.0001 * d)
+		{
+			(void)printf("Capsule tangent error.\n(In AddCapsulePath)\n");
+		}
+	}
+#endif
+
+	// 大きい方の円は半周より広く、小さい方の円は半周より狭く回る
+	GraphicsMoveTo(context, start->x + start->r * cos(angle), start->y + start->r * sin(angle));
+	GraphicsArc(context, start->x, start->y, start->r, angle, arg + M_PI*1.5 + offset);
+	GraphicsArc(context, end->x, end->y, end->r, arg - M_PI*0.5 + offset, angle);
+	GraphicsClosePath(context);
+}
+
+/*
+* OutlineProfile関数
+* 中心線からの距離に対する不透明度の倍率を計算する
+*  ブラシの放射グラデーションと同じく
+*  (1-blur)までは不透明で輪郭に向かって輪郭の硬さの値まで線形に変化する
+* 引数
+* s			: 半径で正規化した中心線からの距離
+* blur		: ボケ足の開始位置(0～1)
+* hardness	: 輪郭の硬さ(0～1)
+* 返り値
+*	不透明度の倍率(0～1)
+*/
+static INLINE FLOAT_T OutlineProfile(FLOAT_T s, FLOAT_T blur, FLOAT_T hardness)
+{
+	if(s > 1)
+	{
+		s = 1;
+	}
+	if(s <= 1 - blur)
+	{
+		return 1;
+	}
+	return hardness + (1 - hardness) * (1 - s) / blur;
+}
+
+/*
+* GetVectorOutlineRectangle関数
+* 中心線から作成した輪郭の描画範囲を取得する
+* 引数
+* outline	: 平坦化した中心線
+* canvas_width	: キャンバスの幅
+* canvas_height	: キャンバスの高さ
+* x			: 描画範囲の左上のX座標を受け取るアドレス
+* y			: 描画範囲の左上のY座標を受け取るアドレス
+* width		: 描画範囲の幅を受け取るアドレス
+* height	: 描画範囲の高さを受け取るアドレス
+* 返り値
+*	描画する範囲が有る:TRUE	無い:FALSE
+*/
+int GetVectorOutlineRectangle(
+	VECTOR_OUTLINE* outline,
+	int canvas_width,
+	int canvas_height,
+	int* x,
+	int* y,
+	int* width,
+	int* height
+)
+{
+	FLOAT_T left, top, right, bottom;
+	int min_x, min_y, max_x, max_y;
+	int i;
+
+	*x = *y = *width = *height = 0;
+
+	if(outline->num_points < 2)
+	{
+		return FALSE;
+	}
+
+	left = right = outline->points[0].x;
+	top = bottom = outline->points[0].y;
+	for(i=0; i<outline->num_points; i++)
+	{
+		const VECTOR_OUTLINE_POINT *point = &outline->points[i];
+		if(left > point->x - point->r)
+		{
+			left = point->x - point->r;
+		}
+		if(right < point->x + point->r)
+		{
+			right = point->x + point->r;
+		}
+		if(top > point->y - point->r)
+		{
+			top = point->y - point->r;
+		}
+		if(bottom < point->y + point->r)
+		{
+			bottom = point->y + point->r;
+		}
+	}
+
+	min_x = (int)floor(left - 1),	min_y = (int)floor(top - 1);
+	max_x = (int)ceil(right + 1),	max_y = (int)ceil(bottom + 1);
+	if(min_x < 0)
+	{
+		min_x = 0;
+	}
+	else if(min_x > canvas_width)
+	{
+		min_x = canvas_width;
+	}
+	if(min_y < 0)
+	{
+		min_y = 0;
+	}
+	else if(min_y > canvas_height)
+	{
+		min_y = canvas_height;
+	}
+	if(max_x > canvas_width)
+	{
+		max_x = canvas_width;
+	}
+	else if(max_x < 0)
+	{
+		max_x = 0;
+	}
+	if(max_y > canvas_height)
+	{
+		max_y = canvas_height;
+	}
+	else if(max_y < 0)
+	{
+		max_y = 0;
+	}
+
+	*x = min_x,	*y = min_y;
+	*width = max_x - min_x,	*height = max_y - min_y;
+
+	return (*width > 0 && *height > 0) ? TRUE : FALSE;
+}
+
+/*
+* FillVectorOutline関数
+* 中心線から作成した可変幅の輪郭を1度だけ塗りつぶして作業レイヤーに描画する
+*  ボケ足と輪郭の硬さは中心線からの距離で画素ごとに計算する
+* 引数
+* window	: 描画するキャンバス
+* line		: ボケ足・輪郭の硬さを持つベクトル線
+* outline	: 平坦化した中心線
+* rect		: 描画範囲を更新する矩形
+*/
+void FillVectorOutline(
+	DRAW_WINDOW* window,
+	VECTOR_LINE* line,
+	VECTOR_OUTLINE* outline,
+	VECTOR_LAYER_RECTANGLE* rect
+)
+{
+	LAYER *work = window->work_layer;
+	int x, y, width, height;
+
+	if(outline->num_points < 2)
+	{
+		return;
+	}
+
+	(void)GetVectorOutlineRectangle(outline, window->width, window->height,
+		&x, &y, &width, &height);
+
+	if(rect->min_x > x)
+	{
+		rect->min_x = x;
+	}
+	if(rect->min_y > y)
+	{
+		rect->min_y = y;
+	}
+	if(rect->max_x < x + width)
+	{
+		rect->max_x = x + width;
+	}
+	if(rect->max_y < y + height)
+	{
+		rect->max_y = y + height;
+	}
+
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	DrawVectorOutline(&window->app->graphics, line, outline,
+		&work->pixels[y*work->stride+x*work->channel], work->stride, x, y, width, height);
+}
+
+/*
+* VECTOR_OUTLINE_FILL_DATA構造体
+* 輪郭の塗りつぶしをスレッドプールで処理するためのデータ
+*/
+typedef struct _VECTOR_OUTLINE_FILL_DATA
+{
+	const VECTOR_OUTLINE *outline;
+	const VECTOR_OUTLINE_SEGMENT *segments;
+	const int *band_start;
+	const int *band_segments;
+	const uint8 *mask;
+	uint8 *pixels;
+	FLOAT_T blur;
+	FLOAT_T hardness;
+	int pixels_stride;
+	int stride;
+	int min_x;
+	int min_y;
+	int width;
+	int solid;
+} VECTOR_OUTLINE_FILL_DATA;
+
+/*
+* FillVectorOutlineRow関数
+* スレッドプールから呼び出されて被覆率と中心線からの距離で1行分の色を決めて合成する
+* 引数
+* y				: 描画範囲の上端からの行番号
+* thread_index	: 処理しているスレッドの番号
+* data			: VECTOR_OUTLINE_FILL_DATA構造体のアドレス
+*/
+static void FillVectorOutlineRow(int y, int thread_index, void* data)
+{
+	VECTOR_OUTLINE_FILL_DATA *fill = (VECTOR_OUTLINE_FILL_DATA*)data;
+	const VECTOR_OUTLINE *outline = fill->outline;
+	const uint8 *mask_line = &fill->mask[y*fill->stride];
+	uint8 *destination = &fill->pixels[y*fill->pixels_stride];
+	const int *band = NULL;
+	int band_size = 0;
+	FLOAT_T py = y + fill->min_y + 0.5;
+	int x, k;
+
+	(void)thread_index;
+
+	if(fill->solid == FALSE)
+	{
+		band = &fill->band_segments[fill->band_start[y/VECTOR_OUTLINE_BAND_HEIGHT]];
+		band_size = fill->band_start[y/VECTOR_OUTLINE_BAND_HEIGHT+1] - fill->band_start[y/VECTOR_OUTLINE_BAND_HEIGHT];
+	}
+
+	for(x=0; x<fill->width; x++, destination+=4)
+	{
+		const FLOAT_T *color;
+		FLOAT_T best_color[4];
+		FLOAT_T alpha;
+		uint8 pixel_alpha;
+
+		if(mask_line[x] == 0)
+		{
+			continue;
+		}
+
+		if(fill->solid != FALSE)
+		{
+			color = outline->points[0].color;
+			alpha = color[3];
+		}
+		else
+		{
+			FLOAT_T px = x + fill->min_x + 0.5;
+			alpha = -1;
+
+			for(k=0; k<band_size; k++)
+			{
+				const VECTOR_OUTLINE_SEGMENT *segment = &fill->segments[band[k]];
+				const VECTOR_OUTLINE_POINT *p0, *p1;
+				FLOAT_T t, r, ex, ey, dist, value;
+
+				if(px < segment->min_x || px > segment->max_x)
+				{
+					continue;
+				}
+
+				t = ((px - segment->x) * segment->dx + (py - segment->y) * segment->dy) * segment->div_length2;
+				// 半径が変化する場合は距離/半径が最小になる位置へ投影位置をずらす
+				r = segment->r + segment->dr * t;
+				if(r > 0)
+				{
+					ex = px - (segment->x + segment->dx * t);
+					ey = py - (segment->y + segment->dy * t);
+					t += segment->dr * (ex*ex + ey*ey) * segment->div_length2 / r;
+				}
+				if(t < 0)
+				{
+					t = 0;
+				}
+				else if(t > 1)
+				{
+					t = 1;
+				}
+				r = segment->r + segment->dr * t;
+				ex = px - (segment->x + segment->dx * t);
+				ey = py - (segment->y + segment->dy * t);
+				dist = sqrt(ex*ex + ey*ey);
+
+				p0 = &outline->points[segment->index];
+				p1 = &outline->points[segment->index+1];
+				value = (p0->color[3] + (p1->color[3] - p0->color[3]) * t)
+					* OutlineProfile((r > 0) ? dist / r : 1, fill->blur, fill->hardness);
+				if(value > alpha)
+				{
+					alpha = value;
+					best_color[0] = p0->color[0] + (p1->color[0] - p0->color[0]) * t;
+					best_color[1] = p0->color[1] + (p1->color[1] - p0->color[1]) * t;
+					best_color[2] = p0->color[2] + (p1->color[2] - p0->color[2]) * t;
+				}
+			}
+
+			if(alpha <= 0)
+			{
+				continue;
+			}
+			color = best_color;
+		}
+
+		alpha *= mask_line[x] * DIV_PIXEL;
+		pixel_alpha = (uint8)(alpha * 255 + 0.5);
+		if(pixel_alpha <= destination[3])
+		{
+			continue;
+		}
+		// 重ねて打点した場合の収束値(最大の不透明度の打点)を直接書き込む
+		destination[0] = (uint8)(color[2] * alpha * 255 + 0.5);
+		destination[1] = (uint8)(color[1] * alpha * 255 + 0.5);
+		destination[2] = (uint8)(color[0] * alpha * 255 + 0.5);
+		destination[3] = pixel_alpha;
+	}
+}
+
+/*
+* DrawVectorOutline関数
+* 中心線から作成した可変幅の輪郭を指定したピクセルデータに描画する
+*  作業レイヤーを使わないので線ごとに別のスレッドから呼び出せる
+* 引数
+* graphics	: 描画エンジンの設定
+* line		: ボケ足・輪郭の硬さを持つベクトル線
+* outline	: 平坦化した中心線
+* pixels	: 描画先のピクセルデータ((min_x, min_y)に対応する位置)
+* pixels_stride	: 描画先の1行分のバイト数
+* min_x		: 描画範囲の左上のX座標
+* min_y		: 描画範囲の左上のY座標
+* width		: 描画範囲の幅
+* height	: 描画範囲の高さ
+*/
+void DrawVectorOutline(
+	GRAPHICS* graphics,
+	VECTOR_LINE* line,
+	VECTOR_OUTLINE* outline,
+	uint8* pixels,
+	int pixels_stride,
+	int min_x,
+	int min_y,
+	int width,
+	int height
+)
+{
+	GRAPHICS_IMAGE_SURFACE surface;
+	GRAPHICS_DEFAULT_CONTEXT context;
+	VECTOR_OUTLINE_SEGMENT *segments;
+	VECTOR_OUTLINE_FILL_DATA fill;
+	FLOAT_T blur = line->blur * 0.01;
+	FLOAT_T hardness = line->outline_hardness * 0.01;
+	uint8 *mask;
+	int *band_start, *band_segments;
+	int stride;
+	int num_segments, num_bands;
+	int solid;
+	int i, j;
+
+	if(outline->num_points < 2 || width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	// 輪郭を1つのパスにまとめてスキャンコンバーターで被覆率のマスクを作る
+	stride = GraphicsFormatStrideForWidth(GRAPHICS_FORMAT_A8, width);
+	mask = (uint8*)MEM_CALLOC_FUNC(stride, height);
+	InitializeGraphicsImageSurfaceForData(&surface, mask, GRAPHICS_FORMAT_A8,
+		width, height, stride, graphics);
+	InitializeGraphicsDefaultContext(&context, &surface.base, graphics);
+	GraphicsTranslate(&context.base, - min_x, - min_y);
+	for(i=0; i<outline->num_points-1; i++)
+	{
+		AddCapsulePath(&context.base, &outline->points[i], &outline->points[i+1]);
+	}
+	GraphicsSetSourceRGBA(&context.base, 0, 0, 0, 1);
+	GraphicsFill(&context.base);
+	DestroyGraphicsContext(&context.base);
+	DestroyGraphicsSurface(&surface.base);
+
+	// ボケ足が無く色が一定なら被覆率だけで描画できる
+	solid = (blur <= 0) ? TRUE : FALSE;
+	for(i=1; i<outline->num_points && solid != FALSE; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			if(outline->points[i].color[j] != outline->points[0].color[j])
+			{
+				solid = FALSE;
+				break;
+			}
+		}
+	}
+
+	// 線分を縦方向の帯ごとに登録する
+	num_segments = outline->num_points - 1;
+	num_bands = (height + VECTOR_OUTLINE_BAND_HEIGHT - 1) / VECTOR_OUTLINE_BAND_HEIGHT;
+	segments = NULL;
+	band_start = NULL;
+	band_segments = NULL;
+	if(solid == FALSE)
+	{
+		int *band_count;
+		int num_entries = 0;
+
+		segments = (VECTOR_OUTLINE_SEGMENT*)MEM_ALLOC_FUNC(sizeof(*segments) * num_segments);
+		band_start = (int*)MEM_CALLOC_FUNC(num_bands + 1, sizeof(*band_start));
+		band_count = (int*)MEM_CALLOC_FUNC(num_bands + 1, sizeof(*band_count));
+
+		for(i=0; i<num_segments; i++)
+		{
+			const VECTOR_OUTLINE_POINT *p0 = &outline->points[i], *p1 = &outline->points[i+1];
+			VECTOR_OUTLINE_SEGMENT *segment = &segments[i];
+			FLOAT_T length2;
+			int first, last;
+
+			segment->x = p0->x,	segment->y = p0->y;
+			segment->dx = p1->x - p0->x,	segment->dy = p1->y - p0->y;
+			length2 = segment->dx * segment->dx + segment->dy * segment->dy;
+			segment->div_length2 = (length2 > 0) ? 1 / length2 : 0;
+			segment->r = p0->r,	segment->dr = p1->r - p0->r;
+			segment->min_x = ((p0->x - p0->r < p1->x - p1->r) ? p0->x - p0->r : p1->x - p1->r) - 1;
+			segment->max_x = ((p0->x + p0->r > p1->x + p1->r) ? p0->x + p0->r : p1->x + p1->r) + 1;
+			segment->index = i;
+
+			first = (int)floor(((p0->y - p0->r < p1->y - p1->r) ? p0->y - p0->r : p1->y - p1->r) - 1) - min_y;
+			last = (int)ceil(((p0->y + p0->r > p1->y + p1->r) ? p0->y + p0->r : p1->y + p1->r) + 1) - min_y;
+			if(first < 0)
+			{
+				first = 0;
+			}
+			if(last > height - 1)
+			{
+				last = height - 1;
+			}
+			if(first > last)
+			{
+				continue;
+			}
+			for(j=first/VECTOR_OUTLINE_BAND_HEIGHT; j<=last/VECTOR_OUTLINE_BAND_HEIGHT; j++)
+			{
+				band_count[j+1]++;
+				num_entries++;
+			}
+		}
+
+		for(j=0; j<num_bands; j++)
+		{
+			band_start[j+1] = band_start[j] + band_count[j+1];
+			band_count[j+1] = band_start[j];
+		}
+		band_segments = (int*)MEM_ALLOC_FUNC(sizeof(*band_segments) * (num_entries + 1));
+		for(i=0; i<num_segments; i++)
+		{
+			const VECTOR_OUTLINE_POINT *p0 = &outline->points[i], *p1 = &outline->points[i+1];
+			int first, last;
+
+			first = (int)floor(((p0->y - p0->r < p1->y - p1->r) ? p0->y - p0->r : p1->y - p1->r) - 1) - min_y;
+			last = (int)ceil(((p0->y + p0->r > p1->y + p1->r) ? p0->y + p0->r : p1->y + p1->r) + 1) - min_y;
+			if(first < 0)
+			{
+				first = 0;
+			}
+			if(last > height - 1)
+			{
+				last = height - 1;
+			}
+			if(first > last)
+			{
+				continue;
+			}
+			for(j=first/VECTOR_OUTLINE_BAND_HEIGHT; j<=last/VECTOR_OUTLINE_BAND_HEIGHT; j++)
+			{
+				band_segments[band_count[j+1]++] = i;
+			}
+		}
+
+		MEM_FREE_FUNC(band_count);
+	}
+
+	// 被覆率と中心線からの距離で色を決めて描画先へ合成する
+	fill.outline = outline;
+	fill.segments = segments;
+	fill.band_start = band_start;
+	fill.band_segments = band_segments;
+	fill.mask = mask;
+	fill.pixels = pixels;
+	fill.blur = blur;
+	fill.hardness = hardness;
+	fill.pixels_stride = pixels_stride;
+	fill.stride = stride;
+	fill.min_x = min_x;
+	fill.min_y = min_y;
+	fill.width = width;
+	fill.solid = solid;
+	ExecuteParallelLoop(height, FillVectorOutlineRow, &fill);
+
+	MEM_FREE_FUNC(mask);
+	MEM_FREE_FUNC(segments);
+	MEM_FREE_FUNC(band_start);
+	MEM_FREE_FUNC(band_segments);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,149 @@
+#ifndef _INCLUDED_VECTOR_OUTLINE_H_
+#define _INCLUDED_VECTOR_OUTLINE_H_
+
+#include "types.h"
+#include "vector.h"
+
+// 輪郭の中心線の点を確保する単位
+#define VECTOR_OUTLINE_BUFFER_SIZE 256
+// 線分を行単位で検索するための帯の高さ
+#define VECTOR_OUTLINE_BAND_HEIGHT 16
+
+/*
+* VECTOR_OUTLINE_POINT構造体
+* 可変幅の輪郭を作成する中心線上の点
+*/
+typedef struct _VECTOR_OUTLINE_POINT
+{
+	FLOAT_T x, y;		// 座標
+	FLOAT_T r;			// 線の半径
+	FLOAT_T color[4];	// 色(0～1)
+} VECTOR_OUTLINE_POINT;
+
+/*
+* VECTOR_OUTLINE構造体
+* 折れ線に平坦化したベクトル線の中心線
+*/
+typedef struct _VECTOR_OUTLINE
+{
+	VECTOR_OUTLINE_POINT *points;
+	int num_points;
+	int buffer_size;
+} VECTOR_OUTLINE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+* InitializeVectorOutline関数
+* 中心線のデータを初期化する
+* 引数
+* outline	: 初期化するデータ
+*/
+EXTERN void InitializeVectorOutline(VECTOR_OUTLINE* outline);
+
+/*
+* ReleaseVectorOutline関数
+* 中心線のデータのメモリを開放する
+* 引数
+* outline	: 開放するデータ
+*/
+EXTERN void ReleaseVectorOutline(VECTOR_OUTLINE* outline);
+
+/*
+* AddVectorOutlinePoint関数
+* 中心線に点を追加する
+*  色は2つの制御点の間を線形補間する
+* 引数
+* outline	: 点を追加する中心線
+* x			: 追加する点のX座標
+* y			: 追加する点のY座標
+* r			: 追加する点での線の半径
+* start		: 補間元の制御点
+* end		: 補間先の制御点
+* t			: 補間係数(0～1)
+*/
+EXTERN void AddVectorOutlinePoint(
+	VECTOR_OUTLINE* outline,
+	FLOAT_T x,
+	FLOAT_T y,
+	FLOAT_T r,
+	const VECTOR_POINT* start,
+	const VECTOR_POINT* end,
+	FLOAT_T t
+);
+
+/*
+* GetVectorOutlineRectangle関数
+* 中心線から作成した輪郭の描画範囲を取得する
+* 引数
+* outline	: 平坦化した中心線
+* canvas_width	: キャンバスの幅
+* canvas_height	: キャンバスの高さ
+* x			: 描画範囲の左上のX座標を受け取るアドレス
+* y			: 描画範囲の左上のY座標を受け取るアドレス
+* width		: 描画範囲の幅を受け取るアドレス
+* height	: 描画範囲の高さを受け取るアドレス
+* 返り値
+*	描画する範囲が有る:TRUE	無い:FALSE
+*/
+EXTERN int GetVectorOutlineRectangle(
+	VECTOR_OUTLINE* outline,
+	int canvas_width,
+	int canvas_height,
+	int* x,
+	int* y,
+	int* width,
+	int* height
+);
+
+/*
+* FillVectorOutline関数
+* 中心線から作成した可変幅の輪郭を1度だけ塗りつぶして作業レイヤーに描画する
+*  ボケ足と輪郭の硬さは中心線からの距離で画素ごとに計算する
+* 引数
+* window	: 描画するキャンバス
+* line		: ボケ足・輪郭の硬さを持つベクトル線
+* outline	: 平坦化した中心線
+* rect		: 描画範囲を更新する矩形
+*/
+EXTERN void FillVectorOutline(
+	DRAW_WINDOW* window,
+	VECTOR_LINE* line,
+	VECTOR_OUTLINE* outline,
+	VECTOR_LAYER_RECTANGLE* rect
+);
+
+/*
+* DrawVectorOutline関数
+* 中心線から作成した可変幅の輪郭を指定したピクセルデータに描画する
+*  作業レイヤーを使わないので線ごとに別のスレッドから呼び出せる
+* 引数
+* graphics	: 描画エンジンの設定
+* line		: ボケ足・輪郭の硬さを持つベクトル線
+* outline	: 平坦化した中心線
+* pixels	: 描画先のピクセルデータ((min_x, min_y)に対応する位置)
+* pixels_stride	: 描画先の1行分のバイト数
+* min_x		: 描画範囲の左上のX座標
+* min_y		: 描画範囲の左上のY座標
+* width		: 描画範囲の幅
+* height	: 描画範囲の高さ
+*/
+EXTERN void DrawVectorOutline(
+	GRAPHICS* graphics,
+	VECTOR_LINE* line,
+	VECTOR_OUTLINE* outline,
+	uint8* pixels,
+	int pixels_stride,
+	int min_x,
+	int min_y,
+	int width,
+	int height
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _INCLUDED_VECTOR_OUTLINE_H_